@@ -5,100 +5,73 @@
 
 #include "SQUIDHID.h"
 
-const size_t       descriptorSize = sizeof(_nkroReportDescriptor) 
+#if __has_include("Preferences.h")
+#include <Preferences.h>
+#endif
 
+// The full report map gets stitched together by the compiler, so it lives in flash and there's nothing to build at boot
+static constexpr auto _hidReportDescriptor = concatDescriptors(
+    _nkroReportDescriptor
 #if MEDIA_ENABLE
-  +  sizeof(_mediakeyReportDescriptor)
+  , _mediakeyReportDescriptor
 #endif
 
 #if SPACEMOUSE_ENABLE
-  +  sizeof(_spacemouseReportDescriptor)
-#else
+  , _spacemouseReportDescriptor
+#endif
 
 #if MOUSE_ENABLE
-  +  sizeof(_mouseReportDescriptor)
+  , _mouseReportDescriptor
 #endif
 
 #if DIGITIZER_ENABLE
-  +  sizeof(_digitizerReportDescriptor)
+  , _digitizerReportDescriptor
 #endif
 
 #if GAMEPAD_ENABLE
-  +  sizeof(_gamepadReportDescriptor)  
-#endif
+  , _gamepadReportDescriptor
 #endif
 
 #if STENO_ENABLE
-  +  sizeof(_stenoReportDescriptor)
+  , _stenoReportDescriptor
 #endif
-  ;                      
+);
 
-static size_t  _hidReportDescriptorLength = 0; 
+static_assert(_hidReportDescriptor.size() <= MAX_DESCRIPTOR_SIZE, "HID descriptor is over the 512 byte limit - turn some features off in config.h");
+static_assert(descriptorWellFormed(_hidReportDescriptor),         "HID descriptor has a truncated item or an unclosed collection");
+static_assert(descriptorReportIdsUnique(_hidReportDescriptor),    "HID descriptor reuses a report ID - check the IDs in Data.h");
 
-#if TRANSPORT == USB
-static uint8_t _hidReportDescriptor[MAX_DESCRIPTOR_SIZE];
-#else                   
-static uint8_t _hidReportDescriptor[descriptorSize];
+// Registry table - everything compiled in, in the same order as the descriptor above
+static const HIDFeatureEntry _hidFeatureTable[] = {
+    { HID_FEATURE_NKRO,       _nkroReportDescriptor,       sizeof(_nkroReportDescriptor),       "NKRO"       },
+#if MEDIA_ENABLE
+    { HID_FEATURE_MEDIA,      _mediakeyReportDescriptor,   sizeof(_mediakeyReportDescriptor),   "Media"      },
 #endif
 
-bool           getInitialized = false;
+#if SPACEMOUSE_ENABLE
+    { HID_FEATURE_SPACEMOUSE, _spacemouseReportDescriptor, sizeof(_spacemouseReportDescriptor), "Spacemouse" },
+#endif
 
-SQUIDHID*      _activeSQUIDHIDInstance = nullptr;
+#if MOUSE_ENABLE
+    { HID_FEATURE_MOUSE,      _mouseReportDescriptor,      sizeof(_mouseReportDescriptor),      "Mouse"      },
+#endif
 
-class HIDDescriptorInitializer {
-public:
-    HIDDescriptorInitializer() {
-        uint8_t* current = _hidReportDescriptor;
-        size_t total = 0;
-        
-        memcpy(current, _nkroReportDescriptor, sizeof(_nkroReportDescriptor));
-        current += sizeof(_nkroReportDescriptor);
-        total += sizeof(_nkroReportDescriptor);
-        
-        #if MEDIA_ENABLE
-        memcpy(current, _mediakeyReportDescriptor, sizeof(_mediakeyReportDescriptor));
-        current += sizeof(_mediakeyReportDescriptor);
-        total += sizeof(_mediakeyReportDescriptor);
-        #endif
-        
-        #if SPACEMOUSE_ENABLE
-        memcpy(current, _spacemouseReportDescriptor, sizeof(_spacemouseReportDescriptor));
-        current += sizeof(_spacemouseReportDescriptor);
-        total += sizeof(_spacemouseReportDescriptor);
-        #else
-        
-        #if MOUSE_ENABLE
-        memcpy(current, _mouseReportDescriptor, sizeof(_mouseReportDescriptor));
-        current += sizeof(_mouseReportDescriptor);
-        total += sizeof(_mouseReportDescriptor);
-        #endif
-        
-        #if DIGITIZER_ENABLE
-        memcpy(current, _digitizerReportDescriptor, sizeof(_digitizerReportDescriptor));
-        current += sizeof(_digitizerReportDescriptor);
-        total += sizeof(_digitizerReportDescriptor);
-        #endif
-        
-        #if GAMEPAD_ENABLE
-        memcpy(current, _gamepadReportDescriptor, sizeof(_gamepadReportDescriptor));
-        current += sizeof(_gamepadReportDescriptor);
-        total += sizeof(_gamepadReportDescriptor);
-        #endif
-        #endif
-        
-        #if STENO_ENABLE
-        memcpy(current, _stenoReportDescriptor, sizeof(_stenoReportDescriptor));
-        current += sizeof(_stenoReportDescriptor);
-        total += sizeof(_stenoReportDescriptor);
-        #endif
-        
-        _hidReportDescriptorLength = total;
-        
-        SQUID_LOG_DEBUG("HID", "Complete HID descriptor built - Total size: %zu", _hidReportDescriptorLength);
-    }
+#if DIGITIZER_ENABLE
+    { HID_FEATURE_DIGITIZER,  _digitizerReportDescriptor,  sizeof(_digitizerReportDescriptor),  "Digitizer"  },
+#endif
+
+#if GAMEPAD_ENABLE
+    { HID_FEATURE_GAMEPAD,    _gamepadReportDescriptor,    sizeof(_gamepadReportDescriptor),    "Gamepad"    },
+#endif
+
+#if STENO_ENABLE
+    { HID_FEATURE_STENO,      _stenoReportDescriptor,      sizeof(_stenoReportDescriptor),      "Steno"      },
+#endif
 };
 
-static HIDDescriptorInitializer _hidDescriptorInitializer;
+bool           getInitialized = false;
+
+SQUIDHID*      _activeSQUIDHIDInstance = nullptr;
 
 // This is a "constructor". It takes that class from the SQUIDHID.h file, and turns it into "objects" that can actually be used.
 SQUIDHID::SQUIDHID(std::string deviceName, std::string deviceManufacturer, 
@@ -117,6 +90,20 @@ SQUIDHID::SQUIDHID(std::string deviceName, std::string deviceManufacturer,
     #if OLED_ENABLE
     , oledDisplay(nullptr)
     , oledInitialized(false)
+    , oledSplashUntil(0)
+    , oledConsole(false)
+    , oledConsoleLevel(LogLevel::INFO)
+    , oledConsoleSink(-1)
+    , oledStatusLabel(0, 0, OLED_WIDTH, OLED::NORMAL_SIZE, OLEDLabel::ALIGN_CENTER)
+    , oledNameLabel(10, 16, OLED_WIDTH - 10)
+    , oledBatteryLabel(10, 32, OLED_WIDTH - 10)
+    , oledLayerLabel(10, 48, OLED_WIDTH - 10)
+    , oledLockLabel(10, 56, OLED_WIDTH - 10)
+    #endif
+    #if ANALOG_ENABLE
+    , analogReportInterval(1000000 / ANALOG_REPORT_RATE)
+    , analogLastReport(0)
+    , analogPending(false)
     #endif
     , lastPollTime(0) 
 {
@@ -140,6 +127,30 @@ SQUIDHID::SQUIDHID(std::string deviceName, std::string deviceManufacturer,
     
     transport = createTransport();
     
+    #if OLED_ENABLE
+    oledWidgets.add(&oledStatusLabel);
+    oledWidgets.add(&oledNameLabel);
+    oledWidgets.add(&oledBatteryLabel);
+    oledWidgets.add(&oledLayerLabel);
+    oledWidgets.add(&oledLockLabel);
+    #endif
+    
+    #if LED_ENABLE
+    for (uint8_t i = 0; i < 5; i++) {
+        lockLEDIndex[i] = -1;
+        lockLEDColor[i] = 0;
+    }
+    #endif
+    
+    #if ANALOG_ENABLE
+    for (uint8_t i = 0; i < 6; i++) {
+        analogAxisMap[i] = -1;
+    }
+    #endif
+    
+    features.begin(_hidFeatureTable, sizeof(_hidFeatureTable) / sizeof(_hidFeatureTable[0]),
+                   _hidReportDescriptor.begin(), _hidReportDescriptor.size());
+    
     // Common transport setup
     if (transport) {
         transport->setDeviceInfo(deviceName.c_str(), deviceManufacturer.c_str(), vid, pid, version);
@@ -163,6 +174,9 @@ SQUIDHID::~SQUIDHID() {
     #endif
     
     #if OLED_ENABLE
+    if (oledConsoleSink >= 0) {
+        SQUIDLOGS::getInstance().removeSink(oledConsoleSink);
+    }
     if (oledDisplay) {
         delete oledDisplay;
         oledDisplay = nullptr;
@@ -201,13 +215,13 @@ void SQUIDHID::begin(void) {
     SQUID_LOG_INFO(MAIN_TAG, "Starting SQUIDHID with transport...");
     SQUID_LOG_DEBUG(MAIN_TAG, "Setting HID report map...");
     
+    // A profile picked last boot that couldn't be applied live goes in before the host sees the descriptor,
+    // unless the sketch has already asked for one
+    loadFeatureProfile();
+    
     // The transport needs the report map before begin() for the USB transport layer
-    if (_hidReportDescriptorLength > 0) {
-        transport->setReportMap((uint8_t *)_hidReportDescriptor, _hidReportDescriptorLength);
-    } else {
-        SQUID_LOG_ERROR(MAIN_TAG, "No HID descriptor built!");
-        return;
-    }
+    transport->setReportMap(features.descriptor(), features.descriptorLength());
+    SQUID_LOG_DEBUG(MAIN_TAG, "HID descriptor size: %zu", features.descriptorLength());
     
     // Initialize transport
     SQUID_LOG_DEBUG(MAIN_TAG, "Initializing transport...");
@@ -234,23 +248,35 @@ void SQUIDHID::begin(void) {
     #if OLED_ENABLE
     if (!oledDisplay) {
     // Auto-initialize OLED with pins and dimensions from config.h
+    #if OLED_BUS == OLED_BUS_SPI
+    initializeOLED(new OLEDSPI(SPI, SCK_PIN, MOSI_PIN, CS_PIN, OLED_DC_PIN,
+                   #ifdef OLED_RST_PIN
+                               OLED_RST_PIN
+                   #else
+                               -1
+                   #endif
+                               ), OLED_WIDTH, OLED_HEIGHT);
+    SQUID_LOG_INFO(MAIN_TAG, "Auto-initialized SPI OLED %dx%d with CS:%d, DC:%d", 
+                   OLED_WIDTH, OLED_HEIGHT, CS_PIN, OLED_DC_PIN);
+    #elif OLED_BUS == OLED_BUS_I2C
+    initializeOLED(new OLEDWireI2C(Wire, SDA_PIN, SCL_PIN), OLED_WIDTH, OLED_HEIGHT);
+    SQUID_LOG_INFO(MAIN_TAG, "Auto-initialized hardware I2C OLED %dx%d with SDA:%d, SCL:%d", 
+                   OLED_WIDTH, OLED_HEIGHT, SDA_PIN, SCL_PIN);
+    #else
     initializeOLED(SDA_PIN, SCL_PIN, OLED_WIDTH, OLED_HEIGHT);
     SQUID_LOG_INFO(MAIN_TAG, "Auto-initialized OLED %dx%d with SDA:%d, SCL:%d", 
                    OLED_WIDTH, OLED_HEIGHT, SDA_PIN, SCL_PIN);
+    #endif
     }
     
     if (oledDisplay && !oledInitialized) {
         oledDisplay->begin();
         oledInitialized = true;
-        oledDisplay->clear(OLED::BLACK);
-        oledDisplay->display();
         
-        // Show startup screen
+        // Show startup screen, update() takes it down again after a second unless the sketch draws over it first
         oledShowSquidLogo();
-        oledDisplay->display();
-        delay(1000); // Show logo for 1 second
-        
-        oledClear();
+        oledSplashUntil = millis() + 1000;
+        if (oledSplashUntil == 0) oledSplashUntil = 1;
         
         SQUID_LOG_INFO(MAIN_TAG, "OLED display initialized");
     }
@@ -278,40 +304,8 @@ void SQUIDHID::begin(void) {
     
     // Initialize features
     SQUID_LOG_DEBUG(MAIN_TAG, "Initializing feature modules...");
-    nkro.begin(transport.get(), _delay_ms);
-    SQUID_LOG_DEBUG(MAIN_TAG, "NKRO keyboard support enabled");
-    
-    #if MEDIA_ENABLE
-    media.begin(transport.get(), _delay_ms);
-    SQUID_LOG_DEBUG(MAIN_TAG, "Media key support enabled");
-    #endif
-    
-    #if SPACEMOUSE_ENABLE
-    spacemouse.begin(transport.get(), _delay_ms);
-    SQUID_LOG_DEBUG(MAIN_TAG, "Spacemouse support enabled");
-    #else
-    
-    #if MOUSE_ENABLE
-    mouse.begin(transport.get(), _delay_ms);
-    SQUID_LOG_DEBUG(MAIN_TAG, "Mouse support enabled");
-    #endif
-    
-    #if DIGITIZER_ENABLE
-    digitizer.begin(transport.get(), _delay_ms);
-    SQUID_LOG_DEBUG(MAIN_TAG, "Digitizer support enabled");
-    #endif
-    
-    #if GAMEPAD_ENABLE
-    gamepad.begin(transport.get(), _delay_ms);
-    SQUID_LOG_DEBUG(MAIN_TAG, "Gamepad support enabled");
-    
-    #endif
-    #endif
-
-    #if STENO_ENABLE
-    steno.begin(transport.get(), _delay_ms);
-    SQUID_LOG_DEBUG(MAIN_TAG, "PloverHID support enabled");
-    #endif
+    attachFeatures();
+    started = true;
     
     lastPollTime = millis();
     SQUID_LOG_INFO(MAIN_TAG, "SQUIDHID started successfully - Waiting for connections...");
@@ -334,6 +328,8 @@ void SQUIDHID::update() {
         transport->update();
     }
     
+    applyHostLEDs();
+    
     if (currentTime - lastUpdateTime >= SCAN_INTERVAL) {
         lastUpdateTime = currentTime;
         
@@ -348,6 +344,11 @@ void SQUIDHID::update() {
         }
     }
     
+    #if ANALOG_MATRIX_ENABLE
+    // Every pass rather than every SCAN_INTERVAL, rapid trigger is only as quick as the scan
+    analogMatrix.update();
+    #endif
+    
     keymap.update();
     
     if (currentTime - lastPollTime >= POLL_INTERVAL) {
@@ -356,18 +357,68 @@ void SQUIDHID::update() {
     }
     
     #if LED_ENABLE
-    // Only update LEDs if they're dirty and ready to show
-    if (ledsDirty && leds && leds->canShow()) {
-        leds->show();
-        ledsDirty = false;
+    // show() only encodes and queues the frame, poll() starts it once the strip is free
+    if (leds) {
+        if (ledEffects.tick(micros())) {
+            applyLockLEDs();  // The effect just painted over them
+            ledsDirty = true;
+        }
+        if (ledsDirty) {
+            leds->show();
+            ledsDirty = false;
+        }
+        leds->poll();
+    }
+    #endif
+    
+    #if POINTER_ENABLE
+    // Before the mouse so a burst read this pass can go out in this pass's report
+    pointer.update(micros());
+    #endif
+    
+    #if MOUSE_ENABLE
+    mouse.update(micros());
+    #endif
+    
+    #if DIGITIZER_ENABLE && !DIGITIZER_TOUCHPAD
+    digitizer.update(micros());
+    #endif
+    
+    #if ANALOG_ENABLE
+    // Samples get filtered as they come in, the host only hears about them at the report rate
+    uint32_t nowUs = micros();
+    if (analog.update(nowUs)) analogPending = true;
+    if (analogPending && started && nowUs - analogLastReport >= analogReportInterval) {
+        analogLastReport = nowUs;
+        analogPending = false;
+        publishAnalog();
     }
     #endif
     
+    #if GAMEPAD_ENABLE
+    // After the analog publish, so this pass's stick readings go out in this pass's report
+    gamepad.update(micros());
+    #endif
+    
     #if OLED_ENABLE
-    // Only update OLED if it's dirty
-    if (oledDirty && oledDisplay && oledInitialized) {
-        oledDisplay->display();
-        oledDirty = false;
+    if (oledDisplay && oledInitialized) {
+        if (oledSplashUntil && (int32_t)(millis() - oledSplashUntil) >= 0) {
+            oledSplashUntil = 0;
+            oledClear();
+        }
+        
+        // The console owns the whole screen, the widgets would draw over it
+        if (!oledConsole && oledWidgets.render(*oledDisplay)) {
+            oledDirty = true;
+        }
+        
+        // Only start a flush if it's dirty, then push it along one chunk per update.
+        // Console writes only mark pages, so it gets a flush whenever one can start - a clean screen just doesn't start one.
+        if ((oledDirty || oledConsole) && !oledDisplay->is_flushing()) {
+            oledDisplay->display_async();
+            oledDirty = false;
+        }
+        oledDisplay->flush_step();
     }
     #endif
 }
@@ -376,9 +427,173 @@ void SQUIDHID::end(void) {
     if (transport) {
         transport->end();
     }
+    started = false;
     SQUID_LOG_INFO(MAIN_TAG, "SQUIDHID stopped");
 }
 
+//
+// ----------------------------------------- Feature Profile Block
+//
+
+// Switched-off features get no transport, so anything that slips past the keymap gate just gets dropped
+Transport* SQUIDHID::featureTransport(uint32_t feature) {
+    return features.isActive(feature) ? transport.get() : nullptr;
+}
+
+void SQUIDHID::attachFeatures() {
+    nkro.begin(transport.get(), _delay_ms);
+    SQUID_LOG_DEBUG(MAIN_TAG, "NKRO keyboard support enabled");
+    
+    #if MEDIA_ENABLE
+    media.begin(featureTransport(HID_FEATURE_MEDIA), _delay_ms);
+    SQUID_LOG_DEBUG(MAIN_TAG, "Media key support %s", features.isActive(HID_FEATURE_MEDIA) ? "enabled" : "disabled");
+    #endif
+    
+    #if SPACEMOUSE_ENABLE
+    spacemouse.begin(featureTransport(HID_FEATURE_SPACEMOUSE), _delay_ms);
+    SQUID_LOG_DEBUG(MAIN_TAG, "Spacemouse support %s", features.isActive(HID_FEATURE_SPACEMOUSE) ? "enabled" : "disabled");
+    #endif
+    
+    #if MOUSE_ENABLE
+    mouse.begin(featureTransport(HID_FEATURE_MOUSE), _delay_ms);
+    SQUID_LOG_DEBUG(MAIN_TAG, "Mouse support %s", features.isActive(HID_FEATURE_MOUSE) ? "enabled" : "disabled");
+    #endif
+    
+    #if DIGITIZER_ENABLE
+    digitizer.begin(featureTransport(HID_FEATURE_DIGITIZER), _delay_ms);
+    SQUID_LOG_DEBUG(MAIN_TAG, "Digitizer support %s", features.isActive(HID_FEATURE_DIGITIZER) ? "enabled" : "disabled");
+    #endif
+    
+    #if GAMEPAD_ENABLE
+    gamepad.begin(featureTransport(HID_FEATURE_GAMEPAD), _delay_ms);
+    SQUID_LOG_DEBUG(MAIN_TAG, "Gamepad support %s", features.isActive(HID_FEATURE_GAMEPAD) ? "enabled" : "disabled");
+    #endif
+
+    #if STENO_ENABLE
+    steno.begin(featureTransport(HID_FEATURE_STENO));
+    // Dictionary mode types through the keyboard
+    steno.onText([this](const StenoEdit& edit) {
+        // One write for the rub-out and the text, so it's all one run of reports
+        std::string keys(edit.backspaces, '\b');
+        keys.append(edit.text, edit.length);
+        nkro.write(reinterpret_cast<const uint8_t*>(keys.data()), keys.size());
+    });
+    SQUID_LOG_DEBUG(MAIN_TAG, "PloverHID support %s", features.isActive(HID_FEATURE_STENO) ? "enabled" : "disabled");
+    #endif
+}
+
+// Works out which feature a keymap entry belongs to so the press/release callbacks can bail early
+uint32_t SQUIDHID::featureFor(KeypressType type) {
+    switch (type) {
+        case KeypressType::MEDIA_KEY:           return HID_FEATURE_MEDIA;
+        case KeypressType::STENO_KEY:           return HID_FEATURE_STENO;
+        case KeypressType::GAMEPAD_BUTTON:
+        case KeypressType::GAMEPAD_HAT:
+        case KeypressType::GAMEPAD_ANALOGUE:    return HID_FEATURE_GAMEPAD;
+        case KeypressType::MOUSE_KEY:
+        case KeypressType::MOUSE_ANALOGUE:      return HID_FEATURE_MOUSE;
+        case KeypressType::DIGITIZER_KEY:
+        case KeypressType::DIGITIZER_ANALOGUE:  return HID_FEATURE_DIGITIZER;
+        case KeypressType::SPACEMOUSE_KEY:
+        case KeypressType::SPACEMOUSE_ANALOGUE: return HID_FEATURE_SPACEMOUSE;
+        default:                                return HID_FEATURE_NKRO;
+    }
+}
+
+bool SQUIDHID::setFeatureProfile(uint32_t profile) {
+    // Let go of everything first so nothing gets stuck down on a report that's about to disappear
+    if (started) {
+        releaseAll();
+    } else {
+        profileRequested = true;
+    }
+    
+    uint32_t previous = features.active();
+    if (!features.setProfile(profile)) {
+        SQUID_LOG_DEBUG(MAIN_TAG, "Feature profile unchanged (0x%02X)", features.active());
+        // Going back to the running profile drops whatever was waiting for a reboot
+        if (started && savedProfile) {
+            saveFeatureProfile(features.active());
+        }
+        return true;
+    }
+    
+    SQUID_LOG_INFO(MAIN_TAG, "Feature profile set to 0x%02X", features.active());
+    
+    if (!transport) {
+        return true;
+    }
+    
+    transport->setReportMap(features.descriptor(), features.descriptorLength());
+    
+    // Not started yet means begin() will pick everything up, nothing else to do
+    if (!started) {
+        return true;
+    }
+    
+    attachFeatures();
+    
+    if (!transport->reloadReportMap()) {
+        // The host holds on to the descriptor it enumerated, so the modules have to stay as they were or
+        // their reports just stop. The new profile waits in NVS for begin() on the next boot.
+        uint32_t requested = features.active();
+        features.setProfile(previous);
+        transport->setReportMap(features.descriptor(), features.descriptorLength());
+        attachFeatures();
+        saveFeatureProfile(requested);
+        
+        SQUID_LOG_WARN(MAIN_TAG, "Transport can't re-enumerate on the fly - profile 0x%02X saved for the next boot", requested);
+        return false;
+    }
+    
+    if (savedProfile) {
+        saveFeatureProfile(features.active());
+    }
+    return true;
+}
+
+void SQUIDHID::loadFeatureProfile() {
+    #if __has_include("Preferences.h")
+    Preferences prefs;
+    if (!prefs.begin("squidhid", true)) {
+        SQUID_LOG_DEBUG(MAIN_TAG, "No saved feature profile");
+        return;
+    }
+    savedProfile = prefs.getUInt("profile", 0);
+    prefs.end();
+    
+    // The sketch asking for one before begin() is the newer word, so the saved one goes
+    if (profileRequested) {
+        if (savedProfile) {
+            SQUID_LOG_INFO(MAIN_TAG, "Saved feature profile 0x%02X dropped for the sketch's 0x%02X", savedProfile, features.active());
+            saveFeatureProfile(0);
+        }
+        return;
+    }
+    
+    if (savedProfile && features.setProfile(savedProfile)) {
+        SQUID_LOG_INFO(MAIN_TAG, "Feature profile 0x%02X restored from NVS", features.active());
+    }
+    #endif
+}
+
+void SQUIDHID::saveFeatureProfile(uint32_t profile) {
+    if (profile == savedProfile) {
+        return;
+    }
+    
+    #if __has_include("Preferences.h")
+    Preferences prefs;
+    if (!prefs.begin("squidhid", false)) {
+        SQUID_LOG_ERROR(MAIN_TAG, "Couldn't open NVS to save the feature profile");
+        return;
+    }
+    prefs.putUInt("profile", profile);
+    prefs.end();
+    savedProfile = profile;
+    #endif
+}
+
 //
 // ----------------------------------------- Global Function Block
 //
@@ -500,7 +715,7 @@ void SQUIDHID::onConnect() {
     #endif
     #if SPACEMOUSE_ENABLE
     spacemouse.onConnect();
-    #else
+    #endif
     #if MOUSE_ENABLE
     mouse.onConnect();
     #endif
@@ -510,7 +725,6 @@ void SQUIDHID::onConnect() {
     #if GAMEPAD_ENABLE
     gamepad.onConnect();
     #endif
-    #endif
     #if STENO_ENABLE
     steno.onConnect();
     #endif
@@ -554,7 +768,7 @@ void SQUIDHID::onDisconnect() {
     #endif
     #if SPACEMOUSE_ENABLE
     spacemouse.onDisconnect();
-    #else
+    #endif
     #if MOUSE_ENABLE
     mouse.onDisconnect();
     #endif
@@ -564,7 +778,6 @@ void SQUIDHID::onDisconnect() {
     #if GAMEPAD_ENABLE
     gamepad.onDisconnect();
     #endif
-    #endif
     #if STENO_ENABLE
     steno.onDisconnect();
     #endif
@@ -588,7 +801,7 @@ void SQUIDHID::releaseAll() {
   
   #if SPACEMOUSE_ENABLE
   spacemouse.releaseAll();
-  #else
+  #endif
   
   #if MOUSE_ENABLE
   mouse.releaseAll();
@@ -596,8 +809,6 @@ void SQUIDHID::releaseAll() {
   
   #if GAMEPAD_ENABLE
   gamepad.releaseAll();
-  
-  #endif
   #endif
   
   #if STENO_ENABLE
@@ -607,11 +818,39 @@ void SQUIDHID::releaseAll() {
 
 void SQUIDHID::onDataReceived(const uint8_t* data, size_t length) {
     SQUID_LOG_DEBUG(MAIN_TAG, "Received %zu bytes from transport", length);
+}
+
+void SQUIDHID::onOutputReport(uint8_t reportId, const uint8_t* data, size_t length) {
+    SQUID_LOG_DEBUG(MAIN_TAG, "Output report %d, %zu bytes", reportId, length);
     
-    // Handle HID output reports (host -> device)
-    if (length > 0) {
-        uint8_t reportId = data[0];
-        
+    // The keyboard's output report is just the lock LED byte
+    if (reportId == NKRO_ID && data && length >= 1) {
+        setHostLEDs(data[0]);
+    }
+}
+
+void SQUIDHID::setHostLEDs(uint8_t leds) {
+    hostLEDs.post(leds);
+}
+
+void SQUIDHID::applyHostLEDs() {
+    // Hosts resend the same state all the time (every reconnect, every other keyboard's lock key)
+    uint8_t changed = hostLEDs.take();
+    if (!changed) return;
+    uint8_t leds = hostLEDs.get();
+    
+    SQUID_LOG_INFO(MAIN_TAG, "Host LEDs: 0x%02X (changed 0x%02X)", leds, changed);
+    
+    #if LED_ENABLE
+    applyLockLEDs(changed);
+    #endif
+    
+    #if OLED_ENABLE
+    oledShowLockState(leds);
+    #endif
+    
+    if (hostLEDCallback) {
+        hostLEDCallback(leds, changed);
     }
 }
 
@@ -664,9 +903,16 @@ void SQUIDHID::setProductId(uint16_t pid) { this->pid = pid; }
 
 void SQUIDHID::setVersion(uint16_t version) { this->version = version; }
 
+void SQUIDHID::handleSwitch(size_t switch_index, bool pressed) {
+    keymap.handleKeyEvent(switch_index, pressed);
+    #if LED_ENABLE
+    ledEffects.onKey(switch_index, pressed);
+    #endif
+}
+
 void SQUIDHID::setupMatrix(const squid_matrix& matrix) {
     auto key_event_callback = [this](size_t switch_index, bool pressed) {
-        this->keymap.handleKeyEvent(switch_index, pressed);
+        this->handleSwitch(switch_index, pressed);
     };
     
     auto pinModeFunc = [this](uint8_t pin, uint8_t mode) {
@@ -684,10 +930,42 @@ void SQUIDHID::setupMatrix(const squid_matrix& matrix) {
     // The unified GPIO functions are being used for matrix scanning because it makes weirder matrices easier to define
     this->matrix.begin(matrix, key_event_callback, pinModeFunc, digitalWriteFunc, digitalReadFunc);
     SQUID_LOG_INFO(MAIN_TAG, "Keyboard matrix configured with %zu switches", matrix.size());
+    
+    #if ANALOG_MATRIX_ENABLE
+    // The analog keys always come after the digital ones, whichever got set up first
+    analogMatrix.setIndexOffset(this->matrix.getSwitchCount());
+    #endif
 }
 
+#if ANALOG_MATRIX_ENABLE
+bool SQUIDHID::setupAnalogMatrix(const AnalogMuxConfig& config) {
+    auto key_event_callback = [this](size_t switch_index, bool pressed) {
+        this->handleSwitch(switch_index, pressed);
+    };
+    
+    auto pinModeFunc = [this](uint8_t pin, uint8_t mode) {
+        this->pinMode(pin, mode);
+    };
+    
+    auto digitalWriteFunc = [this](uint8_t pin, uint8_t value) {
+        this->digitalWrite(pin, value);
+    };
+    
+    // Select lines can go through the MCP like anything else, the ADC pins have to be real ones.
+    // If there's no digital matrix yet setupMatrix() moves the offset along once there is.
+    if (!analogMatrix.begin(config, key_event_callback, matrix.getSwitchCount(), pinModeFunc, digitalWriteFunc)) {
+        return false;
+    }
+    SQUID_LOG_INFO(MAIN_TAG, "Analog matrix configured with %zu keys from index %zu",
+                   analogMatrix.getSwitchCount(), analogMatrix.getIndexOffset());
+    return true;
+}
+#endif
+
 void SQUIDHID::setupKeymap(const std::vector<std::vector<LayerKeymapEntry>>& layers) {
     auto press_callback = [this](const KeymapEntry& key_entry) {
+        if (!this->features.isActive(featureFor(key_entry.type))) return;
+        
         switch (key_entry.type) {
             case KeypressType::NKRO_KEY:
                 this->nkro.press(key_entry.key.nkro_key);
@@ -706,18 +984,22 @@ void SQUIDHID::setupKeymap(const std::vector<std::vector<LayerKeymapEntry>>& lay
             case KeypressType::SPACEMOUSE_KEY:
                 #if SPACEMOUSE_ENABLE
                 this->spacemouse.press(key_entry.key.spacemouse_key);
-                #else
+                #endif
                 break;
             case KeypressType::MOUSE_KEY:
                 #if MOUSE_ENABLE
                 this->mouse.press(key_entry.key.mouse_key);
                 #endif
                 break;
+            case KeypressType::MOUSE_ANALOGUE:
+                #if MOUSE_ENABLE
+                this->mouse.pressDirection(key_entry.key.mouse_analogue);
+                #endif
+                break;
             case KeypressType::GAMEPAD_BUTTON:
                 #if GAMEPAD_ENABLE
                 this->gamepad.press(key_entry.key.gamepad_button);
                 #endif
-                #endif
                 break;
             case KeypressType::STENO_KEY:
                 #if STENO_ENABLE
@@ -730,6 +1012,8 @@ void SQUIDHID::setupKeymap(const std::vector<std::vector<LayerKeymapEntry>>& lay
     };
     
     auto release_callback = [this](const KeymapEntry& key_entry) {
+        if (!this->features.isActive(featureFor(key_entry.type))) return;
+        
         switch (key_entry.type) {
             case KeypressType::NKRO_KEY:
                 this->nkro.release(key_entry.key.nkro_key);
@@ -748,18 +1032,22 @@ void SQUIDHID::setupKeymap(const std::vector<std::vector<LayerKeymapEntry>>& lay
             case KeypressType::SPACEMOUSE_KEY:
                 #if SPACEMOUSE_ENABLE
                 this->spacemouse.release(key_entry.key.spacemouse_key);
-                #else
+                #endif
                 break;
             case KeypressType::MOUSE_KEY:
                 #if MOUSE_ENABLE
                 this->mouse.release(key_entry.key.mouse_key);
                 #endif
                 break;
+            case KeypressType::MOUSE_ANALOGUE:
+                #if MOUSE_ENABLE
+                this->mouse.releaseDirection(key_entry.key.mouse_analogue);
+                #endif
+                break;
             case KeypressType::GAMEPAD_BUTTON:
                 #if GAMEPAD_ENABLE
                 this->gamepad.release(key_entry.key.gamepad_button);
                 #endif
-                #endif
                 break;
             case KeypressType::STENO_KEY:
                 #if STENO_ENABLE
@@ -806,6 +1094,9 @@ bool SQUIDHID::isLayerActive(uint8_t layer) const {
 
 void SQUIDHID::updateMatrix() {
     this->matrix.update();
+    #if ANALOG_MATRIX_ENABLE
+    analogMatrix.update();
+    #endif
     keymap.update();
 }
 
@@ -831,6 +1122,10 @@ size_t SQUIDHID::write(ModKey modifier) { return nkro.write(modifier); }
 
 size_t SQUIDHID::write(ShiftedKey shiftedKey) { return nkro.write(shiftedKey); }
 
+size_t SQUIDHID::write(const uint8_t* buffer, size_t size) { return nkro.write(buffer, size); }
+
+size_t SQUIDHID::print(const char* text) { return nkro.print(text); }
+
 void SQUIDHID::useNKRO(bool state) { nkro.useNKRO(state); }
 
 void SQUIDHID::use6KRO(bool state) { nkro.use6KRO(state); }
@@ -875,49 +1170,7 @@ void SQUIDHID::release(SpacemouseKey button) { spacemouse.release(button); }
 bool SQUIDHID::spacemouseIsPressed(SpacemouseKey button) { return spacemouse.isPressed(button); }
 
 void SQUIDHID::sendSpacemouseReport() { spacemouse.sendReport(); }
-
-
-// 3DConnexion reports interfere with other pointers, so I'm using the 3DConnexion report to emulate the other pointers whenever necessary to get around that
-#if MOUSE_ENABLE
-void SQUIDHID::click(SpacemouseKey b) { spacemouse.click(b); }
-
-void SQUIDHID::move(int16_t x, int16_t y, int16_t wheel, int16_t hWheel) { spacemouse.move(x, y, wheel, hWheel); }
-
-void SQUIDHID::sendMouseReport() { spacemouse.sendReport(); }
-#endif
-
-#if DIGITIZER_ENABLE
-void SQUIDHID::click(uint16_t x, uint16_t y, SpacemouseKey b) { spacemouse.click(x, y, b); }
-
-void SQUIDHID::moveTo(uint16_t x, uint16_t y, uint8_t pressure, SpacemouseKey buttons) { spacemouse.moveTo(x, y, pressure, buttons); }
-
-void SQUIDHID::beginStroke(uint16_t x, uint16_t y, uint16_t initialPressure) { spacemouse.beginStroke(x, y, initialPressure); }
-
-void SQUIDHID::updateStroke(uint16_t x, uint16_t y, uint16_t pressure) { spacemouse.updateStroke(x, y, pressure); }
-
-void SQUIDHID::endStroke(uint16_t x, uint16_t y) { spacemouse.endStroke(x, y); }
-
-void SQUIDHID::setDigitizerRange(uint16_t maxX, uint16_t maxY) { spacemouse.setDigitizerRange(maxX, maxY); }
-
-void SQUIDHID::sendDigitizerReport() { spacemouse.sendReport(); }
-#endif
-
-#if GAMEPAD_ENABLE
-void SQUIDHID::setLeftStick(int16_t x, int16_t y) { spacemouse.gamepadSetLeftStick(x, y); }
-
-void SQUIDHID::setRightStick(int16_t x, int16_t y) { spacemouse.gamepadSetRightStick(x, y); }
-
-void SQUIDHID::setTriggers(int16_t left, int16_t right) { spacemouse.gamepadSetTriggers(left, right); }
-
-void SQUIDHID::gamepadSetAxis(SpacemouseAnalogue axis, int16_t value) { spacemouse.gamepadSetAxis(axis, value); }
-
-int16_t SQUIDHID::gamepadGetAxis(SpacemouseAnalogue axis) { return spacemouse.gamepadGetAxis(axis); }
-
-void SQUIDHID::gamepadSetAllAxes(int16_t values[6]) { spacemouse.gamepadSetAllAxes(values); }
-
-void SQUIDHID::sendGamepadReport() { spacemouse.sendReport(); }
 #endif
-#else
 
 //
 // ----------------------------------------- Mouse Block
@@ -930,7 +1183,11 @@ size_t SQUIDHID::release(MouseKey b) { return mouse.release(b); }
 
 void SQUIDHID::click(MouseKey b) { mouse.click(b); }
 
-void SQUIDHID::move(int8_t x, int8_t y, int8_t wheel, int8_t hWheel) { mouse.move(x, y, wheel, hWheel); }
+void SQUIDHID::move(MouseAxis x, MouseAxis y, int8_t wheel, int8_t hWheel) { mouse.move(x, y, wheel, hWheel); }
+
+void SQUIDHID::accumulateMouse(int32_t x, int32_t y, int32_t wheel, int32_t hWheel) { mouse.accumulate(x, y, wheel, hWheel); }
+
+void SQUIDHID::accumulateMouseFixed(int32_t x, int32_t y, int32_t wheel, int32_t hWheel) { mouse.accumulateFixed(x, y, wheel, hWheel); }
 
 bool SQUIDHID::mouseIsPressed(MouseKey b) { return mouse.mouseIsPressed(b); }
 
@@ -941,10 +1198,10 @@ void SQUIDHID::sendMouseReport() { mouse.sendMouseReport(); }
 // ----------------------------------------- Digitizer Block
 //
 
-#if DIGITIZER_ENABLE
+#if DIGITIZER_ENABLE && !DIGITIZER_TOUCHPAD
 void SQUIDHID::click(uint16_t x, uint16_t y, DigitizerKey b) { digitizer.click(x, y, b); }
 
-void SQUIDHID::moveTo(uint16_t x, uint16_t y, uint8_t pressure, DigitizerKey buttons) { digitizer.moveTo(x, y, pressure, buttons); }
+void SQUIDHID::moveTo(uint16_t x, uint16_t y, uint16_t pressure, DigitizerKey buttons) { digitizer.moveTo(x, y, pressure, buttons); }
 
 void SQUIDHID::beginStroke(uint16_t x, uint16_t y, uint16_t initialPressure) { digitizer.beginStroke(x, y, initialPressure); }
 
@@ -955,6 +1212,16 @@ void SQUIDHID::endStroke(uint16_t x, uint16_t y) { digitizer.endStroke(x, y); }
 void SQUIDHID::setDigitizerRange(uint16_t maxX, uint16_t maxY) { digitizer.setDigitizerRange(maxX, maxY); }
 
 void SQUIDHID::sendDigitizerReport() { digitizer.sendDigitizerReport(); }
+
+void SQUIDHID::setPressureRange(uint16_t maxPressure) { digitizer.setPressureRange(maxPressure); }
+#endif
+
+#if DIGITIZER_ENABLE && DIGITIZER_TOUCHPAD
+void SQUIDHID::touchFrame(const TouchPoint* points, uint8_t count, bool button) { digitizer.touchFrame(points, count, button); }
+
+void SQUIDHID::setTouchpadType(TouchpadType type) { digitizer.setPadType(type); }
+
+bool SQUIDHID::setTouchpadCertification(const uint8_t* blob, size_t length) { return digitizer.setCertificationBlob(blob, length); }
 #endif
 
 //
@@ -985,7 +1252,12 @@ int16_t SQUIDHID::gamepadGetAxis(GamepadAnalogue axis) { return gamepad.gamepadG
 void SQUIDHID::gamepadSetAllAxes(int16_t values[GAMEPAD_ANALOGUE_COUNT]) { gamepad.gamepadSetAllAxes(values); }
 
 void SQUIDHID::sendGamepadReport() { gamepad.sendGamepadReport(); }
-#endif
+
+void SQUIDHID::setGamepadPollRate(uint16_t hz) { gamepad.setPollRate(hz); }
+
+void SQUIDHID::setGamepadAxisHysteresis(GamepadAnalogue axis, uint16_t counts) { gamepad.setAxisHysteresis(axis, counts); }
+
+void SQUIDHID::setGamepadAxisQuantisation(GamepadAnalogue axis, uint8_t bits) { gamepad.setAxisQuantisation(axis, bits); }
 #endif
 
 //
@@ -1000,6 +1272,12 @@ size_t SQUIDHID::release(StenoKey stenoKey) { return steno.release(stenoKey); }
 void SQUIDHID::stenoStroke(const StenoKey* keys, size_t count) { steno.stenoStroke(keys, count); }
 
 void SQUIDHID::sendStenoReport() { steno.sendStenoReport(); }
+
+void SQUIDHID::setStenoMode(StenoMode mode) { steno.setMode(mode); }
+
+void SQUIDHID::setStenoSerial(Stream* serial) { steno.setSerial(serial); }
+
+bool SQUIDHID::setStenoDictionary(const StenoDictionary* dict) { return steno.setDictionary(dict); }
 #endif
 
 //
@@ -1018,10 +1296,27 @@ void SQUIDHID::initializeLEDs(uint16_t count, int16_t pin, neoPixelType type) {
     ledsDirty = true;  // Mark as dirty on initialization
     
     leds = new NeoPixel(count, pin, type);
+    ledEffects.begin(leds);
     
     SQUID_LOG_INFO(MAIN_TAG, "LED driver initialized for %d LEDs on pin %d", count, pin);
 }
 
+// For anything that isn't a WS2812 on an RMT pin, e.g. initializeLEDs(60, new LEDSPIBus(data, clock))
+void SQUIDHID::initializeLEDs(uint16_t count, LEDBus* bus, neoPixelType type) {
+    if (leds) {
+        delete leds;
+    }
+    
+    ledCount = count;
+    ledType = type;
+    ledsDirty = true;
+    
+    leds = new NeoPixel(count, bus, type, true);
+    ledEffects.begin(leds);
+    
+    SQUID_LOG_INFO(MAIN_TAG, "LED driver initialized for %d LEDs on a custom bus", count);
+}
+
 void SQUIDHID::setLEDColor(uint16_t index, uint32_t color) {
     if (leds && index < ledCount) {
         leds->setPixelColor(index, color);
@@ -1060,7 +1355,7 @@ void SQUIDHID::clearLEDs() {
 }
 
 void SQUIDHID::showLEDs() {
-    if (leds && leds->canShow()) {
+    if (leds) {
         leds->show();
         ledsDirty = false;  // Clear dirty flag after showing
     }
@@ -1073,6 +1368,13 @@ void SQUIDHID::setLEDBrightness(uint8_t brightness) {
     }
 }
 
+void SQUIDHID::setLEDGamma(bool enable) {
+    if (leds) {
+        leds->setGamma(enable);
+        ledsDirty = true;
+    }
+}
+
 void SQUIDHID::rainbowLEDs(uint16_t first_hue, int8_t reps, uint8_t saturation, uint8_t brightness, bool gammify) {
     if (leds) {
         leds->rainbow(first_hue, reps, saturation, brightness, gammify);
@@ -1085,11 +1387,52 @@ bool SQUIDHID::ledsCanShow() {
 }
 
 void SQUIDHID::updateLEDs() {
-    if (ledsDirty && leds && leds->canShow()) { // LEDs only update when dirty
+    if (ledsDirty && leds) { // LEDs only update when dirty
         leds->show();
         ledsDirty = false;
     }
 }
+
+void SQUIDHID::setLockLED(LEDBits bit, int16_t index, uint32_t color) {
+    for (uint8_t i = 0; i < 5; i++) {
+        if (bit == (1 << i)) {
+            // Hand the old LED back dark rather than leaving it stuck on
+            if (leds && lockLEDIndex[i] >= 0 && lockLEDIndex[i] != index) {
+                leds->setPixelColor(lockLEDIndex[i], 0);
+                ledsDirty = true;
+            }
+            lockLEDIndex[i] = index;
+            lockLEDColor[i] = color;
+            applyLockLEDs(bit);
+            return;
+        }
+    }
+}
+
+void SQUIDHID::applyLockLEDs(uint8_t changed) {
+    if (!leds) return;
+    
+    for (uint8_t i = 0; i < 5; i++) {
+        if (!(changed & (1 << i)) || lockLEDIndex[i] < 0) continue;
+        
+        if (hostLEDs.get() & (1 << i)) {
+            leds->setPixelColor(lockLEDIndex[i], lockLEDColor[i]);
+        } else if (ledEffects.getEffect() == LEDEffects::EFFECT_NONE) {
+            leds->setPixelColor(lockLEDIndex[i], 0);  // With an effect running, its next frame fills this in
+        }
+        ledsDirty = true;
+    }
+}
+
+void SQUIDHID::setLEDEffect(LEDEffects::Effect effect, uint16_t hue, uint8_t sat, uint8_t val) {
+    ledEffects.setColor(hue, sat, val);
+    ledEffects.setEffect(effect);
+    if (effect == LEDEffects::EFFECT_NONE && leds) {
+        leds->clear();
+        ledsDirty = true;
+    }
+    SQUID_LOG_INFO(MAIN_TAG, "LED effect set to %d", (int)effect);
+}
 #endif
 
 //
@@ -1097,6 +1440,7 @@ void SQUIDHID::updateLEDs() {
 //
 
 #if OLED_ENABLE
+#if I2C_ENABLE
 void SQUIDHID::initializeOLED(uint8_t sda_pin, uint8_t scl_pin, 
                              uint_fast8_t width, uint_fast8_t height,
                              OLED::tDisplayCtrl displayCtrl, uint8_t i2c_address) 
@@ -1118,15 +1462,40 @@ void SQUIDHID::initializeOLED(uint8_t sda_pin, uint8_t scl_pin,
     SQUID_LOG_INFO(MAIN_TAG, "OLED driver initialized on SDA:%d SCL:%d, Size: %dx%d", 
                    sda_pin, scl_pin, displayWidth, displayHeight);
 }
+#endif
+
+void SQUIDHID::initializeOLED(OLEDBus* bus, uint_fast8_t width, uint_fast8_t height,
+                             OLED::tDisplayCtrl displayCtrl)
+{
+    if (oledDisplay) {
+        delete oledDisplay;
+    }
+    
+    uint_fast8_t displayWidth = (width == 0) ? 
+                               (OLED_WIDTH > 0 ? OLED_WIDTH : 128) : width;
+    uint_fast8_t displayHeight = (height == 0) ? 
+                                (OLED_HEIGHT > 0 ? OLED_HEIGHT : 64) : height;
+    
+    // The display owns the bus from here on
+    oledDisplay = new OLED(bus, displayWidth, displayHeight, displayCtrl, true);
+    oledInitialized = false;
+    oledDirty = true;
+    
+    SQUID_LOG_INFO(MAIN_TAG, "OLED driver initialized on a custom bus, Size: %dx%d", 
+                   displayWidth, displayHeight);
+}
 
 void SQUIDHID::oledClear(OLED::tColor color) {
     if (oledDisplay && oledInitialized) {
+        oledSplashUntil = 0;  // Whatever the sketch draws from here on is what stays up
         oledDisplay->clear(color);
+        oledWidgets.invalidate();  // Anything still showing gets drawn back in
         oledDirty = true;  // Mark as dirty when cleared
     }
 }
 void SQUIDHID::oledDisplayUpdate() {
     if (oledDisplay && oledInitialized) {
+        oledSplashUntil = 0;
         oledDisplay->display();
         oledDirty = false;  // Clear dirty flag on updates
     }
@@ -1146,6 +1515,7 @@ void SQUIDHID::oledSetCursor(uint_fast8_t x, uint_fast8_t y) {
 
 void SQUIDHID::oledDrawString(uint_fast8_t x, uint_fast8_t y, const char* s, OLED::tFontScaling scaling, OLED::tColor color) {
     if (oledDisplay && oledInitialized) {
+        oledSplashUntil = 0;
         oledDisplay->draw_string(x, y, s, scaling, color);
         oledDirty = true;  // Mark as dirty when drawing stuff
     }
@@ -1153,6 +1523,7 @@ void SQUIDHID::oledDrawString(uint_fast8_t x, uint_fast8_t y, const char* s, OLE
 
 void SQUIDHID::oledDrawString_P(uint_fast8_t x, uint_fast8_t y, const char* s, OLED::tFontScaling scaling, OLED::tColor color) {
     if (oledDisplay && oledInitialized) {
+        oledSplashUntil = 0;
         oledDisplay->draw_string_P(x, y, s, scaling, color);
         oledDirty = true;  // Mark as dirty when drawing stuff
     }
@@ -1175,8 +1546,10 @@ size_t SQUIDHID::oledPrintf(uint_fast8_t x, uint_fast8_t y, const char *format,
         va_end(arg);
     }
     
+    oledSplashUntil = 0;
     oledDisplay->setCursor(x, y);
     len = oledDisplay->write((const uint8_t*) buffer, len);
+    oledDirty = true;
     
     if (buffer != temp) delete[] buffer;
     return len;
@@ -1199,6 +1572,7 @@ size_t SQUIDHID::oledPrintf(const char *format, ...) {
         va_end(arg);
     }
     
+    oledSplashUntil = 0;
     len = oledDisplay->write((const uint8_t*) buffer, len);
     oledDirty = true;  // Mark as dirty when drawing stuff
     if (buffer != temp) delete[] buffer;
@@ -1211,8 +1585,46 @@ void SQUIDHID::oledSetTTYMode(bool enabled) {
     }
 }
 
+void SQUIDHID::oledLogConsole(bool enabled, LogLevel level) {
+    if (!oledDisplay || !oledInitialized) return;
+    
+    oledConsoleLevel = level;
+    if (enabled == oledConsole) return;
+    oledConsole = enabled;
+    oledSplashUntil = 0;
+    oledDisplay->clear(OLED::BLACK);
+    oledDisplay->setCursor(0, 0);
+    oledDisplay->setTTYMode(enabled);
+    oledDirty = true;
+    
+    if (!enabled) {
+        oledWidgets.invalidate();  // Bring the status screen back on the next update
+        return;
+    }
+    
+    if (oledConsoleSink < 0) {
+        // Sinks run from processQueue(), which update() calls, so this never draws from another task
+        oledConsoleSink = (int) SQUIDLOGS::getInstance().addSink([this](const LogEntry& entry) {
+            if (!oledConsole || !oledDisplay) return;
+            if (static_cast<int>(entry.level) > static_cast<int>(oledConsoleLevel)) return;
+            
+            static const char LEVEL_CHARS[] = "-EWIDV";
+            char line[64];
+            int len = snprintf(line, sizeof(line), "%c %s: %s\n", LEVEL_CHARS[static_cast<int>(entry.level) % 6],
+                               entry.tag.c_str(), entry.message.c_str());
+            if (len <= 0) return;
+            if (len >= (int) sizeof(line)) {
+                len = sizeof(line) - 1;
+                line[len - 1] = '\n';
+            }
+            oledDisplay->write((const uint8_t*) line, len);
+        });
+    }
+}
+
 void SQUIDHID::oledDrawBitmap(uint_fast8_t x, uint_fast8_t y, uint_fast8_t width, uint_fast8_t height, const uint8_t* data, OLED::tColor color) {
     if (oledDisplay && oledInitialized) {
+        oledSplashUntil = 0;
         oledDisplay->draw_bitmap(x, y, width, height, data, color);
         oledDirty = true;  // Mark as dirty when drawing stuff
     }
@@ -1220,6 +1632,7 @@ void SQUIDHID::oledDrawBitmap(uint_fast8_t x, uint_fast8_t y, uint_fast8_t width
 
 void SQUIDHID::oledDrawBitmap_P(uint_fast8_t x, uint_fast8_t y, uint_fast8_t width, uint_fast8_t height, const uint8_t* data, OLED::tColor color) {
     if (oledDisplay && oledInitialized) {
+        oledSplashUntil = 0;
         oledDisplay->draw_bitmap_P(x, y, width, height, data, color);
         oledDirty = true;  // Mark as dirty when drawing stuff
     }
@@ -1241,52 +1654,100 @@ void SQUIDHID::oledShowSquidLogo(OLED::tColor color) {
         oledDisplay->draw_bitmap_P(x_pos, y_pos, 64, 64, simple_squid, color);
     }
     
-    oledDisplay->display();
-    oledDirty = false;  // Clear dirty flag whenever it finishes displaying something
+    oledDirty = true;  // update() flushes it, no point blocking here
 }
 
 void SQUIDHID::oledShowConnectionStatus(bool connected) {
     if (!oledDisplay || !oledInitialized) return;
     
-    oledDisplay->clear(OLED::BLACK);
-    
-    if (connected) {
-        oledDisplay->draw_string(20, 0, "Connected", OLED::NORMAL_SIZE, OLED::WHITE);
-        oledDisplay->draw_string(10, 16, deviceName.c_str(), OLED::NORMAL_SIZE, OLED::WHITE);
-    } else {
-        oledDisplay->draw_string(15, 0, "Disconnected", OLED::NORMAL_SIZE, OLED::WHITE);
-        oledDisplay->draw_string(10, 16, "Advertising...", OLED::NORMAL_SIZE, OLED::WHITE);
-    }
-    
-    // Show battery level
-    char battStr[20];
-    snprintf(battStr, sizeof(battStr), "Battery: %d%%", batteryLevel);
-    oledDisplay->draw_string(10, 32, battStr, OLED::NORMAL_SIZE, OLED::WHITE);
-    
-    oledDisplay->display();
-    oledDirty = false;  // Clear dirty flag whenever it finishes displaying something
+    // The labels only redraw if the text changed, update() renders and flushes them
+    oledStatusLabel.set(connected ? "Connected" : "Disconnected");
+    oledNameLabel.set(connected ? deviceName.c_str() : "Advertising...");
+    oledBatteryLabel.setf("Battery: %d%%", batteryLevel);
 }
 
 void SQUIDHID::oledShowBatteryLevel(uint8_t level) {
     if (!oledDisplay || !oledInitialized) return;
     
-    char battStr[20];
-    snprintf(battStr, sizeof(battStr), "Battery: %d%%", level);
-    
-    oledDisplay->draw_string(10, 32, battStr, OLED::NORMAL_SIZE, OLED::WHITE);
-    oledDisplay->display();
-    oledDirty = false;  // Clear dirty flag whenever it finishes displaying something
+    oledBatteryLabel.setf("Battery: %d%%", level);
 }
 
 void SQUIDHID::oledShowLayerInfo(uint8_t layer) {
     if (!oledDisplay || !oledInitialized) return;
     
-    char layerStr[20];
-    snprintf(layerStr, sizeof(layerStr), "Layer: %d", layer);
+    oledLayerLabel.setf("Layer: %d", layer);
+}
+
+void SQUIDHID::oledShowLockState(uint8_t leds) {
+    if (!oledDisplay || !oledInitialized) return;
+    
+    oledLockLabel.setf("%s%s%s",
+                       (leds & LED_NUM_LOCK)    ? "NUM "  : "",
+                       (leds & LED_CAPS_LOCK)   ? "CAPS " : "",
+                       (leds & LED_SCROLL_LOCK) ? "SCRL"  : "");
+}
+#endif
+
+//
+// ----------------------------------------- Analog Block
+//
+
+#if ANALOG_ENABLE
+void SQUIDHID::mapAnalogAxis(uint8_t axis, int8_t channel) {
+    if (axis >= 6) return;
+    analogAxisMap[axis] = channel < ANALOG_MAX_CHANNELS ? channel : -1;
+    analogPending = true;
+}
+
+void SQUIDHID::setAnalogReportRate(uint16_t hz) {
+    if (!hz) return;
+    analogReportInterval = 1000000 / hz;
+    SQUID_LOG_DEBUG(ANALOG_TAG, "Analog report rate set to %dHz", hz);
+}
+
+void SQUIDHID::publishAnalog() {
+    int16_t values[6] = {0};
+    
+    #if SPACEMOUSE_ENABLE
+    // The puck gets the axes when its profile's on, otherwise they go to the gamepad
+    if (features.isActive(HID_FEATURE_SPACEMOUSE)) {
+        // Same as the gamepad, axes nobody mapped keep whatever the sketch moved them to
+        for (uint8_t i = 0; i < 6; i++) {
+            values[i] = analogAxisMap[i] >= 0 ? analog.value(analogAxisMap[i])
+                                              : spacemouse.getAxis(i);
+        }
+        // Only changed sub-reports actually go out
+        spacemouse.move(values[0], values[1], values[2], values[3], values[4], values[5]);
+        return;
+    }
+    #endif
     
-    oledDisplay->draw_string(10, 48, layerStr, OLED::NORMAL_SIZE, OLED::WHITE);
-    oledDisplay->display();
-    oledDirty = false;  // Clear dirty flag whenever it finishes displaying something
+    #if GAMEPAD_ENABLE
+    // Axes nobody mapped keep whatever the sketch set them to
+    for (uint8_t i = 0; i < GAMEPAD_ANALOGUE_COUNT; i++) {
+        values[i] = analogAxisMap[i] >= 0 ? analog.value(analogAxisMap[i])
+                                          : gamepad.gamepadGetAxis(GamepadAnalogue(i));
+    }
+    gamepad.gamepadSetAllAxes(values);
+    #endif
+}
+#endif
+
+//
+// ----------------------------------------- Pointer Block
+//
+
+#if POINTER_ENABLE
+bool SQUIDHID::initializePointer(PointerSensor* sensor, int8_t motionPin) {
+    // Every count goes through the accumulator, the mouse sends it at whatever rate the transport runs at
+    pointer.onMotion([this](int16_t dx, int16_t dy) {
+        mouse.accumulate(dx, dy);
+    });
+    if (!pointer.begin(sensor, motionPin)) {
+        SQUID_LOG_ERROR(MAIN_TAG, "Failed to initialize pointer sensor");
+        return false;
+    }
+    return true;
 }
 #endif
 
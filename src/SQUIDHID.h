@@ -7,6 +7,11 @@
 #define SQUIDHID_H
 
 #include "drivers/Software/Basic/Keymap/Keymap.h"
+#include "drivers/Software/HID/HostLEDs.h"
+
+#if ANALOG_MATRIX_ENABLE
+  #include "drivers/Software/Basic/Matrix/AnalogMatrix.h"
+#endif
 
 #if TRANSPORT == USB
   #include "drivers/Software/Transport/USB/USBTransport.h"
@@ -28,7 +33,7 @@
 
 #if SPACEMOUSE_ENABLE
   #include "features/Spacemouse/Spacemouse.h"
-#else
+#endif
 
 #if MOUSE_ENABLE
   #include "features/Mouse/Mouse.h"
@@ -41,7 +46,6 @@
 #if GAMEPAD_ENABLE
   #include "features/Gamepad/Gamepad.h"
 #endif
-#endif
 
 #if STENO_ENABLE
   #include "features/Steno/Steno.h"
@@ -49,16 +53,36 @@
 
 #if LED_ENABLE
   #include "drivers/Hardware/LED/NeoPixel.h"
+  #include "drivers/Hardware/LED/LEDEffects.h"
 #endif
 
 #if OLED_ENABLE
-  #include "drivers/Hardware/OLED/OLED.h"
+  #include "drivers/Hardware/OLED/OLEDWidgets.h"
+  #ifndef OLED_BUS
+    #define OLED_BUS OLED_BUS_SOFT_I2C
+  #endif
+  #if OLED_BUS == OLED_BUS_I2C
+    #include <Wire.h>
+  #elif OLED_BUS == OLED_BUS_SPI
+    #include <SPI.h>
+  #endif
 #endif
 
 #if MCP_ENABLE
   #include "drivers/Hardware/Expander/MCP/MCP23XXX.h"
 #endif
 
+#if ANALOG_ENABLE
+  #include "drivers/Hardware/Analog/Analog.h"
+#endif
+
+#if POINTER_ENABLE
+  #if !MOUSE_ENABLE
+    #error "The pointer sensor drives the mouse, turn on MOUSE_ENABLE"
+  #endif
+  #include "drivers/Hardware/Pointer/Pointer.h"
+#endif
+
 // These are used for the status LEDs, they aren't technically part of the NeoPixel driver
 enum LEDBits {
     LED_NUM_LOCK       = 0x01,
@@ -83,6 +107,20 @@ private:
   
   SQUIDMATRIX                 matrix;
   SQUIDKEYMAP                 keymap;
+  #if ANALOG_MATRIX_ENABLE
+    SQUIDANALOGMATRIX         analogMatrix;
+  #endif
+  HIDFeatureRegistry          features;
+  uint32_t                    savedProfile = 0;   // From NVS, 0 if nothing's been saved
+  bool                        profileRequested = false;   // The sketch picked one before begin()
+  bool                        started = false;
+  
+  Transport*                  featureTransport(uint32_t feature);
+  void                        attachFeatures();
+  void                        loadFeatureProfile();
+  void                        saveFeatureProfile(uint32_t profile);
+  static uint32_t             featureFor(KeypressType type);
+  void                        handleSwitch(size_t switch_index, bool pressed);
   bool                        isMCPPin(uint8_t pin) const;
   uint8_t                     toMCPPin(uint8_t pin) const;
   
@@ -99,7 +137,7 @@ private:
   
   #if SPACEMOUSE_ENABLE
     SQUIDSPACEMOUSE           spacemouse;
-  #else
+  #endif
   
   #if MOUSE_ENABLE
     SQUIDMOUSE                mouse;
@@ -112,7 +150,6 @@ private:
   #if GAMEPAD_ENABLE
     SQUIDGAMEPAD              gamepad;
   #endif
-  #endif
   
   #if STENO_ENABLE
     SQUIDSTENO                steno;
@@ -126,14 +163,48 @@ private:
     bool         ledOverrideActive;
     uint32_t     ledOverrideColor;
     bool         ledsDirty;
+    LEDEffects   ledEffects;
+    int16_t      lockLEDIndex[5];   // One per LEDBits bit, -1 if that lock hasn't got an LED
+    uint32_t     lockLEDColor[5];
   #endif
   
   #if OLED_ENABLE
     OLED*        oledDisplay;
     bool         oledInitialized;
     bool         oledDirty;
+    uint32_t     oledSplashUntil;  // 0 once the splash has been taken down
+    bool         oledConsole;      // Log lines go to the screen instead of the status widgets
+    LogLevel     oledConsoleLevel;
+    int          oledConsoleSink;  // -1 until the console has been hooked into SQUIDLOGS
+    
+    // Status screen - each line only redraws when its text actually changes
+    OLEDCompositor oledWidgets;
+    OLEDLabel    oledStatusLabel;
+    OLEDLabel    oledNameLabel;
+    OLEDLabel    oledBatteryLabel;
+    OLEDLabel    oledLayerLabel;
+    OLEDLabel    oledLockLabel;
+  #endif
+  
+  #if ANALOG_ENABLE
+    SQUIDANALOG  analog;
+    int8_t       analogAxisMap[6];   // Sampler channel per report axis, -1 if that axis isn't driven
+    uint32_t     analogReportInterval;
+    uint32_t     analogLastReport;
+    bool         analogPending;      // Something moved since the last report went out
+    void         publishAnalog();
   #endif
   
+  #if POINTER_ENABLE
+    SQUIDPOINTER pointer;
+  #endif
+  
+    // Host lock state as LEDBits. Output reports land on the BLE/USB stack's task, so they only
+    // post the bits here and update() fans out whatever changed.
+    HostLEDs     hostLEDs;
+    std::function<void(uint8_t leds, uint8_t changed)> hostLEDCallback;
+    void         applyHostLEDs();
+  
 public:
   SQUIDHID(std::string deviceName = "SquidHID", 
            std::string deviceManufacturer = "SquidHID", 
@@ -165,6 +236,14 @@ public:
   void        onConnect() override;
   void        onDisconnect() override;
   void        onDataReceived(const uint8_t* data, size_t length) override;
+  void        onOutputReport(uint8_t reportId, const uint8_t* data, size_t length) override;
+  
+  // Host lock LEDs (LEDBits) - setHostLEDs is what the output reports feed, callable directly too.
+  // Safe from any task, the LEDs, OLED and callback catch up on the next update().
+  void        setHostLEDs(uint8_t leds);
+  uint8_t     getHostLEDs() const { return hostLEDs.latest(); }   // Safe from any task
+  bool        isHostLEDOn(LEDBits bit) const { return hostLEDs.latest() & bit; }
+  void        onHostLEDs(std::function<void(uint8_t leds, uint8_t changed)> callback) { hostLEDCallback = callback; }
   
   void        begin(const squid_matrix& matrix, const std::vector<std::vector<LayerKeymapEntry>>& layers);
   void        begin(void);
@@ -177,6 +256,14 @@ public:
 
   void        setAppearance(uint16_t newAppearance);
   
+  // Runtime feature profiles - pick from whatever config.h compiled in
+  // A transport that can't re-enumerate (USB) keeps the running profile, saves the new one and returns false,
+  // begin() applies it on the next boot. One set before begin() wins over a saved one, and clears it.
+  bool        setFeatureProfile(uint32_t profile);
+  uint32_t    getFeatureProfile() const { return features.active(); }
+  uint32_t    getAvailableFeatures() const { return features.available(); }
+  bool        isFeatureActive(uint32_t feature) const { return features.isActive(feature); }
+  
   void        releaseAll();
   
   // BLE helper functions
@@ -203,6 +290,12 @@ public:
   uint8_t     getActiveLayer() const;
   bool        isLayerActive(uint8_t layer) const;
   
+  #if ANALOG_MATRIX_ENABLE
+    // Hall effect keys behind muxes, numbered in the keymap after any digital matrix switches
+    bool      setupAnalogMatrix(const AnalogMuxConfig& config);
+    SQUIDANALOGMATRIX& getAnalogMatrix() { return analogMatrix; }  // Actuation, rapid trigger and calibration per key
+  #endif
+  
   // Combo management
   void addCombo(const KeyComboConfig& combo);
   void setCombos(const std::vector<KeyComboConfig>& combos);
@@ -218,6 +311,8 @@ public:
     size_t    write(uint8_t c);
     size_t    write(ModKey modifier);
     size_t    write(ShiftedKey shiftedKey);
+    size_t    write(const uint8_t* buffer, size_t size);
+    size_t    print(const char* text);
     void      useNKRO(bool state = enabled);
     void      use6KRO(bool state = enabled);
     bool      isNKROEnabled();
@@ -240,51 +335,38 @@ public:
     void      release(SpacemouseKey button);
     bool      spacemouseIsPressed(SpacemouseKey button);
     void      sendSpacemouseReport();
-    
-    #if MOUSE_ENABLE
-    void      click(SpacemouseKey b = MO_BTN1);
-    void      move(int16_t x, int16_t y, int16_t wheel = 0, int16_t hWheel = 0);
-    void      sendMouseReport();
-    #endif
-    
-    #if DIGITIZER_ENABLE
-    void      click(uint16_t x, uint16_t y, SpacemouseKey b = DI_BTN1);
-    void      moveTo(uint16_t x, uint16_t y, uint8_t pressure = 0, SpacemouseKey buttons = SpacemouseKey{0});
-    void      beginStroke(uint16_t x, uint16_t y, uint16_t initialPressure = 127);
-    void      updateStroke(uint16_t x, uint16_t y, uint16_t pressure);
-    void      endStroke(uint16_t x, uint16_t y);
-    void      setDigitizerRange(uint16_t maxX, uint16_t maxY);
-    void      sendDigitizerReport();
-    #endif
-    
-    #if GAMEPAD_ENABLE
-    void      setLeftStick(int16_t x, int16_t y);
-    void      setRightStick(int16_t x, int16_t y);
-    void      setTriggers(int16_t left, int16_t right);
-    void      gamepadSetAxis(SpacemouseAnalogue axis, int16_t value);
-    int16_t   gamepadGetAxis(SpacemouseAnalogue axis);
-    void      gamepadSetAllAxes(int16_t values[6]);
-    void      sendGamepadReport();
-    #endif
-  #else
+  #endif
   
     #if MOUSE_ENABLE
     size_t    press(MouseKey b = MO_BTN1);
     size_t    release(MouseKey b = MO_BTN1);
     void      click(MouseKey b = MO_BTN1);
-    void      move(int8_t x, int8_t y, int8_t wheel = 0, int8_t hWheel = 0);
+    void      move(MouseAxis x, MouseAxis y, int8_t wheel = 0, int8_t hWheel = 0);
+    // Summed with carry and sent at the transport's report rate, for sensors, trackballs and anything fractional
+    void      accumulateMouse(int32_t x, int32_t y, int32_t wheel = 0, int32_t hWheel = 0);
+    void      accumulateMouseFixed(int32_t x, int32_t y, int32_t wheel = 0, int32_t hWheel = 0);
     bool      mouseIsPressed(MouseKey b = MO_BTN1);
     void      sendMouseReport();
+    MouseKeyEngine& getMouseKeys() { return mouse.mouseKeys(); }  // Mode, acceleration curves and friction for MO_UP etc.
     #endif
   
-    #if DIGITIZER_ENABLE
+    #if DIGITIZER_ENABLE && !DIGITIZER_TOUCHPAD
     void      click(uint16_t x, uint16_t y, DigitizerKey b = DI_BTN1);
-    void      moveTo(uint16_t x, uint16_t y, uint8_t pressure = 0, DigitizerKey buttons = DigitizerKey{0});
+    void      moveTo(uint16_t x, uint16_t y, uint16_t pressure = 0, DigitizerKey buttons = DigitizerKey{0});
     void      beginStroke(uint16_t x, uint16_t y, uint16_t initialPressure = 127);
     void      updateStroke(uint16_t x, uint16_t y, uint16_t pressure);
     void      endStroke(uint16_t x, uint16_t y);
     void      setDigitizerRange(uint16_t maxX, uint16_t maxY);
     void      sendDigitizerReport();
+    void      setPressureRange(uint16_t maxPressure);
+    StrokePipeline& getDigitizerStroke() { return digitizer.stroke(); }  // Smoothing (1-euro, Catmull-Rom) and input rate
+    #endif
+    
+    #if DIGITIZER_ENABLE && DIGITIZER_TOUCHPAD
+    void      touchFrame(const TouchPoint* points, uint8_t count, bool button = false);
+    void      setTouchpadType(TouchpadType type);
+    bool      setTouchpadCertification(const uint8_t* blob, size_t length = TOUCHPAD_CERT_SIZE);
+    ContactTracker& getTouchTracker() { return digitizer.tracker(); }  // How far a finger can move between scans and still be the same finger
     #endif
   
     #if GAMEPAD_ENABLE
@@ -300,19 +382,26 @@ public:
     int16_t   gamepadGetAxis(GamepadAnalogue axis);
     void      gamepadSetAllAxes(int16_t values[GAMEPAD_ANALOGUE_COUNT]);
     void      sendGamepadReport();
+    // Axis changes go out from update() at this rate, and only when the host would see a difference
+    void      setGamepadPollRate(uint16_t hz);
+    void      setGamepadAxisHysteresis(GamepadAnalogue axis, uint16_t counts);
+    void      setGamepadAxisQuantisation(GamepadAnalogue axis, uint8_t bits);
     #endif     
-  #endif
     
   #if STENO_ENABLE
     size_t    press(StenoKey stenoKey);
     size_t    release(StenoKey stenoKey);
     void      stenoStroke(const StenoKey* keys, size_t count);
     void      sendStenoReport();
+    void      setStenoMode(StenoMode mode);
+    void      setStenoSerial(Stream* serial);
+    bool      setStenoDictionary(const StenoDictionary* dict);  // Has to stay around, it's read in place
   #endif
              
   #if LED_ENABLE
     NeoPixel* leds;
     void      initializeLEDs(uint16_t count, int16_t pin = 6, neoPixelType type = NEO_GRB);
+    void      initializeLEDs(uint16_t count, LEDBus* bus, neoPixelType type = NEO_BGR);
     void      setLEDColor(uint16_t index, uint32_t color);
     void      setLEDColor(uint16_t index, uint8_t r, uint8_t g, uint8_t b);
     void      fillLEDs(uint8_t r, uint8_t g, uint8_t b);
@@ -320,19 +409,32 @@ public:
     void      clearLEDs();
     void      showLEDs();
     void      setLEDBrightness(uint8_t brightness);
+    void      setLEDGamma(bool enable);
     void      rainbowLEDs(uint16_t first_hue = 0, int8_t reps = 1, uint8_t saturation = 255, uint8_t brightness = 255, bool gammify = true);
     bool      ledsCanShow();
     void      markLEDsDirty() { ledsDirty = true; }
     void      updateLEDs();
+    // Anything but EFFECT_NONE takes the strip over from the manual LED functions above
+    void      setLEDEffect(LEDEffects::Effect effect, uint16_t hue = 0, uint8_t sat = 255, uint8_t val = 255);
+    LEDEffects& getLEDEffects() { return ledEffects; }
+    // Lights LED `index` in `color` while the host has that lock on, -1 to unassign
+    void      setLockLED(LEDBits bit, int16_t index, uint32_t color = 0xFFFFFF);
+    void      applyLockLEDs(uint8_t changed = 0x1F);
   #endif
 
   #if OLED_ENABLE
+    #if I2C_ENABLE || (OLED_BUS == OLED_BUS_SPI && SPI_ENABLE)
     #if I2C_ENABLE
     void initializeOLED(uint8_t sda_pin, uint8_t scl_pin, 
                        uint_fast8_t width = OLED_WIDTH, 
                        uint_fast8_t height = OLED_HEIGHT,
                        OLED::tDisplayCtrl displayCtrl = SSD1306, 
                        uint8_t i2c_address = 0x3C);
+    #endif
+    void initializeOLED(OLEDBus* bus, 
+                       uint_fast8_t width = OLED_WIDTH, 
+                       uint_fast8_t height = OLED_HEIGHT,
+                       OLED::tDisplayCtrl displayCtrl = SSD1306);
     OLED*     getOLED() { return oledDisplay; }
     bool      isOLEDInitialized() { return oledInitialized; }
     void      oledClear(OLED::tColor color = OLED::BLACK);
@@ -344,18 +446,35 @@ public:
     size_t    oledPrintf(uint_fast8_t x, uint_fast8_t y, const char *format, ...);
     size_t    oledPrintf(const char *format, ...);
     void      oledSetTTYMode(bool enabled);
+    void      oledLogConsole(bool enabled, LogLevel level = LogLevel::INFO);  // Scroll SQUID_LOG output on the screen
     void      oledDrawBitmap(uint_fast8_t x, uint_fast8_t y, uint_fast8_t width, uint_fast8_t height, const uint8_t* data, OLED::tColor color = OLED::WHITE);
     void      oledDrawBitmap_P(uint_fast8_t x, uint_fast8_t y, uint_fast8_t width, uint_fast8_t height, const uint8_t* data, OLED::tColor color = OLED::WHITE);
     void      oledShowSquidLogo(OLED::tColor color = OLED::WHITE);
     void      oledShowConnectionStatus(bool connected);
     void      oledShowBatteryLevel(uint8_t level);
     void      oledShowLayerInfo(uint8_t layer);
+    void      oledShowLockState(uint8_t leds);
     void      markOLEDDirty() { oledDirty = true; }
+    OLEDCompositor& getOLEDWidgets() { return oledWidgets; }  // Add your own widgets, update() renders them
     #else
-      #error "You need to turn on I2C to use the I2C OLED driver!"
+      #error "You need to turn on I2C (or SPI with OLED_BUS_SPI) to use the OLED driver!"
     #endif
   #endif
 
+  #if ANALOG_ENABLE
+    SQUIDANALOG& getAnalog() { return analog; }  // beginADC/beginSource and the per-channel setup live here
+    // Report axis 0-5 (spacemouse TX..RZ, gamepad LX..RT) follows sampler `channel`, -1 hands it back to you
+    void      mapAnalogAxis(uint8_t axis, int8_t channel);
+    // Sampling keeps its own rate, this is just how often the latest values go to the host
+    void      setAnalogReportRate(uint16_t hz);
+  #endif
+
+  #if POINTER_ENABLE
+    // Takes ownership of the sensor, e.g. new PMW3360(new PointerSPI(SPI, CS_PIN), true)
+    bool      initializePointer(PointerSensor* sensor, int8_t motionPin = -1);
+    SQUIDPOINTER& getPointer() { return pointer; }  // CPI, angle snap and orientation live here
+  #endif
+
     LogLevel  getLogLevel() const;
     void      setLogLevel(LogLevel level);
     void      initialize(std::function<void(const LogEntry&)> handler = nullptr);
@@ -8,9 +8,13 @@
 #define MEDIA_ENABLE      true
 // #define STENO_ENABLE      true
 // #define MOUSE_ENABLE      true
+// #define MOUSE_16BIT       true  // 16 bit X/Y in the mouse report, for high CPI sensors
 // #define DIGITIZER_ENABLE  true
+// #define DIGITIZER_TOUCHPAD true  // Multi-touch Precision Touchpad instead of a pen
+// #define TOUCHPAD_REPORT_CONTACTS 2  // Fingers per report, fewer than 5 sends a frame over several reports but shrinks the descriptor
 // #define GAMEPAD_ENABLE    true
 // #define SPACEMOUSE_ENABLE true
+// #define SPACEMOUSE_COMBINED true  // One 6-axis report instead of separate translation/rotation ones
 
 #define LED_ENABLE        false
 // #define LED_PIN          20
@@ -19,6 +23,16 @@
 #define OLED_ENABLE       false
 // #define OLED_HEIGHT      64
 // #define OLED_WIDTH       128
+// #define OLED_BUS         OLED_BUS_I2C  // OLED_BUS_SOFT_I2C (default), OLED_BUS_I2C or OLED_BUS_SPI
+// #define OLED_DC_PIN      3             // SPI only
+// #define OLED_RST_PIN     2             // SPI only, leave out if reset is tied high
+
+// #define ANALOG_ENABLE     true  // Filtered analog axes (ADC or I2C sensors) driving the spacemouse or gamepad
+// #define ANALOG_MAX_CHANNELS 8
+
+// #define ANALOG_MATRIX_ENABLE true  // Hall effect keys read through analog muxes, with rapid trigger
+
+// #define POINTER_ENABLE    true  // PMW3360/PAW3395 optical sensor over SPI feeding the mouse, needs MOUSE_ENABLE
 
 #define MCP_ENABLE        false
 #define SHIFT_REGISTERS   false
@@ -13,6 +13,8 @@
 #include <map>
 
 #include "drivers/Software/HID/SquidHIDTypes.h"
+#include "drivers/Software/HID/HIDDescriptor.h"
+#include "drivers/Software/HID/FeatureRegistry.h"
 #include "drivers/Software/Event/Types.h"
 #include "drivers/Software/Log/Log.h"
 #include "drivers/Appearance.h"
@@ -27,12 +29,18 @@
 #define MOUSE_ID      0x06
 #define DIGITIZER_ID  0x07
 #define GAMEPAD_ID    0x08
+#define TOUCHPAD_CAPS_ID   0x0A   // Feature reports, only there when the digitizer's a touchpad
+#define TOUCHPAD_CERT_ID   0x0B
+#define TOUCHPAD_MODE_ID   0x0C
+#define TOUCHPAD_SWITCH_ID 0x0D
 #define STENO_ID      0x50
 
 // Logging Tags
 #define MAIN_TAG        "SQUIDHID"
 #define MATRIX_TAG      "SQUIDMATRIX"
 #define KEYMAP_TAG      "SQUIDKEYMAP"
+#define ANALOG_TAG      "SQUIDANALOG"
+#define POINTER_TAG     "SQUIDPOINTER"
 
 #define BLE_TAG         "SQUIDBLE"
 #define USB_TAG         "SQUIDUSB"
@@ -55,6 +63,12 @@
 // HID Data
 #define MAX_DESCRIPTOR_SIZE       512 // BLE has a 512 byte max so I just made that the global max
 
+// BLE Data
+#define BLE_DIRECTED_ADV_MS       1280 // High duty directed advertising is capped at 1.28s by the spec
+#define BLE_FAST_ADV_MIN          32   // 20ms, in 0.625ms units
+#define BLE_FAST_ADV_MAX          48   // 30ms
+#define BLE_DEFAULT_CONN_INTERVAL 7500 // us, the shortest the spec allows - most hosts end up at 7.5 to 15ms
+
 // Matrix Data
 #define SCAN_INTERVAL             1
 #define POLL_INTERVAL             250
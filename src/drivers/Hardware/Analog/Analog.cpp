@@ -0,0 +1,172 @@
+/**
+ * @file Analog.cpp
+ * @brief Implementation of the analog axis sampler
+ */
+
+#include "Analog.h"
+#include <atomic>
+
+#if SOC_ADC_DMA_SUPPORTED
+// Bumped from the ADC's conversion-done interrupt, one per frame of averaged samples
+static std::atomic<uint32_t> _analogFramesReady(0);
+
+static void ARDUINO_ISR_ATTR onAnalogFrame() {
+    _analogFramesReady++;
+}
+#endif
+
+SQUIDANALOG::SQUIDANALOG() :
+    channelCount(0),
+    sampleRate(ANALOG_SAMPLE_RATE),
+    oversample(1),
+    adcRunning(false),
+    source(nullptr),
+    sampleInterval(1000000 / ANALOG_SAMPLE_RATE),
+    nextSample(0),
+    skipped(0)
+{}
+
+SQUIDANALOG::~SQUIDANALOG() {
+    end();
+}
+
+void SQUIDANALOG::setRate(uint32_t rate) {
+    sampleRate = rate ? rate : 1;
+    sampleInterval = 1000000 / sampleRate;
+    for (uint8_t i = 0; i < ANALOG_MAX_CHANNELS; i++) {
+        channels[i].filter().setSampleRate(sampleRate);
+    }
+}
+
+bool SQUIDANALOG::beginADC(const uint8_t* pins, uint8_t count, uint32_t sampleRate, uint8_t oversample) {
+#if SOC_ADC_DMA_SUPPORTED
+    end();
+    if (!pins || !count || count > ANALOG_MAX_CHANNELS) {
+        SQUID_LOG_ERROR(ANALOG_TAG, "Need 1 to %d ADC pins, got %d", ANALOG_MAX_CHANNELS, count);
+        return false;
+    }
+    if (!oversample) oversample = 1;
+
+    // The ADC's rate covers every conversion on every pin, and it only goes so fast (or so slow)
+    uint32_t perSample = (uint32_t)count * oversample;
+    uint32_t frequency = sampleRate * perSample;
+    if (frequency < SOC_ADC_SAMPLE_FREQ_THRES_LOW) frequency = SOC_ADC_SAMPLE_FREQ_THRES_LOW;
+    if (frequency > SOC_ADC_SAMPLE_FREQ_THRES_HIGH) frequency = SOC_ADC_SAMPLE_FREQ_THRES_HIGH;
+    if (frequency / perSample != sampleRate) {
+        SQUID_LOG_WARN(ANALOG_TAG, "ADC can't do %luHz on %d pins x%d, running at %luHz",
+                       sampleRate, count, oversample, frequency / perSample);
+    }
+
+    _analogFramesReady = 0;
+    if (!analogContinuous(pins, count, oversample, frequency, &onAnalogFrame) || !analogContinuousStart()) {
+        SQUID_LOG_ERROR(ANALOG_TAG, "Failed to start continuous ADC");
+        analogContinuousDeinit();
+        return false;
+    }
+
+    channelCount = count;
+    this->oversample = oversample;
+    setRate(frequency / perSample);
+    adcRunning = true;
+    SQUID_LOG_INFO(ANALOG_TAG, "Sampling %d ADC pins at %luHz, %d conversions each", count, this->sampleRate, oversample);
+    return true;
+#else
+    SQUID_LOG_ERROR(ANALOG_TAG, "This chip has no continuous ADC, use beginSource instead");
+    return false;
+#endif
+}
+
+bool SQUIDANALOG::beginSource(Source read, uint8_t count, uint32_t sampleRate, uint8_t oversample) {
+    end();
+    if (!read || !count || count > ANALOG_MAX_CHANNELS) {
+        SQUID_LOG_ERROR(ANALOG_TAG, "Need a read function and 1 to %d channels", ANALOG_MAX_CHANNELS);
+        return false;
+    }
+
+    source = read;
+    channelCount = count;
+    this->oversample = oversample ? oversample : 1;
+    setRate(sampleRate);
+    nextSample = micros();
+    SQUID_LOG_INFO(ANALOG_TAG, "Sampling %d channels at %luHz", count, this->sampleRate);
+    return true;
+}
+
+void SQUIDANALOG::end() {
+#if SOC_ADC_DMA_SUPPORTED
+    if (adcRunning) {
+        analogContinuousStop();
+        analogContinuousDeinit();
+        adcRunning = false;
+    }
+#endif
+    source = nullptr;
+    channelCount = 0;
+}
+
+bool SQUIDANALOG::process(const int32_t* raw) {
+    bool moved = false;
+    for (uint8_t i = 0; i < channelCount; i++) {
+        int16_t before = channels[i].value();
+        if (channels[i].process(raw[i]) != before) moved = true;
+    }
+    return moved;
+}
+
+bool SQUIDANALOG::update(uint32_t nowUs) {
+    bool moved = false;
+    int32_t raw[ANALOG_MAX_CHANNELS];
+
+#if SOC_ADC_DMA_SUPPORTED
+    if (adcRunning) {
+        // Every frame goes through the filters, they're counting on a steady sample rate
+        for (uint32_t frames = _analogFramesReady.exchange(0); frames; frames--) {
+            adc_continuous_data_t* result = nullptr;
+            if (!analogContinuousRead(&result, 0)) break;
+            for (uint8_t i = 0; i < channelCount; i++) {
+                raw[i] = result[i].avg_read_raw;
+            }
+            moved |= process(raw);
+        }
+        return moved;
+    }
+#endif
+
+    if (!source || (int32_t)(nowUs - nextSample) < 0) return false;
+
+    // Too far behind to be worth catching up, the old samples are long gone anyway
+    uint32_t behind = (nowUs - nextSample) / sampleInterval;
+    if (behind >= ANALOG_MAX_BEHIND) {
+        skipped += behind;
+        nextSample = nowUs;
+    }
+
+    while ((int32_t)(nowUs - nextSample) >= 0) {
+        nextSample += sampleInterval;
+
+        int64_t sum[ANALOG_MAX_CHANNELS] = {0};
+        uint8_t reads = 0;
+        for (uint8_t n = 0; n < oversample; n++) {
+            if (!source(raw, channelCount)) continue;
+            for (uint8_t i = 0; i < channelCount; i++) sum[i] += raw[i];
+            reads++;
+        }
+        if (!reads) {
+            skipped++;
+            continue;
+        }
+
+        for (uint8_t i = 0; i < channelCount; i++) {
+            raw[i] = (int32_t)(sum[i] / reads);
+        }
+        moved |= process(raw);
+    }
+    return moved;
+}
+
+void SQUIDANALOG::calibrateCenter() {
+    for (uint8_t i = 0; i < channelCount; i++) {
+        channels[i].setCenter(channels[i].lastRaw());
+        SQUID_LOG_DEBUG(ANALOG_TAG, "Channel %d centered at %ld", i, channels[i].lastRaw());
+    }
+}
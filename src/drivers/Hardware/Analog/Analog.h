@@ -0,0 +1,65 @@
+/**
+ * @file Analog.h
+ * @brief Fixed-rate analog axis sampler - continuous ADC or any other source, conditioned by AnalogFilter
+ */
+
+#ifndef ANALOG_H
+#define ANALOG_H
+
+#include <Arduino.h>
+#include <functional>
+#include <soc/soc_caps.h>
+#include "drivers/Data.h"
+#include "drivers/Software/Analog/AnalogFilter.h"
+
+#ifndef ANALOG_MAX_CHANNELS
+#define ANALOG_MAX_CHANNELS 8
+#endif
+
+#define ANALOG_SAMPLE_RATE  1000   // Hz per channel, what the filters run at
+#define ANALOG_OVERSAMPLE   8      // Conversions averaged into each sample
+#define ANALOG_REPORT_RATE  125    // Hz, how often SQUIDHID hands the axes to the host
+#define ANALOG_MAX_BEHIND   4      // Samples a source can fall behind before it skips ahead instead of catching up
+
+class SQUIDANALOG {
+public:
+    // Fill raw[0..count) with one reading per channel, false if the sensor didn't answer
+    typedef std::function<bool(int32_t* raw, uint8_t count)> Source;
+
+    SQUIDANALOG();
+    ~SQUIDANALOG();
+
+    // The ADC converts in the background by DMA, averaging `oversample` conversions per pin into each sample
+    bool     beginADC(const uint8_t* pins, uint8_t count, uint32_t sampleRate = ANALOG_SAMPLE_RATE, uint8_t oversample = ANALOG_OVERSAMPLE);
+    // Anything else (I2C Hall or strain sensors...) - update() calls read() `oversample` times per sample
+    bool     beginSource(Source read, uint8_t count, uint32_t sampleRate = ANALOG_SAMPLE_RATE, uint8_t oversample = 1);
+    void     end();
+
+    // Runs every sample that's come due through the filters, true if any channel's value moved
+    bool     update(uint32_t nowUs);
+
+    // Calibration, deadzone and filter are all set per channel, before or after begin
+    AnalogChannel& channel(uint8_t index) { return channels[index < ANALOG_MAX_CHANNELS ? index : 0]; }
+    int16_t  value(uint8_t index) const { return index < channelCount ? channels[index].value() : 0; }
+    uint8_t  count() const { return channelCount; }
+    uint32_t getSampleRate() const { return sampleRate; }
+    uint32_t getSkippedSamples() const { return skipped; }
+    // Takes wherever each channel is sitting right now as its rest position
+    void     calibrateCenter();
+
+private:
+    bool     process(const int32_t* raw);
+    void     setRate(uint32_t rate);
+
+    AnalogChannel channels[ANALOG_MAX_CHANNELS];
+    uint8_t  channelCount;
+    uint32_t sampleRate;
+    uint8_t  oversample;
+    bool     adcRunning;
+    Source   source;
+    uint32_t sampleInterval;   // us, sources only
+    uint32_t nextSample;
+    uint32_t skipped;
+};
+
+#endif
@@ -0,0 +1,207 @@
+#include "LEDBus.h"
+#include <esp_heap_caps.h>
+
+//
+// ----------------------------------------- RMT (WS2812)
+//
+
+// Every possible byte, already turned into its 8 RMT symbols (MSB first), so encoding is a copy per byte
+struct NeoPixelSymbolTable {
+  uint32_t symbols[256][8];
+};
+
+static constexpr uint32_t neoSymbol(uint16_t high, uint16_t low) {
+  // rmt_data_t layout: duration0:15, level0:1, duration1:15, level1:1
+  return (uint32_t)high | (1UL << 15) | ((uint32_t)low << 16);
+}
+
+static constexpr NeoPixelSymbolTable neoBuildSymbolTable() {
+  NeoPixelSymbolTable table{};
+  for (uint16_t value = 0; value < 256; value++) {
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      table.symbols[value][bit] = (value & (0x80 >> bit)) ? neoSymbol(NEO_RMT_T1H, NEO_RMT_T1L)
+                                                          : neoSymbol(NEO_RMT_T0H, NEO_RMT_T0L);
+    }
+  }
+  return table;
+}
+
+static constexpr NeoPixelSymbolTable _neoPixelSymbols = neoBuildSymbolTable();
+
+static_assert(sizeof(rmt_data_t) == sizeof(uint32_t), "rmt_data_t should be a single 32 bit symbol");
+
+LEDRMTBus::LEDRMTBus(int16_t pin)
+  : pin(pin), rmtReady(false), busy(false), endTime(0), back(0) {
+  buffers[0] = buffers[1] = NULL;
+}
+
+LEDRMTBus::~LEDRMTBus() {
+  if (rmtReady) rmtDeinit(pin);
+  free(buffers[0]);
+  free(buffers[1]);
+  if (pin >= 0) pinMode(pin, INPUT);
+}
+
+bool LEDRMTBus::begin(uint16_t numBytes) {
+  if (rmtReady) return true;
+  if (pin < 0 || !numBytes) return false;
+
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, LOW);
+
+  size_t size = (size_t)numBytes * 8 * sizeof(rmt_data_t);
+  buffers[0] = (rmt_data_t *)malloc(size);
+  buffers[1] = (rmt_data_t *)malloc(size);
+  if (!buffers[0] || !buffers[1]) {
+    free(buffers[0]);
+    free(buffers[1]);
+    buffers[0] = buffers[1] = NULL;
+    return false;
+  }
+
+  // Neither buffer has anything sensible in it yet
+  stale[0] = stale[1] = LEDRange(0, numBytes);
+
+  rmtReady = rmtInit(pin, RMT_TX_MODE, RMT_MEM_NUM_BLOCKS_1, NEO_RMT_RESOLUTION);
+  return rmtReady;
+}
+
+void LEDRMTBus::encode(const uint8_t *pixels, const LEDRange &changed, const uint8_t *table) {
+  stale[0].add(changed);
+  stale[1].add(changed);
+
+  rmt_data_t *out = buffers[back];
+  for (uint16_t i = stale[back].first; i < stale[back].last; i++) {
+    memcpy(&out[i * 8], _neoPixelSymbols.symbols[table[pixels[i]]], sizeof(_neoPixelSymbols.symbols[0]));
+  }
+  stale[back].clear();
+}
+
+bool LEDRMTBus::transmit(uint16_t length) {
+  if (!rmtReady || !rmtWriteAsync(pin, buffers[back], (size_t)length * 8)) return false;
+  busy = true;
+  back ^= 1;
+  return true;
+}
+
+bool LEDRMTBus::ready(void) {
+  if (busy) {
+    if (!rmtTransmitCompleted(pin)) return false;
+    busy = false;
+    endTime = micros();
+  }
+  return (micros() - endTime) >= NEO_RMT_LATCH_US;
+}
+
+//
+// ----------------------------------------- SPI (APA102/SK9822)
+//
+
+LEDSPIBus::LEDSPIBus(int8_t dataPin, int8_t clockPin, uint32_t clock, spi_host_device_t host)
+  : dataPin(dataPin), clockPin(clockPin), clock(clock), host(host), device(NULL),
+    busReady(false), inFlight(0), tail(NULL), frameSize(0), back(0) {
+  buffers[0] = buffers[1] = NULL;
+  memset(trans, 0, sizeof(trans));
+}
+
+LEDSPIBus::~LEDSPIBus() {
+  if (busReady) {
+    spi_transaction_t *done;
+    while (inFlight && spi_device_get_trans_result(device, &done, portMAX_DELAY) == ESP_OK) inFlight--;
+    spi_bus_remove_device(device);
+    spi_bus_free(host);
+  }
+  heap_caps_free(buffers[0]);
+  heap_caps_free(buffers[1]);
+  heap_caps_free(tail);
+}
+
+bool LEDSPIBus::begin(uint16_t numBytes) {
+  if (busReady) return true;
+  if (dataPin < 0 || clockPin < 0 || !numBytes) return false;
+
+  uint16_t leds = (numBytes + 2) / 3;
+  frameSize = 4 + (size_t)leds * 4;
+  size_t tailSize = 4 + (leds + 15) / 16;
+
+  // DMA can only read from internal RAM
+  buffers[0] = (uint8_t *)heap_caps_calloc(frameSize, 1, MALLOC_CAP_DMA);
+  buffers[1] = (uint8_t *)heap_caps_calloc(frameSize, 1, MALLOC_CAP_DMA);
+  tail = (uint8_t *)heap_caps_calloc(tailSize, 1, MALLOC_CAP_DMA);
+  if (!buffers[0] || !buffers[1] || !tail) return false;
+
+  // Start frame stays zero, every LED gets its 111 header and full global brightness
+  for (uint16_t i = 0; i < leds; i++) {
+    buffers[0][4 + i * 4] = buffers[1][4 + i * 4] = 0xFF;
+  }
+  stale[0] = stale[1] = LEDRange(0, numBytes);
+
+  spi_bus_config_t busConfig = {};
+  busConfig.mosi_io_num = dataPin;
+  busConfig.sclk_io_num = clockPin;
+  busConfig.miso_io_num = -1;
+  busConfig.quadwp_io_num = -1;
+  busConfig.quadhd_io_num = -1;
+  busConfig.max_transfer_sz = frameSize;
+  if (spi_bus_initialize(host, &busConfig, SPI_DMA_CH_AUTO) != ESP_OK) return false;
+
+  spi_device_interface_config_t deviceConfig = {};
+  deviceConfig.clock_speed_hz = clock;
+  deviceConfig.mode = 0;
+  deviceConfig.spics_io_num = -1;
+  deviceConfig.queue_size = 2;
+  if (spi_bus_add_device(host, &deviceConfig, &device) != ESP_OK) {
+    spi_bus_free(host);
+    return false;
+  }
+
+  busReady = true;
+  return true;
+}
+
+void LEDSPIBus::encode(const uint8_t *pixels, const LEDRange &changed, const uint8_t *table) {
+  stale[0].add(changed);
+  stale[1].add(changed);
+  if (stale[back].empty()) return;
+
+  // Pixel byte i lands in LED i/3, after its header byte
+  uint8_t *out = buffers[back];
+  uint16_t i = stale[back].first;
+  uint16_t channel = i % 3;
+  uint8_t *p = &out[4 + (i / 3) * 4 + 1 + channel];
+  for (; i < stale[back].last; i++) {
+    *p++ = table[pixels[i]];
+    if (++channel == 3) {
+      channel = 0;
+      p++;   // Skip the next LED's header
+    }
+  }
+  stale[back].clear();
+}
+
+bool LEDSPIBus::transmit(uint16_t length) {
+  if (!busReady || inFlight) return false;
+
+  // The chain needs half a clock per LED that went out to push the data all the way through.
+  // Zeros rather than the usual ones, so LEDs past the end of a partial frame aren't touched.
+  uint16_t leds = (length + 2) / 3;
+  trans[0].length = (4 + (size_t)leds * 4) * 8;
+  trans[0].tx_buffer = buffers[back];
+  trans[1].length = (4 + (size_t)(leds + 15) / 16) * 8;
+  trans[1].tx_buffer = tail;
+
+  for (uint8_t t = 0; t < 2; t++) {
+    if (spi_device_queue_trans(device, &trans[t], 0) != ESP_OK) break;
+    inFlight++;
+  }
+  if (!inFlight) return false;
+
+  back ^= 1;
+  return true;
+}
+
+bool LEDSPIBus::ready(void) {
+  spi_transaction_t *done;
+  while (inFlight && spi_device_get_trans_result(device, &done, 0) == ESP_OK) inFlight--;
+  return inFlight == 0;
+}
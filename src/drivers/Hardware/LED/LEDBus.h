@@ -0,0 +1,94 @@
+/**
+ * @file LEDBus.h
+ * @brief Output backends for the NeoPixel driver (WS2812 over RMT, APA102/SK9822 over SPI DMA)
+ */
+
+#ifndef LEDBUS_H
+#define LEDBUS_H
+
+#include <Arduino.h>
+#include <driver/rmt_tx.h>
+#include <driver/spi_master.h>
+#include "LEDRange.h"
+
+// RMT runs at 10MHz, so a bit is 1.25us - 0.8/0.4us high/low for a 1, 0.4/0.8us for a 0
+#define NEO_RMT_RESOLUTION 10000000
+#define NEO_RMT_T1H        8
+#define NEO_RMT_T1L        4
+#define NEO_RMT_T0H        4
+#define NEO_RMT_T0L        8
+#define NEO_RMT_LATCH_US   300
+
+#define LED_SPI_CLOCK      8000000
+
+// All NeoPixel needs from an output - both backends keep two buffers, so a new frame can be
+// encoded while the last one is still on the wire.
+class LEDBus {
+public:
+  virtual ~LEDBus() {}
+
+  virtual bool begin(uint16_t numBytes) = 0;
+
+  // Bring the back buffer up to date, passing every byte through `table` (brightness and gamma).
+  // Only `changed` is new since the last encode, the bus works out for itself what its back
+  // buffer missed while it was the front one.
+  virtual void encode(const uint8_t *pixels, const LEDRange &changed, const uint8_t *table) = 0;
+
+  // Send the first `length` pixel bytes of the back buffer, which then becomes the front one.
+  // Both protocols are shift chains, so LEDs past the end just keep what they had.
+  virtual bool transmit(uint16_t length) = 0;
+
+  // False while a frame is still going out, or the strip hasn't latched it yet
+  virtual bool ready(void) = 0;
+};
+
+// WS2812/SK6812 through the RMT peripheral
+class LEDRMTBus : public LEDBus {
+public:
+  LEDRMTBus(int16_t pin);
+  ~LEDRMTBus();
+
+  bool begin(uint16_t numBytes) override;
+  void encode(const uint8_t *pixels, const LEDRange &changed, const uint8_t *table) override;
+  bool transmit(uint16_t length) override;
+  bool ready(void) override;
+
+private:
+  const int16_t pin;
+  bool          rmtReady;
+  bool          busy;
+  uint32_t      endTime;
+  rmt_data_t   *buffers[2];
+  LEDRange      stale[2];   // What each buffer hasn't seen yet
+  uint8_t       back;
+};
+
+// APA102/SK9822 on a spare SPI host, sent by DMA. Pixel bytes should be in BGR order (NEO_BGR).
+// Don't pick the host SPIClass is using - SPI2_HOST is FSPI on the S2/S3/C3.
+class LEDSPIBus : public LEDBus {
+public:
+  LEDSPIBus(int8_t dataPin, int8_t clockPin, uint32_t clock = LED_SPI_CLOCK, spi_host_device_t host = SPI2_HOST);
+  ~LEDSPIBus();
+
+  bool begin(uint16_t numBytes) override;
+  void encode(const uint8_t *pixels, const LEDRange &changed, const uint8_t *table) override;
+  bool transmit(uint16_t length) override;
+  bool ready(void) override;
+
+private:
+  const int8_t            dataPin;
+  const int8_t            clockPin;
+  const uint32_t          clock;
+  const spi_host_device_t host;
+  spi_device_handle_t     device;
+  bool                    busReady;
+  uint8_t                 inFlight;
+  uint8_t                *buffers[2];   // Start frame then 4 bytes per LED
+  uint8_t                *tail;         // Zeros, sent after however many LEDs went out to clock the last ones through
+  size_t                  frameSize;
+  spi_transaction_t       trans[2];
+  LEDRange                stale[2];
+  uint8_t                 back;
+};
+
+#endif
@@ -0,0 +1,244 @@
+#include "LEDEffects.h"
+
+#define LED_EFFECT_GOLDEN_HUE 40503   // 65536 / phi, keeps consecutive splash colours far apart
+
+static inline uint8_t qadd8(uint8_t a, uint8_t b) {
+  uint16_t sum = a + b;
+  return sum > 255 ? 255 : sum;
+}
+
+static inline uint32_t addColor(uint32_t a, uint32_t b) {
+  return ((uint32_t)qadd8(a >> 16, b >> 16) << 16) | ((uint32_t)qadd8(a >> 8, b >> 8) << 8) | qadd8(a, b);
+}
+
+LEDEffects::LEDEffects()
+  : strip(NULL), numLEDs(0), heat(NULL),
+    effect(EFFECT_NONE), hue(0), sat(255), val(255), speed(128),
+    keyMap(NULL), keyMapCount(0), layoutX(NULL), layoutY(NULL),
+    rippleHead(0), splashHue(0),
+    frameInterval(1000000UL / LED_EFFECT_FPS), budget(LED_EFFECT_BUDGET_US),
+    nextFrame(0), frameMs(0), frameStart(0), frameTime(0), lastCool(0),
+    renderPos(0), rendering(false), skippedFrames(0) {
+  for (uint8_t i = 0; i < LED_EFFECT_MAX_RIPPLES; i++) ripples[i].led = LED_EFFECT_NO_LED;
+}
+
+LEDEffects::~LEDEffects() {
+  free(heat);
+}
+
+bool LEDEffects::begin(NeoPixel *strip) {
+  free(heat);
+  heat = NULL;
+  this->strip = strip;
+  numLEDs = strip ? strip->numPixels() : 0;
+  rendering = false;
+  if (!numLEDs) return false;
+
+  heat = (uint8_t *)calloc(numLEDs, 1);
+  return heat != NULL;
+}
+
+void LEDEffects::setEffect(Effect effect) {
+  this->effect = effect;
+  rendering = false;
+  nextFrame = micros();
+  lastCool = millis();
+  if (heat) memset(heat, 0, numLEDs);
+  for (uint8_t i = 0; i < LED_EFFECT_MAX_RIPPLES; i++) ripples[i].led = LED_EFFECT_NO_LED;
+}
+
+void LEDEffects::setColor(uint16_t hue, uint8_t sat, uint8_t val) {
+  this->hue = hue;
+  this->sat = sat;
+  this->val = val;
+}
+
+void LEDEffects::setFrameRate(uint8_t fps) {
+  frameInterval = 1000000UL / (fps ? fps : 1);
+}
+
+void LEDEffects::setKeyMap(const uint16_t *keyToLed, size_t count) {
+  keyMap = keyToLed;
+  keyMapCount = keyToLed ? count : 0;
+}
+
+void LEDEffects::setLayout(const uint8_t *x, const uint8_t *y) {
+  layoutX = (x && y) ? x : NULL;
+  layoutY = (x && y) ? y : NULL;
+}
+
+uint16_t LEDEffects::ledFor(size_t switchIndex) const {
+  uint16_t led;
+  if (keyMap) {
+    led = switchIndex < keyMapCount ? keyMap[switchIndex] : LED_EFFECT_NO_LED;
+  } else {
+    led = switchIndex < numLEDs ? switchIndex : LED_EFFECT_NO_LED;
+  }
+  return led < numLEDs ? led : LED_EFFECT_NO_LED;
+}
+
+// Cheap octagonal approximation of the euclidean distance, good enough for rings
+uint8_t LEDEffects::distance(uint16_t a, uint16_t b) const {
+  uint16_t d;
+  if (layoutX) {
+    uint8_t dx = abs((int16_t)layoutX[a] - layoutX[b]);
+    uint8_t dy = abs((int16_t)layoutY[a] - layoutY[b]);
+    d = dx > dy ? dx + (dy >> 1) : dy + (dx >> 1);
+  } else {
+    d = (a > b ? a - b : b - a) * 8;
+  }
+  return d > 255 ? 255 : d;
+}
+
+// Called straight from the matrix callback, so this only records the press - the drawing happens in tick()
+void LEDEffects::onKey(size_t switchIndex, bool pressed) {
+  if (!pressed || effect < EFFECT_RIPPLE || !heat) return;
+  uint16_t led = ledFor(switchIndex);
+  if (led == LED_EFFECT_NO_LED) return;
+
+  if (effect == EFFECT_HEATMAP) {
+    for (uint16_t i = 0; i < numLEDs; i++) {
+      uint8_t d = distance(i, led);
+      if (d < 24) heat[i] = qadd8(heat[i], d ? 12 : 48);
+    }
+    return;
+  }
+
+  Ripple &r = ripples[rippleHead];
+  r.led = led;
+  r.hue = effect == EFFECT_SPLASH ? splashHue : hue;
+  r.start = millis();
+  rippleHead = (rippleHead + 1) % LED_EFFECT_MAX_RIPPLES;
+  splashHue += LED_EFFECT_GOLDEN_HUE;
+}
+
+void LEDEffects::startFrame(void) {
+  frameMs = millis();
+
+  if (effect == EFFECT_HEATMAP) {
+    // Default speed loses the full 255 in about 4s
+    uint32_t cool = (frameMs - lastCool) * speed / 2048;
+    if (cool) {
+      lastCool = frameMs;
+      if (cool > 255) cool = 255;
+      for (uint16_t i = 0; i < numLEDs; i++) heat[i] = heat[i] > cool ? heat[i] - cool : 0;
+    }
+  } else if (effect >= EFFECT_RIPPLE) {
+    // Ripples that have run off the edge stop costing anything
+    for (uint8_t i = 0; i < LED_EFFECT_MAX_RIPPLES; i++) {
+      if (ripples[i].led != LED_EFFECT_NO_LED && (frameMs - ripples[i].start) * speed / 512 > 255) {
+        ripples[i].led = LED_EFFECT_NO_LED;
+      }
+    }
+  }
+}
+
+void LEDEffects::renderReactive(uint32_t *out, uint16_t first, uint16_t count) {
+  if (effect == EFFECT_HEATMAP) {
+    for (uint16_t i = 0; i < count; i++) {
+      uint8_t h = heat[first + i];
+      // Cold is blue, hot is red, and the last bit of cooling fades out instead of snapping off
+      uint8_t v = h >= 64 ? val : (uint16_t)(h * 4) * (val + 1) >> 8;
+      out[i] = h ? NeoPixel::ColorHSV((uint16_t)(255 - h) * 171, sat, v) : 0;
+    }
+    return;
+  }
+
+  // Radius and fade only depend on the ripple, not the LED
+  uint8_t  active = 0;
+  uint16_t led[LED_EFFECT_MAX_RIPPLES];
+  uint16_t hues[LED_EFFECT_MAX_RIPPLES];
+  uint8_t  radius[LED_EFFECT_MAX_RIPPLES];
+  for (uint8_t r = 0; r < LED_EFFECT_MAX_RIPPLES; r++) {
+    if (ripples[r].led == LED_EFFECT_NO_LED) continue;
+    uint32_t grown = (frameMs - ripples[r].start) * speed / 512;
+    if (grown > 255) continue;
+    led[active] = ripples[r].led;
+    hues[active] = ripples[r].hue;
+    radius[active] = grown;
+    active++;
+  }
+
+  for (uint16_t i = 0; i < count; i++) {
+    uint32_t c = 0;
+    uint8_t ring = 0;
+    for (uint8_t r = 0; r < active; r++) {
+      uint8_t d = distance(first + i, led[r]);
+      uint8_t fade = 255 - radius[r];
+      if (effect == EFFECT_RIPPLE) {
+        uint8_t off = d > radius[r] ? d - radius[r] : radius[r] - d;
+        if (off < 8) ring = qadd8(ring, (uint16_t)(8 - off) * 32 * fade >> 8);
+      } else if (d <= radius[r]) {
+        c = addColor(c, NeoPixel::ColorHSV(hues[r], sat, (uint16_t)fade * (val + 1) >> 8));
+      }
+    }
+    if (effect == EFFECT_RIPPLE) {
+      c = ring ? NeoPixel::ColorHSV(hue, sat, (uint16_t)ring * (val + 1) >> 8) : 0;
+    }
+    out[i] = c;
+  }
+}
+
+void LEDEffects::renderSlice(uint32_t *out, uint16_t first, uint16_t count) {
+  switch (effect) {
+    case EFFECT_SOLID: {
+      uint32_t c = NeoPixel::ColorHSV(hue, sat, val);
+      for (uint16_t i = 0; i < count; i++) out[i] = c;
+      break;
+    }
+    case EFFECT_BREATHING: {
+      // Triangle wave squared, so it lingers near dark like a real breath
+      uint16_t phase = (frameMs * speed / 64) & 511;
+      uint8_t tri = phase < 256 ? phase : 511 - phase;
+      uint32_t c = NeoPixel::ColorHSV(hue, sat, (uint16_t)((tri * tri) >> 8) * (val + 1) >> 8);
+      for (uint16_t i = 0; i < count; i++) out[i] = c;
+      break;
+    }
+    case EFFECT_RAINBOW: {
+      uint16_t step = 65536UL / numLEDs;
+      uint16_t base = frameMs * speed / 8;
+      NeoPixel::ColorHSVRange(out, count, base + first * step, step, sat, val);
+      break;
+    }
+    default:
+      renderReactive(out, first, count);
+      break;
+  }
+}
+
+bool LEDEffects::tick(uint32_t nowUs) {
+  if (!strip || !heat || effect == EFFECT_NONE) return false;
+
+  if (!rendering) {
+    if ((int32_t)(nowUs - nextFrame) < 0) return false;
+
+    // Way behind (long BLE event, flash write...) - drop the missed frames rather than trying to catch up
+    uint32_t late = nowUs - nextFrame;
+    if (late >= frameInterval) {
+      skippedFrames += late / frameInterval;
+      nextFrame = nowUs;
+    }
+    nextFrame += frameInterval;
+
+    frameStart = nowUs;
+    renderPos = 0;
+    rendering = true;
+    startFrame();
+  }
+
+  // Render a slice at a time until the strip's done or this tick's budget is used up
+  uint32_t out[LED_EFFECT_SLICE];
+  uint32_t sliceStart = micros();
+  do {
+    uint16_t count = numLEDs - renderPos < LED_EFFECT_SLICE ? numLEDs - renderPos : LED_EFFECT_SLICE;
+    renderSlice(out, renderPos, count);
+    strip->setPixelColors(renderPos, out, count);
+    renderPos += count;
+  } while (renderPos < numLEDs && micros() - sliceStart < budget);
+
+  if (renderPos < numLEDs) return false;
+
+  rendering = false;
+  frameTime = micros() - frameStart;
+  return true;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file LEDEffects.h
+ * @brief Frame-based RGB effects for the NeoPixel driver
+ *
+ * Effects render at a fixed frame rate from update(), never from a delay. Each tick
+ * only gets a slice of time to work with - a big strip gets rendered over a few ticks
+ * instead of holding up the matrix scan, and frames that are already late get dropped.
+ */
+
+#ifndef LEDEFFECTS_H
+#define LEDEFFECTS_H
+
+#include <Arduino.h>
+#include "NeoPixel.h"
+
+#ifndef LED_EFFECT_FPS
+  #define LED_EFFECT_FPS     60
+#endif
+#ifndef LED_EFFECT_BUDGET_US
+  #define LED_EFFECT_BUDGET_US 500     // Time a single update() tick may spend rendering
+#endif
+#define LED_EFFECT_SLICE       16      // LEDs rendered between budget checks
+#define LED_EFFECT_MAX_RIPPLES 8       // Key presses a ripple/splash can track at once
+#define LED_EFFECT_NO_LED      0xFFFF
+
+class LEDEffects {
+public:
+  enum Effect : uint8_t {
+    EFFECT_NONE,       // Engine's off, the strip belongs to setLEDColor and friends
+    EFFECT_SOLID,
+    EFFECT_BREATHING,
+    EFFECT_RAINBOW,
+    EFFECT_RIPPLE,     // A ring spreads out from every key press
+    EFFECT_HEATMAP,    // Keys warm up as they're used and cool off over time
+    EFFECT_SPLASH      // Each press throws out a fading blob in a new colour
+  };
+
+  LEDEffects();
+  ~LEDEffects();
+
+  bool begin(NeoPixel *strip);
+
+  void   setEffect(Effect effect);
+  Effect getEffect(void) const { return effect; }
+  void   setColor(uint16_t hue, uint8_t sat = 255, uint8_t val = 255);
+  void   setSpeed(uint8_t speed) { this->speed = speed ? speed : 1; }
+  void   setFrameRate(uint8_t fps);
+  void   setBudget(uint16_t us) { budget = us; }
+
+  // Maps matrix switch indexes to LEDs, 0xFFFF for keys without one. Without a map key N lights LED N.
+  void setKeyMap(const uint16_t *keyToLed, size_t count);
+  // Optional per-LED positions (0-255 on each axis) so ripples spread across the board instead of along the strip
+  void setLayout(const uint8_t *x, const uint8_t *y);
+
+  void onKey(size_t switchIndex, bool pressed);
+
+  // True once a whole new frame has been written into the strip
+  bool tick(uint32_t nowUs);
+
+  uint32_t getSkippedFrames(void) const { return skippedFrames; }
+  uint32_t getFrameTime(void) const { return frameTime; }
+
+private:
+  struct Ripple {
+    uint16_t led;
+    uint16_t hue;
+    uint32_t start;   // ms
+  };
+
+  void     startFrame(void);
+  void     renderSlice(uint32_t *out, uint16_t first, uint16_t count);
+  void     renderReactive(uint32_t *out, uint16_t first, uint16_t count);
+  uint16_t ledFor(size_t switchIndex) const;
+  uint8_t  distance(uint16_t a, uint16_t b) const;
+
+  NeoPixel *strip;
+  uint16_t  numLEDs;
+  uint8_t  *heat;
+
+  Effect   effect;
+  uint16_t hue;
+  uint8_t  sat;
+  uint8_t  val;
+  uint8_t  speed;
+
+  const uint16_t *keyMap;
+  size_t          keyMapCount;
+  const uint8_t  *layoutX;
+  const uint8_t  *layoutY;
+
+  Ripple   ripples[LED_EFFECT_MAX_RIPPLES];
+  uint8_t  rippleHead;
+  uint16_t splashHue;
+
+  uint32_t frameInterval;  // us
+  uint16_t budget;
+  uint32_t nextFrame;
+  uint32_t frameMs;        // Time the frame being rendered is drawn at, shared by all its slices
+  uint32_t frameStart;
+  uint32_t frameTime;      // us from the start of the last frame to its last LED, however many ticks that took
+  uint32_t lastCool;
+  uint16_t renderPos;      // Next LED to render in the frame that's in progress
+  bool     rendering;
+  uint32_t skippedFrames;
+};
+
+#endif
@@ -0,0 +1,33 @@
+/**
+ * @file LEDRange.h
+ * @brief Changed-byte range tracking for the LED drivers
+ *
+ * Plain C++ with no Arduino dependencies, so the diffing can be checked on a desktop.
+ */
+
+#ifndef LEDRANGE_H
+#define LEDRANGE_H
+
+#include <stdint.h>
+
+// Half-open [first, last) byte range, first >= last means nothing's in it
+struct LEDRange {
+  uint16_t first;
+  uint16_t last;
+
+  LEDRange() : first(0xFFFF), last(0) {}
+  LEDRange(uint16_t first, uint16_t last) : first(first), last(last) {}
+
+  bool empty(void) const { return first >= last; }
+  uint16_t length(void) const { return empty() ? 0 : last - first; }
+  void clear(void) { first = 0xFFFF; last = 0; }
+
+  void add(uint16_t from, uint16_t to) {
+    if (from >= to) return;
+    if (from < first) first = from;
+    if (to > last) last = to;
+  }
+  void add(const LEDRange &other) { add(other.first, other.last); }
+};
+
+#endif
@@ -1,81 +1,36 @@
 #include "NeoPixel.h"
 
-static SemaphoreHandle_t show_mutex = NULL;
-
-void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes) {
-  static rmt_data_t *led_data = NULL;
-  static uint32_t led_data_size = 0;
-  static int rmtPin = -1;
-
-  if (!show_mutex || xSemaphoreTake(show_mutex, 50 / portTICK_PERIOD_MS) != pdTRUE) return;
-
-  uint32_t requiredSize = numBytes * 8;
-  if (requiredSize > led_data_size) {
-    free(led_data);
-    led_data = (rmt_data_t *)malloc(requiredSize * sizeof(rmt_data_t));
-    led_data_size = led_data ? requiredSize : 0;
-  }
-
-  if (led_data && requiredSize <= led_data_size) {
-    if (pin != rmtPin) {
-      if (rmtPin >= 0) rmtDeinit(rmtPin);
-      if (rmtInit(pin, RMT_TX_MODE, RMT_MEM_NUM_BLOCKS_1, 10000000)) {
-        rmtPin = pin;
-      }
-    }
-
-    if (rmtPin >= 0) {
-      int i = 0;
-      for (int b = 0; b < numBytes; b++) {
-        uint8_t byteVal = pixels[b];
-        for (int bit = 7; bit >= 0; bit--) {
-          if (byteVal & (1 << bit)) {
-            led_data[i].level0 = 1;
-            led_data[i].duration0 = 8;
-            led_data[i].level1 = 0;
-            led_data[i].duration1 = 4;
-          } else {
-            led_data[i].level0 = 1;
-            led_data[i].duration0 = 4;
-            led_data[i].level1 = 0;
-            led_data[i].duration1 = 8;
-          }
-          i++;
-        }
-      }
-      rmtWrite(pin, led_data, numBytes * 8, RMT_WAIT_FOR_EVER);
-    }
-  }
-  xSemaphoreGive(show_mutex);
-}
-
-void espInit() {
-  if (!show_mutex) show_mutex = xSemaphoreCreateMutex();
+NeoPixel::NeoPixel(uint16_t n, int16_t p, neoPixelType t)
+  : NeoPixel(n, new LEDRMTBus(p), t, true) {
+  pin = p;
 }
 
-NeoPixel::NeoPixel(uint16_t n, int16_t p, neoPixelType t)
-  : begun(false), brightness(0), pixels(NULL), endTime(0) {
+NeoPixel::NeoPixel(uint16_t n, LEDBus *bus, neoPixelType t, bool ownsBus)
+  : begun(false), pin(-1), brightness(0), gammaEnabled(false), pixels(NULL),
+    bus(bus), ownsBus(ownsBus), busReady(false), pendingLength(0), framePending(false) {
   updateType(t);
   updateLength(n);
-  pin = p;
-  espInit();
+  buildOutputTable();
 }
 
 NeoPixel::~NeoPixel() {
   if (pixels) {
     clear();
     show();
+    wait();
     free(pixels);
   }
-  if (pin >= 0) pinMode(pin, INPUT);
+  if (ownsBus) delete bus;
 }
 
 bool NeoPixel::begin(void) {
-  if (pin < 0) return false;
-  pinMode(pin, OUTPUT);
-  digitalWrite(pin, LOW);
   begun = true;
-  return true;
+  return initBus();
+}
+
+bool NeoPixel::initBus(void) {
+  if (!busReady && bus && numBytes) busReady = bus->begin(numBytes);
+  return busReady;
 }
 
 void NeoPixel::updateLength(uint16_t n) {
@@ -85,6 +40,7 @@ void NeoPixel::updateLength(uint16_t n) {
   if (pixels) {
     memset(pixels, 0, numBytes);
     numLEDs = n;
+    changed.add(0, numBytes);   // No idea what the strip's showing yet, so the first frame goes out in full
   } else {
     numLEDs = numBytes = 0;
   }
@@ -97,31 +53,73 @@ void NeoPixel::updateType(neoPixelType t) {
   bOffset = t & 0b11;
 }
 
+// Never waits - the frame gets encoded into the spare buffer and goes out as soon as the strip is free.
+// Nothing changed means nothing gets sent, and a frame only runs as far as the last LED that changed.
 void NeoPixel::show(void) {
-  if (!pixels) return;
-  while (!canShow());
-  espShow(pin, pixels, numBytes);
-  endTime = micros();
+  if (!pixels || !initBus() || changed.empty()) return;
+  bus->encode(pixels, changed, outputTable);
+  if (changed.last > pendingLength) pendingLength = changed.last;
+  changed.clear();
+  framePending = true;
+  poll();
+}
+
+// Call this often, it's what actually starts a queued frame. True while there's still something in flight.
+bool NeoPixel::poll(void) {
+  if (!busReady) return false;
+  bool ready = bus->ready();
+
+  if (framePending && ready) {
+    if (bus->transmit(pendingLength)) {
+      ready = false;
+    } else {
+      changed.add(0, pendingLength);   // Never made it out, so the next show() has to cover it again
+    }
+    framePending = false;
+    pendingLength = 0;
+  }
+  return !ready || framePending;
 }
 
-void NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
-  if (n >= numLEDs) return;
-  
-  uint8_t r = (uint8_t)(c >> 16), g = (uint8_t)(c >> 8), b = (uint8_t)c;
-  if (brightness) {
-    r = (r * brightness) >> 8;
-    g = (g * brightness) >> 8;
-    b = (b * brightness) >> 8;
-  }
-  
-  uint8_t *p = &pixels[n * ((wOffset == rOffset) ? 3 : 4)];
-  if (wOffset != rOffset) {
-    uint8_t w = (uint8_t)(c >> 24);
-    p[wOffset] = brightness ? ((w * brightness) >> 8) : w;
+void NeoPixel::wait(void) {
+  uint32_t start = millis();
+  while (poll() && millis() - start < 50) yield();
+}
+
+bool NeoPixel::canShow(void) {
+  return busReady && bus->ready();
+}
+
+// Only marks the pixel as changed if it actually is
+void NeoPixel::store(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
+  const uint8_t stride = (wOffset == rOffset) ? 3 : 4;
+  uint8_t *p = &pixels[n * stride];
+  uint8_t diff = (p[rOffset] ^ r) | (p[gOffset] ^ g) | (p[bOffset] ^ b);
+  if (stride == 4) {
+    diff |= p[wOffset] ^ w;
+    p[wOffset] = w;
   }
+  if (!diff) return;
   p[rOffset] = r;
   p[gOffset] = g;
   p[bOffset] = b;
+  changed.add(n * stride, (n + 1) * stride);
+}
+
+void NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
+  if (n >= numLEDs) return;
+  store(n, (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c, (uint8_t)(c >> 24));
+}
+
+// Same as setPixelColor in a loop, minus the per-call bounds checks
+void NeoPixel::setPixelColors(uint16_t first, const uint32_t *colors, uint16_t count) {
+  if (first >= numLEDs || !colors) return;
+  if (count > numLEDs - first) count = numLEDs - first;
+
+  for (uint16_t i = 0; i < count; i++) {
+    uint32_t c = colors[i];
+    store(first + i, (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c, (uint8_t)(c >> 24));
+  }
 }
 
 void NeoPixel::fill(uint32_t c, uint16_t first, uint16_t count) {
@@ -131,8 +129,8 @@ void NeoPixel::fill(uint32_t c, uint16_t first, uint16_t count) {
   for (uint16_t i = first; i < end; i++) setPixelColor(i, c);
 }
 
-uint32_t NeoPixel::ColorHSV(uint16_t hue, uint8_t sat, uint8_t val) {
-  hue = (hue * 1530L + 32768) / 65536;
+// hue here is already on the 0-1529 wheel
+static inline uint32_t neoHSV(uint16_t hue, uint16_t s1, uint8_t s2, uint32_t v1) {
   uint8_t r, g, b;
   
   if (hue < 510) { // Red to Green
@@ -149,57 +147,74 @@ uint32_t NeoPixel::ColorHSV(uint16_t hue, uint8_t sat, uint8_t val) {
     b = (hue < 1275) ? 255 : 1530 - hue;
   }
 
-  uint32_t v1 = 1 + val;
-  uint16_t s1 = 1 + sat;
-  uint8_t s2 = 255 - sat;
   return ((((((r * s1) >> 8) + s2) * v1) & 0xff00) << 8) |
          (((((g * s1) >> 8) + s2) * v1) & 0xff00) |
          (((((b * s1) >> 8) + s2) * v1) >> 8);
 }
 
+uint32_t NeoPixel::ColorHSV(uint16_t hue, uint8_t sat, uint8_t val) {
+  return neoHSV((hue * 1530L + 32768) / 65536, 1 + sat, 255 - sat, 1 + val);
+}
+
+// A whole run of evenly spaced hues in one go. The wheel position is kept in 16.16 fixed point,
+// so there's no multiply/divide per pixel, and the sat/val terms only get worked out once.
+void NeoPixel::ColorHSVRange(uint32_t *out, uint16_t count, uint16_t first_hue, uint16_t hue_step, uint8_t sat, uint8_t val) {
+  const uint32_t wheel = 1530UL << 16;
+  uint32_t pos = (uint32_t)first_hue * 1530UL + 32768;
+  uint32_t step = (uint32_t)hue_step * 1530UL;   // Hue wraps, so a "negative" step is just a big one
+  const uint16_t s1 = 1 + sat;
+  const uint8_t s2 = 255 - sat;
+  const uint32_t v1 = 1 + val;
+  if (pos >= wheel) pos -= wheel;
+
+  for (uint16_t i = 0; i < count; i++) {
+    out[i] = neoHSV(pos >> 16, s1, s2, v1);
+    pos += step;
+    if (pos >= wheel) pos -= wheel;
+  }
+}
+
 uint32_t NeoPixel::getPixelColor(uint16_t n) const {
   if (n >= numLEDs) return 0;
   uint8_t *p = &pixels[n * ((wOffset == rOffset) ? 3 : 4)];
-  
-  if (wOffset == rOffset) {
-    if (brightness) {
-      return (((uint32_t)(p[rOffset] << 8) / brightness) << 16) |
-             (((uint32_t)(p[gOffset] << 8) / brightness) << 8) |
-             ((uint32_t)(p[bOffset] << 8) / brightness);
-    }
-    return ((uint32_t)p[rOffset] << 16) | ((uint32_t)p[gOffset] << 8) | p[bOffset];
-  } else {
-    if (brightness) {
-      return (((uint32_t)(p[wOffset] << 8) / brightness) << 24) |
-             (((uint32_t)(p[rOffset] << 8) / brightness) << 16) |
-             (((uint32_t)(p[gOffset] << 8) / brightness) << 8) |
-             ((uint32_t)(p[bOffset] << 8) / brightness);
-    }
-    return ((uint32_t)p[wOffset] << 24) | ((uint32_t)p[rOffset] << 16) | ((uint32_t)p[gOffset] << 8) | p[bOffset];
+  uint32_t c = ((uint32_t)p[rOffset] << 16) | ((uint32_t)p[gOffset] << 8) | p[bOffset];
+  if (wOffset != rOffset) c |= (uint32_t)p[wOffset] << 24;
+  return c;
+}
+
+// Brightness and gamma folded into one table, so encoding is a single lookup per byte
+void NeoPixel::buildOutputTable(void) {
+  for (uint16_t x = 0; x < 256; x++) {
+    uint8_t v = gammaEnabled ? gamma8(x) : x;
+    outputTable[x] = brightness ? (v * brightness) >> 8 : v;
   }
 }
 
+// The stored colours aren't touched, so turning it down and back up again loses nothing
 void NeoPixel::setBrightness(uint8_t b) {
   uint8_t newBrightness = b + 1;
   if (newBrightness == brightness) return;
-  
-  uint16_t scale;
-  if (brightness == 1) {
-    scale = 0;
-  } else if (b == 255) {
-    scale = 65535 / (brightness - 1);
-  } else {
-    scale = (((uint16_t)newBrightness << 8) - 1) / (brightness - 1);
-  }
-  
-  for (uint16_t i = 0; i < numBytes; i++) {
-    pixels[i] = (pixels[i] * scale) >> 8;
-  }
   brightness = newBrightness;
+  buildOutputTable();
+  changed.add(0, numBytes);
+}
+
+void NeoPixel::setGamma(bool enable) {
+  if (enable == gammaEnabled) return;
+  gammaEnabled = enable;
+  buildOutputTable();
+  changed.add(0, numBytes);
 }
 
 void NeoPixel::clear(void) {
-  if (pixels) memset(pixels, 0, numBytes);
+  if (!pixels) return;
+  // Only the span that was actually lit counts as changed
+  uint16_t first = 0, last = numBytes;
+  while (first < last && !pixels[first]) first++;
+  while (last > first && !pixels[last - 1]) last--;
+  if (first == last) return;
+  memset(&pixels[first], 0, last - first);
+  changed.add(first, last);
 }
 
 uint32_t NeoPixel::gamma32(uint32_t x) {
@@ -209,9 +224,15 @@ uint32_t NeoPixel::gamma32(uint32_t x) {
 }
 
 void NeoPixel::rainbow(uint16_t first_hue, int8_t reps, uint8_t saturation, uint8_t bright, bool gammify) {
-  for (uint16_t i = 0; i < numLEDs; i++) {
-    uint16_t hue = first_hue + (i * (uint32_t)reps * 65536) / numLEDs;
-    uint32_t color = ColorHSV(hue, saturation, bright);
-    setPixelColor(i, gammify ? gamma32(color) : color);
+  if (!numLEDs) return;
+  uint32_t colors[32];
+  uint16_t step = (uint16_t)(((int32_t)reps * 65536) / numLEDs);
+  for (uint16_t i = 0; i < numLEDs; i += 32) {
+    uint16_t run = (numLEDs - i) < 32 ? (numLEDs - i) : 32;
+    ColorHSVRange(colors, run, first_hue + (uint16_t)(i * step), step, saturation, bright);
+    if (gammify) {
+      for (uint16_t j = 0; j < run; j++) colors[j] = gamma32(colors[j]);
+    }
+    setPixelColors(i, colors, run);
   }
 }
@@ -2,9 +2,10 @@
 #define NEOPIXEL_H
 
 #include <Arduino.h>
-#include <driver/rmt_tx.h>
+#include "LEDBus.h"
 
 #define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_BGR ((2 << 6) | (2 << 4) | (1 << 2) | (0))   // APA102/SK9822 wire order
 
 #define RGB_AZURE       0x99, 0xF5, 0xFF
 #define RGB_BLACK       0x00, 0x00, 0x00
@@ -44,23 +45,28 @@ static const uint8_t PROGMEM _NeoPixelGammaTable[256] = {
 class NeoPixel {
 public:
   NeoPixel(uint16_t n, int16_t pin = 6, neoPixelType type = NEO_GRB);
+  NeoPixel(uint16_t n, LEDBus *bus, neoPixelType type = NEO_GRB, bool ownsBus = false);
   ~NeoPixel();
 
   bool begin(void);
   void show(void);
+  bool poll(void);
+  void wait(void);
   void setPixelColor(uint16_t n, uint32_t c);
+  void setPixelColors(uint16_t first, const uint32_t *colors, uint16_t count);
   void fill(uint32_t c = 0, uint16_t first = 0, uint16_t count = 0);
   void setBrightness(uint8_t);
+  void setGamma(bool enable);   // Applied on output, so leave rainbow()'s gammify off when this is on
   void clear(void);
   
-  bool canShow(void) {
-    uint32_t now = micros();
-    if (endTime > now) endTime = now;
-    return (now - endTime) >= 300L;
-  }
+  bool canShow(void);
+  bool isChanged(void) const { return !changed.empty(); }
+  // For anything written straight into getPixels(), otherwise show() won't know it's there
+  void markAllChanged(void) { changed.add(0, numBytes); }
   
   uint8_t *getPixels(void) const { return pixels; };
   uint8_t getBrightness(void) const { return brightness - 1; };
+  bool getGamma(void) const { return gammaEnabled; }
   int16_t getPin(void) const { return pin; };
   uint16_t numPixels(void) const { return numLEDs; }
   uint32_t getPixelColor(uint16_t n) const;
@@ -68,6 +74,7 @@ public:
   static uint8_t gamma8(uint8_t x) { return pgm_read_byte(&_NeoPixelGammaTable[x]); }
   static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) { return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b; }
   static uint32_t ColorHSV(uint16_t hue, uint8_t sat = 255, uint8_t val = 255);
+  static void ColorHSVRange(uint32_t *out, uint16_t count, uint16_t first_hue, uint16_t hue_step, uint8_t sat = 255, uint8_t val = 255);
   static uint32_t gamma32(uint32_t x);
 
   void rainbow(uint16_t first_hue = 0, int8_t reps = 1, uint8_t saturation = 255, uint8_t brightness = 255, bool gammify = true);
@@ -75,18 +82,29 @@ public:
 private:
   void updateType(neoPixelType t);
   void updateLength(uint16_t n);
+  bool initBus(void);
+  void buildOutputTable(void);
+  void store(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
 
   bool begun;
   uint16_t numLEDs;
   uint16_t numBytes;
   int16_t pin;
   uint8_t brightness;
-  uint8_t *pixels;
+  bool gammaEnabled;
+  uint8_t *pixels;      // Logical colours, brightness and gamma only get applied on the way out
+  uint8_t outputTable[256];
   uint8_t rOffset;
   uint8_t gOffset;
   uint8_t bOffset;
   uint8_t wOffset;
-  uint32_t endTime;
+
+  LEDBus *bus;
+  bool ownsBus;
+  bool busReady;
+  LEDRange changed;        // Pixel bytes that differ from the last frame handed to the bus
+  uint16_t pendingLength;  // How far into the strip the queued frame has to go
+  bool framePending;
 };
 
 #endif
@@ -6,11 +6,42 @@
 #include <Arduino.h>
 #include "OLED.h"
 
+// The 2x font is worked out by the compiler, so big text costs the same per column as small text
+struct OLEDDoubleFont {
+    uint16_t columns[sizeof(oled_font6x8)];
+};
+
+static constexpr uint16_t oled_double_bits(uint8_t b)
+{
+    uint16_t w = 0;
+    for (uint_fast8_t bit = 0; bit < 8; bit++)
+    {
+        if (b & (1 << bit)) w |= 3 << (bit << 1);
+    }
+    return w;
+}
+
+static constexpr OLEDDoubleFont oled_expand_font()
+{
+    OLEDDoubleFont font{};
+    for (size_t i = 0; i < sizeof(oled_font6x8); i++)
+    {
+        font.columns[i] = oled_double_bits(oled_font6x8[i]);
+    }
+    return font;
+}
+
+static constexpr OLEDDoubleFont oled_font12x16 PROGMEM = oled_expand_font();
+
 OLED::OLED(uint8_t sda_pin, uint8_t scl_pin, uint_fast8_t width, uint_fast8_t height, 
            tDisplayCtrl displayCtrl, uint8_t i2c_address) :
-    sda_pin(sda_pin),
-    scl_pin(scl_pin),
-    i2c_address(i2c_address),
+    OLED(new OLEDSoftI2C(sda_pin, scl_pin, i2c_address), width, height, displayCtrl, true)
+{
+}
+
+OLED::OLED(OLEDBus* bus, uint_fast8_t width, uint_fast8_t height, tDisplayCtrl displayCtrl, bool ownsBus) :
+    bus(bus),
+    ownsBus(ownsBus),
     displayController(displayCtrl),
     width(width),
     height(height),
@@ -23,107 +54,57 @@ OLED::OLED(uint8_t sda_pin, uint8_t scl_pin, uint_fast8_t width, uint_fast8_t he
     ttyMode = OLED_DEFAULT_TTY_MODE;
     fontInverted = false;
     usingOffset = false;
+    pageOffset = 0;
+    startLinePending = false;
+    // The start line only wraps cleanly if the buffer covers all of the controller's RAM rows
+    hwScroll = (displayCtrl == CTRL_SH1107) ? (height == 128) : (height == 64);
+    flushState = FLUSH_IDLE;
+    flushPage = 0;
+    flushCol = 0;
+    flushEnd = 0;
+    mark_all_dirty();
 }
 
 OLED::~OLED()
 {
     free(buffer);
+    if (ownsBus) delete bus;
 }
 
-void OLED::i2c_start()
-{
-    while (!digitalRead(sda_pin) || !digitalRead(scl_pin));
-    digitalWrite(sda_pin, LOW);
-    pinMode(sda_pin, OUTPUT);
-    OLED_I2C_DELAY;
-    digitalWrite(scl_pin, LOW);
-    pinMode(scl_pin, OUTPUT);
-    OLED_I2C_DELAY;
-}
-
-void OLED::i2c_stop()
+bool OLED::send_commands(const uint8_t* cmds, size_t length)
 {
-    pinMode(scl_pin, INPUT);
-    digitalWrite(scl_pin, HIGH);
-    OLED_I2C_DELAY;
-    pinMode(sda_pin, INPUT);
-    digitalWrite(sda_pin, HIGH);
-    OLED_I2C_DELAY;
-    while (!digitalRead(sda_pin) || !digitalRead(scl_pin));
-}
-
-bool OLED::i2c_send(uint8_t byte)
-{
-    for (int_fast8_t bit = 7; bit >= 0; bit--)
-    {
-        if (byte & 128) {
-          pinMode(sda_pin, INPUT);
-          digitalWrite(sda_pin, HIGH);
-        } else {
-          digitalWrite(sda_pin, LOW);
-          pinMode(sda_pin, OUTPUT);
-        }
-        OLED_I2C_DELAY;
-        pinMode(scl_pin, INPUT);
-        digitalWrite(scl_pin, HIGH);        
-        OLED_I2C_DELAY;
-        while (!digitalRead(scl_pin)); 
-        digitalWrite(scl_pin, LOW);
-        pinMode(scl_pin, OUTPUT);
-        OLED_I2C_DELAY;
-        byte = byte << 1;
-    }
-    pinMode(sda_pin, INPUT);
-    digitalWrite(sda_pin, HIGH);
-    pinMode(scl_pin, INPUT);
-    digitalWrite(scl_pin, HIGH);    
-    OLED_I2C_DELAY;
-    while (!digitalRead(scl_pin)); 
-    bool ack = digitalRead(sda_pin) == 0;    
-    digitalWrite(scl_pin, LOW);
-    pinMode(scl_pin, OUTPUT);
-    OLED_I2C_DELAY;
-    return ack;
+    return bus->command(cmds, length);
 }
 
 void OLED::begin()
 {
-
-    pinMode(sda_pin, INPUT);
-    pinMode(scl_pin, INPUT);
+    static const uint8_t init_sequence[] = {
+        0xAE,
+        0xD5, 0x80,
+        0xA8, 63,
+        0xD3, 0x00,
+        0x40,
+        0x8D, 0x14,
+        0x20, 0x00,
+        0xA1,
+        0xC8,
+        0xDA, 0x12,
+        0x81, 0x80,
+        0xD9, 0x22,
+        0xDB, 0x20,
+        0xA4,
+        0xA6,
+        0x2E
+    };
+
+    bus->begin();
     
     delay(100);
-    i2c_start();
-    i2c_send(i2c_address << 1);
-    i2c_send(0x00);
-    i2c_send(0xAE);
-    i2c_send(0xD5);
-    i2c_send(0x80); 
-    i2c_send(0xA8);
-    i2c_send(63); 
-    i2c_send(0xD3);
-    i2c_send(0x00); 
-    i2c_send(0x40);
-    i2c_send(0x8D);
-    i2c_send(0x14); 
-    i2c_send(0x20);
-    i2c_send(0x00); 
-    i2c_send(0xA1);
-    i2c_send(0xC8);
-    i2c_send(0xDA);
-    i2c_send(0x12); 
-    i2c_send(0x81);
-    i2c_send(0x80);
-    i2c_send(0xD9);
-    i2c_send(0x22); 
-    i2c_send(0xDB);
-    i2c_send(0x20); 
-    i2c_send(0xA4);
-    i2c_send(0xA6);
-    i2c_send(0x2E);
-    i2c_stop();
+    send_commands(init_sequence, sizeof(init_sequence));
     delay(100);
 
+    pageOffset = 0;
+    startLinePending = false;
     clear();
     display();
     set_power(true);
@@ -131,81 +112,56 @@ void OLED::begin()
 
 void OLED::set_power(bool enable)
 {
-    i2c_start();
-    i2c_send(i2c_address << 1);
-    i2c_send(0x00);
-    if (enable)
-    {
-        i2c_send(0x8D);
-        i2c_send(0x14);
-        i2c_send(0xAF);
-    }
-    else
-    {
-        i2c_send(0xAE);
-        i2c_send(0x8D);
-        i2c_send(0x10);
-    }
-    i2c_stop();
+    static const uint8_t power_on[]  = { 0x8D, 0x14, 0xAF };
+    static const uint8_t power_off[] = { 0xAE, 0x8D, 0x10 };
+    
+    if (enable) send_commands(power_on, sizeof(power_on));
+    else        send_commands(power_off, sizeof(power_off));
 }
 
 void OLED::set_invert(bool enable)
 {
-    i2c_start();
-    i2c_send(i2c_address << 1);
-    i2c_send(0x00);
-    if (enable)
-    {
-        i2c_send(0xA7);
-    }
-    else
-    {
-        i2c_send(0xA6);
-    }
-    i2c_stop();
+    uint8_t cmd = enable ? 0xA7 : 0xA6;
+    send_commands(&cmd, 1);
 }
 
 void OLED::set_scrolling(tScrollEffect scroll_type, uint_fast8_t first_page, uint_fast8_t last_page)
 {
-    i2c_start();
-    i2c_send(i2c_address << 1);
-    i2c_send(0x00);
-    i2c_send(0x2E);
+    uint8_t cmds[13];
+    size_t n = 0;
+    
+    cmds[n++] = 0x2E;
     if (scroll_type == DIAGONAL_LEFT || scroll_type == DIAGONAL_RIGHT)
     {
-        i2c_send(0xA3);
-        i2c_send(0x00);
-        i2c_send(63);
+        cmds[n++] = 0xA3;
+        cmds[n++] = 0x00;
+        cmds[n++] = 63;
     }
     if (scroll_type != NO_SCROLLING)
     {
-        i2c_send(scroll_type);
-        i2c_send(0x00);
-        i2c_send(first_page);
-        i2c_send(0x00);
-        i2c_send(last_page);
+        cmds[n++] = scroll_type;
+        cmds[n++] = 0x00;
+        cmds[n++] = first_page;
+        cmds[n++] = 0x00;
+        cmds[n++] = last_page;
         if (scroll_type == DIAGONAL_LEFT || scroll_type == DIAGONAL_RIGHT)
         {
-            i2c_send(0x01);
+            cmds[n++] = 0x01;
         }
         else
         {
-            i2c_send(0x00);
-            i2c_send(0xFF);
+            cmds[n++] = 0x00;
+            cmds[n++] = 0xFF;
         }
-        i2c_send(0x2F);
+        cmds[n++] = 0x2F;
     }
-    i2c_stop();
+    send_commands(cmds, n);
 }
 
 void OLED::set_contrast(uint8_t contrast)
 {
-    i2c_start();
-    i2c_send(i2c_address << 1);
-    i2c_send(0x00);
-    i2c_send(0x81);
-    i2c_send(contrast); 
-    i2c_stop();
+    uint8_t cmds[] = { 0x81, contrast };
+    send_commands(cmds, sizeof(cmds));
 }
 
 void OLED::clear(tColor color)
@@ -220,118 +176,195 @@ void OLED::clear(tColor color)
     }
     X=0;
     Y=0;
+    mark_all_dirty();
 }
 
-void OLED::display()
+// Fills a box a whole byte at a time, masking off the partial pages at the top and bottom
+void OLED::clear_area(uint_fast8_t x0, uint_fast8_t y0, uint_fast8_t x1, uint_fast8_t y1, tColor color)
 {
-    uint16_t index = 0;
-    for (uint_fast8_t page = 0; page < pages; page++)
+    if (x0 >= width || y0 >= height || x1 < x0 || y1 < y0) return;
+    if (x1 >= width) x1 = width - 1;
+    if (y1 >= height) y1 = height - 1;
+    
+    for (uint_fast8_t page = y0 / 8; page <= y1 / 8; page++)
     {
-        i2c_start();
-        i2c_send(i2c_address << 1);
-        i2c_send(0x00);
-        if (displayController == CTRL_SSD1306) {
-            i2c_send(0xB0 + page);
-            i2c_send(0x21);
-            i2c_send(0x00);
-            i2c_send(width - 1);
-        } else {
-            i2c_send(0xB0 + page);
-            i2c_send(0x00);
-            i2c_send(0x10);
-        }
-        i2c_stop();
-
-        i2c_start();
-        i2c_send(i2c_address << 1);
-        i2c_send(0x40);
-        if(usingOffset){
-            i2c_send(0);
-            i2c_send(0);
-        }
-        for (uint_fast8_t column = 0; column < width; column++)
+        uint8_t mask = 0xFF;
+        if (page == y0 / 8) mask &= 0xFF << (y0 & 7);
+        if (page == y1 / 8) mask &= 0xFF >> (7 - (y1 & 7));
+        
+        uint8_t* row = page_ptr(page);
+        for (uint_fast8_t x = x0; x <= x1; x++)
         {
-            i2c_send(buffer[index++]);
+            if (color == WHITE) row[x] |= mask;
+            else row[x] &= ~mask;
         }
-        i2c_stop();
-        yield();
     }
+    mark_dirty(x0, y0, x1, y1);
 }
 
-void OLED::draw_byte(uint_fast8_t x, uint_fast8_t y, uint8_t b, tColor color)
+void OLED::mark_all_dirty()
 {
-    if (x >= width || y >= height) return;
+    for (uint_fast8_t page = 0; page < OLED_MAX_PAGES; page++)
+    {
+        dirtyMin[page] = 0;
+        dirtyMax[page] = width - 1;
+    }
+}
 
-    uint_fast16_t buffer_index = y / 8 * width + x;
+void OLED::mark_dirty(uint_fast8_t x0, uint_fast8_t y0, uint_fast8_t x1, uint_fast8_t y1)
+{
+    if (x0 >= width || y0 >= height) return;
+    if (x1 >= width) x1 = width - 1;
+    if (y1 >= height) y1 = height - 1;
+    for (uint_fast8_t page = y0 / 8; page <= y1 / 8; page++)
+    {
+        mark_page_dirty(page, x0, x1);
+    }
+}
 
-    if (fontInverted) {
-        b^=255;
+bool OLED::is_dirty()
+{
+    if (startLinePending) return true;
+    for (uint_fast8_t page = 0; page < pages; page++)
+    {
+        if (dirtyMin[page] <= dirtyMax[page]) return true;
     }
+    return false;
+}
 
-    if (color == WHITE)
+// Blocking flush, finishes whatever's in flight and then sends everything else that's dirty
+void OLED::display()
+{
+    while (flush_step()) yield();
+    display_async();
+    while (flush_step()) yield();
+}
+
+// Kicks off a flush without waiting for it - flush_step() then moves it along one bus transaction at a time
+bool OLED::display_async()
+{
+    if (flushState != FLUSH_IDLE) return true;
+    if (!is_dirty()) return false;
+    
+    flushPage = 0;
+    flushState = FLUSH_ADDRESS;
+    return true;
+}
+
+// Only the changed column window of each changed page goes out over the bus
+bool OLED::flush_step()
+{
+    switch (flushState)
     {
-        if (y % 8 == 0)
+    case FLUSH_IDLE:
+        return false;
+        
+    case FLUSH_ADDRESS:
+    {
+        while (flushPage < pages && dirtyMin[flushPage] > dirtyMax[flushPage]) flushPage++;
+        if (flushPage >= pages)
         {
-            if (buffer_index < bufsize) buffer[buffer_index] |= b;
+            // Start line goes last, so a freshly scrolled-in line is already there when it appears
+            if (startLinePending) send_start_line();
+            flushState = FLUSH_IDLE;
+            return false;
         }
-        else
-        {
-            uint16_t w = (uint16_t) b << (y % 8);
-            if (buffer_index < bufsize) buffer[buffer_index] |= (w & 0xFF);
-            uint16_t buffer_index2 = buffer_index + width;
-            if (buffer_index2 < bufsize) buffer[buffer_index2] |= (w >> 8);
+        
+        // Without hardware scrolling the ring gets unrolled here instead
+        uint_fast8_t ram_page = hwScroll ? flushPage : (flushPage + pages - pageOffset) % pages;
+        uint_fast8_t x0 = dirtyMin[flushPage];
+        uint_fast8_t x1 = dirtyMax[flushPage];
+        
+        // Clean the page now, anything drawn while it's going out marks it again for next time
+        dirtyMin[flushPage] = 0xFF;
+        dirtyMax[flushPage] = 0;
+        
+        uint8_t cmds[7];
+        size_t n = 0;
+        if (displayController == CTRL_SSD1306) {
+            // Horizontal addressing mode, so set both the column and the page window
+            cmds[n++] = 0xB0 + ram_page;
+            cmds[n++] = 0x21;
+            cmds[n++] = x0;
+            cmds[n++] = x1;
+            cmds[n++] = 0x22;
+            cmds[n++] = ram_page;
+            cmds[n++] = ram_page;
+        } else {
+            // SH110x only does page addressing, column goes in as two nibbles
+            uint_fast8_t column = x0 + (usingOffset ? 2 : 0);
+            cmds[n++] = 0xB0 + ram_page;
+            cmds[n++] = 0x00 | (column & 0x0F);
+            cmds[n++] = 0x10 | (column >> 4);
         }
+        send_commands(cmds, n);
+        
+        flushCol = x0;
+        flushEnd = x1;
+        flushState = FLUSH_DATA;
+        return true;
     }
-    else
+        
+    case FLUSH_DATA:
     {
-        if (y % 8 == 0)
-        {
-            if (buffer_index < bufsize) buffer[buffer_index] &= ~b;
-        }
-        else
+        size_t chunk = flushEnd - flushCol + 1;
+        if (chunk > bus->maxChunk()) chunk = bus->maxChunk();
+        
+        bus->data(&buffer[flushPage * width + flushCol], chunk);
+        flushCol += chunk;
+        
+        if (flushCol > flushEnd)
         {
-            uint16_t w = (uint16_t) b << (y % 8);
-            if (buffer_index < bufsize) buffer[buffer_index] &= ~(w & 0xFF);
-            uint16_t buffer_index2 = buffer_index + width;
-            if (buffer_index2 < bufsize) buffer[buffer_index2] &= ~(w >> 8);
+            flushPage++;
+            flushState = FLUSH_ADDRESS;
         }
+        return true;
+    }
     }
+    return false;
 }
 
-void OLED::draw_bytes(uint_fast8_t x, uint_fast8_t y, const uint8_t* data, uint_fast8_t size, tFontScaling scaling, tColor color, bool useProgmem)
+// Columns go into the framebuffer a page at a time - page-aligned it's a straight OR per
+// column, otherwise each column gets shifted once and merged into the pages it straddles
+template <typename T>
+void OLED::blit_columns(uint_fast8_t x, uint_fast8_t y, const T* columns, uint_fast8_t count, tColor color, bool useProgmem)
 {
-    for (uint_fast8_t column = 0; column < size; column++)
+    if (x >= width || y >= height) return;
+    if (count > width - x) count = width - x;
+    if (count == 0) return;
+
+    const uint_fast8_t first_page = y / 8;
+    const uint_fast8_t shift = y & 7;
+    const uint_fast8_t span = sizeof(T) + (shift ? 1 : 0);
+    const uint32_t invert = fontInverted ? (uint32_t)(T)~(T)0 : 0;
+
+    for (uint_fast8_t p = 0; p < span && first_page + p < pages; p++)
     {
-        uint8_t b = useProgmem ? pgm_read_byte(data) : *data;
-        data++;
-        if (scaling == DOUBLE_SIZE)
-        {
-            uint16_t w = 0;
-            for (uint_fast8_t bit = 0; bit < 7; bit++)
-            {
-                if (b & (1 << bit))
-                {
-                    uint_fast8_t pos = bit << 1;
-                    w |= ((1 << pos) | (1 << (pos + 1)));
-                }
-            }
-            draw_byte(x, y, w & 0xFF, color);
-            draw_byte(x, y + 8, (w >> 8), color);
-            x++;
-            draw_byte(x, y, w & 0xFF, color);
-            draw_byte(x, y + 8, (w >> 8), color);
-            x++;
-        }
-        else
+        uint8_t* row = page_ptr(first_page + p) + x;
+        const uint_fast8_t bit_offset = p * 8;
+
+        for (uint_fast8_t i = 0; i < count; i++)
         {
-            draw_byte(x++, y, b, color);
+            uint32_t column;
+            if (sizeof(T) == 1) column = useProgmem ? pgm_read_byte(&columns[i]) : columns[i];
+            else                column = useProgmem ? pgm_read_word(&columns[i]) : columns[i];
+
+            uint8_t b = (uint8_t)(((column ^ invert) << shift) >> bit_offset);
+            if (color == WHITE) row[i] |= b;
+            else row[i] &= ~b;
         }
+        mark_page_dirty(first_page + p, x, x + count - 1);
     }
 }
 
+void OLED::draw_bytes(uint_fast8_t x, uint_fast8_t y, const uint8_t* data, uint_fast8_t size, tColor color, bool useProgmem)
+{
+    blit_columns(x, y, data, size, color, useProgmem);
+}
+
 size_t OLED::draw_character(uint_fast8_t x, uint_fast8_t y, char c, tFontScaling scaling, tColor color)
 {
-    if (x >= width || y >= height || c < 32) return 0;
+    if (x >= width || y >= height || (unsigned char) c < 32) return 0;
 
     switch ((unsigned char) c)
     {
@@ -345,10 +378,23 @@ size_t OLED::draw_character(uint_fast8_t x, uint_fast8_t y, char c, tFontScaling
         case 223: c = 134; break;
     }
 
-    uint16_t font_index = (c - 32)*6;
+    uint16_t font_index = ((unsigned char) c - 32)*6;
     if (font_index >= sizeof (oled_font6x8)) return 0;
 
-    draw_bytes(x, y, &oled_font6x8[font_index], 6, scaling, color, true);
+    if (scaling == DOUBLE_SIZE)
+    {
+        // Each 16 bit column of the doubled glyph goes out twice to double the width too
+        uint16_t columns[12];
+        for (uint_fast8_t i = 0; i < 6; i++)
+        {
+            columns[i * 2] = columns[i * 2 + 1] = pgm_read_word(&oled_font12x16.columns[font_index + i]);
+        }
+        blit_columns(x, y, columns, 12, color, false);
+    }
+    else
+    {
+        blit_columns(x, y, &oled_font6x8[font_index], 6, color, true);
+    }
     return 1;
 }
 
@@ -378,7 +424,7 @@ void OLED::draw_bitmap(uint_fast8_t x, uint_fast8_t y, uint_fast8_t bitmap_width
     uint_fast8_t num_pages = (bitmap_height + 7) / 8;
     for (uint_fast8_t page = 0; page < num_pages; page++)
     {
-        draw_bytes(x, y, data, bitmap_width, NORMAL_SIZE, color, false);
+        draw_bytes(x, y, data, bitmap_width, color, false);
         data += bitmap_width;
         y += 8;
     }
@@ -389,7 +435,7 @@ void OLED::draw_bitmap_P(uint_fast8_t x, uint_fast8_t y, uint_fast8_t bitmap_wid
     uint_fast8_t num_pages = (bitmap_height + 7) / 8;
     for (uint_fast8_t page = 0; page < num_pages; page++)
     {
-        draw_bytes(x, y, data, bitmap_width, NORMAL_SIZE, color, true);
+        draw_bytes(x, y, data, bitmap_width, color, true);
         data += bitmap_width;
         y += 8;
     }
@@ -398,13 +444,14 @@ void OLED::draw_bitmap_P(uint_fast8_t x, uint_fast8_t y, uint_fast8_t bitmap_wid
 void OLED::draw_pixel(uint_fast8_t x, uint_fast8_t y, tColor color)
 {
     if (x >= width || y >= height) return;
+    mark_page_dirty(y / 8, x, x);
     if (color == WHITE)
     {
-        buffer[x + (y / 8) * width] |= (1 << (y & 7));
+        page_ptr(y / 8)[x] |= (1 << (y & 7));
     }
     else
     {
-        buffer[x + (y / 8) * width] &= ~(1 << (y & 7));
+        page_ptr(y / 8)[x] &= ~(1 << (y & 7));
     }
 }
 
@@ -520,60 +567,90 @@ void OLED::draw_rectangle(uint_fast8_t x0, uint_fast8_t y0, uint_fast8_t x1, uin
     }
 }
 
+void OLED::send_start_line()
+{
+    uint_fast8_t line = hwScroll ? pageOffset * 8 : 0;
+    if (displayController == CTRL_SH1107)
+    {
+        uint8_t cmds[] = { 0xDC, (uint8_t) line };
+        send_commands(cmds, sizeof(cmds));
+    }
+    else
+    {
+        uint8_t cmd = 0x40 | line;
+        send_commands(&cmd, 1);
+    }
+    startLinePending = false;
+}
+
+// Scrolls one whole text line - the top page gets blanked and becomes the bottom page
+void OLED::scroll_page()
+{
+    memset(page_ptr(0), 0, width);
+    pageOffset = (pageOffset + 1) % pages;
+    
+    if (hwScroll)
+    {
+        // One blank page and a start line command, that's the whole transfer
+        mark_page_dirty(pages - 1, 0, width - 1);
+        startLinePending = true;
+    }
+    else
+    {
+        mark_all_dirty();
+    }
+}
+
 void OLED::scroll_up(uint_fast8_t num_lines, uint_fast8_t delay_ms)
 {
     if (delay_ms == 0)
     {
         uint_fast8_t scroll_pages = num_lines / 8;
-        for (uint_fast8_t i = 0; i < pages; i++)
+        if (scroll_pages >= pages)
         {
-            for (uint_fast8_t x = 0; x < width; x++)
-            {
-                uint16_t index = i * width + x;
-                uint16_t index2 = (i + scroll_pages) * width + x;
-                if (index2 < bufsize) buffer[index] = buffer[index2];
-                else buffer[index] = 0;
-            }
+            uint_fast8_t x = X, y = Y;
+            clear();
+            X = x;
+            Y = y;
+        }
+        else
+        {
+            for (uint_fast8_t i = 0; i < scroll_pages; i++) scroll_page();
         }
         num_lines -= scroll_pages * 8;
     }
 
-    bool need_refresh=true;
     if (num_lines > 0)
     {
         uint16_t start=millis() & 0xFFFF;
         uint16_t target_time=0;
         
+        // Anything that isn't a whole page still has to be bit-shifted the slow way
         for (uint_fast8_t i = 0; i < num_lines; i++)
         {
             for (uint_fast8_t j = 0; j < pages; j++)
             {
-                uint16_t index = j*width;
-                uint16_t index2 = index + width;
+                uint8_t* row = page_ptr(j);
+                uint8_t* next = (j + 1 < pages) ? page_ptr(j + 1) : nullptr;
                 for (uint_fast8_t x = 0; x < width; x++)
                 {
-                    uint_fast8_t carry = 0;
-                    if (index2 < bufsize && (buffer[index2] & 1)) carry = width;
-                    buffer[index] = (buffer[index] >> 1) | carry;
-                    index++;
-                    index2++;
+                    uint_fast8_t carry = (next && (next[x] & 1)) ? 0x80 : 0;
+                    row[x] = (row[x] >> 1) | carry;
                 }
             }
-            need_refresh=true;
-            target_time+=delay_ms;
+            mark_all_dirty();
+            if (delay_ms == 0) continue;
             
+            // Animated, so each step has to actually be on screen before the next one
+            target_time+=delay_ms;
             uint16_t now=millis() & 0xFFFF;
-            if (now-start < target_time)
-            {
-                display();
-                need_refresh=false;
-            }
-                       
+            if (now-start < target_time) display();
             while((millis() & 0xFFFF)-start < target_time) yield();
         }
+        if (delay_ms) display();
     }
     
-    if (need_refresh) display();
+    // Otherwise it's only marked dirty, the next flush sends it
 }
 
 size_t OLED::write(uint8_t c)
@@ -648,25 +725,36 @@ size_t OLED::write(const uint8_t *buffer, size_t len)
 		}
 		else if (*(buffer+ix) == '\f')
 		{
-			scroll_up(64);
+			scroll_up(height);
 			X=0;
 			Y=0;
 		}
 		else
 		{
+			// A console wraps long lines rather than drawing off the edge
+			if (ttyMode && X + OLED_FONT_WIDTH > width)
+			{
+				X=0;
+				Y+=(OLED_FONT_HEIGHT);
+				if (Y + OLED_FONT_HEIGHT > height)
+				{
+					scroll_up(OLED_FONT_HEIGHT);
+					Y=height-OLED_FONT_HEIGHT;
+				}
+			}
 			write(buffer[ix]);
 		}
 
 		if (ttyMode)
 		{
-			if (Y >= 64)
+			if (Y + OLED_FONT_HEIGHT > height)
 			{
 				scroll_up(OLED_FONT_HEIGHT);
-				Y=64-OLED_FONT_HEIGHT;
+				Y=height-OLED_FONT_HEIGHT;
 			}
 		}
     }
-    if (ttyMode) display();
+    // Only the pages that changed are marked, display() or an async flush sends them
     return len;
 }
 
@@ -8,17 +8,18 @@
 
 #include <stdint.h>
 #include "Print.h"
+#include "OLEDBus.h"
 
-#define OLED_I2C_DELAY delayMicroseconds(1)
 #define OLED_FONT_HEIGHT 8
 #define OLED_FONT_WIDTH 6
 #define OLED_DEFAULT_TTY_MODE false
+#define OLED_MAX_PAGES 16 // 128px tall is the biggest any of the supported controllers go
 
 #define SSD1306 OLED::CTRL_SSD1306
 #define SH1106  OLED::CTRL_SH1106
 #define SH1107  OLED::CTRL_SH1107
 
-static const uint8_t oled_font6x8 [] PROGMEM = {
+static constexpr uint8_t oled_font6x8 [] PROGMEM = {
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // sp
     0x00, 0x00, 0x00, 0x2f, 0x00, 0x00, // !
     0x00, 0x00, 0x07, 0x00, 0x07, 0x00, // "
@@ -169,6 +170,7 @@ public:
     enum tDisplayCtrl { CTRL_SSD1306, CTRL_SH1106, CTRL_SH1107 };
     
     OLED(uint8_t sda_pin, uint8_t scl_pin, uint_fast8_t width, uint_fast8_t height, tDisplayCtrl displayCtrl=CTRL_SSD1306, uint8_t i2c_address=0x3C);
+    OLED(OLEDBus* bus, uint_fast8_t width, uint_fast8_t height, tDisplayCtrl displayCtrl=CTRL_SSD1306, bool ownsBus=false);
     
     virtual ~OLED();    
     
@@ -180,7 +182,14 @@ public:
     void set_scrolling(tScrollEffect scroll_type, uint_fast8_t first_page=0, uint_fast8_t last_page=7);
     void scroll_up(uint_fast8_t num_lines=OLED_FONT_HEIGHT, uint_fast8_t delay_ms=0);
     void display();    
+    bool display_async();
+    bool flush_step();
+    bool is_flushing() const { return flushState != FLUSH_IDLE; }
+    bool is_dirty();
+    void mark_dirty(uint_fast8_t x0, uint_fast8_t y0, uint_fast8_t x1, uint_fast8_t y1);
+    void mark_all_dirty();
     void clear(tColor color=BLACK);
+    void clear_area(uint_fast8_t x0, uint_fast8_t y0, uint_fast8_t x1, uint_fast8_t y1, tColor color=BLACK);
     void draw_bitmap(uint_fast8_t x, uint_fast8_t y, uint_fast8_t width, uint_fast8_t height, const uint8_t* data, tColor color=WHITE);
     void draw_bitmap_P(uint_fast8_t x, uint_fast8_t y, uint_fast8_t width, uint_fast8_t height, const uint8_t* data, tColor color=WHITE);
     size_t draw_character(uint_fast8_t x, uint_fast8_t y, char c, tFontScaling scaling=NORMAL_SIZE, tColor color=WHITE);
@@ -210,9 +219,10 @@ public:
         
 private:
 
-    const uint8_t sda_pin;
-    const uint8_t scl_pin;
-    const uint8_t i2c_address;
+    enum tFlushState : uint8_t { FLUSH_IDLE, FLUSH_ADDRESS, FLUSH_DATA };
+
+    OLEDBus* bus;
+    bool ownsBus;
     tDisplayCtrl displayController;
     bool usingOffset;
     const uint_fast8_t pages;
@@ -224,12 +234,41 @@ private:
     const uint_fast8_t height;
     bool ttyMode;
     bool fontInverted;
+    
+    // Per-page dirty column window, min > max means the page is clean
+    uint8_t dirtyMin[OLED_MAX_PAGES];
+    uint8_t dirtyMax[OLED_MAX_PAGES];
+    
+    // TTY scrolling rotates a ring of pages instead of moving the buffer around. With
+    // hwScroll the controller's start line follows along, otherwise the flush remaps pages.
+    uint_fast8_t pageOffset;
+    bool hwScroll;
+    bool startLinePending;
+    
+    // Where the async flush is up to
+    tFlushState flushState;
+    uint_fast8_t flushPage;
+    uint_fast16_t flushCol;
+    uint_fast16_t flushEnd;
+    
+    // Logical page (what the drawing code sees) to its row in the buffer
+    inline uint8_t* page_ptr(uint_fast8_t page) {
+        return &buffer[((page + pageOffset) % pages) * width];
+    }
+    
+    inline void mark_page_dirty(uint_fast8_t page, uint_fast8_t x0, uint_fast8_t x1) {
+        if (page >= pages) return;
+        page = (page + pageOffset) % pages;
+        if (x0 < dirtyMin[page]) dirtyMin[page] = x0;
+        if (x1 > dirtyMax[page]) dirtyMax[page] = x1;
+    }
 
-    void i2c_start();
-    void i2c_stop();
-    bool i2c_send(uint8_t byte);
-    void draw_byte(uint_fast8_t x, uint_fast8_t y, uint8_t b, tColor color);
-    void draw_bytes(uint_fast8_t x, uint_fast8_t y, const uint8_t* data, uint_fast8_t size, tFontScaling scaling, tColor color, bool useProgmem);
+    bool send_commands(const uint8_t* cmds, size_t length);
+    void send_start_line();
+    void scroll_page();
+    void draw_bytes(uint_fast8_t x, uint_fast8_t y, const uint8_t* data, uint_fast8_t size, tColor color, bool useProgmem);
+    template <typename T>
+    void blit_columns(uint_fast8_t x, uint_fast8_t y, const T* columns, uint_fast8_t count, tColor color, bool useProgmem);
     void set_font_inverted(bool enabled);
     uint_fast8_t ToCol(uint_fast8_t x);
     uint_fast8_t ToRow(uint_fast8_t y);
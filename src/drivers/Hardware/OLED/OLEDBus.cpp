@@ -0,0 +1,216 @@
+/**
+ * @file OLEDBus.cpp
+ * @brief Implementation of the OLED bus backends
+ */
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <SPI.h>
+#include "OLEDBus.h"
+
+//
+// ----------------------------------------- Software I2C
+//
+
+OLEDSoftI2C::OLEDSoftI2C(uint8_t sda_pin, uint8_t scl_pin, uint8_t i2c_address) :
+    sda_pin(sda_pin),
+    scl_pin(scl_pin),
+    i2c_address(i2c_address)
+{
+}
+
+bool OLEDSoftI2C::begin()
+{
+    pinMode(sda_pin, INPUT);
+    pinMode(scl_pin, INPUT);
+    return true;
+}
+
+bool OLEDSoftI2C::wait_high(uint8_t pin)
+{
+    uint32_t start = micros();
+    while (!digitalRead(pin))
+    {
+        if (micros() - start > OLED_I2C_TIMEOUT_US) return false;
+    }
+    return true;
+}
+
+bool OLEDSoftI2C::start()
+{
+    if (!wait_high(sda_pin) || !wait_high(scl_pin)) return false;
+    digitalWrite(sda_pin, LOW);
+    pinMode(sda_pin, OUTPUT);
+    OLED_I2C_DELAY;
+    digitalWrite(scl_pin, LOW);
+    pinMode(scl_pin, OUTPUT);
+    OLED_I2C_DELAY;
+    return true;
+}
+
+void OLEDSoftI2C::stop()
+{
+    pinMode(scl_pin, INPUT);
+    digitalWrite(scl_pin, HIGH);
+    OLED_I2C_DELAY;
+    pinMode(sda_pin, INPUT);
+    digitalWrite(sda_pin, HIGH);
+    OLED_I2C_DELAY;
+    wait_high(sda_pin);
+    wait_high(scl_pin);
+}
+
+bool OLEDSoftI2C::send(uint8_t byte)
+{
+    for (int_fast8_t bit = 7; bit >= 0; bit--)
+    {
+        if (byte & 128) {
+          pinMode(sda_pin, INPUT);
+          digitalWrite(sda_pin, HIGH);
+        } else {
+          digitalWrite(sda_pin, LOW);
+          pinMode(sda_pin, OUTPUT);
+        }
+        OLED_I2C_DELAY;
+        pinMode(scl_pin, INPUT);
+        digitalWrite(scl_pin, HIGH);
+        OLED_I2C_DELAY;
+        if (!wait_high(scl_pin)) return false; // Clock stretching, but not forever
+        digitalWrite(scl_pin, LOW);
+        pinMode(scl_pin, OUTPUT);
+        OLED_I2C_DELAY;
+        byte = byte << 1;
+    }
+    pinMode(sda_pin, INPUT);
+    digitalWrite(sda_pin, HIGH);
+    pinMode(scl_pin, INPUT);
+    digitalWrite(scl_pin, HIGH);
+    OLED_I2C_DELAY;
+    if (!wait_high(scl_pin)) return false;
+    bool ack = digitalRead(sda_pin) == 0;
+    digitalWrite(scl_pin, LOW);
+    pinMode(scl_pin, OUTPUT);
+    OLED_I2C_DELAY;
+    return ack;
+}
+
+bool OLEDSoftI2C::transfer(uint8_t control, const uint8_t* bytes, size_t length)
+{
+    if (!start()) return false;
+    bool ok = send(i2c_address << 1) && send(control);
+    for (size_t i = 0; ok && i < length; i++)
+    {
+        ok = send(bytes[i]);
+    }
+    stop();
+    return ok;
+}
+
+bool OLEDSoftI2C::command(const uint8_t* cmds, size_t length)
+{
+    return transfer(0x00, cmds, length);
+}
+
+bool OLEDSoftI2C::data(const uint8_t* bytes, size_t length)
+{
+    return transfer(0x40, bytes, length);
+}
+
+//
+// ----------------------------------------- Hardware I2C
+//
+
+OLEDWireI2C::OLEDWireI2C(TwoWire& wire, uint8_t sda_pin, uint8_t scl_pin, uint8_t i2c_address, uint32_t clock) :
+    wire(wire),
+    sda_pin(sda_pin),
+    scl_pin(scl_pin),
+    i2c_address(i2c_address),
+    clock(clock)
+{
+}
+
+bool OLEDWireI2C::begin()
+{
+    if (!wire.begin(sda_pin, scl_pin, clock)) return false;
+    wire.setTimeOut(10); // Don't let a missing display hang the main loop
+    return true;
+}
+
+size_t OLEDWireI2C::maxChunk() const
+{
+    // Wire's TX buffer has to hold the control byte too
+    return (I2C_BUFFER_LENGTH - 1) < OLED_FLUSH_CHUNK ? (I2C_BUFFER_LENGTH - 1) : OLED_FLUSH_CHUNK;
+}
+
+bool OLEDWireI2C::transfer(uint8_t control, const uint8_t* bytes, size_t length)
+{
+    wire.beginTransmission(i2c_address);
+    wire.write(control);
+    wire.write(bytes, length);
+    return wire.endTransmission() == 0;
+}
+
+bool OLEDWireI2C::command(const uint8_t* cmds, size_t length)
+{
+    return transfer(0x00, cmds, length);
+}
+
+bool OLEDWireI2C::data(const uint8_t* bytes, size_t length)
+{
+    return transfer(0x40, bytes, length);
+}
+
+//
+// ----------------------------------------- SPI
+//
+
+OLEDSPI::OLEDSPI(SPIClass& spi, int8_t sck_pin, int8_t mosi_pin, uint8_t cs_pin, uint8_t dc_pin, int8_t rst_pin, uint32_t clock) :
+    spi(spi),
+    sck_pin(sck_pin),
+    mosi_pin(mosi_pin),
+    cs_pin(cs_pin),
+    dc_pin(dc_pin),
+    rst_pin(rst_pin),
+    clock(clock)
+{
+}
+
+bool OLEDSPI::begin()
+{
+    pinMode(cs_pin, OUTPUT);
+    digitalWrite(cs_pin, HIGH);
+    pinMode(dc_pin, OUTPUT);
+
+    spi.begin(sck_pin, -1, mosi_pin, -1);
+
+    if (rst_pin >= 0)
+    {
+        pinMode(rst_pin, OUTPUT);
+        digitalWrite(rst_pin, LOW);
+        delay(10);
+        digitalWrite(rst_pin, HIGH);
+        delay(10);
+    }
+    return true;
+}
+
+bool OLEDSPI::transfer(bool isData, const uint8_t* bytes, size_t length)
+{
+    digitalWrite(dc_pin, isData ? HIGH : LOW);
+    spi.beginTransaction(SPISettings(clock, MSBFIRST, SPI_MODE0));
+    digitalWrite(cs_pin, LOW);
+    spi.writeBytes(bytes, length);
+    digitalWrite(cs_pin, HIGH);
+    spi.endTransaction();
+    return true;
+}
+
+bool OLEDSPI::command(const uint8_t* cmds, size_t length)
+{
+    return transfer(false, cmds, length);
+}
+
+bool OLEDSPI::data(const uint8_t* bytes, size_t length)
+{
+    return transfer(true, bytes, length);
+}
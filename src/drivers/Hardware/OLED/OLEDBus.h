@@ -0,0 +1,103 @@
+/**
+ * @file OLEDBus.h
+ * @brief Bus backends for the OLED driver (software I2C, ESP32 hardware I2C, SPI)
+ */
+
+#ifndef OLEDBUS_H
+#define OLEDBUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Pick one of these for OLED_BUS in config.h
+#define OLED_BUS_SOFT_I2C 0
+#define OLED_BUS_I2C      1
+#define OLED_BUS_SPI      2
+
+#define OLED_I2C_DELAY          delayMicroseconds(1)
+#define OLED_I2C_TIMEOUT_US     2000     // How long a stuck SCL/SDA gets before the bit-banger gives up
+#define OLED_I2C_CLOCK          400000
+#define OLED_SPI_CLOCK          8000000
+#define OLED_FLUSH_CHUNK        32       // Data bytes per bus transaction during a flush
+
+class TwoWire;
+class SPIClass;
+
+// All the OLED driver needs from a bus - a way to send a run of commands and a run of
+// display RAM data. Keeping it this small means the flush logic can be driven by a mock.
+class OLEDBus {
+public:
+    virtual ~OLEDBus() {}
+
+    virtual bool   begin() = 0;
+    virtual bool   command(const uint8_t* cmds, size_t length) = 0;
+    virtual bool   data(const uint8_t* bytes, size_t length) = 0;
+
+    // Biggest data run the bus is happy to take in one go
+    virtual size_t maxChunk() const { return OLED_FLUSH_CHUNK; }
+};
+
+// The original bit-banged driver, now with timeouts instead of spinning forever on a stuck line
+class OLEDSoftI2C : public OLEDBus {
+public:
+    OLEDSoftI2C(uint8_t sda_pin, uint8_t scl_pin, uint8_t i2c_address = 0x3C);
+
+    bool begin() override;
+    bool command(const uint8_t* cmds, size_t length) override;
+    bool data(const uint8_t* bytes, size_t length) override;
+
+private:
+    const uint8_t sda_pin;
+    const uint8_t scl_pin;
+    const uint8_t i2c_address;
+
+    bool wait_high(uint8_t pin);
+    bool start();
+    void stop();
+    bool send(uint8_t byte);
+    bool transfer(uint8_t control, const uint8_t* bytes, size_t length);
+};
+
+// ESP32 I2C peripheral through Wire
+class OLEDWireI2C : public OLEDBus {
+public:
+    OLEDWireI2C(TwoWire& wire, uint8_t sda_pin, uint8_t scl_pin, uint8_t i2c_address = 0x3C, uint32_t clock = OLED_I2C_CLOCK);
+
+    bool   begin() override;
+    bool   command(const uint8_t* cmds, size_t length) override;
+    bool   data(const uint8_t* bytes, size_t length) override;
+    size_t maxChunk() const override;
+
+private:
+    TwoWire&       wire;
+    const uint8_t  sda_pin;
+    const uint8_t  scl_pin;
+    const uint8_t  i2c_address;
+    const uint32_t clock;
+
+    bool transfer(uint8_t control, const uint8_t* bytes, size_t length);
+};
+
+// 4-wire SPI modules - D/C pin picks command vs data, reset is optional (-1 if it's tied high)
+class OLEDSPI : public OLEDBus {
+public:
+    OLEDSPI(SPIClass& spi, int8_t sck_pin, int8_t mosi_pin, uint8_t cs_pin, uint8_t dc_pin, int8_t rst_pin = -1, uint32_t clock = OLED_SPI_CLOCK);
+
+    bool   begin() override;
+    bool   command(const uint8_t* cmds, size_t length) override;
+    bool   data(const uint8_t* bytes, size_t length) override;
+    size_t maxChunk() const override { return 128; }
+
+private:
+    SPIClass&      spi;
+    const int8_t   sck_pin;
+    const int8_t   mosi_pin;
+    const uint8_t  cs_pin;
+    const uint8_t  dc_pin;
+    const int8_t   rst_pin;
+    const uint32_t clock;
+
+    bool transfer(bool isData, const uint8_t* bytes, size_t length);
+};
+
+#endif
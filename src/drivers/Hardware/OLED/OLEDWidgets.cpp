@@ -0,0 +1,245 @@
+/**
+ * @file OLEDWidgets.cpp
+ * @brief Implementation of the OLED widgets
+ */
+
+#include <Arduino.h>
+#include "OLEDWidgets.h"
+
+//
+// ----------------------------------------- Base
+//
+
+OLEDWidget::OLEDWidget(uint_fast8_t x, uint_fast8_t y, uint_fast8_t w, uint_fast8_t h) :
+    x(x),
+    y(y),
+    w(w),
+    h(h),
+    stale(false),
+    shown(false),
+    erase(false)
+{
+}
+
+void OLEDWidget::hide()
+{
+    if (!shown) return;
+    shown = false;
+    erase = true;
+}
+
+bool OLEDWidget::render(OLED& oled)
+{
+    if (!shown)
+    {
+        if (!erase) return false;
+        
+        // Hidden since last time, so just wipe the box
+        oled.clear_area(x, y, x + w - 1, y + h - 1);
+        erase = false;
+        stale = false;
+        return true;
+    }
+
+    if (!stale) return false;
+
+    oled.clear_area(x, y, x + w - 1, y + h - 1);
+    draw(oled);
+    stale = false;
+    erase = false;
+    return true;
+}
+
+//
+// ----------------------------------------- Label
+//
+
+OLEDLabel::OLEDLabel(uint_fast8_t x, uint_fast8_t y, uint_fast8_t w, OLED::tFontScaling scaling, tAlign align) :
+    OLEDWidget(x, y, w, scaling == OLED::DOUBLE_SIZE ? OLED_FONT_HEIGHT * 2 : OLED_FONT_HEIGHT),
+    scaling(scaling),
+    align(align)
+{
+    text[0] = '\0';
+}
+
+void OLEDLabel::set(const char* s)
+{
+    if (!s) s = "";
+    if (strncmp(text, s, OLED_LABEL_MAX - 1) != 0)
+    {
+        strncpy(text, s, OLED_LABEL_MAX - 1);
+        text[OLED_LABEL_MAX - 1] = '\0';
+        changed();
+    }
+    else if (!isShown())
+    {
+        changed();
+    }
+}
+
+void OLEDLabel::setf(const char* format, ...)
+{
+    char temp[OLED_LABEL_MAX];
+    va_list arg;
+    va_start(arg, format);
+    vsnprintf(temp, sizeof(temp), format, arg);
+    va_end(arg);
+    set(temp);
+}
+
+void OLEDLabel::draw(OLED& oled)
+{
+    uint_fast8_t text_width = strlen(text) * OLED_FONT_WIDTH * (scaling == OLED::DOUBLE_SIZE ? 2 : 1);
+    uint_fast8_t offset = 0;
+    if (text_width < w)
+    {
+        if (align == ALIGN_CENTER) offset = (w - text_width) / 2;
+        else if (align == ALIGN_RIGHT) offset = w - text_width;
+    }
+    oled.draw_string(x + offset, y, text, scaling, OLED::WHITE);
+}
+
+//
+// ----------------------------------------- Icon
+//
+
+OLEDIcon::OLEDIcon(uint_fast8_t x, uint_fast8_t y, uint_fast8_t w, uint_fast8_t h) :
+    OLEDWidget(x, y, w, h),
+    bitmap(nullptr)
+{
+}
+
+void OLEDIcon::set(const uint8_t* bitmap)
+{
+    if (bitmap != this->bitmap || !isShown())
+    {
+        this->bitmap = bitmap;
+        changed();
+    }
+}
+
+void OLEDIcon::draw(OLED& oled)
+{
+    if (bitmap) oled.draw_bitmap_P(x, y, w, h, bitmap, OLED::WHITE);
+}
+
+//
+// ----------------------------------------- Bar
+//
+
+OLEDBar::OLEDBar(uint_fast8_t x, uint_fast8_t y, uint_fast8_t w, uint_fast8_t h, uint8_t max) :
+    OLEDWidget(x, y, w, h),
+    value(0),
+    max(max ? max : 1)
+{
+}
+
+void OLEDBar::set(uint8_t value)
+{
+    if (value > max) value = max;
+    if (value != this->value || !isShown())
+    {
+        this->value = value;
+        changed();
+    }
+}
+
+void OLEDBar::draw(OLED& oled)
+{
+    oled.draw_rectangle(x, y, x + w - 1, y + h - 1, OLED::HOLLOW, OLED::WHITE);
+    if (w <= 4 || h <= 4) return;
+
+    // 1px gap inside the outline
+    uint_fast16_t fill = (uint_fast16_t)(w - 4) * value / max;
+    if (fill > 0)
+    {
+        oled.clear_area(x + 2, y + 2, x + 1 + fill, y + h - 3, OLED::WHITE);
+    }
+}
+
+//
+// ----------------------------------------- Graph
+//
+
+OLEDGraph::OLEDGraph(uint_fast8_t x, uint_fast8_t y, uint_fast8_t w, uint_fast8_t h, uint8_t max) :
+    OLEDWidget(x, y, w > OLED_GRAPH_MAX ? OLED_GRAPH_MAX : w, h),
+    head(0),
+    count(0),
+    max(max ? max : 1)
+{
+    memset(samples, 0, sizeof(samples));
+}
+
+void OLEDGraph::push(uint8_t sample)
+{
+    samples[head] = sample > max ? max : sample;
+    head = (head + 1) % w;
+    if (count < w) count++;
+    changed();
+}
+
+void OLEDGraph::reset()
+{
+    head = 0;
+    count = 0;
+    changed();
+}
+
+void OLEDGraph::draw(OLED& oled)
+{
+    // Oldest sample first, right-aligned so the newest one is always at the edge
+    uint_fast8_t start = (head + w - count) % w;
+    uint_fast8_t column = x + w - count;
+    for (uint_fast8_t i = 0; i < count; i++)
+    {
+        uint_fast8_t bar = (uint_fast16_t)samples[(start + i) % w] * h / max;
+        if (bar > 0)
+        {
+            oled.clear_area(column, y + h - bar, column, y + h - 1, OLED::WHITE);
+        }
+        column++;
+    }
+}
+
+//
+// ----------------------------------------- Compositor
+//
+
+OLEDCompositor::OLEDCompositor() :
+    count(0)
+{
+}
+
+bool OLEDCompositor::add(OLEDWidget* widget)
+{
+    if (!widget || count >= OLED_MAX_WIDGETS) return false;
+    widgets[count++] = widget;
+    return true;
+}
+
+bool OLEDCompositor::render(OLED& oled)
+{
+    bool drew = false;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        drew |= widgets[i]->render(oled);
+    }
+    return drew;
+}
+
+void OLEDCompositor::invalidate()
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        widgets[i]->invalidate();
+    }
+}
+
+bool OLEDCompositor::isStale() const
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (widgets[i]->isStale()) return true;
+    }
+    return false;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file OLEDWidgets.h
+ * @brief Retained-mode widgets for the OLED driver
+ *
+ * Each widget owns a box on the screen and remembers what it last drew, so setting
+ * the same value again costs a compare and nothing else. Only stale widgets get
+ * redrawn, and only their box gets marked dirty for the next flush.
+ */
+
+#ifndef OLEDWIDGETS_H
+#define OLEDWIDGETS_H
+
+#include "OLED.h"
+
+#define OLED_LABEL_MAX    22    // 128px / 6px font, plus the terminator
+#define OLED_GRAPH_MAX    128   // Samples a graph can hold, one per column
+#define OLED_MAX_WIDGETS  12
+
+class OLEDWidget {
+public:
+    OLEDWidget(uint_fast8_t x, uint_fast8_t y, uint_fast8_t w, uint_fast8_t h);
+    virtual ~OLEDWidget() {}
+
+    // Redraws into the framebuffer if the value changed, returns whether it did
+    bool render(OLED& oled);
+
+    void invalidate() { stale = true; }
+    bool isStale() const { return (stale && shown) || erase; }
+    bool isShown() const { return shown; }
+    void hide();
+
+protected:
+    virtual void draw(OLED& oled) = 0;
+    void changed() { stale = true; shown = true; }
+
+    const uint_fast8_t x;
+    const uint_fast8_t y;
+    const uint_fast8_t w;
+    const uint_fast8_t h;
+
+private:
+    bool stale;
+    bool shown;   // Nothing gets drawn until a widget has been given a value
+    bool erase;   // Hidden since the last render, so the box still needs wiping
+};
+
+class OLEDLabel : public OLEDWidget {
+public:
+    enum tAlign { ALIGN_LEFT, ALIGN_CENTER, ALIGN_RIGHT };
+
+    OLEDLabel(uint_fast8_t x, uint_fast8_t y, uint_fast8_t w,
+              OLED::tFontScaling scaling = OLED::NORMAL_SIZE, tAlign align = ALIGN_LEFT);
+
+    void set(const char* s);
+    void setf(const char* format, ...);
+    const char* get() const { return text; }
+
+protected:
+    void draw(OLED& oled) override;
+
+private:
+    char text[OLED_LABEL_MAX];
+    OLED::tFontScaling scaling;
+    tAlign align;
+};
+
+class OLEDIcon : public OLEDWidget {
+public:
+    OLEDIcon(uint_fast8_t x, uint_fast8_t y, uint_fast8_t w, uint_fast8_t h);
+
+    // Bitmap lives in PROGMEM, swapping pointers is how you change the icon
+    void set(const uint8_t* bitmap);
+
+protected:
+    void draw(OLED& oled) override;
+
+private:
+    const uint8_t* bitmap;
+};
+
+class OLEDBar : public OLEDWidget {
+public:
+    OLEDBar(uint_fast8_t x, uint_fast8_t y, uint_fast8_t w, uint_fast8_t h, uint8_t max = 100);
+
+    void set(uint8_t value);
+    uint8_t get() const { return value; }
+
+protected:
+    void draw(OLED& oled) override;
+
+private:
+    uint8_t value;
+    uint8_t max;
+};
+
+// Scrolling bar graph, newest sample on the right - handy for WPM
+class OLEDGraph : public OLEDWidget {
+public:
+    OLEDGraph(uint_fast8_t x, uint_fast8_t y, uint_fast8_t w, uint_fast8_t h, uint8_t max = 100);
+
+    void push(uint8_t sample);
+    void reset();
+
+protected:
+    void draw(OLED& oled) override;
+
+private:
+    uint8_t samples[OLED_GRAPH_MAX];
+    uint8_t head;
+    uint8_t count;
+    uint8_t max;
+};
+
+class OLEDCompositor {
+public:
+    OLEDCompositor();
+
+    bool add(OLEDWidget* widget);
+    bool render(OLED& oled);   // True if anything got drawn
+    void invalidate();         // Everything redraws next time, e.g. after the screen got cleared
+    bool isStale() const;
+
+private:
+    OLEDWidget* widgets[OLED_MAX_WIDGETS];
+    uint8_t     count;
+};
+
+#endif
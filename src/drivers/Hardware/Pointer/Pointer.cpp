@@ -0,0 +1,119 @@
+/**
+ * @file Pointer.cpp
+ * @brief Implementation of the pointing sensor poller
+ */
+
+#include "Pointer.h"
+
+SQUIDPOINTER::SQUIDPOINTER() :
+    sensor(nullptr),
+    motionCallback(nullptr),
+    motionPin(-1),
+    motionFlag(false),
+    pollInterval(POINTER_POLL_US),
+    lastPoll(0),
+    readTime(0),
+    squal(0),
+    swapXY(false),
+    invertX(false),
+    invertY(false),
+    angleSnap(false),
+    softwareSnap(false)
+{}
+
+SQUIDPOINTER::~SQUIDPOINTER() {
+    end();
+}
+
+void IRAM_ATTR SQUIDPOINTER::onMotionPin(void* arg) {
+    static_cast<SQUIDPOINTER*>(arg)->motionFlag = true;
+}
+
+bool SQUIDPOINTER::begin(PointerSensor* sensor, int8_t motionPin) {
+    end();
+    if (!sensor) return false;
+    this->sensor = sensor;
+
+    if (!sensor->begin()) {
+        SQUID_LOG_ERROR(POINTER_TAG, "%s didn't answer, check the wiring and CS pin", sensor->name());
+        end();
+        return false;
+    }
+
+    // Set before begin() there was no sensor to hand it to, and a fresh sensor comes up with it off
+    if (angleSnap) setAngleSnap(true);
+
+    this->motionPin = motionPin;
+    if (motionPin >= 0) {
+        pinMode(motionPin, INPUT_PULLUP);
+        motionFlag = true;   // Whatever built up before the interrupt was attached
+        attachInterruptArg(digitalPinToInterrupt(motionPin), onMotionPin, this, FALLING);
+    }
+
+    SQUID_LOG_INFO(POINTER_TAG, "%s running at %d CPI, %s", sensor->name(), sensor->getCPI(),
+                   motionPin >= 0 ? "motion pin" : "polled");
+    return true;
+}
+
+void SQUIDPOINTER::end() {
+    if (motionPin >= 0) detachInterrupt(digitalPinToInterrupt(motionPin));
+    motionPin = -1;
+    delete sensor;
+    sensor = nullptr;
+}
+
+bool SQUIDPOINTER::setCPI(uint16_t cpi) {
+    if (!sensor || !sensor->setCPI(cpi)) return false;
+    SQUID_LOG_DEBUG(POINTER_TAG, "CPI set to %d", sensor->getCPI());
+    return true;
+}
+
+void SQUIDPOINTER::setAngleSnap(bool enable) {
+    angleSnap = enable;
+    // The sensor does it better if it can, it sees the raw motion
+    softwareSnap = enable && !(sensor && sensor->setAngleSnap(true));
+    if (!enable && sensor) sensor->setAngleSnap(false);
+}
+
+void SQUIDPOINTER::setOrientation(bool swapXY, bool invertX, bool invertY) {
+    this->swapXY = swapXY;
+    this->invertX = invertX;
+    this->invertY = invertY;
+}
+
+bool SQUIDPOINTER::update(uint32_t nowUs) {
+    if (!sensor || nowUs - lastPoll < pollInterval) return false;
+
+    // MOTION stays low until the burst is read, so a missed edge still gets picked up by the level
+    if (motionPin >= 0) {
+        if (!motionFlag && digitalRead(motionPin) == HIGH) return false;
+        motionFlag = false;
+    }
+    lastPoll = nowUs;
+
+    PointerMotion motion;
+    uint32_t start = micros();
+    bool ok = sensor->readMotion(motion);
+    readTime = micros() - start;
+    if (!ok) return false;
+
+    squal = motion.squal;
+    if (!motion.moved || motion.lifted) return false;
+
+    int32_t dx = motion.dx;
+    int32_t dy = motion.dy;
+    if (swapXY) { int32_t t = dx; dx = dy; dy = t; }
+    if (invertX) dx = -dx;
+    if (invertY) dy = -dy;
+
+    if (softwareSnap) {
+        int32_t ax = dx < 0 ? -dx : dx;
+        int32_t ay = dy < 0 ? -dy : dy;
+        if (ax >= ay * POINTER_SNAP_RATIO) dy = 0;
+        else if (ay >= ax * POINTER_SNAP_RATIO) dx = 0;
+    }
+
+    if (!dx && !dy) return false;
+    if (motionCallback) motionCallback((int16_t)constrain(dx, -32767, 32767), (int16_t)constrain(dy, -32767, 32767));
+    return true;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file Pointer.h
+ * @brief Polls an optical sensor at its own rate and hands the motion on, oriented and snapped
+ */
+
+#ifndef POINTER_H
+#define POINTER_H
+
+#include <Arduino.h>
+#include <functional>
+#include "drivers/Data.h"
+#include "PointerSensor.h"
+
+#define POINTER_POLL_US    125   // 8kHz, as fast as the sensors frame with motion on
+#define POINTER_SNAP_RATIO 8     // Software angle snap - the smaller axis gets dropped when the other is this many times bigger
+
+class SQUIDPOINTER {
+public:
+    typedef std::function<void(int16_t dx, int16_t dy)> MotionCallback;
+
+    SQUIDPOINTER();
+    ~SQUIDPOINTER();
+
+    // Takes ownership of the sensor. With a motion pin bursts only happen once the sensor says it has something.
+    bool     begin(PointerSensor* sensor, int8_t motionPin = -1);
+    void     end();
+
+    // One burst at most, true if there was motion to hand on
+    bool     update(uint32_t nowUs);
+    void     onMotion(MotionCallback callback) { motionCallback = callback; }
+
+    bool     setCPI(uint16_t cpi);
+    uint16_t getCPI() const { return sensor ? sensor->getCPI() : 0; }
+    void     setAngleSnap(bool enable);
+    // Applied in that order, for sensors mounted sideways or upside down
+    void     setOrientation(bool swapXY, bool invertX, bool invertY);
+    void     setPollInterval(uint32_t us) { pollInterval = us; }
+
+    PointerSensor* getSensor() { return sensor; }
+    uint32_t getReadTime() const { return readTime; }   // us the last burst took, should stay well inside the poll interval
+    uint8_t  getSqual() const { return squal; }
+
+private:
+    static void IRAM_ATTR onMotionPin(void* arg);
+
+    PointerSensor* sensor;
+    MotionCallback motionCallback;
+    int8_t   motionPin;
+    volatile bool motionFlag;
+    uint32_t pollInterval;
+    uint32_t lastPoll;
+    uint32_t readTime;
+    uint8_t  squal;
+    bool     swapXY;
+    bool     invertX;
+    bool     invertY;
+    bool     angleSnap;      // What was asked for, a sensor begun later gets it too
+    bool     softwareSnap;
+};
+
+#endif
@@ -0,0 +1,43 @@
+/**
+ * @file PointerBus.cpp
+ * @brief Implementation of the pointing sensor bus backends
+ */
+
+#include "PointerBus.h"
+#include <Arduino.h>
+#include <SPI.h>
+
+PointerSPI::PointerSPI(SPIClass& spi, uint8_t cs_pin, uint32_t clock) :
+    spi(spi),
+    cs_pin(cs_pin),
+    clock(clock),
+    inTransaction(false)
+{}
+
+bool PointerSPI::begin() {
+    pinMode(cs_pin, OUTPUT);
+    digitalWrite(cs_pin, HIGH);
+    // Whoever owns the SPIClass has already called begin() on it with the right pins
+    return true;
+}
+
+void PointerSPI::select(bool active) {
+    if (active) {
+        // The bus can be shared with an OLED or the MCP, so it's claimed for as long as CS is low
+        spi.beginTransaction(SPISettings(clock, MSBFIRST, SPI_MODE3));
+        inTransaction = true;
+        digitalWrite(cs_pin, LOW);
+    } else {
+        digitalWrite(cs_pin, HIGH);
+        if (inTransaction) spi.endTransaction();
+        inTransaction = false;
+    }
+}
+
+void PointerSPI::transfer(const uint8_t* tx, uint8_t* rx, size_t length) {
+    spi.transferBytes(tx, rx, length);
+}
+
+void PointerSPI::wait(uint32_t us) {
+    delayMicroseconds(us);
+}
@@ -0,0 +1,46 @@
+/**
+ * @file PointerBus.h
+ * @brief Bus backends for the pointing sensor drivers
+ */
+
+#ifndef POINTERBUS_H
+#define POINTERBUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define POINTER_SPI_CLOCK 2000000   // What the PMW3360 tops out at, most PixArt sensors are happy here
+
+class SPIClass;
+
+// All a sensor driver needs from its bus - chip select, bytes both ways and a way to wait. Waiting goes
+// through the bus too, so a fake one can stand in for the sensor without anybody sitting through the delays.
+class PointerBus {
+public:
+    virtual ~PointerBus() {}
+
+    virtual bool begin() = 0;
+    virtual void select(bool active) = 0;
+    // Either buffer can be NULL - no tx clocks out filler, no rx throws the answer away
+    virtual void transfer(const uint8_t* tx, uint8_t* rx, size_t length) = 0;
+    virtual void wait(uint32_t us) = 0;
+};
+
+// Any SPIClass, mode 3 like every PixArt sensor wants
+class PointerSPI : public PointerBus {
+public:
+    PointerSPI(SPIClass& spi, uint8_t cs_pin, uint32_t clock = POINTER_SPI_CLOCK);
+
+    bool begin() override;
+    void select(bool active) override;
+    void transfer(const uint8_t* tx, uint8_t* rx, size_t length) override;
+    void wait(uint32_t us) override;
+
+private:
+    SPIClass&      spi;
+    const uint8_t  cs_pin;
+    const uint32_t clock;
+    bool           inTransaction;
+};
+
+#endif
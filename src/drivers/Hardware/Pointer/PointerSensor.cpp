@@ -0,0 +1,218 @@
+/**
+ * @file PointerSensor.cpp
+ * @brief Implementation of the optical pointing sensor drivers
+ */
+
+#include "PointerSensor.h"
+
+// Registers both sensors have in the same place
+#define REG_PRODUCT_ID     0x00
+#define REG_MOTION         0x02
+#define REG_DELTA_X_L      0x03
+#define REG_DELTA_X_H      0x04
+#define REG_DELTA_Y_L      0x05
+#define REG_DELTA_Y_H      0x06
+#define REG_POWER_UP_RESET 0x3A
+#define POWER_UP_RESET_KEY 0x5A
+
+#define MOTION_MOT         0x80
+#define MOTION_LIFT        0x08
+
+//
+// ----------------------------------------- Common
+//
+
+PointerSensor::PointerSensor(PointerBus* bus, bool ownsBus) :
+    bus(bus),
+    ownsBus(ownsBus),
+    timing{160, 35, 180, 20, 35},
+    burstRegister(0x50),
+    burstNeedsPrime(false),
+    burstPrimed(false),
+    cpi(0)
+{}
+
+PointerSensor::~PointerSensor() {
+    if (ownsBus) delete bus;
+}
+
+uint8_t PointerSensor::readRegister(uint8_t reg) {
+    uint8_t address = reg & 0x7F;
+    uint8_t value = 0;
+
+    bus->select(true);
+    bus->transfer(&address, nullptr, 1);
+    bus->wait(timing.readAddress);
+    bus->transfer(nullptr, &value, 1);
+    bus->wait(1);
+    bus->select(false);
+    bus->wait(timing.afterRead);
+
+    burstPrimed = false;   // Any other access takes the sensor out of burst mode
+    return value;
+}
+
+void PointerSensor::writeRegister(uint8_t reg, uint8_t value) {
+    uint8_t frame[2] = { (uint8_t)(reg | 0x80), value };
+
+    bus->select(true);
+    bus->transfer(frame, nullptr, 2);
+    bus->wait(timing.writeHold);
+    bus->select(false);
+    bus->wait(timing.afterWrite);
+
+    burstPrimed = false;
+}
+
+void PointerSensor::writeSequence(const PointerRegWrite* sequence, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        writeRegister(sequence[i].reg, sequence[i].value);
+    }
+}
+
+void PointerSensor::powerUp(uint32_t resetWaitUs) {
+    // Toggling NCS resets the sensor's SPI port in case it was left mid-transfer
+    bus->select(false);
+    bus->select(true);
+    bus->select(false);
+
+    writeRegister(REG_POWER_UP_RESET, POWER_UP_RESET_KEY);
+    bus->wait(resetWaitUs);
+
+    // Motion built up during reset is junk
+    for (uint8_t reg = REG_MOTION; reg <= REG_DELTA_Y_H; reg++) readRegister(reg);
+}
+
+bool PointerSensor::readMotion(PointerMotion& motion) {
+    uint8_t data[POINTER_BURST_LENGTH];
+
+    if (burstNeedsPrime && !burstPrimed) {
+        writeRegister(burstRegister, 0x00);
+        burstPrimed = true;
+    }
+
+    // Address, one wait, then the whole lot in a single transfer
+    bus->select(true);
+    bus->transfer(&burstRegister, nullptr, 1);
+    bus->wait(timing.burstAddress);
+    bus->transfer(nullptr, data, sizeof(data));
+    bus->select(false);
+    bus->wait(1);   // tBEXIT
+
+    motion.moved  = (data[0] & MOTION_MOT) != 0;
+    motion.lifted = (data[0] & MOTION_LIFT) != 0;
+    motion.dx     = (int16_t)(data[2] | (data[3] << 8));
+    motion.dy     = (int16_t)(data[4] | (data[5] << 8));
+    motion.squal  = data[6];
+    return true;
+}
+
+//
+// ----------------------------------------- PMW3360
+//
+
+#define PMW3360_PRODUCT_ID   0x42
+#define PMW3360_CONFIG1      0x0F   // Resolution, (CPI / 100) - 1
+#define PMW3360_CONFIG2      0x10
+#define PMW3360_SROM_ENABLE  0x13
+#define PMW3360_SROM_ID      0x2A
+#define PMW3360_ANGLE_SNAP   0x42
+#define PMW3360_SROM_BURST   0x62
+
+PMW3360::PMW3360(PointerBus* bus, bool ownsBus) :
+    PointerSensor(bus, ownsBus),
+    firmware(nullptr),
+    firmwareLength(0)
+{
+    burstRegister = 0x50;
+    burstNeedsPrime = true;
+}
+
+bool PMW3360::uploadFirmware() {
+    writeRegister(PMW3360_CONFIG2, 0x00);   // Rest mode off while it loads
+    writeRegister(PMW3360_SROM_ENABLE, 0x1D);
+    bus->wait(10000);
+    writeRegister(PMW3360_SROM_ENABLE, 0x18);
+
+    uint8_t address = PMW3360_SROM_BURST | 0x80;
+    bus->select(true);
+    bus->transfer(&address, nullptr, 1);
+    bus->wait(15);
+    for (size_t i = 0; i < firmwareLength; i++) {
+        bus->transfer(&firmware[i], nullptr, 1);
+        bus->wait(15);
+    }
+    bus->select(false);
+    bus->wait(200);
+
+    return readRegister(PMW3360_SROM_ID) != 0;
+}
+
+bool PMW3360::begin() {
+    if (!bus || !bus->begin()) return false;
+
+    powerUp(50000);
+    if (readRegister(REG_PRODUCT_ID) != PMW3360_PRODUCT_ID) return false;
+
+    // Tracks without it, just not as well
+    if (firmware && firmwareLength && !uploadFirmware()) return false;
+
+    return setCPI(cpi ? cpi : 1600);
+}
+
+bool PMW3360::setCPI(uint16_t cpi) {
+    if (cpi < 100) cpi = 100;
+    if (cpi > 12000) cpi = 12000;
+    writeRegister(PMW3360_CONFIG1, (uint8_t)(cpi / 100 - 1));
+    this->cpi = (cpi / 100) * 100;
+    return true;
+}
+
+bool PMW3360::setAngleSnap(bool enable) {
+    writeRegister(PMW3360_ANGLE_SNAP, enable ? 0x80 : 0x00);
+    return true;
+}
+
+//
+// ----------------------------------------- PAW3395
+//
+
+#define PAW3395_PRODUCT_ID     0x51
+#define PAW3395_SET_RESOLUTION 0x47
+#define PAW3395_RESOLUTION_X_L 0x48
+#define PAW3395_RESOLUTION_X_H 0x49
+#define PAW3395_RESOLUTION_Y_L 0x4A
+#define PAW3395_RESOLUTION_Y_H 0x4B
+
+PAW3395::PAW3395(PointerBus* bus, bool ownsBus) :
+    PointerSensor(bus, ownsBus),
+    initSequence(nullptr),
+    initLength(0)
+{
+    burstRegister = 0x16;
+    burstNeedsPrime = false;
+}
+
+bool PAW3395::begin() {
+    if (!bus || !bus->begin()) return false;
+
+    powerUp(5000);
+    writeSequence(initSequence, initLength);
+    if (readRegister(REG_PRODUCT_ID) != PAW3395_PRODUCT_ID) return false;
+
+    return setCPI(cpi ? cpi : 1600);
+}
+
+bool PAW3395::setCPI(uint16_t cpi) {
+    if (cpi < 50) cpi = 50;
+    if (cpi > 26000) cpi = 26000;
+    uint16_t value = cpi / 50;
+
+    writeRegister(PAW3395_RESOLUTION_X_L, value & 0xFF);
+    writeRegister(PAW3395_RESOLUTION_X_H, value >> 8);
+    writeRegister(PAW3395_RESOLUTION_Y_L, value & 0xFF);
+    writeRegister(PAW3395_RESOLUTION_Y_H, value >> 8);
+    writeRegister(PAW3395_SET_RESOLUTION, 0x01);   // Latches both axes at once
+    this->cpi = value * 50;
+    return true;
+}
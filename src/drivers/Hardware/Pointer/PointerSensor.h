@@ -0,0 +1,104 @@
+/**
+ * @file PointerSensor.h
+ * @brief Optical pointing sensor drivers (PixArt PMW3360, PAW3395) read with motion bursts
+ *
+ * Only talks to the sensor through a PointerBus, so a fake bus can play the sensor on a desktop.
+ */
+
+#ifndef POINTERSENSOR_H
+#define POINTERSENSOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "PointerBus.h"
+
+#define POINTER_BURST_LENGTH 12   // Motion, Observation, Delta X L/H, Delta Y L/H, SQUAL, Raw sum, Max, Min, Shutter H/L
+
+// One motion burst worth of data
+struct PointerMotion {
+    int16_t dx;
+    int16_t dy;
+    uint8_t squal;    // Surface quality, roughly how many features the sensor can see
+    bool    moved;
+    bool    lifted;   // Off the surface, whatever's in dx/dy shouldn't be trusted
+};
+
+// For the bits of a power-up sequence that only the datasheet has
+struct PointerRegWrite {
+    uint8_t  reg;
+    uint8_t  value;
+};
+
+// Bus timings in us, straight from the datasheet
+struct PointerTiming {
+    uint16_t readAddress;    // tSRAD - address to first data byte on a register read
+    uint16_t burstAddress;   // tSRAD_MOTBR - the same for a motion burst
+    uint16_t afterWrite;     // tSWW/tSWR - before the next access
+    uint16_t afterRead;      // tSRW/tSRR
+    uint16_t writeHold;      // tSCLK-NCS on a write
+};
+
+class PointerSensor {
+public:
+    PointerSensor(PointerBus* bus, bool ownsBus = false);
+    virtual ~PointerSensor();
+
+    virtual bool        begin() = 0;
+    // One SPI transaction - whatever has built up since the last one
+    virtual bool        readMotion(PointerMotion& motion);
+    virtual bool        setCPI(uint16_t cpi) = 0;
+    uint16_t            getCPI() const { return cpi; }
+    // False if the sensor can't snap by itself, SQUIDPOINTER does it in software then
+    virtual bool        setAngleSnap(bool) { return false; }
+    virtual const char* name() const = 0;
+
+protected:
+    uint8_t             readRegister(uint8_t reg);
+    void                writeRegister(uint8_t reg, uint8_t value);
+    void                writeSequence(const PointerRegWrite* sequence, size_t count);
+    // Power_Up_Reset then the usual read of the motion registers to clear them
+    void                powerUp(uint32_t resetWaitUs);
+
+    PointerBus*         bus;
+    const bool          ownsBus;
+    PointerTiming       timing;
+    uint8_t             burstRegister;
+    bool                burstNeedsPrime;   // Some sensors want a write to the burst register after any other access
+    bool                burstPrimed;
+    uint16_t            cpi;
+};
+
+// PMW3360 - 100 to 12000 CPI. Its SROM firmware is PixArt's and isn't shipped here, pass it in before begin() if you have it.
+class PMW3360 : public PointerSensor {
+public:
+    PMW3360(PointerBus* bus, bool ownsBus = false);
+
+    void        setFirmware(const uint8_t* srom, size_t length) { firmware = srom; firmwareLength = length; }
+    bool        begin() override;
+    bool        setCPI(uint16_t cpi) override;
+    bool        setAngleSnap(bool enable) override;
+    const char* name() const override { return "PMW3360"; }
+
+private:
+    bool        uploadFirmware();
+
+    const uint8_t* firmware;
+    size_t         firmwareLength;
+};
+
+// PAW3395 - 50 to 26000 CPI. Its power-up register sequence is under NDA, pass it in from the datasheet before begin().
+class PAW3395 : public PointerSensor {
+public:
+    PAW3395(PointerBus* bus, bool ownsBus = false);
+
+    void        setInitSequence(const PointerRegWrite* sequence, size_t count) { initSequence = sequence; initLength = count; }
+    bool        begin() override;
+    bool        setCPI(uint16_t cpi) override;
+    const char* name() const override { return "PAW3395"; }
+
+private:
+    const PointerRegWrite* initSequence;
+    size_t                 initLength;
+};
+
+#endif
@@ -0,0 +1,174 @@
+/**
+ * @file AnalogFilter.cpp
+ * @brief Implementation of the analog axis conditioning chain
+ */
+
+#include "AnalogFilter.h"
+
+#define TWO_PI_Q16 411775   // 2 * pi * 65536
+
+static inline int32_t clampAxis(int32_t v, int32_t low) {
+    return v < low ? low : (v > ANALOG_AXIS_MAX ? ANALOG_AXIS_MAX : v);
+}
+
+//
+// ----------------------------------------- Filter
+//
+
+AnalogFilter::AnalogFilter() :
+    mode(FILTER_NONE),
+    shift(0),
+    rate(1000),
+    minCutoff(1 << 16),
+    beta(0),
+    twoPiTe(0),
+    alphaD(0),
+    y(0),
+    dx(0),
+    xPrev(0),
+    primed(false)
+{
+    updateRates();
+}
+
+void AnalogFilter::setNone() {
+    mode = FILTER_NONE;
+    reset();
+}
+
+void AnalogFilter::setIIR(uint8_t shift) {
+    this->shift = shift > 15 ? 15 : shift;
+    mode = FILTER_IIR;
+    reset();
+}
+
+void AnalogFilter::setOneEuro(float minCutoffHz, float beta) {
+    this->minCutoff = (int32_t)(minCutoffHz * 65536.0f);
+    this->beta = (int32_t)(beta * 16777216.0f);
+    mode = FILTER_ONE_EURO;
+    reset();
+}
+
+void AnalogFilter::setSampleRate(uint32_t hz) {
+    rate = hz ? hz : 1;
+    updateRates();
+}
+
+void AnalogFilter::updateRates() {
+    twoPiTe = TWO_PI_Q16 / rate;
+    // alpha = r / (r + 1) with r = 2*pi*fc/rate, fc = 1Hz for the derivative
+    alphaD = ((int64_t)twoPiTe << 16) / (twoPiTe + 65536);
+}
+
+void AnalogFilter::reset() {
+    primed = false;
+    dx = 0;
+}
+
+int32_t AnalogFilter::apply(int32_t x) {
+    if (mode == FILTER_NONE) return x;
+
+    if (!primed) {
+        // Start where the input is rather than sliding in from zero
+        y = x << 8;
+        xPrev = x;
+        dx = 0;
+        primed = true;
+        return x;
+    }
+
+    if (mode == FILTER_IIR) {
+        y += ((x << 8) - y) >> shift;
+        return (y + 128) >> 8;
+    }
+
+    // 1-euro: the faster it's moving, the higher the cutoff
+    int32_t speed = (x - xPrev) * (int32_t)rate;
+    xPrev = x;
+    dx += (int32_t)(((int64_t)(speed - dx) * alphaD) >> 16);
+
+    int64_t cutoff = minCutoff + (((int64_t)beta * (dx < 0 ? -dx : dx)) >> 8);
+    int64_t r = (cutoff * twoPiTe) >> 16;
+    int32_t alpha = (int32_t)((r << 16) / (r + 65536));
+
+    y += (int32_t)(((int64_t)((x << 8) - y) * alpha) >> 16);
+    return (y + 128) >> 8;
+}
+
+//
+// ----------------------------------------- Channel
+//
+
+AnalogChannel::AnalogChannel() :
+    min(0),
+    center(2048),
+    max(4095),   // 12 bit ADC until told otherwise
+    invert(false),
+    gainPos(0),
+    gainNeg(0),
+    deadInner(0),
+    deadOuter(0),
+    deadGain(1 << 16),
+    raw(0),
+    out(0)
+{
+    updateGains();
+}
+
+void AnalogChannel::setCalibration(int32_t min, int32_t center, int32_t max, bool invert) {
+    this->min = min;
+    this->center = center;
+    this->max = max;
+    this->invert = invert;
+    updateGains();
+    _filter.reset();
+}
+
+void AnalogChannel::setCenter(int32_t center) {
+    this->center = center;
+    updateGains();
+}
+
+void AnalogChannel::setDeadzone(uint16_t inner, uint16_t outer) {
+    if ((uint32_t)inner + outer >= ANALOG_AXIS_MAX) return;
+    deadInner = inner;
+    deadOuter = outer;
+    updateGains();
+}
+
+void AnalogChannel::updateGains() {
+    // Divides happen here, once, so process() only multiplies
+    gainPos = max > center ? ((uint64_t)ANALOG_AXIS_MAX << 16) / (uint32_t)(max - center) : 0;
+    gainNeg = center > min ? ((uint64_t)ANALOG_AXIS_MAX << 16) / (uint32_t)(center - min) : 0;
+    deadGain = ((uint32_t)ANALOG_AXIS_MAX << 16) / (ANALOG_AXIS_MAX - deadInner - deadOuter);
+}
+
+int16_t AnalogChannel::process(int32_t raw) {
+    this->raw = raw;
+
+    // Calibrate - each side of center gets its own gain, sticks are rarely symmetric
+    int32_t delta = raw - center;
+    uint64_t scaled = delta >= 0 ? (uint64_t)delta * gainPos : (uint64_t)-(int64_t)delta * gainNeg;
+    int32_t v = (int32_t)((scaled + 0x8000) >> 16);
+    if ((delta < 0) != invert) v = -v;
+    // Triggers rest at one end and only ever go one way, whichever end that is
+    bool oneSided = center <= min || center >= max;
+    if (oneSided && v < 0) v = -v;
+    v = clampAxis(v, oneSided ? 0 : -ANALOG_AXIS_MAX);
+
+    v = _filter.apply(v);
+
+    // Deadzone after smoothing, otherwise noise chatters across its edge
+    int32_t magnitude = v < 0 ? -v : v;
+    if (magnitude <= deadInner) {
+        magnitude = 0;
+    } else if (magnitude >= ANALOG_AXIS_MAX - deadOuter) {
+        magnitude = ANALOG_AXIS_MAX;
+    } else {
+        magnitude = ((uint32_t)(magnitude - deadInner) * (uint64_t)deadGain) >> 16;
+    }
+    v = clampAxis(v < 0 ? -magnitude : magnitude, -ANALOG_AXIS_MAX);
+
+    out = (int16_t)v;
+    return out;
+}
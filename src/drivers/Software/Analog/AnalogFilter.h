@@ -0,0 +1,84 @@
+/**
+ * @file AnalogFilter.h
+ * @brief Fixed-point conditioning for analog axes - calibration, smoothing and deadzone
+ *
+ * Plain C++ with no Arduino dependencies, so the whole chain can be built and checked on a desktop.
+ * Floats only show up in the setters, never per sample.
+ */
+
+#ifndef ANALOGFILTER_H
+#define ANALOGFILTER_H
+
+#include <stdint.h>
+
+#define ANALOG_AXIS_MAX 32767
+
+class AnalogFilter {
+public:
+    enum Mode : uint8_t {
+        FILTER_NONE,
+        FILTER_IIR,       // Plain exponential smoothing, cheapest
+        FILTER_ONE_EURO   // Smooths hard at rest, follows fast moves with little lag
+    };
+
+    AnalogFilter();
+
+    void    setNone();
+    void    setIIR(uint8_t shift);   // Each sample moves the output 1/2^shift of the way
+    void    setOneEuro(float minCutoffHz, float beta);
+    void    setSampleRate(uint32_t hz);
+    Mode    getMode() const { return mode; }
+
+    void    reset();
+    int32_t apply(int32_t x);
+
+private:
+    void    updateRates();
+
+    Mode     mode;
+    uint8_t  shift;
+    uint32_t rate;       // Hz
+    int32_t  minCutoff;  // Q16 Hz
+    int32_t  beta;       // Q24, Hz per unit/s
+    int32_t  twoPiTe;    // Q16, 2*pi / rate
+    int32_t  alphaD;     // Q16, the derivative's own 1Hz low-pass
+    int32_t  y;          // Q8, so slow drifts don't get rounded away
+    int32_t  dx;         // Smoothed speed, units/s
+    int32_t  xPrev;
+    bool     primed;
+};
+
+class AnalogChannel {
+public:
+    AnalogChannel();
+
+    // Raw readings at both ends and at rest. Resting at either end makes it one-sided (triggers), 0 to ANALOG_AXIS_MAX.
+    void    setCalibration(int32_t min, int32_t center, int32_t max, bool invert = false);
+    void    setCenter(int32_t center);
+    // Both in output units - inner snaps small values to 0, outer lets the axis hit full scale before the physical end
+    void    setDeadzone(uint16_t inner, uint16_t outer = 0);
+    AnalogFilter& filter() { return _filter; }
+
+    int16_t process(int32_t raw);
+    int32_t lastRaw() const { return raw; }
+    int16_t value() const { return out; }
+
+private:
+    void     updateGains();
+
+    int32_t  min;
+    int32_t  center;
+    int32_t  max;
+    bool     invert;
+    uint32_t gainPos;    // Q16 output units per raw unit, above center
+    uint32_t gainNeg;    // ...and below it
+    uint16_t deadInner;
+    uint16_t deadOuter;
+    uint32_t deadGain;   // Q16, stretches what's left after the deadzones back to full scale
+
+    AnalogFilter _filter;
+    int32_t  raw;
+    int16_t  out;
+};
+
+#endif
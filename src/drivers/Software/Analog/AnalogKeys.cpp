@@ -0,0 +1,69 @@
+/**
+ * @file AnalogKeys.cpp
+ * @brief Implementation of the analog key settings, process() lives in the header
+ */
+
+#include "AnalogKeys.h"
+
+#define ANALOG_KEY_MIN_SPAN 16   // Raw counts - anything closer than this isn't a real calibration, and would overflow the scale
+
+AnalogKeys::AnalogKeys() {}
+
+void AnalogKeys::begin(size_t count) {
+    // Until calibrated, assume a 12 bit reading that rises by about half the range on the way down
+    rest.assign(count, 2048);
+    bottom.assign(count, 3072);
+    scale.assign(count, 0);
+    actuation.assign(count, ANALOG_KEY_ACTUATION);
+    releasePoint.assign(count, ANALOG_KEY_ACTUATION - ANALOG_KEY_HYSTERESIS);
+    sensitivity.assign(count, 0);
+    travel.assign(count, 0);
+    extreme.assign(count, 0);
+    pressed.assign(count, 0);
+
+    for (size_t i = 0; i < count; i++) updateScale(i);
+}
+
+void AnalogKeys::updateScale(size_t key) {
+    int32_t span = (int32_t)bottom[key] - rest[key];
+    if (span > -ANALOG_KEY_MIN_SPAN && span < ANALOG_KEY_MIN_SPAN) {
+        span = span < 0 ? -ANALOG_KEY_MIN_SPAN : ANALOG_KEY_MIN_SPAN;
+    }
+    scale[key] = ((int32_t)ANALOG_KEY_TRAVEL << 12) / span;
+}
+
+void AnalogKeys::setCalibration(size_t key, uint16_t rest, uint16_t bottom) {
+    if (key >= count()) return;
+    this->rest[key] = rest;
+    this->bottom[key] = bottom;
+    updateScale(key);
+}
+
+void AnalogKeys::calibrateRest(const uint16_t* raw) {
+    for (size_t i = 0; i < count(); i++) {
+        int32_t shifted = (int32_t)bottom[i] + raw[i] - rest[i];
+        bottom[i] = (uint16_t)(shifted < 0 ? 0 : (shifted > 0xFFFF ? 0xFFFF : shifted));
+        rest[i] = raw[i];
+        updateScale(i);
+    }
+}
+
+void AnalogKeys::setActuation(size_t key, uint16_t point, uint16_t hysteresis) {
+    if (key >= count()) return;
+    if (point > ANALOG_KEY_TRAVEL) point = ANALOG_KEY_TRAVEL;
+    if (point == 0) point = 1;   // 0 would count a key at rest as pressed
+    actuation[key] = point;
+    releasePoint[key] = hysteresis < point ? point - hysteresis : 1;   // Released once it's all the way back up at worst
+}
+
+void AnalogKeys::setRapidTrigger(size_t key, uint16_t sensitivity) {
+    if (key >= count()) return;
+    this->sensitivity[key] = sensitivity > ANALOG_KEY_TRAVEL ? ANALOG_KEY_TRAVEL : sensitivity;
+}
+
+void AnalogKeys::setAll(uint16_t actuation, uint16_t rapidTrigger, uint16_t hysteresis) {
+    for (size_t i = 0; i < count(); i++) {
+        setActuation(i, actuation, hysteresis);
+        setRapidTrigger(i, rapidTrigger);
+    }
+}
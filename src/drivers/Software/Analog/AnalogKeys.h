@@ -0,0 +1,107 @@
+/**
+ * @file AnalogKeys.h
+ * @brief Per-key travel, actuation and rapid trigger for analog (Hall effect) switches
+ *
+ * Plain C++ with no Arduino dependencies, so the scan kernel can be built and timed on a desktop.
+ * State is kept as one array per field rather than one struct per key, so the travel pass is a
+ * straight loop over contiguous arrays the compiler can vectorise.
+ */
+
+#ifndef ANALOGKEYS_H
+#define ANALOGKEYS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#define ANALOG_KEY_TRAVEL     1023   // Fully bottomed out, whatever the switch's real travel is
+#define ANALOG_KEY_ACTUATION  410    // About 1.6mm on a 4mm switch
+#define ANALOG_KEY_HYSTERESIS 30     // How far back up a key goes before it releases, without rapid trigger
+
+class AnalogKeys {
+public:
+    AnalogKeys();
+
+    void     begin(size_t count);
+    size_t   count() const { return rest.size(); }
+
+    // Raw 12 bit readings with the key untouched and bottomed out. Either direction works, some magnets read lower when pressed.
+    void     setCalibration(size_t key, uint16_t rest, uint16_t bottom);
+    // Takes every reading in `raw` as that key's rest position, keeping its travel
+    void     calibrateRest(const uint16_t* raw);
+    // In travel units, 0 to ANALOG_KEY_TRAVEL
+    void     setActuation(size_t key, uint16_t point, uint16_t hysteresis = ANALOG_KEY_HYSTERESIS);
+    // Re-press after going down `sensitivity`, release after coming up `sensitivity`, anywhere past the actuation point. 0 turns it off.
+    void     setRapidTrigger(size_t key, uint16_t sensitivity);
+    void     setAll(uint16_t actuation, uint16_t rapidTrigger = 0, uint16_t hysteresis = ANALOG_KEY_HYSTERESIS);
+
+    // One reading per key. Calls onChange(key, pressed) for every key that flipped, returns how many did.
+    template<typename F>
+    size_t   process(const uint16_t* raw, F&& onChange);
+
+    bool     isPressed(size_t key) const { return key < pressed.size() && pressed[key]; }
+    uint16_t getTravel(size_t key) const { return key < travel.size() ? travel[key] : 0; }
+
+private:
+    void     updateScale(size_t key);
+
+    // Calibration
+    std::vector<uint16_t> rest;
+    std::vector<uint16_t> bottom;
+    std::vector<int32_t>  scale;       // Q12 travel units per raw count, negative if readings fall as the key goes down
+
+    // Settings
+    std::vector<uint16_t> actuation;
+    std::vector<uint16_t> releasePoint;
+    std::vector<uint16_t> sensitivity;  // Rapid trigger, 0 if off
+
+    // State
+    std::vector<uint16_t> travel;
+    std::vector<uint16_t> extreme;      // Deepest point since pressing, or highest since releasing
+    std::vector<uint8_t>  pressed;      // Bytes rather than vector<bool>, no bit twiddling in the loop
+};
+
+template<typename F>
+size_t AnalogKeys::process(const uint16_t* raw, F&& onChange) {
+    const size_t n = rest.size();
+    uint16_t*       t   = travel.data();
+    const uint16_t* r   = rest.data();
+    const int32_t*  s   = scale.data();
+
+    // Pass 1: raw to travel, no branches besides the clamp
+    for (size_t i = 0; i < n; i++) {
+        int32_t v = ((int32_t)raw[i] - r[i]) * s[i] >> 12;
+        v = v < 0 ? 0 : v;
+        t[i] = (uint16_t)(v > ANALOG_KEY_TRAVEL ? ANALOG_KEY_TRAVEL : v);
+    }
+
+    // Pass 2: state, most keys fall straight through the first test
+    size_t changes = 0;
+    uint16_t*       ex  = extreme.data();
+    uint8_t*        p   = pressed.data();
+    const uint16_t* act = actuation.data();
+    const uint16_t* rel = releasePoint.data();
+    const uint16_t* sen = sensitivity.data();
+
+    for (size_t i = 0; i < n; i++) {
+        uint16_t v = t[i];
+        if (!p[i]) {
+            if (v < ex[i]) ex[i] = v;
+            // Past the actuation point - with rapid trigger it also has to have come down far enough since the last release
+            if (v < act[i] || (sen[i] && v < ex[i] + sen[i])) continue;
+            p[i] = 1;
+            ex[i] = v;
+        } else {
+            if (v > ex[i]) ex[i] = v;
+            bool release = v < rel[i] || (sen[i] && v + sen[i] <= ex[i]);
+            if (!release) continue;
+            p[i] = 0;
+            ex[i] = v;
+        }
+        onChange(i, p[i] != 0);
+        changes++;
+    }
+    return changes;
+}
+
+#endif
@@ -0,0 +1,39 @@
+/**
+ * @file AxisHysteresis.cpp
+ * @brief Implementation of the axis hysteresis/quantisation
+ */
+
+#include "AxisHysteresis.h"
+
+#define AXIS_RAIL 32767
+
+AxisHysteresis::AxisHysteresis() : hysteresis(0), bits(0), held(0) { }
+
+void AxisHysteresis::setHysteresis(uint16_t counts) {
+    hysteresis = counts;
+}
+
+void AxisHysteresis::setQuantisation(uint8_t bits) {
+    this->bits = bits > 14 ? 14 : bits;
+}
+
+void AxisHysteresis::reset(int16_t value) {
+    held = value;
+}
+
+int16_t AxisHysteresis::apply(int16_t raw) {
+    int32_t v = raw;
+    if (bits) {
+        v = ((v + (1 << (bits - 1))) >> bits) << bits;
+        if (v > AXIS_RAIL) v = AXIS_RAIL;
+        if (v < -AXIS_RAIL) v = -AXIS_RAIL;
+    }
+
+    // Centre and the end stops always get through, otherwise a stick could rest a few counts off them
+    int32_t diff = v - held;
+    if (diff < 0) diff = -diff;
+    if (diff > hysteresis || raw == 0 || raw >= AXIS_RAIL || raw <= -AXIS_RAIL) {
+        held = (int16_t)v;
+    }
+    return held;
+}
@@ -0,0 +1,32 @@
+/**
+ * @file AxisHysteresis.h
+ * @brief Holds an axis still until it's really moved, so sensor noise doesn't turn into reports
+ *
+ * Plain C++ with no Arduino dependencies, so it can be built and checked on a desktop.
+ */
+
+#ifndef AXISHYSTERESIS_H
+#define AXISHYSTERESIS_H
+
+#include <stdint.h>
+
+class AxisHysteresis {
+public:
+    AxisHysteresis();
+
+    // Has to move more than this many counts from the held value before it changes, 0 is off
+    void    setHysteresis(uint16_t counts);
+    // Rounds to steps of 2^bits first, 0 is off
+    void    setQuantisation(uint8_t bits);
+    void    reset(int16_t value = 0);
+
+    int16_t apply(int16_t raw);
+    int16_t value() const { return held; }
+
+private:
+    uint16_t hysteresis;
+    uint8_t  bits;
+    int16_t  held;
+};
+
+#endif
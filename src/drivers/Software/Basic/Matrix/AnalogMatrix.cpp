@@ -0,0 +1,105 @@
+/**
+ * @file AnalogMatrix.cpp
+ * @brief Implementation of the analog key matrix
+ */
+
+#include "AnalogMatrix.h"
+
+SQUIDANALOGMATRIX::SQUIDANALOGMATRIX()
+    : _channels(0),
+      _index_offset(0),
+      _scan_initialized(false),
+      _key_event_callback(nullptr),
+      _pinModeFunc(nullptr),
+      _digitalWriteFunc(nullptr),
+      _analogReadFunc(nullptr) {}
+
+bool SQUIDANALOGMATRIX::begin(const AnalogMuxConfig& config,
+                              std::function<void(size_t, bool)> key_event_callback,
+                              size_t index_offset,
+                              std::function<void(uint8_t, uint8_t)> pinModeFunc,
+                              std::function<void(uint8_t, uint8_t)> digitalWriteFunc,
+                              std::function<uint16_t(uint8_t)> analogReadFunc) {
+    if (config.adcPins.empty() || config.selectPins.size() > 8) {
+        SQUID_LOG_ERROR(MATRIX_TAG, "Analog matrix needs at least one ADC pin and at most 8 select pins");
+        return false;
+    }
+
+    _config = config;
+    _key_event_callback = key_event_callback;
+    _index_offset = index_offset;
+    _pinModeFunc = pinModeFunc;
+    _digitalWriteFunc = digitalWriteFunc;
+    _analogReadFunc = analogReadFunc;
+
+    _channels = (size_t)1 << _config.selectPins.size();
+    size_t capacity = _channels * _config.adcPins.size();
+    size_t count = _config.keyCount && _config.keyCount < capacity ? _config.keyCount : capacity;
+
+    _keys.begin(count);
+    _raw.assign(capacity, 0);
+
+    for (uint8_t pin : _config.selectPins) {
+        if (_pinModeFunc) _pinModeFunc(pin, OUTPUT);
+        else ::pinMode(pin, OUTPUT);
+    }
+
+    _scan_initialized = true;
+
+    // Whatever the keys read right now is as good a rest position as any until calibrated properly
+    readAll();
+    calibrateRest();
+
+    SQUID_LOG_INFO(MATRIX_TAG, "Analog matrix initialized with %zu keys on %zu muxes of %zu channels",
+                   count, _config.adcPins.size(), _channels);
+    return true;
+}
+
+void SQUIDANALOGMATRIX::selectChannel(size_t channel) {
+    for (size_t bit = 0; bit < _config.selectPins.size(); ++bit) {
+        uint8_t level = (channel >> bit) & 1 ? HIGH : LOW;
+        if (_digitalWriteFunc) _digitalWriteFunc(_config.selectPins[bit], level);
+        else ::digitalWrite(_config.selectPins[bit], level);
+    }
+}
+
+void SQUIDANALOGMATRIX::readAll() {
+    // Channel-major, so every mux gets switched at once and each switch only settles once
+    size_t muxes = _config.adcPins.size();
+    for (size_t channel = 0; channel < _channels; ++channel) {
+        selectChannel(channel);
+        if (_config.settleUs) delayMicroseconds(_config.settleUs);
+
+        for (size_t mux = 0; mux < muxes; ++mux) {
+            uint8_t pin = _config.adcPins[mux];
+            _raw[mux * _channels + channel] = _analogReadFunc ? _analogReadFunc(pin) : ::analogRead(pin);
+        }
+    }
+}
+
+void SQUIDANALOGMATRIX::update() {
+    if (!_scan_initialized) return;
+
+    readAll();
+    _keys.process(_raw.data(), [this](size_t key, bool pressed) {
+        if (_key_event_callback) {
+            _key_event_callback(key + _index_offset, pressed);
+        }
+    });
+}
+
+void SQUIDANALOGMATRIX::calibrateRest() {
+    if (!_scan_initialized) return;
+    _keys.calibrateRest(_raw.data());
+    SQUID_LOG_DEBUG(MATRIX_TAG, "Analog matrix rest positions recalibrated");
+}
+
+bool SQUIDANALOGMATRIX::isPressed(size_t switch_index) const {
+    if (switch_index < _index_offset) return false;
+    return _keys.isPressed(switch_index - _index_offset);
+}
+
+uint16_t SQUIDANALOGMATRIX::getTravel(size_t switch_index) const {
+    if (switch_index < _index_offset) return 0;
+    return _keys.getTravel(switch_index - _index_offset);
+}
@@ -0,0 +1,68 @@
+/**
+ * @file AnalogMatrix.h
+ * @brief Analog (Hall effect) key matrix read through multiplexers
+ */
+
+#ifndef ANALOGMATRIX_H
+#define ANALOGMATRIX_H
+
+#include "drivers/Data.h"
+#include "drivers/Software/Analog/AnalogKeys.h"
+
+#define ANALOG_MUX_SETTLE_US 2   // After switching channels, before reading
+
+// Every mux shares the same select lines, key index is mux * channels + channel
+struct AnalogMuxConfig {
+    std::vector<uint8_t> selectPins;   // S0, S1... - 4 of them for a 16 channel mux
+    std::vector<uint8_t> adcPins;      // One per mux, wherever its common pin goes
+    uint16_t             keyCount;     // 0 uses every channel of every mux
+    uint16_t             settleUs;
+
+    AnalogMuxConfig(std::vector<uint8_t> select = {}, std::vector<uint8_t> adc = {}, uint16_t keys = 0)
+        : selectPins(select), adcPins(adc), keyCount(keys), settleUs(ANALOG_MUX_SETTLE_US) {}
+};
+
+class SQUIDANALOGMATRIX {
+private:
+    AnalogMuxConfig _config;
+    AnalogKeys _keys;
+    std::vector<uint16_t> _raw;
+    size_t _channels;
+    size_t _index_offset;   // Where these keys start in the keymap, after any digital matrix
+    bool _scan_initialized;
+    std::function<void(size_t, bool)> _key_event_callback;
+
+    // GPIO function pointers, same as SQUIDMATRIX, plus the ADC read for external converters
+    std::function<void(uint8_t, uint8_t)> _pinModeFunc;
+    std::function<void(uint8_t, uint8_t)> _digitalWriteFunc;
+    std::function<uint16_t(uint8_t)> _analogReadFunc;
+
+    void selectChannel(size_t channel);
+    void readAll();
+
+public:
+    SQUIDANALOGMATRIX();
+
+    bool begin(const AnalogMuxConfig& config,
+               std::function<void(size_t, bool)> key_event_callback = nullptr,
+               size_t index_offset = 0,
+               std::function<void(uint8_t, uint8_t)> pinModeFunc = nullptr,
+               std::function<void(uint8_t, uint8_t)> digitalWriteFunc = nullptr,
+               std::function<uint16_t(uint8_t)> analogReadFunc = nullptr);
+
+    // Reads every key once and fires the callback for any that changed
+    void update();
+    // Keys must be untouched while this runs
+    void calibrateRest();
+
+    AnalogKeys& keys() { return _keys; }
+    bool isPressed(size_t switch_index) const;
+    uint16_t getTravel(size_t switch_index) const;
+    uint16_t getRaw(size_t key) const { return key < _raw.size() ? _raw[key] : 0; }
+    size_t getSwitchCount() const { return _keys.count(); }
+    size_t getIndexOffset() const { return _index_offset; }
+    // For when the digital matrix in front of these keys gets set up after this one
+    void setIndexOffset(size_t index_offset) { _index_offset = index_offset; }
+};
+
+#endif // ANALOGMATRIX_H
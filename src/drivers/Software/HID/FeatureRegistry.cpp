@@ -0,0 +1,94 @@
+/**
+ * @file FeatureRegistry.cpp
+ * @brief Runtime HID feature registry implementation
+ */
+
+#include "drivers/Data.h"
+#include "FeatureRegistry.h"
+
+HIDFeatureRegistry::HIDFeatureRegistry()
+    : entries(nullptr)
+    , entryCount(0)
+    , fullDescriptor(nullptr)
+    , fullLength(0)
+    , availableMask(0)
+    , activeMask(0)
+{
+}
+
+void HIDFeatureRegistry::begin(const HIDFeatureEntry* table, size_t count, const uint8_t* descriptor, size_t length) {
+    entries        = table;
+    entryCount     = count;
+    fullDescriptor = descriptor;
+    fullLength     = length;
+
+    availableMask = 0;
+    for (size_t i = 0; i < entryCount; i++) {
+        availableMask |= entries[i].feature;
+    }
+
+    // Everything that's compiled in starts out switched on
+    activeMask = availableMask;
+    profileDescriptor.clear();
+    profileDescriptor.shrink_to_fit();
+}
+
+bool HIDFeatureRegistry::setProfile(uint32_t features) {
+    // Keyboard always stays - the LED output report and the transports depend on it
+    uint32_t mask = (features | HID_FEATURE_NKRO) & availableMask;
+
+    if ((features & ~availableMask) != 0 && features != HID_FEATURE_ALL) {
+        SQUID_LOG_WARN(MAIN_TAG, "Profile asks for features that aren't compiled in (0x%02X), ignoring them",
+                       features & ~availableMask);
+    }
+
+    if (mask == activeMask) {
+        return false;
+    }
+
+    activeMask = mask;
+    rebuildDescriptor();
+
+    for (size_t i = 0; i < entryCount; i++) {
+        SQUID_LOG_DEBUG(MAIN_TAG, "Feature %s: %s", entries[i].name,
+                        isActive(entries[i].feature) ? "on" : "off");
+    }
+
+    return true;
+}
+
+void HIDFeatureRegistry::rebuildDescriptor() {
+    if (activeMask == availableMask) {
+        // Back to the full set, so drop the RAM copy and point at flash again
+        profileDescriptor.clear();
+        profileDescriptor.shrink_to_fit();
+        SQUID_LOG_INFO(MAIN_TAG, "HID descriptor restored to full feature set (%zu bytes)", fullLength);
+        return;
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < entryCount; i++) {
+        if (isActive(entries[i].feature)) {
+            total += entries[i].length;
+        }
+    }
+
+    profileDescriptor.clear();
+    profileDescriptor.reserve(total);
+    for (size_t i = 0; i < entryCount; i++) {
+        if (isActive(entries[i].feature)) {
+            profileDescriptor.insert(profileDescriptor.end(), entries[i].descriptor,
+                                     entries[i].descriptor + entries[i].length);
+        }
+    }
+
+    SQUID_LOG_INFO(MAIN_TAG, "HID descriptor rebuilt for profile 0x%02X (%zu bytes)", activeMask, total);
+}
+
+const uint8_t* HIDFeatureRegistry::descriptor() const {
+    return profileDescriptor.empty() ? fullDescriptor : profileDescriptor.data();
+}
+
+size_t HIDFeatureRegistry::descriptorLength() const {
+    return profileDescriptor.empty() ? fullLength : profileDescriptor.size();
+}
@@ -0,0 +1,67 @@
+/**
+ * @file FeatureRegistry.h
+ * @brief Runtime selection of which compiled-in HID features get exposed to the host
+ */
+
+#ifndef FEATUREREGISTRY_H
+#define FEATUREREGISTRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// config.h decides what gets compiled in, these decide what's actually switched on
+enum HIDFeature : uint32_t {
+    HID_FEATURE_NKRO       = 0x01,
+    HID_FEATURE_MEDIA      = 0x02,
+    HID_FEATURE_SPACEMOUSE = 0x04,
+    HID_FEATURE_MOUSE      = 0x08,
+    HID_FEATURE_DIGITIZER  = 0x10,
+    HID_FEATURE_GAMEPAD    = 0x20,
+    HID_FEATURE_STENO      = 0x40,
+    HID_FEATURE_ALL        = 0xFFFFFFFF
+};
+
+// Some ready-made profiles - anything that isn't compiled in just gets masked off
+#define HID_PROFILE_KEYBOARD  (HID_FEATURE_NKRO | HID_FEATURE_MEDIA)
+#define HID_PROFILE_MACROPAD  (HID_FEATURE_NKRO | HID_FEATURE_MEDIA | HID_FEATURE_MOUSE)
+#define HID_PROFILE_6DOF      (HID_FEATURE_NKRO | HID_FEATURE_SPACEMOUSE)
+#define HID_PROFILE_STENO     (HID_FEATURE_NKRO | HID_FEATURE_STENO)
+
+struct HIDFeatureEntry {
+    uint32_t       feature;
+    const uint8_t* descriptor;
+    size_t         length;
+    const char*    name;
+};
+
+class HIDFeatureRegistry {
+private:
+    const HIDFeatureEntry* entries;
+    size_t                 entryCount;
+
+    // The full descriptor is already sitting in flash, so it's only copied into RAM for a reduced profile
+    const uint8_t*         fullDescriptor;
+    size_t                 fullLength;
+    std::vector<uint8_t>   profileDescriptor;
+
+    uint32_t               availableMask;
+    uint32_t               activeMask;
+
+    void                   rebuildDescriptor();
+
+public:
+    HIDFeatureRegistry();
+
+    void        begin(const HIDFeatureEntry* table, size_t count, const uint8_t* descriptor, size_t length);
+    bool        setProfile(uint32_t features);
+
+    uint32_t    available() const { return availableMask; }
+    uint32_t    active() const { return activeMask; }
+    bool        isActive(uint32_t feature) const { return (activeMask & feature) != 0; }
+
+    const uint8_t* descriptor() const;
+    size_t         descriptorLength() const;
+};
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * @file HIDDescriptor.h
+ * @brief Compile-time HID report descriptor assembly and validation
+ */
+
+#ifndef HIDDESCRIPTOR_H
+#define HIDDESCRIPTOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Fixed-size descriptor blob - everything in here is built by the compiler, so a
+// static constexpr instance ends up in flash with nothing to do at boot
+template <size_t N>
+struct HIDDescriptor {
+    uint8_t data[N];
+
+    constexpr size_t size() const { return N; }
+    constexpr const uint8_t* begin() const { return data; }
+};
+
+namespace HIDDescriptorDetail {
+    constexpr void copyPart(uint8_t* out, size_t& pos, const uint8_t* part, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            out[pos++] = part[i];
+        }
+    }
+
+    // Short items carry 0, 1, 2 or 4 data bytes depending on the low two bits of the prefix
+    constexpr size_t itemDataSize(uint8_t prefix) {
+        return (prefix & 0x03) == 0x03 ? 4 : (prefix & 0x03);
+    }
+}
+
+// Glue the per-feature descriptor arrays together back to back
+template <size_t... Ns>
+constexpr HIDDescriptor<(Ns + ...)> concatDescriptors(const uint8_t (&... parts)[Ns]) {
+    HIDDescriptor<(Ns + ...)> out{};
+    size_t pos = 0;
+    (HIDDescriptorDetail::copyPart(out.data, pos, parts, Ns), ...);
+    return out;
+}
+
+// Walks the item stream and makes sure every item fits and every collection gets closed
+template <size_t N>
+constexpr bool descriptorWellFormed(const HIDDescriptor<N>& desc) {
+    size_t i = 0;
+    int depth = 0;
+    while (i < N) {
+        uint8_t prefix = desc.data[i];
+
+        if (prefix == 0xFE) { // Long item - size byte, tag byte, then data
+            if (i + 2 >= N) return false;
+            i += 3 + desc.data[i + 1];
+            continue;
+        }
+
+        if ((prefix & 0xFC) == 0xA0) depth++;           // Collection
+        if ((prefix & 0xFC) == 0xC0 && --depth < 0) return false; // End Collection
+
+        i += 1 + HIDDescriptorDetail::itemDataSize(prefix);
+    }
+    return i == N && depth == 0;
+}
+
+// Every Report ID item in the descriptor has to be non-zero and only show up once
+template <size_t N>
+constexpr bool descriptorReportIdsUnique(const HIDDescriptor<N>& desc) {
+    bool seen[256] = {};
+    size_t i = 0;
+    while (i < N) {
+        uint8_t prefix = desc.data[i];
+
+        if (prefix == 0xFE) {
+            if (i + 2 >= N) return false;
+            i += 3 + desc.data[i + 1];
+            continue;
+        }
+
+        if (prefix == 0x85) { // Report ID, 1 byte
+            if (i + 1 >= N) return false;
+            uint8_t id = desc.data[i + 1];
+            if (id == 0 || seen[id]) return false;
+            seen[id] = true;
+        }
+
+        i += 1 + HIDDescriptorDetail::itemDataSize(prefix);
+    }
+    return true;
+}
+
+#endif
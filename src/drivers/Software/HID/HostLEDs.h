@@ -0,0 +1,51 @@
+/**
+ * @file HostLEDs.h
+ * @brief Hands the host's lock LED bits over from the transport's task to update()
+ *
+ * Plain C++ with no Arduino dependencies, so the handoff can be checked on a desktop.
+ */
+
+#ifndef HOSTLEDS_H
+#define HOSTLEDS_H
+
+#include <stdint.h>
+#include <atomic>
+
+#define HOST_LED_MASK 0x1F   // Num, caps, scroll, compose, kana - the rest of the byte is padding
+
+class HostLEDs {
+public:
+    // Any task. Only the newest state matters, so posting twice before a take() just replaces the first.
+    void post(uint8_t leds) {
+        // Bits first, then the flag, so take() never sees the flag without them
+        pending.store(leds & HOST_LED_MASK, std::memory_order_relaxed);
+        posted.store(true, std::memory_order_release);
+    }
+
+    // update()'s task only - the bits that flipped since the last take(), 0 if none did
+    uint8_t take() {
+        if (!posted.exchange(false, std::memory_order_acquire)) return 0;
+        uint8_t leds = pending.load(std::memory_order_relaxed);
+        uint8_t changed = leds ^ current;
+        current = leds;
+        return changed;
+    }
+
+    // update()'s task only - the state as of the last take()
+    uint8_t get() const { return current; }
+
+    // Any task - the newest bits posted, taken yet or not
+    uint8_t latest() const { return pending.load(std::memory_order_acquire); }
+
+    // PS/2 Set LEDs has scroll/num/caps in bits 0/1/2, HID wants num/caps/scroll
+    static uint8_t fromPS2(uint8_t ps2) {
+        return ((ps2 >> 1) & 0x03) | ((ps2 & 0x01) << 2);
+    }
+
+private:
+    std::atomic<uint8_t> pending{0};
+    std::atomic<bool>    posted{false};
+    uint8_t              current = 0;   // Only update()'s task touches this
+};
+
+#endif
@@ -617,41 +617,42 @@
 #define SET_IDLE                 0xa
 
 /* HID Class Report Descriptor */
-/* Short items: size is 0, 1, 2 or 3 specifying 0, 1, 2 or 4 (four) bytes */
-/* of data as per HID Class standard */
+/* Short items: the argument is how many bytes of data follow - 0, 1, 2 or 4. */
+/* The size code in the low bits of the prefix is 0, 1, 2 or 3 as per HID Class standard */
+#define HID_SIZE(a)              ((a) == 4 ? 3 : (a))
 
 /* Main items */
-#define HIDINPUT(a)              0x80,a
-#define HIDOUTPUT(a)             0x90,a
-#define FEATURE(a)               0xb0,a
-#define COLLECTION(a)            0xa0,a
-#define END_COLLECTION(a)        0xc0,a
+#define HIDINPUT(a)              (0x80 | HID_SIZE(a))
+#define HIDOUTPUT(a)             (0x90 | HID_SIZE(a))
+#define FEATURE(a)               (0xb0 | HID_SIZE(a))
+#define COLLECTION(a)            (0xa0 | HID_SIZE(a))
+#define END_COLLECTION(a)        (0xc0 | HID_SIZE(a))
 
 /* Global items */
-#define USAGE_PAGE(a)            0x04,a
-#define LOGICAL_MINIMUM(a)       0x14,a
-#define LOGICAL_MAXIMUM(a)       0x24,a
-#define PHYSICAL_MINIMUM(a)      0x34,a
-#define PHYSICAL_MAXIMUM(a)      0x44,a
-#define UNIT_EXPONENT(a)         0x54,a
-#define UNIT(a)                  0x64,a
-#define REPORT_SIZE(a)           0x74,a  //bits
-#define REPORT_ID(a)             0x84,a
-#define REPORT_COUNT(a)          0x94,a  //bytes
-#define PUSH(a)                  0xa4,a
-#define POP(a)                   0xb4,a
+#define USAGE_PAGE(a)            (0x04 | HID_SIZE(a))
+#define LOGICAL_MINIMUM(a)       (0x14 | HID_SIZE(a))
+#define LOGICAL_MAXIMUM(a)       (0x24 | HID_SIZE(a))
+#define PHYSICAL_MINIMUM(a)      (0x34 | HID_SIZE(a))
+#define PHYSICAL_MAXIMUM(a)      (0x44 | HID_SIZE(a))
+#define UNIT_EXPONENT(a)         (0x54 | HID_SIZE(a))
+#define UNIT(a)                  (0x64 | HID_SIZE(a))
+#define REPORT_SIZE(a)           (0x74 | HID_SIZE(a))  //bits
+#define REPORT_ID(a)             (0x84 | HID_SIZE(a))
+#define REPORT_COUNT(a)          (0x94 | HID_SIZE(a))  //bytes
+#define PUSH(a)                  (0xa4 | HID_SIZE(a))
+#define POP(a)                   (0xb4 | HID_SIZE(a))
 
 /* Local items */
-#define USAGE(a)                 0x08,a
-#define USAGE_MINIMUM(a)         0x18,a
-#define USAGE_MAXIMUM(a)         0x28,a
-#define DESIGNATOR_INDEX(a)      0x38,a
-#define DESIGNATOR_MINIMUM(a)    0x48,a
-#define DESIGNATOR_MAXIMUM(a)    0x58,a
-#define STRING_INDEX(a)          0x78,a
-#define STRING_MINIMUM(a)        0x88,a
-#define STRING_MAXIMUM(a)        0x98,a
-#define DELIMITER(a)             0xa8,a
+#define USAGE(a)                 (0x08 | HID_SIZE(a))
+#define USAGE_MINIMUM(a)         (0x18 | HID_SIZE(a))
+#define USAGE_MAXIMUM(a)         (0x28 | HID_SIZE(a))
+#define DESIGNATOR_INDEX(a)      (0x38 | HID_SIZE(a))
+#define DESIGNATOR_MINIMUM(a)    (0x48 | HID_SIZE(a))
+#define DESIGNATOR_MAXIMUM(a)    (0x58 | HID_SIZE(a))
+#define STRING_INDEX(a)          (0x78 | HID_SIZE(a))
+#define STRING_MINIMUM(a)        (0x88 | HID_SIZE(a))
+#define STRING_MAXIMUM(a)        (0x98 | HID_SIZE(a))
+#define DELIMITER(a)             (0xa8 | HID_SIZE(a))
 
 /* HID Report */
 /* Where report IDs are used the first byte of 'data' will be the */
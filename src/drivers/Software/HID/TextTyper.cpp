@@ -0,0 +1,37 @@
+/**
+ * @file TextTyper.cpp
+ * @brief Implementation of the text report planner
+ */
+
+#include "TextTyper.h"
+
+TextTyper::TextTyper() {
+    reset();
+}
+
+void TextTyper::reset() {
+    last = TextReport{ 0, 0 };
+}
+
+uint8_t TextTyper::type(uint8_t c, TextReport out[2]) {
+    AsciiKey key = asciiToKey(c);
+    if (!key.keycode) return 0;
+
+    uint8_t n = 0;
+    // A key has to go down in a report whose modifiers the host has already seen, or "aB" can come out
+    // as "ab" - so a shift change gets a report to itself first. The same key twice needs a gap too.
+    if (key.modifiers != last.modifiers || key.keycode == last.keycode) {
+        out[n++] = TextReport{ key.modifiers, 0 };
+    }
+    out[n++] = TextReport{ key.modifiers, key.keycode };
+    last = out[n - 1];
+    return n;
+}
+
+uint8_t TextTyper::finish(TextReport out[1]) {
+    if (!last.keycode && !last.modifiers) return 0;
+    // Shift and the key can go up together, letting go of a key never types anything
+    out[0] = TextReport{ 0, 0 };
+    last = out[0];
+    return 1;
+}
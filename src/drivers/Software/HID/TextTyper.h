@@ -0,0 +1,85 @@
+/**
+ * @file TextTyper.h
+ * @brief Turns ASCII text into the shortest run of keyboard reports that types it
+ *
+ * Plain C++ with no Arduino dependencies, so it can be built and checked on a desktop.
+ * Keycodes here are real HID usages, not the 0x88-offset ones the KC_ constants use for Enter and co.
+ */
+
+#ifndef TEXTTYPER_H
+#define TEXTTYPER_H
+
+#include <stdint.h>
+
+#define TEXT_MOD_SHIFT 0x02   // Left shift in the report's modifier byte
+
+struct AsciiKey {
+    uint8_t keycode;     // 0 if there's no key for it
+    uint8_t modifiers;
+};
+
+#define TK(k)  { k, 0 }
+#define TS(k)  { k, TEXT_MOD_SHIFT }
+#define TX     { 0, 0 }
+
+// US layout, indexed by the character
+static constexpr AsciiKey ASCII_KEYS[128] = {
+    // 0x00 - 0x1F, only the controls that have a key of their own
+    TX,       TX,       TX,       TX,       TX,       TX,       TX,       TX,
+    TK(0x2A), TK(0x2B), TK(0x28), TX,       TX,       TX,       TX,       TX,        // \b \t \n, \r is skipped so \r\n is one Enter
+    TX,       TX,       TX,       TX,       TX,       TX,       TX,       TX,
+    TX,       TX,       TX,       TK(0x29), TX,       TX,       TX,       TX,        // Esc
+    // ' ' to '/'
+    TK(0x2C), TS(0x1E), TS(0x34), TS(0x20), TS(0x21), TS(0x22), TS(0x24), TK(0x34),
+    TS(0x26), TS(0x27), TS(0x25), TS(0x2E), TK(0x36), TK(0x2D), TK(0x37), TK(0x38),
+    // '0' to '?'
+    TK(0x27), TK(0x1E), TK(0x1F), TK(0x20), TK(0x21), TK(0x22), TK(0x23), TK(0x24),
+    TK(0x25), TK(0x26), TS(0x33), TK(0x33), TS(0x36), TK(0x2E), TS(0x37), TS(0x38),
+    // '@' to '_'
+    TS(0x1F), TS(0x04), TS(0x05), TS(0x06), TS(0x07), TS(0x08), TS(0x09), TS(0x0A),
+    TS(0x0B), TS(0x0C), TS(0x0D), TS(0x0E), TS(0x0F), TS(0x10), TS(0x11), TS(0x12),
+    TS(0x13), TS(0x14), TS(0x15), TS(0x16), TS(0x17), TS(0x18), TS(0x19), TS(0x1A),
+    TS(0x1B), TS(0x1C), TS(0x1D), TK(0x2F), TK(0x31), TK(0x30), TS(0x23), TS(0x2D),
+    // '`' to Del
+    TK(0x35), TK(0x04), TK(0x05), TK(0x06), TK(0x07), TK(0x08), TK(0x09), TK(0x0A),
+    TK(0x0B), TK(0x0C), TK(0x0D), TK(0x0E), TK(0x0F), TK(0x10), TK(0x11), TK(0x12),
+    TK(0x13), TK(0x14), TK(0x15), TK(0x16), TK(0x17), TK(0x18), TK(0x19), TK(0x1A),
+    TK(0x1B), TK(0x1C), TK(0x1D), TS(0x2F), TS(0x31), TS(0x30), TS(0x35), TK(0x4C),
+};
+
+#undef TK
+#undef TS
+#undef TX
+
+static constexpr AsciiKey asciiToKey(uint8_t c) {
+    return c < 128 ? ASCII_KEYS[c] : AsciiKey{ 0, 0 };
+}
+
+static_assert(asciiToKey('a').keycode == 0x04 && asciiToKey('Z').modifiers == TEXT_MOD_SHIFT, "ASCII_KEYS is out of line");
+static_assert(asciiToKey('~').keycode == 0x35 && asciiToKey(0x7F).keycode == 0x4C && !asciiToKey('\r').keycode, "ASCII_KEYS is out of line");
+
+// What the text adds to the report - one key at most, since the order of keys inside a report is lost
+struct TextReport {
+    uint8_t modifiers;
+    uint8_t keycode;     // 0 for nothing down
+};
+
+class TextTyper {
+public:
+    TextTyper();
+
+    void    reset();
+
+    // Reports to send so c gets typed after whatever came before, up to 2 of them. Letting go of the
+    // last key rides along with pressing the next one, so most characters are a single report.
+    // Returns how many went into out, 0 if c can't be typed.
+    uint8_t type(uint8_t c, TextReport out[2]);
+
+    // The report that lets go of everything, 0 if nothing's down
+    uint8_t finish(TextReport out[1]);
+
+private:
+    TextReport last;
+};
+
+#endif
@@ -147,6 +147,9 @@ void SQUIDLOGS::processQueue() {
         if (outputHandler) {
             outputHandler(entry);
         }
+        for (auto& sink : sinks) {
+            if (sink) sink(entry);
+        }
         logQueue.pop();
     }
     
@@ -156,6 +159,22 @@ void SQUIDLOGS::processQueue() {
     #endif
 }
 
+size_t SQUIDLOGS::addSink(std::function<void(const LogEntry&)> sink) {
+    // Reuse a removed slot so the IDs handed out stay valid
+    for (size_t i = 0; i < sinks.size(); i++) {
+        if (!sinks[i]) {
+            sinks[i] = sink;
+            return i;
+        }
+    }
+    sinks.push_back(sink);
+    return sinks.size() - 1;
+}
+
+void SQUIDLOGS::removeSink(size_t id) {
+    if (id < sinks.size()) sinks[id] = nullptr;
+}
+
 void SQUIDLOGS::flush() {
     processQueue();
 }
@@ -11,6 +11,7 @@
 #include <string>
 #include <functional>
 #include <cstdarg>
+#include <vector>
 
 // Platform detection - Only ESP/nRF for now
 #if defined(ARDUINO_ARCH_ESP32)
@@ -54,6 +55,7 @@ private:
     uint32_t maxQueueSize = 100; // Prevent memory exhaustion
     LogLevel currentLogLevel = LogLevel::INFO; // Default level
     std::function<void(const LogEntry&)> outputHandler;
+    std::vector<std::function<void(const LogEntry&)>> sinks;  // Extra outputs after the handler, a removed one leaves an empty slot
     
 public:
     static SQUIDLOGS& getInstance() {
@@ -66,6 +68,11 @@ public:
     void initialize(std::function<void(const LogEntry&)> handler = nullptr);
     void log(LogLevel level, const std::string& tag, const std::string& message);
     void processQueue();
+    
+    // Extra outputs (an OLED console, a file...) that see every entry after the handler does.
+    // They run from processQueue(), so on whatever task calls that rather than the one logging.
+    size_t addSink(std::function<void(const LogEntry&)> sink);
+    void removeSink(size_t id);
     void flush();
     
     // Unified log level control
@@ -0,0 +1,67 @@
+/**
+ * @file MotionAccumulator.cpp
+ * @brief Implementation of the relative motion accumulator
+ */
+
+#include "MotionAccumulator.h"
+
+#define MOTION_ONE   (1 << MOTION_FRACTION_BITS)
+#define MOTION_LIMIT (INT32_MAX >> 1)   // Well past anything a report could drain, just keeps the sums from wrapping
+
+MotionAccumulator::MotionAccumulator() {
+    clear();
+}
+
+void MotionAccumulator::clear() {
+    for (uint8_t i = 0; i < MOTION_AXES; i++) acc[i] = 0;
+}
+
+void MotionAccumulator::addAxis(uint8_t axis, int32_t fixed) {
+    // Saturate instead of wrapping, a flood of motion should pin the pointer, not reverse it
+    int64_t sum = (int64_t)acc[axis] + fixed;
+    if (sum > MOTION_LIMIT) sum = MOTION_LIMIT;
+    if (sum < -MOTION_LIMIT) sum = -MOTION_LIMIT;
+    acc[axis] = (int32_t)sum;
+}
+
+void MotionAccumulator::add(int32_t x, int32_t y, int32_t wheel, int32_t hWheel) {
+    const int32_t counts[MOTION_AXES] = { x, y, wheel, hWheel };
+    for (uint8_t i = 0; i < MOTION_AXES; i++) {
+        int64_t fixed = (int64_t)counts[i] * MOTION_ONE;
+        addAxis(i, fixed > MOTION_LIMIT ? MOTION_LIMIT : (fixed < -MOTION_LIMIT ? -MOTION_LIMIT : (int32_t)fixed));
+    }
+}
+
+void MotionAccumulator::addFixed(int32_t x, int32_t y, int32_t wheel, int32_t hWheel) {
+    addAxis(AXIS_X, x);
+    addAxis(AXIS_Y, y);
+    addAxis(AXIS_WHEEL, wheel);
+    addAxis(AXIS_HWHEEL, hWheel);
+}
+
+bool MotionAccumulator::take(const int32_t limit[MOTION_AXES], int32_t out[MOTION_AXES]) {
+    bool any = false;
+    for (uint8_t i = 0; i < MOTION_AXES; i++) {
+        // Truncating toward zero, so the leftover fraction always has the same sign as the motion
+        int32_t whole = acc[i] / MOTION_ONE;
+        if (whole > limit[i]) whole = limit[i];
+        if (whole < -limit[i]) whole = -limit[i];
+        acc[i] -= whole * MOTION_ONE;
+        out[i] = whole;
+        if (whole) any = true;
+    }
+    return any;
+}
+
+void MotionAccumulator::restore(const int32_t out[MOTION_AXES]) {
+    for (uint8_t i = 0; i < MOTION_AXES; i++) {
+        addAxis(i, out[i] * MOTION_ONE);
+    }
+}
+
+bool MotionAccumulator::pending() const {
+    for (uint8_t i = 0; i < MOTION_AXES; i++) {
+        if (acc[i] >= MOTION_ONE || acc[i] <= -MOTION_ONE) return true;
+    }
+    return false;
+}
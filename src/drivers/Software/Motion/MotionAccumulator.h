@@ -0,0 +1,45 @@
+/**
+ * @file MotionAccumulator.h
+ * @brief Sums high resolution relative motion and hands it out in report-sized pieces
+ *
+ * Plain C++ with no Arduino dependencies, so it can be built and checked on a desktop.
+ * Motion is kept in fixed point, so slow sources (mouse keys, trackballs, scaled sensors) don't
+ * lose whatever doesn't add up to a whole count yet, and fast ones don't lose what didn't fit in a report.
+ */
+
+#ifndef MOTIONACCUMULATOR_H
+#define MOTIONACCUMULATOR_H
+
+#include <stdint.h>
+
+#define MOTION_FRACTION_BITS 8   // Fixed point deltas are in 1/256ths of a count
+#define MOTION_AXES          4   // X, Y, wheel, horizontal wheel
+
+class MotionAccumulator {
+public:
+    enum Axis : uint8_t { AXIS_X, AXIS_Y, AXIS_WHEEL, AXIS_HWHEEL };
+
+    MotionAccumulator();
+
+    // Whole counts
+    void    add(int32_t x, int32_t y, int32_t wheel = 0, int32_t hWheel = 0);
+    // Fixed point, MOTION_FRACTION_BITS below the point
+    void    addFixed(int32_t x, int32_t y, int32_t wheel = 0, int32_t hWheel = 0);
+
+    // Whole counts for one report, each axis clamped to +-limit[axis]. What didn't fit, and the
+    // fractions, stay behind for the next one. False if there was nothing to send.
+    bool    take(const int32_t limit[MOTION_AXES], int32_t out[MOTION_AXES]);
+    // Puts back what take() gave out, for when the report didn't make it
+    void    restore(const int32_t out[MOTION_AXES]);
+
+    bool    pending() const;   // At least one whole count waiting on some axis
+    int32_t getFixed(Axis axis) const { return acc[axis]; }
+    void    clear();
+
+private:
+    void    addAxis(uint8_t axis, int32_t fixed);
+
+    int32_t acc[MOTION_AXES];
+};
+
+#endif
@@ -0,0 +1,194 @@
+/**
+ * @file MouseKeyEngine.cpp
+ * @brief Implementation of the mouse keys engine
+ */
+
+#include "MouseKeyEngine.h"
+#include <math.h>
+
+#define MOUSEKEY_ONE       (1 << MOTION_FRACTION_BITS)
+#define MOUSEKEY_DIAGONAL  181   // 1/sqrt(2) in Q8, so diagonals aren't 41% faster than straight lines
+#define POINTER_MASK       (MOUSEKEY_UP | MOUSEKEY_DOWN | MOUSEKEY_LEFT | MOUSEKEY_RIGHT)
+#define WHEEL_MASK         (MOUSEKEY_WHEEL_UP | MOUSEKEY_WHEEL_DOWN | MOUSEKEY_WHEEL_LEFT | MOUSEKEY_WHEEL_RIGHT)
+
+static const MouseKeyCurve _defaultPointerCurve = { 200, 1000, 100, 2000, 2.0f };
+static const MouseKeyCurve _defaultWheelCurve   = { 200, 1000, 10,  40,   1.0f };
+
+MouseKeyEngine::MouseKeyEngine() :
+    mode(MOUSEKEY_ACCELERATED),
+    tickUs(MOUSEKEY_TICK_US),
+    pointerCurve(_defaultPointerCurve),
+    wheelCurve(_defaultWheelCurve),
+    friction(0),
+    inertiaAccel(0),
+    held(0),
+    speedOverride(-1),
+    pointerTicks(0),
+    wheelTicks(0),
+    velocity{0, 0},
+    nextTick(0),
+    running(false)
+{
+    setCurve(pointerCurve);
+    setWheelCurve(wheelCurve);
+    setFriction(3000);
+}
+
+void MouseKeyEngine::buildTable(const MouseKeyCurve& curve, uint16_t table[MOUSEKEY_CURVE_STEPS]) {
+    // Floats only ever happen here, the tick itself is a table lookup
+    for (uint8_t i = 0; i < MOUSEKEY_CURVE_STEPS; i++) {
+        float t = (float)i / (MOUSEKEY_CURVE_STEPS - 1);
+        float speed = curve.startSpeed + (float)(curve.maxSpeed - curve.startSpeed) * powf(t, curve.exponent);
+        float step = speed * tickUs * MOUSEKEY_ONE / 1000000.0f + 0.5f;
+        table[i] = step > 65535.0f ? 65535 : (step < 0.0f ? 0 : (uint16_t)step);
+    }
+}
+
+void MouseKeyEngine::setMode(MouseKeyMode mode) {
+    this->mode = mode;
+    velocity[0] = velocity[1] = 0;
+}
+
+void MouseKeyEngine::setTick(uint32_t tickUs) {
+    this->tickUs = tickUs ? tickUs : MOUSEKEY_TICK_US;
+    // Everything's stored per tick, so it all has to be worked out again
+    setCurve(pointerCurve);
+    setWheelCurve(wheelCurve);
+}
+
+void MouseKeyEngine::setCurve(const MouseKeyCurve& curve) {
+    pointerCurve = curve;
+    if (pointerCurve.maxSpeed < pointerCurve.startSpeed) pointerCurve.maxSpeed = pointerCurve.startSpeed;
+    buildTable(pointerCurve, pointerTable);
+
+    // Inertia speeds up at a constant rate that gets to the top speed in timeToMaxMs
+    uint32_t ticksToMax = (uint32_t)pointerCurve.timeToMaxMs * 1000 / tickUs;
+    inertiaAccel = pointerTable[MOUSEKEY_CURVE_STEPS - 1] / (ticksToMax ? ticksToMax : 1);
+    if (inertiaAccel < 1) inertiaAccel = 1;
+}
+
+void MouseKeyEngine::setWheelCurve(const MouseKeyCurve& curve) {
+    wheelCurve = curve;
+    if (wheelCurve.maxSpeed < wheelCurve.startSpeed) wheelCurve.maxSpeed = wheelCurve.startSpeed;
+    buildTable(wheelCurve, wheelTable);
+}
+
+void MouseKeyEngine::setFriction(uint16_t deceleration) {
+    float step = (float)deceleration * tickUs * tickUs * MOUSEKEY_ONE / 1e12f + 0.5f;
+    friction = step < 1.0f ? 1 : (int32_t)step;
+}
+
+void MouseKeyEngine::press(uint8_t directions) {
+    // A fresh press starts the curve over, even if the last one never got a tick to notice it was let go
+    if (!(held & POINTER_MASK) && (directions & POINTER_MASK)) pointerTicks = 0;
+    if (!(held & WHEEL_MASK) && (directions & WHEEL_MASK)) wheelTicks = 0;
+    held |= directions;
+}
+
+void MouseKeyEngine::release(uint8_t directions) {
+    held &= ~directions;
+}
+
+void MouseKeyEngine::reset() {
+    held = 0;
+    speedOverride = -1;
+    pointerTicks = 0;
+    wheelTicks = 0;
+    velocity[0] = velocity[1] = 0;
+    running = false;
+}
+
+bool MouseKeyEngine::active() const {
+    return held || velocity[0] || velocity[1];
+}
+
+int32_t MouseKeyEngine::curveStep(const uint16_t table[MOUSEKEY_CURVE_STEPS], const MouseKeyCurve& curve, uint32_t heldTicks, bool tap) {
+    int32_t top = table[MOUSEKEY_CURVE_STEPS - 1];
+    if (speedOverride >= 0) return speedOverride >= 2 ? top : top >> (2 - speedOverride);
+
+    uint32_t t = heldTicks;
+    if (tap) {
+        // One count straight away so a quick tap nudges by exactly one, then nothing until the delay's up
+        if (heldTicks == 0) return MOUSEKEY_ONE;
+        uint32_t delayTicks = ((uint32_t)curve.delayMs * 1000 + tickUs - 1) / tickUs;
+        if (heldTicks < delayTicks) return 0;
+        t = heldTicks - delayTicks;
+    }
+
+    uint32_t ticksToMax = (uint32_t)curve.timeToMaxMs * 1000 / tickUs;
+    if (t >= ticksToMax) return top;
+    return table[t * (MOUSEKEY_CURVE_STEPS - 1) / ticksToMax];
+}
+
+void MouseKeyEngine::tickInertia(uint8_t axis, int8_t direction, int32_t top, int32_t out[MOTION_AXES]) {
+    int32_t v = velocity[axis];
+    if (direction) {
+        v += direction * inertiaAccel;
+        if (v > top) v = top;
+        if (v < -top) v = -top;
+    } else if (v > 0) {
+        v = v > friction ? v - friction : 0;
+    } else if (v < 0) {
+        v = -v > friction ? v + friction : 0;
+    }
+    velocity[axis] = v;
+    out[axis] += v;
+}
+
+void MouseKeyEngine::tick(int32_t out[MOTION_AXES]) {
+    int8_t dx = ((held & MOUSEKEY_RIGHT) ? 1 : 0) - ((held & MOUSEKEY_LEFT) ? 1 : 0);
+    int8_t dy = ((held & MOUSEKEY_DOWN) ? 1 : 0) - ((held & MOUSEKEY_UP) ? 1 : 0);
+
+    if (mode == MOUSEKEY_INERTIA) {
+        int32_t top = pointerTable[MOUSEKEY_CURVE_STEPS - 1];
+        if (speedOverride >= 0 && speedOverride < 2) top >>= (2 - speedOverride);
+        if (dx && dy) top = (top * MOUSEKEY_DIAGONAL) >> 8;
+        tickInertia(MotionAccumulator::AXIS_X, dx, top, out);
+        tickInertia(MotionAccumulator::AXIS_Y, dy, top, out);
+    } else if (held & POINTER_MASK) {
+        int32_t step = curveStep(pointerTable, pointerCurve, pointerTicks, mode == MOUSEKEY_ACCELERATED);
+        if (dx && dy) step = (step * MOUSEKEY_DIAGONAL) >> 8;
+        out[MotionAccumulator::AXIS_X] += dx * step;
+        out[MotionAccumulator::AXIS_Y] += dy * step;
+    }
+    pointerTicks = (held & POINTER_MASK) ? pointerTicks + 1 : 0;
+
+    // The wheel always works off the curve, momentum on a scroll wheel just overshoots
+    if (held & WHEEL_MASK) {
+        int8_t dv = ((held & MOUSEKEY_WHEEL_UP) ? 1 : 0) - ((held & MOUSEKEY_WHEEL_DOWN) ? 1 : 0);
+        int8_t dh = ((held & MOUSEKEY_WHEEL_RIGHT) ? 1 : 0) - ((held & MOUSEKEY_WHEEL_LEFT) ? 1 : 0);
+        int32_t step = curveStep(wheelTable, wheelCurve, wheelTicks, mode != MOUSEKEY_KINETIC);
+        out[MotionAccumulator::AXIS_WHEEL] += dv * step;
+        out[MotionAccumulator::AXIS_HWHEEL] += dh * step;
+        wheelTicks++;
+    } else {
+        wheelTicks = 0;
+    }
+}
+
+bool MouseKeyEngine::update(uint32_t nowUs, int32_t out[MOTION_AXES]) {
+    for (uint8_t i = 0; i < MOTION_AXES; i++) out[i] = 0;
+
+    if (!active()) {
+        running = false;
+        return false;
+    }
+    // First tick lands on the update that sees the press, not up to a tick later
+    if (!running) {
+        running = true;
+        nextTick = nowUs;
+    }
+
+    uint8_t ticks = 0;
+    while ((int32_t)(nowUs - nextTick) >= 0) {
+        if (ticks++ >= MOUSEKEY_MAX_BEHIND) {
+            // Stalled for a while, a burst of catch-up motion would just throw the pointer
+            nextTick = nowUs + tickUs;
+            break;
+        }
+        tick(out);
+        nextTick += tickUs;
+    }
+
+    return out[0] || out[1] || out[2] || out[3];
+}
@@ -0,0 +1,95 @@
+/**
+ * @file MouseKeyEngine.h
+ * @brief Turns held direction keys into pointer and wheel motion with QMK-style acceleration
+ *
+ * Plain C++ with no Arduino dependencies, so it can be built and checked on a desktop.
+ * Runs on a fixed tick and hands out fixed point motion for a MotionAccumulator, so the cursor
+ * speed doesn't depend on how often update() gets called or how fast the transport reports.
+ */
+
+#ifndef MOUSEKEYENGINE_H
+#define MOUSEKEYENGINE_H
+
+#include <stdint.h>
+#include "MotionAccumulator.h"
+
+#define MOUSEKEY_TICK_US      8000   // 125Hz, plenty since the accumulator carries the fractions
+#define MOUSEKEY_CURVE_STEPS  64     // Speed table entries between the start and top speeds
+#define MOUSEKEY_MAX_BEHIND   4      // Ticks update() will catch up on before it gives up on the rest
+
+// One bit per direction key, so several can be held at once
+enum MouseKeyDirection : uint8_t {
+    MOUSEKEY_UP          = 0x01,
+    MOUSEKEY_DOWN        = 0x02,
+    MOUSEKEY_LEFT        = 0x04,
+    MOUSEKEY_RIGHT       = 0x08,
+    MOUSEKEY_WHEEL_UP    = 0x10,
+    MOUSEKEY_WHEEL_DOWN  = 0x20,
+    MOUSEKEY_WHEEL_LEFT  = 0x40,
+    MOUSEKEY_WHEEL_RIGHT = 0x80
+};
+
+enum MouseKeyMode : uint8_t {
+    MOUSEKEY_ACCELERATED,   // One count on press, then after the delay speeds up along the curve (QMK's default)
+    MOUSEKEY_KINETIC,       // Starts moving straight away and speeds up along the curve
+    MOUSEKEY_INERTIA        // The pointer has momentum - keys push it, friction stops it after they're let go
+};
+
+// Speeds are in counts per second, so the curve holds whatever the tick is
+struct MouseKeyCurve {
+    uint16_t delayMs;       // Accelerated mode only, the pause after the first count
+    uint16_t timeToMaxMs;
+    uint16_t startSpeed;
+    uint16_t maxSpeed;
+    float    exponent;      // 1 is a straight ramp, 2 stays slow for longer for fine positioning
+};
+
+class MouseKeyEngine {
+public:
+    MouseKeyEngine();
+
+    void    setMode(MouseKeyMode mode);
+    void    setTick(uint32_t tickUs);
+    // Both rebuild their speed table, neither should be called every tick
+    void    setCurve(const MouseKeyCurve& curve);
+    void    setWheelCurve(const MouseKeyCurve& curve);
+    // Inertia mode, in counts per second per second
+    void    setFriction(uint16_t deceleration);
+
+    void    press(uint8_t directions);
+    void    release(uint8_t directions);
+    // QMK's ACL0-2 - hold for a fixed slow, medium or full speed, -1 goes back to the curve
+    void    setSpeedOverride(int8_t level) { speedOverride = level; }
+    void    reset();
+
+    // Anything still moving or held
+    bool    active() const;
+    // Runs every tick that's come due, out[] gets the motion in 1/256ths of a count for MotionAccumulator::addFixed.
+    // False if nothing moved.
+    bool    update(uint32_t nowUs, int32_t out[MOTION_AXES]);
+
+private:
+    void    buildTable(const MouseKeyCurve& curve, uint16_t table[MOUSEKEY_CURVE_STEPS]);
+    int32_t curveStep(const uint16_t table[MOUSEKEY_CURVE_STEPS], const MouseKeyCurve& curve, uint32_t heldTicks, bool tap);
+    void    tick(int32_t out[MOTION_AXES]);
+    void    tickInertia(uint8_t axis, int8_t direction, int32_t top, int32_t out[MOTION_AXES]);
+
+    MouseKeyMode  mode;
+    uint32_t      tickUs;
+    MouseKeyCurve pointerCurve;
+    MouseKeyCurve wheelCurve;
+    uint16_t      pointerTable[MOUSEKEY_CURVE_STEPS];   // Q8 counts per tick
+    uint16_t      wheelTable[MOUSEKEY_CURVE_STEPS];
+    int32_t       friction;                             // Q8 counts per tick, taken off each tick
+    int32_t       inertiaAccel;                         // Q8 counts per tick, added each tick
+
+    uint8_t       held;
+    int8_t        speedOverride;
+    uint32_t      pointerTicks;                         // Ticks since the first pointer key went down
+    uint32_t      wheelTicks;
+    int32_t       velocity[2];                          // Inertia mode, Q8 counts per tick
+    uint32_t      nextTick;
+    bool          running;
+};
+
+#endif
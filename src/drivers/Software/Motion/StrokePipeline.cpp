@@ -0,0 +1,173 @@
+/**
+ * @file StrokePipeline.cpp
+ * @brief Implementation of the pen stroke pipeline
+ */
+
+#include "StrokePipeline.h"
+
+#define STROKE_U_BITS 10   // Catmull-Rom segment position, Q10 keeps the Horner steps inside 32 bits
+
+static inline uint16_t clampLogical(int32_t v) {
+    return v < 0 ? 0 : (v > STROKE_LOGICAL_MAX ? STROKE_LOGICAL_MAX : (uint16_t)v);
+}
+
+// Rounded, so the top of the input range lands exactly on STROKE_LOGICAL_MAX
+static inline uint32_t scaleFactor(uint16_t max) {
+    return ((uint32_t)STROKE_LOGICAL_MAX << 16) / (max ? max : 1) + 1;
+}
+
+StrokePipeline::StrokePipeline() :
+    maxX(1920),
+    maxY(1080),
+    maxPressure(127),
+    smoothing(STROKE_SMOOTH_NONE),
+    renderDelay(0),
+    count(0),
+    last{0, 0, 0},
+    fresh(false)
+{
+    setRange(maxX, maxY);
+    setPressureRange(maxPressure);
+    filterX.setOneEuro(1.0f, 0.007f);
+    filterY.setOneEuro(1.0f, 0.007f);
+    setInputRate(STROKE_INPUT_RATE);
+}
+
+void StrokePipeline::setRange(uint16_t maxX, uint16_t maxY) {
+    this->maxX = maxX ? maxX : 1;
+    this->maxY = maxY ? maxY : 1;
+    scaleX = scaleFactor(this->maxX);
+    scaleY = scaleFactor(this->maxY);
+}
+
+void StrokePipeline::setPressureRange(uint16_t maxPressure) {
+    this->maxPressure = maxPressure ? maxPressure : 1;
+    scaleP = scaleFactor(this->maxPressure);
+}
+
+void StrokePipeline::setSmoothing(Smoothing smoothing) {
+    this->smoothing = smoothing;
+    filterX.reset();
+    filterY.reset();
+}
+
+void StrokePipeline::setOneEuro(float minCutoffHz, float beta) {
+    filterX.setOneEuro(minCutoffHz, beta);
+    filterY.setOneEuro(minCutoffHz, beta);
+}
+
+void StrokePipeline::setInputRate(uint16_t hz) {
+    if (!hz) hz = STROKE_INPUT_RATE;
+    filterX.setSampleRate(hz);
+    filterY.setSampleRate(hz);
+    renderDelay = 2000000UL / hz;
+}
+
+StrokePoint StrokePipeline::scale(uint16_t x, uint16_t y, uint16_t pressure) const {
+    // Clamped to the range first, so the product can't get past 32 bits
+    if (x > maxX) x = maxX;
+    if (y > maxY) y = maxY;
+    if (pressure > maxPressure) pressure = maxPressure;
+
+    StrokePoint point;
+    point.x = clampLogical((x * scaleX) >> 16);
+    point.y = clampLogical((y * scaleY) >> 16);
+    point.pressure = clampLogical((pressure * scaleP) >> 16);
+    return point;
+}
+
+void StrokePipeline::push(const StrokePoint& point, uint32_t nowUs) {
+    Sample sample;
+    sample.x = point.x;
+    sample.y = point.y;
+    sample.pressure = point.pressure;
+    sample.time = nowUs;
+
+    if (smoothing == STROKE_SMOOTH_ONE_EURO) {
+        sample.x = filterX.apply(sample.x);
+        sample.y = filterY.apply(sample.y);
+    }
+
+    if (count < STROKE_HISTORY) {
+        history[count++] = sample;
+    } else {
+        for (uint8_t i = 1; i < STROKE_HISTORY; i++) history[i - 1] = history[i];
+        history[STROKE_HISTORY - 1] = sample;
+    }
+    fresh = true;
+}
+
+void StrokePipeline::begin(uint16_t x, uint16_t y, uint16_t pressure, uint32_t nowUs) {
+    count = 0;
+    filterX.reset();
+    filterY.reset();
+    push(scale(x, y, pressure), nowUs);
+    last = latest();
+    fresh = false;
+}
+
+void StrokePipeline::add(uint16_t x, uint16_t y, uint16_t pressure, uint32_t nowUs) {
+    push(scale(x, y, pressure), nowUs);
+}
+
+StrokePoint StrokePipeline::latest() const {
+    if (!count) return last;
+    const Sample& s = history[count - 1];
+    return StrokePoint{ clampLogical(s.x), clampLogical(s.y), clampLogical(s.pressure) };
+}
+
+// q(u) = p1 + (c1 + (c2 + c3*u)*u)*u / 2, Horner in Q10 so no step gets near 2^31 with 15 bit values
+static inline uint16_t catmullRomAxis(int32_t v0, int32_t v1, int32_t v2, int32_t v3, int32_t u) {
+    int32_t c1 = v2 - v0;
+    int32_t c2 = 2 * v0 - 5 * v1 + 4 * v2 - v3;
+    int32_t c3 = -v0 + 3 * v1 - 3 * v2 + v3;
+    int32_t q = (c3 * u) >> STROKE_U_BITS;
+    q = ((q + c2) * u) >> STROKE_U_BITS;
+    q = ((q + c1) * u) >> STROKE_U_BITS;
+    return clampLogical(v1 + (q >> 1));
+}
+
+void StrokePipeline::catmullRom(const Sample& p0, const Sample& p1, const Sample& p2, const Sample& p3, int32_t u, StrokePoint& out) const {
+    out.x = catmullRomAxis(p0.x, p1.x, p2.x, p3.x, u);
+    out.y = catmullRomAxis(p0.y, p1.y, p2.y, p3.y, u);
+    out.pressure = catmullRomAxis(p0.pressure, p1.pressure, p2.pressure, p3.pressure, u);
+}
+
+bool StrokePipeline::render(uint32_t nowUs, StrokePoint& out) {
+    if (!count) return false;
+
+    StrokePoint point;
+    if (smoothing != STROKE_SMOOTH_CATMULL_ROM || count < 2) {
+        if (!fresh) return false;
+        point = latest();
+    } else {
+        // Drawn a little in the past so there's a sample either side of the segment
+        uint32_t renderTime = nowUs - renderDelay;
+        const Sample& newest = history[count - 1];
+
+        if ((int32_t)(renderTime - newest.time) >= 0) {
+            point = latest();
+        } else if ((int32_t)(renderTime - history[0].time) < 0) {
+            point = StrokePoint{ clampLogical(history[0].x), clampLogical(history[0].y), clampLogical(history[0].pressure) };
+        } else {
+            uint8_t k = count - 2;
+            while (k > 0 && (int32_t)(renderTime - history[k].time) < 0) k--;
+
+            const Sample& p1 = history[k];
+            const Sample& p2 = history[k + 1];
+            const Sample& p0 = k > 0 ? history[k - 1] : p1;           // Ends of the stroke just repeat the end point
+            const Sample& p3 = k + 2 < count ? history[k + 2] : p2;
+
+            uint32_t span = p2.time - p1.time;
+            int32_t u = span ? (int32_t)(((renderTime - p1.time) << STROKE_U_BITS) / span) : (1 << STROKE_U_BITS);
+            if (u > (1 << STROKE_U_BITS)) u = 1 << STROKE_U_BITS;
+            catmullRom(p0, p1, p2, p3, u, point);
+        }
+    }
+
+    fresh = false;
+    if (point.x == last.x && point.y == last.y && point.pressure == last.pressure) return false;
+    last = point;
+    out = point;
+    return true;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file StrokePipeline.h
+ * @brief Scales, smooths and resamples pen strokes so the host gets them at a steady report rate
+ *
+ * Plain C++ with no Arduino dependencies, so it can be built and checked on a desktop.
+ * Scaling is a precomputed fixed point multiply per sample, and floats only show up in the setters.
+ */
+
+#ifndef STROKEPIPELINE_H
+#define STROKEPIPELINE_H
+
+#include <stdint.h>
+#include "drivers/Software/Analog/AnalogFilter.h"
+
+#define STROKE_LOGICAL_MAX  32767   // X, Y and pressure all go out as 0 to this
+#define STROKE_INPUT_RATE   240     // Hz, what most pen sensors and touch panels sample at
+#define STROKE_HISTORY      4       // Catmull-Rom needs a point either side of the segment it's drawing
+
+// A point in report units
+struct StrokePoint {
+    uint16_t x;
+    uint16_t y;
+    uint16_t pressure;
+};
+
+class StrokePipeline {
+public:
+    enum Smoothing : uint8_t {
+        STROKE_SMOOTH_NONE,         // Latest sample at each report
+        STROKE_SMOOTH_ONE_EURO,     // Latest sample through a 1-euro filter, steadies a shaky hand with little lag
+        STROKE_SMOOTH_CATMULL_ROM   // Curves through the samples at the report rate, two input samples behind
+    };
+
+    StrokePipeline();
+
+    // Input ranges - coordinates 0..maxX/maxY, pressure 0..maxPressure
+    void    setRange(uint16_t maxX, uint16_t maxY);
+    void    setPressureRange(uint16_t maxPressure);
+    void    setSmoothing(Smoothing smoothing);
+    void    setOneEuro(float minCutoffHz, float beta);
+    // How often samples come in, the filters and the Catmull-Rom delay are worked out from it
+    void    setInputRate(uint16_t hz);
+    Smoothing getSmoothing() const { return smoothing; }
+
+    StrokePoint scale(uint16_t x, uint16_t y, uint16_t pressure) const;
+
+    void    begin(uint16_t x, uint16_t y, uint16_t pressure, uint32_t nowUs);
+    void    add(uint16_t x, uint16_t y, uint16_t pressure, uint32_t nowUs);
+    // Where the pen should be drawn right now, false if that hasn't changed since the last call
+    bool    render(uint32_t nowUs, StrokePoint& out);
+    // The newest sample as it came in (after the 1-euro filter if that's on), for finishing a stroke
+    StrokePoint latest() const;
+
+private:
+    struct Sample {
+        int32_t  x;
+        int32_t  y;
+        int32_t  pressure;
+        uint32_t time;
+    };
+
+    void    push(const StrokePoint& point, uint32_t nowUs);
+    void    catmullRom(const Sample& p0, const Sample& p1, const Sample& p2, const Sample& p3, int32_t u, StrokePoint& out) const;
+
+    uint32_t  scaleX;          // Q16 report units per input unit
+    uint32_t  scaleY;
+    uint32_t  scaleP;
+    uint16_t  maxX;
+    uint16_t  maxY;
+    uint16_t  maxPressure;
+    Smoothing smoothing;
+    uint32_t  renderDelay;     // us, Catmull-Rom only
+
+    AnalogFilter filterX;
+    AnalogFilter filterY;
+
+    Sample    history[STROKE_HISTORY];   // Oldest first
+    uint8_t   count;
+    StrokePoint last;
+    bool      fresh;           // Something's come in since the last render
+};
+
+#endif
@@ -0,0 +1,107 @@
+/**
+ * @file StenoChord.cpp
+ * @brief Implementation of the steno chord conversions
+ */
+
+#include "StenoChord.h"
+
+// Steno order, and which Plover HID key each stroke bit comes from
+static const char _stenoLetters[STENO_STROKE_KEYS + 1] = "#STKPWHRAO*EUFRPBLGTSDZ";
+#define STENO_BIT_NUMBER  0
+#define STENO_BIT_A       8
+#define STENO_BIT_STAR    10
+#define STENO_BIT_E       11
+#define STENO_BIT_F       13   // First right hand consonant
+
+#define NONE 0xFF
+
+// Plover HID key -> stroke bit, indexed by StenoKeys value. X keys aren't part of a stroke.
+static const uint8_t _hidToStroke[64] = {
+     1,  2,  4,  6, 10, 13, 15, 17, 19, 21,   // S1 T- P- H- *1 -F -P -L -T -D
+     1,  3,  5,  7, 10, 14, 16, 18, 20, 22,   // S2 K- W- R- *2 -R -B -G -S -Z
+     8,  9, 10, 11, 12, 10,  0,  0,  0,  0,   // A  O  *3 -E -U *4 #1 #2 #3 #4
+     0,  0,  0,  0,  0,  0,  0,  0,           // #5 .. #C
+    NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE,
+    NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE
+};
+
+// Gemini PR key chart position for each Plover HID key - 6 bytes of 7 bits, position p is byte p/7 bit 6-p%7
+static const uint8_t _hidToGemini[64] = {
+     7,  9, 11, 13, 17, 26, 28, 30, 32, 34,   // S1 T- P- H- *1 -F -P -L -T -D
+     8, 10, 12, 14, 18, 27, 29, 31, 33, 41,   // S2 K- W- R- *2 -R -B -G -S -Z
+    15, 16, 22, 24, 25, 23,  1,  2,  3,  4,   // A  O  *3 -E -U *4 #1 #2 #3 #4
+     5,  6, 35, 36, 37, 38, 39, 40,           // #5 #6 #7 #8 #9 #A #B #C
+    NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE,
+    NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE
+};
+
+namespace StenoChord {
+
+StenoStroke toStroke(const uint8_t keys[8]) {
+    StenoStroke stroke = 0;
+    for (uint8_t i = 0; i < 64; i++) {
+        if (!(keys[i >> 3] & (1 << (i & 7)))) continue;
+        if (_hidToStroke[i] != NONE) stroke |= 1UL << _hidToStroke[i];
+    }
+    return stroke;
+}
+
+void toGemini(const uint8_t keys[8], uint8_t out[GEMINI_PACKET_SIZE]) {
+    for (uint8_t i = 0; i < GEMINI_PACKET_SIZE; i++) out[i] = 0;
+    out[0] = 0x80;
+    for (uint8_t i = 0; i < 64; i++) {
+        if (!(keys[i >> 3] & (1 << (i & 7)))) continue;
+        uint8_t p = _hidToGemini[i];
+        if (p != NONE) out[p / 7] |= 1 << (6 - p % 7);
+    }
+}
+
+size_t toTxBolt(StenoStroke stroke, uint8_t out[TXBOLT_PACKET_MAX]) {
+    // Groups of six in steno order, S- first and # last in the fourth group
+    uint32_t bits = (stroke >> 1) | ((stroke & 1) << (STENO_STROKE_KEYS - 1));
+    size_t n = 0;
+    for (uint8_t group = 0; group < 4; group++) {
+        uint8_t keys = (bits >> (group * 6)) & 0x3F;
+        if (keys) out[n++] = (group << 6) | keys;
+    }
+    if (n) out[n++] = 0;
+    return n;
+}
+
+size_t formatStroke(StenoStroke stroke, char out[STENO_STROKE_TEXT]) {
+    size_t n = 0;
+    bool vowel = false;
+    for (uint8_t i = 0; i < STENO_STROKE_KEYS; i++) {
+        if (!(stroke & (1UL << i))) continue;
+        // Right hand keys need a hyphen in front if nothing in the middle says which side they're on
+        if (i >= STENO_BIT_F && !vowel) {
+            out[n++] = '-';
+            vowel = true;
+        }
+        if (i >= STENO_BIT_A && i <= STENO_BIT_E + 1) vowel = true;
+        out[n++] = _stenoLetters[i];
+    }
+    out[n] = '\0';
+    return n;
+}
+
+StenoStroke parseStroke(const char* text) {
+    StenoStroke stroke = 0;
+    uint8_t pos = 0;
+    for (const char* c = text; *c; c++) {
+        if (*c == '-') {
+            if (pos > STENO_BIT_F) return 0;
+            pos = STENO_BIT_F;
+            continue;
+        }
+        // Each letter has to come later in steno order than the last one
+        uint8_t i = pos;
+        while (i < STENO_STROKE_KEYS && _stenoLetters[i] != *c) i++;
+        if (i == STENO_STROKE_KEYS) return 0;
+        stroke |= 1UL << i;
+        pos = i + 1;
+    }
+    return stroke;
+}
+
+}
@@ -0,0 +1,40 @@
+/**
+ * @file StenoChord.h
+ * @brief Steno chords as plain bitmaps - conversions from the Plover HID layout, and the serial protocols
+ *
+ * Plain C++ with no Arduino dependencies, so it can be built and checked on a desktop.
+ */
+
+#ifndef STENOCHORD_H
+#define STENOCHORD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// A stroke in steno order, # S T K P W H R A O * E U F R P B L G T S D Z, bit 0 being #.
+// All the number keys fold into #, both S keys into S and all four stars into *, like Plover does.
+typedef uint32_t StenoStroke;
+
+#define STENO_STROKE_KEYS   23
+#define STENO_STROKE_MASK   ((1UL << STENO_STROKE_KEYS) - 1)
+#define STENO_STROKE_TEXT   (STENO_STROKE_KEYS + 3)   // Longest formatStroke() output, hyphen and NUL included
+
+#define GEMINI_PACKET_SIZE  6
+#define TXBOLT_PACKET_MAX   5
+
+namespace StenoChord {
+    // Chords come in as the 64 bit Plover HID bitmap, byte i bit j being key 8i+j
+    StenoStroke toStroke(const uint8_t keys[8]);
+
+    // Gemini PR - always 6 bytes, top bit only set on the first
+    void        toGemini(const uint8_t keys[8], uint8_t out[GEMINI_PACKET_SIZE]);
+    // TX Bolt - one byte per group that has keys in it, then a 0 so back to back strokes in the same group split
+    size_t      toTxBolt(StenoStroke stroke, uint8_t out[TXBOLT_PACKET_MAX]);
+
+    // "STKPW", "-FRPB", "KA*T" and the like, the way a steno dictionary writes it
+    size_t      formatStroke(StenoStroke stroke, char out[STENO_STROKE_TEXT]);
+    // The other way round, 0 if it isn't a valid stroke. Number strokes need the # written out.
+    StenoStroke parseStroke(const char* text);
+}
+
+#endif
@@ -0,0 +1,55 @@
+/**
+ * @file StenoDictionary.cpp
+ * @brief Implementation of the steno dictionary lookup
+ */
+
+#include "StenoDictionary.h"
+
+namespace StenoDict {
+
+// Outline in the dictionary against one being looked up, like strcmp
+static int compare(const StenoStroke* stored, const StenoStroke* outline, uint8_t length) {
+    for (uint8_t i = 0; ; i++) {
+        if (i == length) return (stored[i - 1] & STENO_OUTLINE_END) ? 0 : 1;   // Stored one's longer
+        StenoStroke s = stored[i] & ~STENO_OUTLINE_END;
+        if (s != outline[i]) return s < outline[i] ? -1 : 1;
+        if ((stored[i] & STENO_OUTLINE_END) && i + 1 < length) return -1;       // Stored one's shorter
+    }
+}
+
+const char* lookup(const StenoDictionary& dict, const StenoStroke* outline, uint8_t length) {
+    if (!length || !dict.count) return nullptr;
+
+    // Plain binary search - 18 steps for 150k entries, and each one only touches a couple of words of flash
+    uint32_t lo = 0, hi = dict.count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int c = compare(dict.strokes + dict.entries[mid].outline, outline, length);
+        if (c == 0) return dict.text + dict.entries[mid].text;
+        if (c < 0) lo = mid + 1;
+        else       hi = mid;
+    }
+    return nullptr;
+}
+
+bool isSorted(const StenoDictionary& dict) {
+    for (uint32_t i = 1; i < dict.count; i++) {
+        const StenoStroke* a = dict.strokes + dict.entries[i - 1].outline;
+        const StenoStroke* b = dict.strokes + dict.entries[i].outline;
+        // Walk both together, a has to come out strictly first
+        for (uint8_t k = 0; ; k++) {
+            StenoStroke sa = a[k] & ~STENO_OUTLINE_END, sb = b[k] & ~STENO_OUTLINE_END;
+            if (sa != sb) {
+                if (sa > sb) return false;
+                break;
+            }
+            bool endA = a[k] & STENO_OUTLINE_END, endB = b[k] & STENO_OUTLINE_END;
+            if (endA && endB) return false;   // Same outline twice
+            if (endA) break;                  // a's a prefix of b, that's fine
+            if (endB) return false;
+        }
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,41 @@
+/**
+ * @file StenoDictionary.h
+ * @brief Read-only steno dictionary laid out so it can sit in flash and be binary searched in place
+ *
+ * Plain C++ with no Arduino dependencies, so it can be built and checked on a desktop.
+ *
+ * Layout - all of it const, so it stays in flash:
+ *   strokes - every outline back to back, STENO_OUTLINE_END set on the last stroke of each one
+ *   entries - one per outline, sorted by outline (stroke by stroke, a shorter outline before anything it starts)
+ *   text    - the translations, NUL terminated, back to back
+ * A 150k entry Plover dictionary comes out at around 3MB.
+ */
+
+#ifndef STENODICTIONARY_H
+#define STENODICTIONARY_H
+
+#include "StenoChord.h"
+
+#define STENO_OUTLINE_END   0x80000000UL
+#define STENO_MAX_OUTLINE   4            // Longest outline looked up, strokes
+
+struct StenoDictEntry {
+    uint32_t outline;   // Index into strokes
+    uint32_t text;      // Offset into text
+};
+
+struct StenoDictionary {
+    const StenoStroke*    strokes;
+    const StenoDictEntry* entries;
+    const char*           text;
+    uint32_t              count;
+};
+
+namespace StenoDict {
+    // The translation for exactly this outline, nullptr if there isn't one
+    const char* lookup(const StenoDictionary& dict, const StenoStroke* outline, uint8_t length);
+    // Checks the entries really are in order, a single one out of place makes lookups miss
+    bool        isSorted(const StenoDictionary& dict);
+}
+
+#endif
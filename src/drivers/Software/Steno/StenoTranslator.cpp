@@ -0,0 +1,136 @@
+/**
+ * @file StenoTranslator.cpp
+ * @brief Implementation of the steno translator
+ */
+
+#include "StenoTranslator.h"
+#include <string.h>
+
+#define STENO_UNDO_STROKE  (1UL << 10)   // * on its own
+
+StenoTranslator::StenoTranslator() : dict(nullptr), count(0) { }
+
+void StenoTranslator::setDictionary(const StenoDictionary* dict) {
+    this->dict = dict;
+    reset();
+}
+
+void StenoTranslator::reset() {
+    count = 0;
+}
+
+void StenoTranslator::push(const Translation& translation) {
+    if (count == STENO_UNDO_HISTORY) {
+        memmove(history, history + 1, sizeof(Translation) * (STENO_UNDO_HISTORY - 1));
+        count--;
+    }
+    history[count++] = translation;
+}
+
+void StenoTranslator::emit(const char* text, const StenoStroke* outline, uint8_t length, StenoEdit& edit) {
+    size_t len = strlen(text);
+    bool attachBefore = count && history[count - 1].attachNext;
+    bool attachAfter = false;
+
+    if (len >= 2 && text[0] == '{' && text[len - 1] == '}' && !memchr(text + 1, '{', len - 2)) {
+        text++;
+        len -= 2;
+        // {^} on its own glues the words either side of it together
+        if (len == 1 && text[0] == '^') attachAfter = true;
+        if (len && text[0] == '^') { attachBefore = true; text++; len--; }
+        if (len && text[len - 1] == '^') { attachAfter = true; len--; }
+        // {.} {,} {?} {!} {:} {;} - punctuation sticks to the word before it
+        if (len == 1 && strchr(".,?!:;", text[0])) attachBefore = true;
+    }
+
+    uint8_t n = 0;
+    if (!attachBefore && len) edit.text[n++] = ' ';
+    for (size_t i = 0; i < len && n < STENO_MAX_TEXT - 1; i++) edit.text[n++] = text[i];
+    edit.text[n] = '\0';
+    edit.length = n;
+
+    Translation translation;
+    memcpy(translation.strokes, outline, sizeof(StenoStroke) * length);
+    translation.strokeCount = length;
+    translation.chars = n;
+    translation.attachNext = attachAfter;
+    push(translation);
+}
+
+// Folds an edit that comes after this one into it, neither has gone to the host yet
+void StenoTranslator::append(const StenoEdit& step, StenoEdit& edit) {
+    uint16_t rubbed = step.backspaces < edit.length ? step.backspaces : edit.length;
+    edit.length -= rubbed;
+    edit.backspaces += step.backspaces - rubbed;
+
+    uint8_t room = STENO_MAX_TEXT - 1 - edit.length;
+    uint8_t n = step.length < room ? step.length : room;
+    memcpy(edit.text + edit.length, step.text, n);
+    edit.length += n;
+    edit.text[edit.length] = '\0';
+    // What got cut off never reaches the host, so a later undo mustn't rub it out
+    if (n < step.length && count) history[count - 1].chars -= step.length - n;
+}
+
+void StenoTranslator::translate(StenoStroke stroke, StenoEdit& edit) {
+    edit.backspaces = 0;
+    edit.length = 0;
+    edit.text[0] = '\0';
+    stroke &= STENO_STROKE_MASK;
+    if (!stroke) return;
+
+    if (stroke == STENO_UNDO_STROKE) {
+        undo(edit);
+        return;
+    }
+    this->stroke(stroke, edit);
+}
+
+void StenoTranslator::undo(StenoEdit& edit) {
+    if (!count) return;
+    Translation last = history[--count];
+    edit.backspaces = last.chars;
+
+    // A multi-stroke match rubbed out what its earlier strokes typed on their own. Running those strokes
+    // again from the same history gives the same translations back, so A/TKPWAEUPB then * leaves "a".
+    for (uint8_t i = 0; i + 1 < last.strokeCount; i++) {
+        StenoEdit step;
+        step.backspaces = 0;
+        step.length = 0;
+        step.text[0] = '\0';
+        stroke(last.strokes[i], step);
+        append(step, edit);
+    }
+}
+
+void StenoTranslator::stroke(StenoStroke stroke, StenoEdit& edit) {
+    // Try the longest outline first - this stroke on the end of the last few translations, down to this stroke alone
+    if (dict) {
+        StenoStroke outline[STENO_MAX_OUTLINE];
+        for (int8_t k = count; k >= 0; k--) {
+            uint8_t length = 0;
+            for (uint8_t t = count - k; t < count; t++) length += history[t].strokeCount;
+            if (length + 1 > STENO_MAX_OUTLINE) continue;
+
+            length = 0;
+            for (uint8_t t = count - k; t < count; t++) {
+                memcpy(outline + length, history[t].strokes, sizeof(StenoStroke) * history[t].strokeCount);
+                length += history[t].strokeCount;
+            }
+            outline[length++] = stroke;
+
+            const char* text = StenoDict::lookup(*dict, outline, length);
+            if (!text) continue;
+
+            // The earlier strokes were typed as something shorter, that comes back off first
+            for (uint8_t t = 0; t < k; t++) edit.backspaces += history[--count].chars;
+            emit(text, outline, length, edit);
+            return;
+        }
+    }
+
+    // Not in the dictionary, so it goes out as steno the way Plover shows an untranslate
+    char raw[STENO_STROKE_TEXT];
+    StenoChord::formatStroke(stroke, raw);
+    emit(raw, &stroke, 1, edit);
+}
@@ -0,0 +1,52 @@
+/**
+ * @file StenoTranslator.h
+ * @brief Turns strokes into text through a StenoDictionary, Plover style - longest outline wins, * undoes
+ *
+ * Plain C++ with no Arduino dependencies, so it can be built and checked on a desktop.
+ * Only whole-translation metas are understood: {^...}, {...^} and {^} for attaching, and {.} {,} and friends
+ * for punctuation. Anything else in braces goes out as it's written.
+ */
+
+#ifndef STENOTRANSLATOR_H
+#define STENOTRANSLATOR_H
+
+#include "StenoDictionary.h"
+
+#define STENO_UNDO_HISTORY  16   // Translations * can take back
+#define STENO_MAX_TEXT      64   // Longest translation that gets typed, the rest is cut off
+
+// What a stroke does to the text on the host - rub out this many characters, then type this
+struct StenoEdit {
+    uint16_t backspaces;
+    uint8_t  length;
+    char     text[STENO_MAX_TEXT];
+};
+
+class StenoTranslator {
+public:
+    StenoTranslator();
+
+    void setDictionary(const StenoDictionary* dict);
+    void reset();
+    void translate(StenoStroke stroke, StenoEdit& edit);
+
+private:
+    struct Translation {
+        StenoStroke strokes[STENO_MAX_OUTLINE];   // The earlier ones are what it replaced, an undo replays them
+        uint8_t     strokeCount;
+        uint8_t     chars;        // What it typed, so an undo knows how much to rub out
+        bool        attachNext;
+    };
+
+    void stroke(StenoStroke stroke, StenoEdit& edit);
+    void undo(StenoEdit& edit);
+    void emit(const char* text, const StenoStroke* outline, uint8_t length, StenoEdit& edit);
+    void append(const StenoEdit& step, StenoEdit& edit);
+    void push(const Translation& translation);
+
+    const StenoDictionary* dict;
+    Translation history[STENO_UNDO_HISTORY];   // Oldest first
+    uint8_t     count;
+};
+
+#endif
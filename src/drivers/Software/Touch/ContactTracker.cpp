@@ -0,0 +1,114 @@
+/**
+ * @file ContactTracker.cpp
+ * @brief Implementation of the touch contact tracker
+ */
+
+#include "ContactTracker.h"
+
+ContactTracker::ContactTracker() :
+    matchLimit((uint32_t)TOUCH_MATCH_DISTANCE * TOUCH_MATCH_DISTANCE),
+    idCounter(0)
+{
+    reset();
+}
+
+void ContactTracker::setMatchDistance(uint16_t distance) {
+    matchLimit = (uint32_t)distance * distance;
+}
+
+void ContactTracker::reset() {
+    for (uint8_t i = 0; i < TOUCH_MAX_CONTACTS; i++) tracks[i].active = false;
+}
+
+uint8_t ContactTracker::activeCount() const {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < TOUCH_MAX_CONTACTS; i++) n += tracks[i].active;
+    return n;
+}
+
+uint8_t ContactTracker::nextId(uint8_t reserved[TOUCH_MAX_CONTACTS], uint8_t reservedCount) {
+    // Rotating rather than lowest-free, so an ID that just lifted doesn't come straight back as a different finger
+    for (uint8_t tries = 0; tries < TOUCH_CONTACT_IDS; tries++) {
+        uint8_t id = idCounter;
+        idCounter = (idCounter + 1) % TOUCH_CONTACT_IDS;
+
+        bool taken = false;
+        for (uint8_t i = 0; i < reservedCount; i++) taken |= reserved[i] == id;
+        if (!taken) return id;
+    }
+    return 0;
+}
+
+uint8_t ContactTracker::update(const TouchPoint* points, uint8_t count, TouchContact out[TOUCH_MAX_CONTACTS]) {
+    if (count > TOUCH_MAX_CONTACTS) count = TOUCH_MAX_CONTACTS;
+
+    // Every track/point distance once, then the closest remaining pair wins each round. Five by five is
+    // small enough that greedy is as good as optimal in practice and a lot cheaper.
+    uint32_t distance[TOUCH_MAX_CONTACTS][TOUCH_MAX_CONTACTS];
+    for (uint8_t t = 0; t < TOUCH_MAX_CONTACTS; t++) {
+        if (!tracks[t].active) continue;
+        for (uint8_t p = 0; p < count; p++) {
+            int32_t dx = (int32_t)points[p].x - tracks[t].x;
+            int32_t dy = (int32_t)points[p].y - tracks[t].y;
+            distance[t][p] = (uint32_t)(dx * dx) + (uint32_t)(dy * dy);
+        }
+    }
+
+    int8_t trackFor[TOUCH_MAX_CONTACTS];
+    bool   trackMatched[TOUCH_MAX_CONTACTS] = {};
+    for (uint8_t p = 0; p < count; p++) trackFor[p] = -1;
+
+    while (true) {
+        uint32_t best = matchLimit + 1;
+        int8_t bestTrack = -1, bestPoint = -1;
+        for (uint8_t t = 0; t < TOUCH_MAX_CONTACTS; t++) {
+            if (!tracks[t].active || trackMatched[t]) continue;
+            for (uint8_t p = 0; p < count; p++) {
+                if (trackFor[p] < 0 && distance[t][p] < best) {
+                    best = distance[t][p];
+                    bestTrack = t;
+                    bestPoint = p;
+                }
+            }
+        }
+        if (bestTrack < 0) break;
+        trackMatched[bestTrack] = true;
+        trackFor[bestPoint] = bestTrack;
+    }
+
+    // IDs that go out this frame, lifted ones included, so a new finger can't take one of them
+    uint8_t reserved[TOUCH_MAX_CONTACTS];
+    uint8_t reservedCount = 0;
+    uint8_t n = 0;
+
+    for (uint8_t t = 0; t < TOUCH_MAX_CONTACTS; t++) {
+        if (!tracks[t].active || trackMatched[t]) continue;
+        // Lifted - one last report where it was, with the tip off
+        out[n++] = TouchContact{ tracks[t].x, tracks[t].y, tracks[t].id, false, true };
+        reserved[reservedCount++] = tracks[t].id;
+        tracks[t].active = false;
+    }
+
+    for (uint8_t p = 0; p < count; p++) {
+        int8_t t = trackFor[p];
+        if (t < 0) continue;
+        tracks[t].x = points[p].x;
+        tracks[t].y = points[p].y;
+        out[n++] = TouchContact{ points[p].x, points[p].y, tracks[t].id, true, points[p].confident };
+        reserved[reservedCount++] = tracks[t].id;
+    }
+
+    for (uint8_t p = 0; p < count && n < TOUCH_MAX_CONTACTS; p++) {
+        if (trackFor[p] >= 0) continue;
+        // Only room once a lifted finger's been reported, anything left over gets picked up next frame
+        for (uint8_t t = 0; t < TOUCH_MAX_CONTACTS; t++) {
+            if (tracks[t].active) continue;
+            tracks[t] = Track{ points[p].x, points[p].y, nextId(reserved, reservedCount), true };
+            out[n++] = TouchContact{ points[p].x, points[p].y, tracks[t].id, true, points[p].confident };
+            reserved[reservedCount++] = tracks[t].id;
+            break;
+        }
+    }
+
+    return n;
+}
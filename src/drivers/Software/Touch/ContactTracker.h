@@ -0,0 +1,61 @@
+/**
+ * @file ContactTracker.h
+ * @brief Gives touch contacts from a capacitive sensor stable IDs from one frame to the next
+ *
+ * Plain C++ with no Arduino dependencies, so it can be built and checked on a desktop.
+ * Everything lives in fixed arrays, a frame never touches the heap.
+ */
+
+#ifndef CONTACTTRACKER_H
+#define CONTACTTRACKER_H
+
+#include <stdint.h>
+
+#define TOUCH_MAX_CONTACTS    5     // What Windows asks a Precision Touchpad to handle at minimum
+#define TOUCH_CONTACT_IDS     64    // 6 bit contact ID in the report
+#define TOUCH_MATCH_DISTANCE  400   // Logical units - further than this between frames and it's a different finger
+
+// One touch as the sensor sees it, in no particular order and with no identity
+struct TouchPoint {
+    uint16_t x;
+    uint16_t y;
+    bool     confident;   // False for palms and anything else the sensor thinks is accidental
+};
+
+// One touch as the host sees it
+struct TouchContact {
+    uint16_t x;
+    uint16_t y;
+    uint8_t  id;
+    bool     tip;         // False on the one frame after a finger lifts, which is how the host finds out
+    bool     confident;
+};
+
+class ContactTracker {
+public:
+    ContactTracker();
+
+    void    setMatchDistance(uint16_t distance);
+    void    reset();
+
+    // Matches this frame's points to last frame's contacts, closest pairs first. Fingers that lifted
+    // come out once more with tip off, new ones get a fresh ID. Returns how many went into out.
+    uint8_t update(const TouchPoint* points, uint8_t count, TouchContact out[TOUCH_MAX_CONTACTS]);
+    uint8_t activeCount() const;
+
+private:
+    struct Track {
+        uint16_t x;
+        uint16_t y;
+        uint8_t  id;
+        bool     active;
+    };
+
+    uint8_t  nextId(uint8_t reserved[TOUCH_MAX_CONTACTS], uint8_t reservedCount);
+
+    Track    tracks[TOUCH_MAX_CONTACTS];
+    uint32_t matchLimit;   // Squared
+    uint8_t  idCounter;
+};
+
+#endif
@@ -0,0 +1,33 @@
+/**
+ * @file TouchpadReport.cpp
+ * @brief Implementation of the Precision Touchpad report packing
+ */
+
+#include "TouchpadReport.h"
+#include <string.h>
+
+uint8_t packTouchpadReports(const TouchContact* contacts, uint8_t count, uint16_t scanTime, uint8_t buttons,
+                            TouchpadReport out[TOUCHPAD_MAX_REPORTS]) {
+    if (count > TOUCH_MAX_CONTACTS) count = TOUCH_MAX_CONTACTS;
+    uint8_t reports = count ? (count + TOUCHPAD_REPORT_CONTACTS - 1) / TOUCHPAD_REPORT_CONTACTS : 1;
+
+    for (uint8_t r = 0; r < reports; r++) {
+        TouchpadReport& report = out[r];
+        // Unused finger slots have to be zero, the host reads them up to the contact count only but some don't
+        memset(&report, 0, sizeof(report));
+        report.scanTime = scanTime;
+        report.contactCount = r == 0 ? count : 0;
+        report.buttons = buttons;
+
+        for (uint8_t f = 0; f < TOUCHPAD_REPORT_CONTACTS; f++) {
+            uint8_t i = r * TOUCHPAD_REPORT_CONTACTS + f;
+            if (i >= count) break;
+            const TouchContact& c = contacts[i];
+            report.fingers[f].flags = (c.confident ? TOUCHPAD_CONFIDENCE : 0) | (c.tip ? TOUCHPAD_TIP : 0) |
+                                      (uint8_t)((c.id % TOUCH_CONTACT_IDS) << TOUCHPAD_ID_SHIFT);
+            report.fingers[f].x = c.x;
+            report.fingers[f].y = c.y;
+        }
+    }
+    return reports;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file TouchpadReport.h
+ * @brief Precision Touchpad input report layout, and packing tracked contacts into it
+ *
+ * Plain C++ with no Arduino dependencies, so it can be built and checked on a desktop.
+ * The layout has to match the touchpad descriptor in Digitizer.h byte for byte.
+ */
+
+#ifndef TOUCHPADREPORT_H
+#define TOUCHPADREPORT_H
+
+#include <stdint.h>
+#include "ContactTracker.h"
+
+#ifndef PACKED
+#define PACKED __attribute__((packed))
+#endif
+
+// Contacts per report. Fewer than TOUCH_MAX_CONTACTS is hybrid mode - a frame goes out over several
+// reports with the same scan time, and only the first one carries the contact count.
+#ifndef TOUCHPAD_REPORT_CONTACTS
+#define TOUCHPAD_REPORT_CONTACTS TOUCH_MAX_CONTACTS
+#endif
+
+#define TOUCHPAD_MAX_REPORTS ((TOUCH_MAX_CONTACTS + TOUCHPAD_REPORT_CONTACTS - 1) / TOUCHPAD_REPORT_CONTACTS)
+
+#define TOUCHPAD_CONFIDENCE  0x01
+#define TOUCHPAD_TIP         0x02
+#define TOUCHPAD_ID_SHIFT    2
+
+static_assert(TOUCHPAD_REPORT_CONTACTS >= 1 && TOUCHPAD_REPORT_CONTACTS <= TOUCH_MAX_CONTACTS, "TOUCHPAD_REPORT_CONTACTS has to be 1 to TOUCH_MAX_CONTACTS");
+
+struct PACKED TouchpadFinger {
+    uint8_t  flags;         // Confidence, tip switch, then the contact ID in the top 6 bits
+    uint16_t x;
+    uint16_t y;
+};
+
+struct PACKED TouchpadReport {
+    TouchpadFinger fingers[TOUCHPAD_REPORT_CONTACTS];
+    uint16_t       scanTime;      // 100us units, wraps
+    uint8_t        contactCount;  // Whole frame in the first report, 0 in the rest
+    uint8_t        buttons;
+};
+
+static_assert(sizeof(TouchpadFinger) == 5, "TouchpadFinger has to match the descriptor");
+static_assert(sizeof(TouchpadReport) == 5 * TOUCHPAD_REPORT_CONTACTS + 4, "TouchpadReport has to match the descriptor");
+
+// Fills out with as many reports as the frame needs and returns how many that was. A frame with no
+// contacts still makes one report, so a button change on its own gets through.
+uint8_t packTouchpadReports(const TouchContact* contacts, uint8_t count, uint16_t scanTime, uint8_t buttons,
+                            TouchpadReport out[TOUCHPAD_MAX_REPORTS]);
+
+#endif
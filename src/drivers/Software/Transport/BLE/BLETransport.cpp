@@ -5,6 +5,10 @@
 
 #include "BLETransport.h"
 
+#if __has_include("Preferences.h")
+#include <Preferences.h>
+#endif
+
 BLETransport::BLETransport() 
     : server(nullptr), hidDevice(nullptr), advertising(nullptr),
       transportCallbacks(nullptr), vid(0x046D), pid(0xC52B), version(0x0310),
@@ -17,7 +21,7 @@ BLETransport::BLETransport()
       inputSpacetrans(nullptr),
       inputSpacerotat(nullptr),
       inputSpaceclick(nullptr),
-      #else
+      #endif
       #if MOUSE_ENABLE
       inputMouse(nullptr), 
       #endif
@@ -27,14 +31,15 @@ BLETransport::BLETransport()
       #if GAMEPAD_ENABLE
       inputGamepad(nullptr),
       #endif
-      #endif
       #if STENO_ENABLE
       inputSteno(nullptr), 
       #endif
-      outputKeyboard(nullptr) { }
+      outputKeyboard(nullptr), configHash(0), fastBoot(false), directedAdvertising(false),
+      directedRank(0), advStartTime(0), connInterval(BLE_DEFAULT_CONN_INTERVAL) { }
 
 BLETransport::~BLETransport() {
     end();
+    teardown();
 }
 
 bool BLETransport::begin() {
@@ -42,9 +47,32 @@ bool BLETransport::begin() {
         return true;
     }
     
+    uint32_t beginStart = millis();
+    uint32_t hash = computeConfigHash();
+    
+    // end() left the stack and GATT table up - same layout means there's nothing to build, just advertise again
+    if (server && hash == configHash) {
+        initialized = true;
+        SQUID_LOG_INFO(BLE_TAG, "BLE stack resumed in %lu ms, GATT table reused", millis() - beginStart);
+        return true;
+    }
+    
+    // Layout changed since end(), the old table has to go before the new one gets built
+    teardown();
+    
     NimBLEDevice::init(deviceName.empty() ? "SquidHID" : deviceName.c_str());
     NimBLEDevice::setSecurityAuth(true, true, true);
     
+    // If nothing about the GATT layout changed since last boot, hosts still have valid cached handles
+    loadBondCache();
+    configHash = hash;
+    fastBoot = bondCache.configMatches(configHash);
+    if (!fastBoot) {
+        SQUID_LOG_INFO(BLE_TAG, "GATT configuration changed since last boot (hash 0x%08X)", configHash);
+        bondCache.setConfigHash(configHash);
+        saveBondCache();
+    }
+    
     server = NimBLEDevice::createServer();
     server->setCallbacks(this);
     
@@ -77,29 +105,134 @@ bool BLETransport::begin() {
     advertising = server->getAdvertising();
     initialized = true;
     
+    SQUID_LOG_INFO(BLE_TAG, "BLE stack up in %lu ms (%s, %zu cached hosts)", millis() - beginStart,
+                   fastBoot ? "fast path" : "full setup", bondCache.hostCount());
+    
     return true;
 }
 
+uint32_t BLETransport::computeConfigHash() {
+    // Anything that changes what the host sees in GATT goes in here
+    uint32_t hash = BondCache::hash(reportMap, reportMap ? reportMapLength : 0);
+    hash = BondCache::hash(&vid, sizeof(vid), hash);
+    hash = BondCache::hash(&pid, sizeof(pid), hash);
+    hash = BondCache::hash(&version, sizeof(version), hash);
+    hash = BondCache::hash(&appearance, sizeof(appearance), hash);
+    hash = BondCache::hash(deviceName.data(), deviceName.size(), hash);
+    return hash;
+}
+
+void BLETransport::loadBondCache() {
+    #if __has_include("Preferences.h")
+    Preferences prefs;
+    if (!prefs.begin("squidble", true)) {
+        SQUID_LOG_DEBUG(BLE_TAG, "No saved bond cache yet");
+        return;
+    }
+    
+    BondCache::Blob blob;
+    size_t length = prefs.getBytes("hosts", &blob, sizeof(blob));
+    prefs.end();
+    
+    if (!bondCache.load(&blob, length)) {
+        SQUID_LOG_DEBUG(BLE_TAG, "Bond cache missing or invalid, starting fresh");
+        bondCache.clear();
+        return;
+    }
+    
+    // Drop anything NimBLE doesn't have keys for anymore, directed advertising at them is pointless
+    BondCacheEntry host;
+    for (size_t rank = 0; bondCache.getCandidate(rank, host); ) {
+        ble_addr_t addr;
+        addr.type = host.addressType;
+        memcpy(addr.val, host.address, 6);
+        
+        if (!NimBLEDevice::isBonded(NimBLEAddress(addr))) {
+            SQUID_LOG_DEBUG(BLE_TAG, "Cached host %s no longer bonded, dropping it", NimBLEAddress(addr).toString().c_str());
+            bondCache.forgetHost(host.address, host.addressType);
+        } else {
+            rank++;
+        }
+    }
+    
+    if (bondCache.isDirty()) {
+        saveBondCache();
+    }
+    #endif
+}
+
+void BLETransport::saveBondCache() {
+    #if __has_include("Preferences.h")
+    Preferences prefs;
+    if (!prefs.begin("squidble", false)) {
+        SQUID_LOG_ERROR(BLE_TAG, "Couldn't open NVS to save bond cache");
+        return;
+    }
+    
+    const BondCache::Blob& blob = bondCache.save();
+    prefs.putBytes("hosts", &blob, sizeof(blob));
+    prefs.end();
+    #endif
+}
+
+void BLETransport::clearBondCache() {
+    uint32_t hash = bondCache.getConfigHash();
+    bondCache.clear();
+    bondCache.setConfigHash(hash);
+    saveBondCache();
+    SQUID_LOG_INFO(BLE_TAG, "Bond cache cleared");
+}
+
 void BLETransport::end() {
+    if (!initialized) {
+        return;
+    }
+    
+    // Cleared first so onDisconnect doesn't go straight back to advertising
+    initialized = false;
+    directedAdvertising = false;
+    directedRank = 0;
+    
     if (advertising) {
         advertising->stop();
     }
     
+    // The stack and GATT table stay up, rebuilding them is most of what a wake from sleep costs.
+    // begin() reuses them if the layout's the same, teardown() is what actually lets go.
     if (server) {
-        // NimBLE doesn't have deleteServer() - I'm just gonna deinit the device
-        // The server will be cleaned up when NimBLEDevice is deinitialized maybe? 
-        server = nullptr;
+        for (uint16_t handle : server->getPeerDevices()) {
+            server->disconnect(handle);
+        }
+    }
+    connected = false;
+}
+
+void BLETransport::teardown() {
+    if (!server) {
+        return;
     }
     
+    // NimBLE doesn't have deleteServer() - deinit with clearAll takes the server and its services with it
     NimBLEDevice::deinit(true);
-    initialized = false;
-    connected = false;
+    server = nullptr;
+    
+    // The HID wrapper only pointed at those services, so it can go too
+    delete hidDevice;
+    hidDevice = nullptr;
+    advertising = nullptr;
+    featureCharacteristics.clear();
 }
 
 void BLETransport::update() {
     static uint32_t lastStateCheck = 0;
     uint32_t currentTime = millis();
     
+    // Directed advertising ran out without the host showing up, try the next one or go general
+    if (initialized && directedAdvertising && advertising && !advertising->isAdvertising() && !connected) {
+        directedRank++;
+        startAdvertising();
+    }
+    
     // Check connection state periodically
     if (currentTime - lastStateCheck >= 1000) {
         lastStateCheck = currentTime;
@@ -161,9 +294,11 @@ void BLETransport::createHIDService() {
     #endif
     #if SPACEMOUSE_ENABLE
     inputSpacetrans = hidDevice->getInputReport(SPACETRANS_ID); // Spacemouse translations
+    #if !SPACEMOUSE_COMBINED
     inputSpacerotat = hidDevice->getInputReport(SPACEROTAT_ID); // Spacemouse rotations
+    #endif
     inputSpaceclick = hidDevice->getInputReport(SPACECLICK_ID); // Spacemouse buttons
-    #else
+    #endif
     #if MOUSE_ENABLE
     inputMouse = hidDevice->getInputReport(MOUSE_ID);           // Mouse
     #endif
@@ -173,11 +308,24 @@ void BLETransport::createHIDService() {
     #if GAMEPAD_ENABLE
     inputGamepad = hidDevice->getInputReport(GAMEPAD_ID);       // Gamepad
     #endif
-    #endif
     #if STENO_ENABLE
     inputSteno = hidDevice->getInputReport(STENO_ID);           // Plover HID steno
     #endif
     
+    // Feature reports, with whatever's been set so far carried over from the last time the stack was up
+    featureCharacteristics.clear();
+    #if DIGITIZER_ENABLE && DIGITIZER_TOUCHPAD
+    for (uint8_t id : { TOUCHPAD_CAPS_ID, TOUCHPAD_CERT_ID, TOUCHPAD_MODE_ID, TOUCHPAD_SWITCH_ID }) {
+        featureCharacteristics[id] = hidDevice->getFeatureReport(id);  // Touchpad caps, certification and config
+    }
+    #endif
+    for (auto& feature : featureCharacteristics) {
+        auto value = featureValues.find(feature.first);
+        if (feature.second && value != featureValues.end()) {
+            feature.second->setValue(value->second.data(), value->second.size());
+        }
+    }
+    
     // Set callbacks for ALL characteristics
     if (outputKeyboard) {
         outputKeyboard->setCallbacks(this);
@@ -223,7 +371,7 @@ void BLETransport::createHIDService() {
     } else {
         SQUID_LOG_ERROR(BLE_TAG, "Spacemouse Buttons Input characteristic creation failed!");
     }
-    #else
+    #endif
     
     #if MOUSE_ENABLE
     if (inputMouse) {
@@ -251,7 +399,6 @@ void BLETransport::createHIDService() {
         SQUID_LOG_ERROR(BLE_TAG, "Gamepad Input characteristic creation failed!");
     }
     #endif
-    #endif
     
     #if STENO_ENABLE
     if (inputSteno) {
@@ -266,6 +413,11 @@ void BLETransport::createHIDService() {
     SQUID_LOG_DEBUG(BLE_TAG, "Starting HID services...");
     hidDevice->startServices();
     
+    // Same layout as a boot that already checked out fine, so skip the settle time and the handle dump
+    if (fastBoot) {
+        return;
+    }
+    
     // Wait a moment for services to be fully initialized
     delay(50);
     
@@ -286,7 +438,7 @@ void BLETransport::verifyCharacteristicHandles() {
         {inputSpacetrans, "Spacemouse Translations Input"},
         {inputSpacerotat, "Spacemouse Rotations Input"},
         {inputSpaceclick, "Spacemouse Buttons Input"},
-        #else
+        #endif
         #if MOUSE_ENABLE
         {inputMouse, "Mouse Input"},
         #endif
@@ -296,7 +448,6 @@ void BLETransport::verifyCharacteristicHandles() {
         #if GAMEPAD_ENABLE
         {inputGamepad, "Gamepad Input"},
         #endif
-        #endif
         #if STENO_ENABLE
         {inputSteno, "Steno Input"},
         #endif
@@ -342,7 +493,7 @@ void BLETransport::debugCharacteristics() {
         {inputSpacetrans, "Spacemouse Translations Input"},
         {inputSpacerotat, "Spacemouse Rotations Input"},
         {inputSpaceclick, "Spacemouse Buttons Input"},
-        #else
+        #endif
         #if MOUSE_ENABLE
         {inputMouse, "Mouse Input"},
         #endif
@@ -352,7 +503,6 @@ void BLETransport::debugCharacteristics() {
         #if GAMEPAD_ENABLE
         {inputGamepad, "Gamepad Input"},
         #endif
-        #endif
         #if STENO_ENABLE
         {inputSteno, "Steno Input"},
         #endif
@@ -397,7 +547,7 @@ bool BLETransport::sendReport(uint8_t reportId, const uint8_t* data, size_t leng
         case SPACETRANS_ID: characteristic = inputSpacetrans; charName = "Spacetrans"; break;
         case SPACEROTAT_ID: characteristic = inputSpacerotat; charName = "Spacerotat"; break;
         case SPACECLICK_ID: characteristic = inputSpaceclick; charName = "Spaceclick"; break;
-        #else
+        #endif
         #if MOUSE_ENABLE
         case MOUSE_ID: characteristic = inputMouse; charName = "Mouse"; break;
         #endif
@@ -407,7 +557,6 @@ bool BLETransport::sendReport(uint8_t reportId, const uint8_t* data, size_t leng
         #if GAMEPAD_ENABLE
         case GAMEPAD_ID: characteristic = inputGamepad; charName = "Gamepad"; break;
         #endif
-        #endif
         #if STENO_ENABLE
         case STENO_ID: characteristic = inputSteno; charName = "Steno"; break;
         #endif
@@ -494,6 +643,38 @@ void BLETransport::setReportMap(const uint8_t* descriptor, size_t length) {
     SQUID_LOG_INFO(BLE_TAG, "Report map stored - Length: %zu", length);
 }
 
+bool BLETransport::setFeatureReport(uint8_t reportId, const uint8_t* data, size_t length) {
+    if (!data) return false;
+    featureValues[reportId].assign(data, data + length);
+    
+    auto it = featureCharacteristics.find(reportId);
+    if (it != featureCharacteristics.end() && it->second) {
+        it->second->setValue(data, length);
+    } else if (initialized) {
+        // Kept anyway, a report map reload might bring the characteristic in
+        SQUID_LOG_DEBUG(BLE_TAG, "No characteristic for feature report 0x%02X yet", reportId);
+    }
+    return true;
+}
+
+bool BLETransport::reloadReportMap() {
+    if (!initialized) {
+        // Nothing running yet, begin() will pick up the new map
+        return true;
+    }
+    
+    SQUID_LOG_INFO(BLE_TAG, "Report map changed - restarting BLE stack and advertising");
+    
+    // The HID service can't be edited in place once it's started, so the whole stack gets torn down and rebuilt
+    // Hosts drop the link here and see the new map when they reconnect
+    end();
+    if (!begin()) {
+        SQUID_LOG_ERROR(BLE_TAG, "Failed to restart BLE stack with new report map");
+        return false;
+    }
+    return startAdvertising();
+}
+
 void BLETransport::setAppearance(uint16_t newAppearance) {
     this->appearance = newAppearance;
     SQUID_LOG_INFO(BLE_TAG, "Appearance set to: 0x%04X", appearance);
@@ -513,11 +694,24 @@ bool BLETransport::startAdvertising() {
     
     // Stop any existing advertising first
     advertising->stop();
-    delay(50);
+    if (!fastBoot) {
+        delay(50);
+    }
+    
+    // Try the hosts we've bonded with before, most recent first, before falling back to general advertising
+    BondCacheEntry host;
+    if (!connected && bondCache.getCandidate(directedRank, host)) {
+        if (startDirectedAdvertising(host)) {
+            return true;
+        }
+        directedRank++;
+    }
+    directedAdvertising = false;
     
     // Configure advertising parameters
-    advertising->setMinInterval(32);
-    advertising->setMaxInterval(48);
+    advertising->setAdvertisementType(BLE_GAP_CONN_MODE_UND);
+    advertising->setMinInterval(BLE_FAST_ADV_MIN);
+    advertising->setMaxInterval(BLE_FAST_ADV_MAX);
     
     // Create advertisement data
     BLEAdvertisementData advData;
@@ -543,6 +737,7 @@ bool BLETransport::startAdvertising() {
     // Start advertising
     bool result = advertising->start();
     if (result) {
+        advStartTime = millis();
         SQUID_LOG_INFO(BLE_TAG, "BLE advertising started");
     } else {
         SQUID_LOG_ERROR(BLE_TAG, "Failed to start BLE advertising");
@@ -551,7 +746,55 @@ bool BLETransport::startAdvertising() {
     return result;
 }
 
+bool BLETransport::startDirectedAdvertising(const BondCacheEntry& host) {
+    ble_addr_t addr;
+    addr.type = host.addressType;
+    memcpy(addr.val, host.address, 6);
+    NimBLEAddress target(addr);
+    
+    advertising->setAdvertisementType(BLE_GAP_CONN_MODE_DIR);
+    
+    // High duty directed advertising times out on its own, update() moves on to the next host when it does
+    if (!advertising->start(BLE_DIRECTED_ADV_MS, nullptr, &target)) {
+        SQUID_LOG_WARN(BLE_TAG, "Directed advertising to %s failed to start", target.toString().c_str());
+        return false;
+    }
+    
+    directedAdvertising = true;
+    advStartTime = millis();
+    SQUID_LOG_INFO(BLE_TAG, "Directed advertising to cached host %d: %s", directedRank, target.toString().c_str());
+    return true;
+}
+
 // BLE Callbacks
+void BLETransport::onConnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {
+    SQUID_LOG_INFO(BLE_TAG, "Host %s connected %lu ms after %s advertising started (%lu ms since boot)",
+                   NimBLEAddress(desc->peer_id_addr).toString().c_str(), millis() - advStartTime,
+                   directedAdvertising ? "directed" : "general", millis());
+    
+    directedAdvertising = false;
+    directedRank = 0;
+    
+    // One notification per connection event is what gets through without queueing
+    connInterval = desc->conn_itvl ? desc->conn_itvl * 1250 : BLE_DEFAULT_CONN_INTERVAL;
+    SQUID_LOG_DEBUG(BLE_TAG, "Connection interval %lu us", connInterval);
+}
+
+void BLETransport::onAuthenticationComplete(ble_gap_conn_desc* desc) {
+    if (!desc->sec_state.encrypted) {
+        SQUID_LOG_WARN(BLE_TAG, "Pairing with host failed");
+        return;
+    }
+    
+    // Only bonded hosts are worth coming back to, anything else won't have keys next time
+    if (desc->sec_state.bonded) {
+        bondCache.recordHost(desc->peer_id_addr.val, desc->peer_id_addr.type);
+        if (bondCache.isDirty()) {
+            saveBondCache();
+        }
+    }
+}
+
 void BLETransport::onConnect(NimBLEServer* pServer) {
     connected = true;
     
@@ -578,7 +821,7 @@ void BLETransport::onConnect(NimBLEServer* pServer) {
     if (inputSpaceclick && inputSpaceclick->getHandle() != 0) {
         inputSpaceclick->notify();
     }
-    #else
+    #endif
     
     #if MOUSE_ENABLE
     if (inputMouse && inputMouse->getHandle() != 0) {
@@ -597,7 +840,6 @@ void BLETransport::onConnect(NimBLEServer* pServer) {
         inputGamepad->notify();
     }
     #endif
-    #endif
     
     #if STENO_ENABLE
     if (inputSteno && inputSteno->getHandle() != 0) {
@@ -618,9 +860,10 @@ void BLETransport::onDisconnect(NimBLEServer* pServer) {
         transportCallbacks->onDisconnect();
     }
     
-    // Restart advertising when disconnected
-    if (advertising) {
-        advertising->start();
+    // Restart advertising when disconnected - the host we just lost is top of the cache, so it gets a directed attempt first
+    if (advertising && initialized) {
+        directedRank = 0;
+        startAdvertising();
         SQUID_LOG_INFO(BLE_TAG, "Advertising restarted after disconnect");
     }
 }
@@ -642,6 +885,12 @@ void BLETransport::onWrite(NimBLECharacteristic* characteristic) {
             hexStr += buf;
         }
         SQUID_LOG_DEBUG(BLE_TAG, "Output report data: %s", hexStr.c_str());
+        
+        // The characteristic is the report ID over BLE, so it isn't in the data
+        if (transportCallbacks) {
+            transportCallbacks->onOutputReport(NKRO_ID, reinterpret_cast<const uint8_t*>(value.data()), value.length());
+        }
+        return;
     }
     
     if (transportCallbacks) {
@@ -672,7 +921,7 @@ void BLETransport::onSubscribe(NimBLEServer* pServer, ble_gap_conn_desc* desc, u
         SQUID_LOG_INFO(BLE_TAG, "Spacemouse rotations report subscribed");
     } else if (inputSpaceclick && inputSpaceclick->getHandle() == attr_handle) {
         SQUID_LOG_INFO(BLE_TAG, "Spacemouse buttons report subscribed");
-    #else
+    #endif
     #if MOUSE_ENABLE
     } else if (inputMouse && inputMouse->getHandle() == attr_handle) {
         SQUID_LOG_INFO(BLE_TAG, "Mouse report subscribed");
@@ -685,7 +934,6 @@ void BLETransport::onSubscribe(NimBLEServer* pServer, ble_gap_conn_desc* desc, u
     } else if (inputGamepad && inputGamepad->getHandle() == attr_handle) {
         SQUID_LOG_INFO(BLE_TAG, "Gamepad report subscribed");
     #endif
-    #endif
     #if STENO_ENABLE
     } else if (inputSteno && inputSteno->getHandle() == attr_handle) {
         SQUID_LOG_INFO(BLE_TAG, "Steno report subscribed");
@@ -9,6 +9,7 @@
 #include "../Transport.h"
 
 #include "HIDTypes.h"
+#include "BondCache.h"
 
 #if __has_include("NimBLEAdvertising.h")
 #include "NimBLEAdvertising.h"
@@ -46,7 +47,7 @@ private:
     NimBLECharacteristic* inputSpacetrans;
     NimBLECharacteristic* inputSpacerotat;
     NimBLECharacteristic* inputSpaceclick;
-    #else
+    #endif
     #if MOUSE_ENABLE
     NimBLECharacteristic* inputMouse;
     #endif
@@ -56,12 +57,15 @@ private:
     #if GAMEPAD_ENABLE
     NimBLECharacteristic* inputGamepad;
     #endif
-    #endif
     #if STENO_ENABLE
     NimBLECharacteristic* inputSteno;
     #endif
     NimBLECharacteristic* outputKeyboard;
     
+    // Feature reports have to exist before the service starts, but the values can turn up any time
+    std::map<uint8_t, NimBLECharacteristic*> featureCharacteristics;
+    std::map<uint8_t, std::vector<uint8_t>>  featureValues;
+    
     // Callbacks
     TransportCallbacks*   transportCallbacks;
     
@@ -76,6 +80,21 @@ private:
     bool initialized;
     bool connected;
     
+    // Reconnect cache
+    BondCache bondCache;
+    uint32_t  configHash;
+    bool      fastBoot;             // Same GATT layout as last boot, so the sanity checks get skipped
+    bool      directedAdvertising;
+    uint8_t   directedRank;         // Which cached host we're currently trying
+    uint32_t  advStartTime;
+    uint32_t  connInterval;         // us, whatever the host settled on for this connection
+    
+    uint32_t computeConfigHash();
+    void     teardown();
+    void     loadBondCache();
+    void     saveBondCache();
+    bool     startDirectedAdvertising(const BondCacheEntry& host);
+    
 public:
     BLETransport();
     virtual ~BLETransport();
@@ -97,8 +116,11 @@ public:
     void setAppearance(uint16_t appearance) override;
     void setCallbacks(TransportCallbacks* callbacks) override;
     void setReportMap(const uint8_t* descriptor, size_t length) override;
+    bool reloadReportMap() override;
     
     bool supportsHID() override { return true; }
+    uint32_t getReportInterval() override { return connInterval; }
+    bool setFeatureReport(uint8_t reportId, const uint8_t* data, size_t length) override;
     
     // BLE-specific methods
     NimBLEHIDDevice* getHIDDevice() { return hidDevice; }
@@ -108,8 +130,14 @@ public:
     void createHIDService();
     bool startAdvertising();
     
+    // Reconnect cache
+    void clearBondCache();
+    size_t getCachedHostCount() { return bondCache.hostCount(); }
+    
     // BLE callbacks
     void onConnect(NimBLEServer* pServer);
+    void onConnect(NimBLEServer* pServer, ble_gap_conn_desc* desc);
+    void onAuthenticationComplete(ble_gap_conn_desc* desc);
     void onDisconnect(NimBLEServer* pServer);
     void onWrite(NimBLECharacteristic* characteristic);
     void onSubscribe(NimBLEServer* pServer, ble_gap_conn_desc* desc, uint16_t attr_handle);
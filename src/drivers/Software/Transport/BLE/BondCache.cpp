@@ -0,0 +1,147 @@
+/**
+ * @file BondCache.cpp
+ * @brief Bonded host cache implementation
+ */
+
+#include "BondCache.h"
+
+#include <string.h>
+
+BondCache::BondCache() {
+    clear();
+}
+
+void BondCache::clear() {
+    memset(&blob, 0, sizeof(blob));
+    blob.version = BOND_CACHE_VERSION;
+    dirty = true;
+}
+
+uint32_t BondCache::computeChecksum() const {
+    return hash(&blob, offsetof(Blob, checksum));
+}
+
+uint32_t BondCache::hash(const void* data, size_t length, uint32_t seed) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint32_t h = seed;
+    for (size_t i = 0; i < length; i++) {
+        h ^= bytes[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+bool BondCache::load(const void* data, size_t length) {
+    if (!data || length != sizeof(Blob)) {
+        return false;
+    }
+
+    Blob incoming;
+    memcpy(&incoming, data, sizeof(Blob));
+
+    if (incoming.version != BOND_CACHE_VERSION || incoming.count > BOND_CACHE_SIZE) {
+        return false;
+    }
+
+    if (hash(&incoming, offsetof(Blob, checksum)) != incoming.checksum) {
+        return false;
+    }
+
+    blob  = incoming;
+    dirty = false;
+    return true;
+}
+
+const BondCache::Blob& BondCache::save() {
+    blob.checksum = computeChecksum();
+    dirty = false;
+    return blob;
+}
+
+int BondCache::find(const uint8_t* address, uint8_t addressType) const {
+    for (int i = 0; i < BOND_CACHE_SIZE; i++) {
+        const BondCacheEntry& e = blob.entries[i];
+        if (e.valid && e.addressType == addressType && memcmp(e.address, address, 6) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void BondCache::recordHost(const uint8_t* address, uint8_t addressType) {
+    int slot = find(address, addressType);
+
+    if (slot >= 0 && blob.entries[slot].lastUsed == blob.sequence) {
+        // Already the most recent host, nothing worth writing to flash
+        return;
+    }
+
+    if (slot < 0) {
+        // Take a free slot, or kick out whoever was used least recently
+        slot = 0;
+        for (int i = 0; i < BOND_CACHE_SIZE; i++) {
+            if (!blob.entries[i].valid) {
+                slot = i;
+                break;
+            }
+            if (blob.entries[i].lastUsed < blob.entries[slot].lastUsed) {
+                slot = i;
+            }
+        }
+
+        if (!blob.entries[slot].valid) {
+            blob.count++;
+        }
+
+        memcpy(blob.entries[slot].address, address, 6);
+        blob.entries[slot].addressType = addressType;
+        blob.entries[slot].valid = 1;
+    }
+
+    blob.entries[slot].lastUsed = ++blob.sequence;
+    dirty = true;
+}
+
+bool BondCache::forgetHost(const uint8_t* address, uint8_t addressType) {
+    int slot = find(address, addressType);
+    if (slot < 0) {
+        return false;
+    }
+
+    memset(&blob.entries[slot], 0, sizeof(BondCacheEntry));
+    blob.count--;
+    dirty = true;
+    return true;
+}
+
+bool BondCache::getCandidate(size_t rank, BondCacheEntry& out) const {
+    if (rank >= blob.count) {
+        return false;
+    }
+
+    // Only a handful of entries, so just pick the rank-th biggest lastUsed by counting
+    for (int i = 0; i < BOND_CACHE_SIZE; i++) {
+        const BondCacheEntry& e = blob.entries[i];
+        if (!e.valid) continue;
+
+        size_t newer = 0;
+        for (int j = 0; j < BOND_CACHE_SIZE; j++) {
+            if (blob.entries[j].valid && blob.entries[j].lastUsed > e.lastUsed) {
+                newer++;
+            }
+        }
+
+        if (newer == rank) {
+            out = e;
+            return true;
+        }
+    }
+    return false;
+}
+
+void BondCache::setConfigHash(uint32_t hash) {
+    if (blob.configHash != hash) {
+        blob.configHash = hash;
+        dirty = true;
+    }
+}
@@ -0,0 +1,72 @@
+/**
+ * @file BondCache.h
+ * @brief Remembers recently bonded hosts so reconnects can skip general advertising
+ *
+ * Nothing in here touches NimBLE or NVS - BLETransport does the loading/saving and
+ * just hands the raw blob back and forth, so this bit can be reasoned about on its own.
+ */
+
+#ifndef BONDCACHE_H
+#define BONDCACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define BOND_CACHE_SIZE     4    // How many hosts to remember
+#define BOND_CACHE_VERSION  1    // Bump if the blob layout changes, old blobs get thrown out
+
+struct BondCacheEntry {
+    uint8_t  address[6];   // Identity address, little endian like NimBLE has it
+    uint8_t  addressType;  // Public/random, straight from ble_addr_t
+    uint8_t  valid;
+    uint32_t lastUsed;     // Connection sequence number, higher = more recent
+};
+
+class BondCache {
+public:
+    // What actually gets written to flash
+    struct Blob {
+        uint8_t         version;
+        uint8_t         count;
+        uint16_t        reserved;
+        uint32_t        configHash;
+        uint32_t        sequence;
+        BondCacheEntry  entries[BOND_CACHE_SIZE];
+        uint32_t        checksum;
+    };
+
+private:
+    Blob   blob;
+    bool   dirty;
+
+    uint32_t computeChecksum() const;
+    int      find(const uint8_t* address, uint8_t addressType) const;
+
+public:
+    BondCache();
+
+    void   clear();
+
+    // Persistence - load() rejects anything with the wrong version or a bad checksum
+    bool         load(const void* data, size_t length);
+    const Blob&  save();
+    bool         isDirty() const { return dirty; }
+
+    // Host bookkeeping
+    void   recordHost(const uint8_t* address, uint8_t addressType);
+    bool   forgetHost(const uint8_t* address, uint8_t addressType);
+    size_t hostCount() const { return blob.count; }
+
+    // Most recently used first, index 0 is the best guess for who's coming back
+    bool   getCandidate(size_t rank, BondCacheEntry& out) const;
+
+    // Config hash - if the GATT layout hasn't changed since last boot, hosts' cached handles are still good
+    void     setConfigHash(uint32_t hash);
+    uint32_t getConfigHash() const { return blob.configHash; }
+    bool     configMatches(uint32_t hash) const { return blob.configHash == hash; }
+
+    // FNV-1a, chain calls with the previous result as the seed
+    static uint32_t hash(const void* data, size_t length, uint32_t seed = 2166136261u);
+};
+
+#endif
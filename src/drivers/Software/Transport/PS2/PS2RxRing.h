@@ -0,0 +1,72 @@
+/**
+ * @file PS2RxRing.h
+ * @brief Lock-free ring the PS/2 clock ISR drops received bytes into for update() to pick up
+ *
+ * Plain C++ with no Arduino dependencies, so the ring can be hammered from two threads on a desktop.
+ */
+
+#ifndef PS2RXRING_H
+#define PS2RXRING_H
+
+#include <stdint.h>
+#include <atomic>
+
+// Size has to be a power of two for the index masking to work, one slot always stays empty
+#define PS2_RX_RING_SIZE 32
+#define PS2_RX_RING_MASK (PS2_RX_RING_SIZE - 1)
+
+// Single producer (clock ISR) / single consumer (update loop). The producer only ever moves head and
+// the consumer only ever moves tail, so no locking is needed.
+class PS2RxRing {
+public:
+    // Producer only. Full drops the new byte rather than stomping on unread ones.
+    void push(uint8_t data) {
+        uint8_t at = head.load(std::memory_order_relaxed);
+        uint8_t next = (at + 1) & PS2_RX_RING_MASK;
+        if (next == tail.load(std::memory_order_acquire)) {
+            countOverflow();
+            return;
+        }
+        buffer[at] = data;
+        head.store(next, std::memory_order_release);
+    }
+
+    // Consumer only
+    bool pop(uint8_t& data) {
+        uint8_t at = tail.load(std::memory_order_relaxed);
+        if (at == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        data = buffer[at];
+        tail.store((at + 1) & PS2_RX_RING_MASK, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return tail.load(std::memory_order_relaxed) == head.load(std::memory_order_acquire);
+    }
+
+    // Consumer only - throws away whatever's waiting
+    void clear() {
+        tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // Either side can count, the counters are only ever added to or reset
+    void     countOverflow()    { overflowCount.fetch_add(1, std::memory_order_relaxed); }
+    void     countParityError() { parityErrorCount.fetch_add(1, std::memory_order_relaxed); }
+    uint32_t overflows() const    { return overflowCount.load(std::memory_order_relaxed); }
+    uint32_t parityErrors() const { return parityErrorCount.load(std::memory_order_relaxed); }
+    void resetCounters() {
+        overflowCount.store(0, std::memory_order_relaxed);
+        parityErrorCount.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    volatile uint8_t      buffer[PS2_RX_RING_SIZE] = {};
+    std::atomic<uint8_t>  head{0};
+    std::atomic<uint8_t>  tail{0};
+    std::atomic<uint32_t> overflowCount{0};
+    std::atomic<uint32_t> parityErrorCount{0};
+};
+
+#endif
@@ -4,6 +4,8 @@
  */
 
 #include "PS2Transport.h"
+#include "PS2RxRing.h"
+#include "../../HID/HostLEDs.h"
 
 // PS/2 command codes
 namespace PS2Commands {
@@ -13,6 +15,8 @@ namespace PS2Commands {
     constexpr uint8_t PS2_KEYBOARD_ECHO = 0xEE;
     constexpr uint8_t PS2_KEYBOARD_SET_LEDS = 0xED;
     constexpr uint8_t PS2_KEYBOARD_SET_SCANCODE = 0xF0;
+    constexpr uint8_t PS2_KEYBOARD_SET_TYPEMATIC = 0xF3;
+    constexpr uint8_t PS2_KEYBOARD_RESEND = 0xFE;
     
     constexpr uint8_t PS2_MOUSE_RESET = 0xFF;
     constexpr uint8_t PS2_MOUSE_DISABLE = 0xF5;
@@ -22,6 +26,10 @@ namespace PS2Commands {
     constexpr uint8_t PS2_MOUSE_SET_RESOLUTION = 0xE8;
     constexpr uint8_t PS2_MOUSE_STATUS_REQUEST = 0xE9;
     constexpr uint8_t PS2_MOUSE_SET_SCALING = 0xE6;
+    
+    // Lowest command byte each side knows - no argument byte ever gets this high
+    constexpr uint8_t PS2_KEYBOARD_COMMAND_MIN = 0xED;
+    constexpr uint8_t PS2_MOUSE_COMMAND_MIN = 0xE6;
 }
 
 // PS/2 responses
@@ -207,13 +215,15 @@ static const PS2Scancode MODIFIER_KEYS[] = {
 
 // Static members for ISR
 static volatile PS2Transport* activePS2Instance = nullptr;
-static volatile uint8_t ps2RxBuffer[16];
-static volatile uint8_t ps2RxIndex = 0;
 static volatile bool ps2Receiving = false;
+static volatile bool ps2Parity = false;
 static volatile uint8_t ps2CurrentBit = 0;
 static volatile uint8_t ps2CurrentByte = 0;
 static volatile uint32_t ps2LastClockTime = 0;
 
+// Bytes from the clock ISR, waiting for update()
+static PS2RxRing ps2Rx;
+
 PS2Transport::PS2Transport(DeviceType type, int clkPin, int dataPin)
     : callbacks(nullptr)
     , deviceName("PS2 Device")
@@ -225,8 +235,11 @@ PS2Transport::PS2Transport(DeviceType type, int clkPin, int dataPin)
     , dataPin(dataPin)
     , inhibitCommunication(false)
     , lastCommand(0)
+    , lastSent(0)
     , responseIndex(0)
     , keyboardLEDs(0)
+    , typematicRate(0x2B) // 10.9 cps, 500ms delay - the PS/2 power-on default
+    , scancodeSet(2)
     , keyboardEnabled(false)
     , mouseSampleRate(100)
     , mouseResolution(4)
@@ -242,6 +255,7 @@ PS2Transport::PS2Transport(DeviceType type, int clkPin, int dataPin)
 {
     memset(keyboardReport, 0, sizeof(keyboardReport));
     memset(mouseReport, 0, sizeof(mouseReport));
+    memset(responseBuffer, 0, sizeof(responseBuffer));
 }
 
 PS2Transport::~PS2Transport() {
@@ -257,6 +271,12 @@ bool PS2Transport::begin() {
     pinMode(clockPin, INPUT_PULLUP);
     pinMode(dataPin, INPUT_PULLUP);
     
+    // Start with an empty ring
+    ps2Rx.clear();
+    ps2CurrentBit = 0;
+    responseIndex = 0;
+    lastCommand = 0;
+    
     // Attach interrupts
     activePS2Instance = this;
     attachInterrupt(digitalPinToInterrupt(clockPin), ps2ClockISR, FALLING);
@@ -307,11 +327,7 @@ void PS2Transport::end() {
 }
 
 void PS2Transport::update() {
-    // Process any received PS/2 commands
-    if (ps2RxIndex > 0) {
-        uint8_t command = ps2Read();
-        processPS2Command(command);
-    }
+    handlePS2Communication();
 }
 
 bool PS2Transport::isConnected() {
@@ -502,9 +518,9 @@ void PS2Transport::sendMouseReportPS2(const uint8_t* hidReport) {
     }
 }
 
-void PS2Transport::ps2Write(uint8_t data) {
+bool PS2Transport::ps2Write(uint8_t data, bool waitForAck) {
     // Very basic error handling
-    if (!initialized) return;
+    if (!initialized) return false;
     
     // Implement PS/2 write protocol
     inhibitCommunication = true;
@@ -515,7 +531,7 @@ void PS2Transport::ps2Write(uint8_t data) {
         if (micros() > timeout) {
             SQUID_LOG_WARN(PS2_TAG, "PS/2 clock stuck low during write");
             inhibitCommunication = false;
-            return;
+            return false;
         }
         delayMicroseconds(10);
     }
@@ -562,77 +578,83 @@ void PS2Transport::ps2Write(uint8_t data) {
     pinMode(dataPin, INPUT_PULLUP);
     inhibitCommunication = false;
     
+    lastSent = data;
+    
     // Wait for ACK, notify if nothing comes in
-    ps2WaitForAck();
-    if (!ps2WaitForAck()) {
+    if (waitForAck && !ps2WaitForAck()) {
         SQUID_LOG_WARN(PS2_TAG, "No ACK received for command 0x%02X", data);
+        return false;
     }
+    return true;
+}
+
+bool PS2Transport::ps2Available() {
+    return responseIndex > 0 || !ps2Rx.empty();
 }
 
 uint8_t PS2Transport::ps2Read() {
-    // This would be called from ISR - simplified for example
-    if (ps2RxIndex > 0) {
-        uint8_t data = ps2RxBuffer[0];
-        // Shift buffer
-        for (int i = 1; i < ps2RxIndex; i++) {
-            ps2RxBuffer[i-1] = ps2RxBuffer[i];
-        }
-        ps2RxIndex--;
+    // Anything set aside while waiting for an ACK arrived first, so it goes out first
+    if (responseIndex > 0) {
+        uint8_t data = responseBuffer[0];
+        memmove(responseBuffer, responseBuffer + 1, --responseIndex);
         return data;
     }
-    return 0;
+    
+    uint8_t data = 0;
+    ps2Rx.pop(data);
+    return data;
 }
 
-bool PS2Transport::ps2WaitForAck() {
-    uint32_t timeout = millis() + 1000;
-    while (millis() < timeout) {
-        if (ps2RxIndex > 0 && ps2RxBuffer[0] == PS2Responses::ACK) {
-            ps2RxIndex = 0; // Consume ACK
-            return true;
+bool PS2Transport::ps2WaitForByte(uint8_t expected, uint32_t timeoutMs) {
+    uint32_t start = millis();
+    while (millis() - start < timeoutMs) {
+        uint8_t data;
+        while (ps2Rx.pop(data)) {
+            if (data == expected) {
+                return true;
+            }
+            if (expected == PS2Responses::ACK && data == PS2Responses::RESEND) {
+                SQUID_LOG_DEBUG(PS2_TAG, "Resend requested instead of ACK");
+                return false;
+            }
+            
+            // Not what we're waiting for - keep it for update() instead of throwing it away
+            if (responseIndex < sizeof(responseBuffer)) {
+                responseBuffer[responseIndex++] = data;
+            } else {
+                ps2Rx.countOverflow();
+            }
         }
         delayMicroseconds(100);
     }
     return false;
 }
 
+bool PS2Transport::ps2WaitForAck() {
+    return ps2WaitForByte(PS2Responses::ACK, 1000);
+}
+
 void PS2Transport::ps2Reset() {
     SQUID_LOG_DEBUG(PS2_TAG, "Performing PS/2 reset");
     
     // Reset keyboard
     if (deviceType == DeviceType::PS2_KEYBOARD || deviceType == DeviceType::PS2_COMBO) {
-        ps2Write(PS2Commands::PS2_KEYBOARD_RESET);
-        if (ps2WaitForAck()) {
+        if (ps2Write(PS2Commands::PS2_KEYBOARD_RESET)) {
             // Wait for self-test passed
-            uint32_t timeout = millis() + 2000;
-            while (millis() < timeout) {
-                if (ps2RxIndex > 0 && ps2RxBuffer[0] == PS2Responses::SELF_TEST_PASSED) {
-                    ps2RxIndex = 0;
-                    keyboardEnabled = true;
-                    SQUID_LOG_INFO(PS2_TAG, "Keyboard self-test passed");
-                    break;
-                }
-                delayMicroseconds(100);
+            if (ps2WaitForByte(PS2Responses::SELF_TEST_PASSED, 2000)) {
+                keyboardEnabled = true;
+                SQUID_LOG_INFO(PS2_TAG, "Keyboard self-test passed");
             }
         }
     }
     
     // Reset mouse
     if (deviceType == DeviceType::PS2_MOUSE || deviceType == DeviceType::PS2_COMBO) {
-        ps2Write(PS2Commands::PS2_MOUSE_RESET);
-        if (ps2WaitForAck()) {
-            // Mouse reset sequence
-            uint32_t timeout = millis() + 2000;
-            while (millis() < timeout) {
-                if (ps2RxIndex >= 3) {
-                    if (ps2RxBuffer[0] == 0xAA && ps2RxBuffer[1] == 0x00) {
-                        // Mouse reset successful
-                        ps2RxIndex = 0;
-                        mouseEnabled = true;
-                        SQUID_LOG_INFO(PS2_TAG, "Mouse self-test passed");
-                        break;
-                    }
-                }
-                delayMicroseconds(100);
+        if (ps2Write(PS2Commands::PS2_MOUSE_RESET)) {
+            // Mouse reset sequence - self-test result followed by device ID 0x00
+            if (ps2WaitForByte(PS2Responses::SELF_TEST_PASSED, 2000) && ps2WaitForByte(0x00, 500)) {
+                mouseEnabled = true;
+                SQUID_LOG_INFO(PS2_TAG, "Mouse self-test passed");
             }
         }
     }
@@ -646,8 +668,7 @@ void PS2Transport::ps2KeyboardInit() {
     
         // Enable keyboard, retry a few times if unsuccessful then stop gracefully
     for (int attempt = 0; attempt < 3; attempt++) {
-        ps2Write(PS2Commands::PS2_KEYBOARD_ENABLE);
-        if (ps2WaitForAck()) {
+        if (ps2Write(PS2Commands::PS2_KEYBOARD_ENABLE)) {
             break;
         }
         delay(100);
@@ -655,9 +676,7 @@ void PS2Transport::ps2KeyboardInit() {
     
     // Set scancode set 2 (most common)
     ps2Write(PS2Commands::PS2_KEYBOARD_SET_SCANCODE);
-    ps2WaitForAck();
     ps2Write(0x02); // Scancode set 2
-    ps2WaitForAck();
     
     SQUID_LOG_DEBUG(PS2_TAG, "Keyboard initialized with scancode set 2");
 }
@@ -667,19 +686,14 @@ void PS2Transport::ps2MouseInit() {
     
     // Enable mouse
     ps2Write(PS2Commands::PS2_MOUSE_ENABLE);
-    ps2WaitForAck();
     
     // Set sample rate
     ps2Write(PS2Commands::PS2_MOUSE_SET_SAMPLE_RATE);
-    ps2WaitForAck();
     ps2Write(mouseSampleRate);
-    ps2WaitForAck();
     
     // Set resolution
     ps2Write(PS2Commands::PS2_MOUSE_SET_RESOLUTION);
-    ps2WaitForAck();
     ps2Write(mouseResolution);
-    ps2WaitForAck();
     
     SQUID_LOG_DEBUG(PS2_TAG, "Mouse initialized - Rate: %d, Resolution: %d", 
                    mouseSampleRate, mouseResolution);
@@ -703,20 +717,25 @@ void PS2Transport::ps2ClockISR() {
             ps2Receiving = true;
             ps2CurrentByte = 0;
             ps2CurrentBit = 1;
+            ps2Parity = false;
         }
     } else if (ps2CurrentBit <= 8) {
         // Data bits
         ps2CurrentByte |= (dataBit << (ps2CurrentBit - 1));
+        ps2Parity = ps2Parity ^ dataBit;
         ps2CurrentBit++;
     } else if (ps2CurrentBit == 9) {
-        // Parity bit (we ignore for now)
+        // Parity bit - data bits plus parity should come out odd
+        ps2Parity = ps2Parity ^ dataBit;
         ps2CurrentBit++;
     } else if (ps2CurrentBit == 10) {
         // Stop bit should be 1
         if (dataBit) {
-            // Valid byte received
-            if (ps2RxIndex < 16) {
-                ps2RxBuffer[ps2RxIndex++] = ps2CurrentByte;
+            if (ps2Parity) {
+                // Valid byte received
+                ps2Rx.push(ps2CurrentByte);
+            } else {
+                ps2Rx.countParityError();
             }
         }
         ps2Receiving = false;
@@ -771,52 +790,114 @@ void PS2Transport::setDeviceType(DeviceType type) {
 }
 
 void PS2Transport::handlePS2Communication() {
-    // Process any received PS/2 commands
-    if (ps2RxIndex > 0) {
-        uint8_t command = ps2Read();
-        processPS2Command(command);
+    // Drain everything the ISR has queued up since the last call
+    while (ps2Available()) {
+        processPS2Command(ps2Read());
     }
 }
 
-void PS2Transport::processPS2Command(uint8_t command) {
-    SQUID_LOG_DEBUG(PS2_TAG, "Processing PS/2 command: 0x%02X", command);
+void PS2Transport::processPS2Command(uint8_t data) {
+    // Two-byte commands leave lastCommand set until their argument turns up. A command byte in its
+    // place means the host gave up on the argument, so it gets handled as a new command instead.
+    uint8_t commandMin = deviceType == DeviceType::PS2_KEYBOARD ? PS2Commands::PS2_KEYBOARD_COMMAND_MIN
+                                                                : PS2Commands::PS2_MOUSE_COMMAND_MIN;
+    if (lastCommand != 0 && data >= commandMin) {
+        SQUID_LOG_DEBUG(PS2_TAG, "Command 0x%02X arrived instead of the argument for 0x%02X", data, lastCommand);
+        lastCommand = 0;
+    }
     
-    switch (command) {
-        case PS2Commands::PS2_KEYBOARD_SET_LEDS:
-            // Host wants to set LEDs
-            if (ps2WaitForAck()) {
-                uint8_t ledData = ps2Read();
-                keyboardLEDs = ledData;
-                ps2Write(PS2Responses::ACK);
+    if (lastCommand != 0) {
+        uint8_t command = lastCommand;
+        lastCommand = 0;
+        
+        switch (command) {
+            case PS2Commands::PS2_KEYBOARD_SET_LEDS:
+                keyboardLEDs = data & 0x07;
+                ps2Write(PS2Responses::ACK, false);
+                SQUID_LOG_DEBUG(PS2_TAG, "Host set LEDs: 0x%02X", keyboardLEDs);
                 
                 if (callbacks) {
-                    // Convert to HID-style report (LED status)
-                    uint8_t report[1] = {ledData};
-                    callbacks->onDataReceived(report, 1);
+                    uint8_t report[1] = {HostLEDs::fromPS2(keyboardLEDs)};
+                    callbacks->onOutputReport(NKRO_ID, report, 1);
                 }
-            }
+                return;
+                
+            case PS2Commands::PS2_KEYBOARD_SET_TYPEMATIC: // Same code as PS2_MOUSE_SET_SAMPLE_RATE
+                // A combo device can't tell which one the host meant, so both take it
+                if (deviceType == DeviceType::PS2_MOUSE || deviceType == DeviceType::PS2_COMBO) {
+                    mouseSampleRate = data;
+                    SQUID_LOG_DEBUG(PS2_TAG, "Host set sample rate: %d", data);
+                }
+                if (deviceType == DeviceType::PS2_KEYBOARD || deviceType == DeviceType::PS2_COMBO) {
+                    typematicRate = data & 0x7F;
+                    SQUID_LOG_DEBUG(PS2_TAG, "Host set typematic rate/delay: 0x%02X", typematicRate);
+                }
+                ps2Write(PS2Responses::ACK, false);
+                return;
+                
+            case PS2Commands::PS2_KEYBOARD_SET_SCANCODE:
+                ps2Write(PS2Responses::ACK, false);
+                if (data == 0x00) {
+                    ps2Write(scancodeSet, false); // Host is asking which set we're using
+                } else {
+                    scancodeSet = data;
+                }
+                return;
+                
+            case PS2Commands::PS2_MOUSE_SET_RESOLUTION:
+                mouseResolution = data;
+                ps2Write(PS2Responses::ACK, false);
+                return;
+                
+            default:
+                break;
+        }
+    }
+    
+    SQUID_LOG_DEBUG(PS2_TAG, "Processing PS/2 command: 0x%02X", data);
+    
+    switch (data) {
+        case PS2Commands::PS2_KEYBOARD_SET_LEDS:
+        case PS2Commands::PS2_KEYBOARD_SET_TYPEMATIC:
+        case PS2Commands::PS2_KEYBOARD_SET_SCANCODE:
+        case PS2Commands::PS2_MOUSE_SET_RESOLUTION:
+            // ACK the command now, argument byte comes through on a later pass
+            lastCommand = data;
+            ps2Write(PS2Responses::ACK, false);
+            break;
+            
+        case PS2Commands::PS2_KEYBOARD_RESEND:
+            ps2Write(lastSent, false);
             break;
             
         case PS2Commands::PS2_KEYBOARD_ECHO:
-            ps2Write(PS2Responses::ECHO_RESPONSE);
+            ps2Write(PS2Responses::ECHO_RESPONSE, false);
             break;
             
         case PS2Commands::PS2_KEYBOARD_ENABLE:
             mouseEnabled = true;
             keyboardEnabled = true;
-            ps2Write(PS2Responses::ACK);
+            ps2Write(PS2Responses::ACK, false);
             break;
             
         case PS2Commands::PS2_KEYBOARD_DISABLE:
             keyboardEnabled = false;
             mouseEnabled = false;
-            ps2Write(PS2Responses::ACK);
+            ps2Write(PS2Responses::ACK, false);
+            break;
+            
+        case PS2Commands::PS2_KEYBOARD_RESET:
+            ps2Write(PS2Responses::ACK, false);
+            ps2Write(PS2Responses::SELF_TEST_PASSED, false);
+            if (deviceType == DeviceType::PS2_MOUSE) {
+                ps2Write(0x00, false); // Device ID
+            }
             break;
             
         default:
             // Unknown command - send ACK anyway because why not
-            ps2Write(PS2Responses::ACK);
-            SQUID_LOG_DEBUG(PS2_TAG, "Unknown PS/2 command: 0x%02X", command);
+            ps2Write(PS2Responses::ACK, false);
+            SQUID_LOG_DEBUG(PS2_TAG, "Unknown PS/2 command: 0x%02X", data);
             break;
     }
 }
@@ -829,10 +910,8 @@ void PS2Transport::setLEDs(bool scrollLock, bool numLock, bool capsLock) {
     if (numLock)    ledState |= 0x02;
     if (capsLock)   ledState |= 0x04;
     
-    ps2Write(PS2Commands::PS2_KEYBOARD_SET_LEDS);
-    if (ps2WaitForAck()) {
+    if (ps2Write(PS2Commands::PS2_KEYBOARD_SET_LEDS)) {
         ps2Write(ledState);
-        ps2WaitForAck();
         keyboardLEDs = ledState;
     }
 }
@@ -843,9 +922,7 @@ void PS2Transport::setMouseSampleRate(uint8_t rate) {
     mouseSampleRate = rate;
     if (initialized) {
         ps2Write(PS2Commands::PS2_MOUSE_SET_SAMPLE_RATE);
-        ps2WaitForAck();
         ps2Write(rate);
-        ps2WaitForAck();
     }
 }
 
@@ -855,8 +932,18 @@ void PS2Transport::setMouseResolution(uint8_t resolution) {
     mouseResolution = resolution;
     if (initialized) {
         ps2Write(PS2Commands::PS2_MOUSE_SET_RESOLUTION);
-        ps2WaitForAck();
         ps2Write(resolution);
-        ps2WaitForAck();
     }
 }
+
+uint32_t PS2Transport::getRxOverflowCount() {
+    return ps2Rx.overflows();
+}
+
+uint32_t PS2Transport::getRxParityErrorCount() {
+    return ps2Rx.parityErrors();
+}
+
+void PS2Transport::resetRxCounters() {
+    ps2Rx.resetCounters();
+}
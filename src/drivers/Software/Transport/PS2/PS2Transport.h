@@ -48,12 +48,15 @@ private:
     
     // PS/2 protocol state
     bool inhibitCommunication;
-    uint8_t lastCommand;
-    uint8_t responseBuffer[16];
+    uint8_t lastCommand;      // Host command waiting for its argument byte (0 = none)
+    uint8_t lastSent;         // Last byte we sent, replayed when the host asks for a resend
+    uint8_t responseBuffer[16]; // Bytes pulled off the ring while waiting for an ACK
     uint8_t responseIndex;
     
     // Keyboard state
     uint8_t keyboardLEDs;
+    uint8_t typematicRate;
+    uint8_t scancodeSet;
     bool keyboardEnabled;
     
     // Mouse state  
@@ -78,13 +81,15 @@ private:
     size_t reportMapLength;
     
     // PS/2 protocol methods
-    void ps2Write(uint8_t data);
+    bool ps2Write(uint8_t data, bool waitForAck = true);
+    bool ps2Available();
     uint8_t ps2Read();
+    bool ps2WaitForByte(uint8_t expected, uint32_t timeoutMs);
     bool ps2WaitForAck();
     void ps2Reset();
     void ps2KeyboardInit();
     void ps2MouseInit();
-    void processPS2Command(uint8_t command);
+    void processPS2Command(uint8_t data);
     
     // HID to PS/2 conversion
     void sendKeyboardReportPS2(const uint8_t* hidReport);
@@ -129,8 +134,10 @@ public:
     void setCallbacks(TransportCallbacks* callbacks) override;
     
     void setReportMap(const uint8_t* descriptor, size_t length) override;
+    bool reloadReportMap() override { return true; } // PS/2 doesn't use the report map
     
     bool supportsHID() override { return true; }
+    uint32_t getReportInterval() override { return 1000000 / (mouseSampleRate ? mouseSampleRate : 100); }
     
     // PS/2 specific methods
     void setPins(int clockPin, int dataPin);
@@ -143,6 +150,11 @@ public:
     // Mouse configuration
     void setMouseSampleRate(uint8_t rate);
     void setMouseResolution(uint8_t resolution);
+    
+    // RX ring diagnostics
+    uint32_t getRxOverflowCount();
+    uint32_t getRxParityErrorCount();
+    void resetRxCounters();
 };
 
 #endif
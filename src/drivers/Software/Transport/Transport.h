@@ -34,6 +34,9 @@ public:
     virtual void onConnect() = 0;
     virtual void onDisconnect() = 0;
     virtual void onDataReceived(const uint8_t* data, size_t length) = 0;
+    
+    // HID output reports with the report ID split out (the data doesn't include it)
+    virtual void onOutputReport(uint8_t reportId, const uint8_t* data, size_t length) { onDataReceived(data, length); }
 };
 
 class Transport {
@@ -65,8 +68,19 @@ public:
     // HID descriptor management
     virtual void setReportMap(const uint8_t* descriptor, size_t length) = 0;
     
+    // Re-advertise/re-enumerate after the report map changes at runtime
+    // Returns false if the transport can't do that without a reboot
+    virtual bool reloadReportMap() { return false; }
+    
     // Service availability
     virtual bool supportsHID() = 0;
+    
+    // Roughly how often the host picks up a report, in us - anything sent faster just queues up
+    virtual uint32_t getReportInterval() { return 8000; }
+    
+    // Feature reports just sit there until the host asks for them, this sets what it gets back
+    // Returns false if the transport has nowhere to put them
+    virtual bool setFeatureReport(uint8_t reportId, const uint8_t* data, size_t length) { return false; }
 };
 
 #endif
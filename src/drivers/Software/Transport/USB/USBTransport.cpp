@@ -168,6 +168,13 @@ bool USBTransport::sendData(const uint8_t* data, size_t length) {
     return sendReport(0, data, length);
 }
 
+bool USBTransport::setFeatureReport(uint8_t reportId, const uint8_t* data, size_t length) {
+    if (!data) return false;
+    featureReports[reportId].assign(data, data + length);
+    SQUID_LOG_DEBUG(USB_TAG, "Feature report 0x%02X set: %zu bytes", reportId, length);
+    return true;
+}
+
 #if __has_include("USBHIDVendor.h")
 
 // USBHIDDevice interface implementation
@@ -182,8 +189,28 @@ uint16_t USBTransport::_onGetDescriptor(uint8_t* buffer) {
 void USBTransport::_onOutput(uint8_t report_id, const uint8_t* buffer, uint16_t len) {
     // Handle HID output reports (like LED status, haptics, other things I haven't properly implemented)
     if (callbacks) {
-        callbacks->onDataReceived(buffer, len);
+        callbacks->onOutputReport(report_id, buffer, len);
+    }
+}
+
+uint16_t USBTransport::_onGetFeature(uint8_t report_id, uint8_t* buffer, uint16_t len) {
+    auto it = featureReports.find(report_id);
+    if (it == featureReports.end()) {
+        SQUID_LOG_DEBUG(USB_TAG, "Host asked for feature report 0x%02X, nothing set", report_id);
+        return 0;
+    }
+    uint16_t n = it->second.size() < len ? it->second.size() : len;
+    memcpy(buffer, it->second.data(), n);
+    return n;
+}
+
+void USBTransport::_onSetFeature(uint8_t report_id, const uint8_t* buffer, uint16_t len) {
+    // Things like the touchpad input mode - kept so the host reads back what it wrote
+    auto it = featureReports.find(report_id);
+    if (it != featureReports.end()) {
+        it->second.assign(buffer, buffer + len);
     }
+    SQUID_LOG_DEBUG(USB_TAG, "Host set feature report 0x%02X: %u bytes", report_id, len);
 }
 
 #endif
@@ -42,6 +42,7 @@ private:
     #endif
     const uint8_t* reportMap;
     size_t reportMapLength;
+    std::map<uint8_t, std::vector<uint8_t>> featureReports;  // Answered straight from here on a GET_REPORT
     
     bool initialized;
     bool connected;
@@ -70,11 +71,15 @@ public:
     void setReportMap(const uint8_t* descriptor, size_t length) override;
 
     bool supportsHID() override { return true; }
+    uint32_t getReportInterval() override { return 1000; }  // Full speed interrupt endpoint, polled every frame
+    bool setFeatureReport(uint8_t reportId, const uint8_t* data, size_t length) override;
 
     #if __has_include("USBHIDVendor.h")
     // USBHIDDevice interface
     uint16_t _onGetDescriptor(uint8_t* buffer) override;
     void _onOutput(uint8_t report_id, const uint8_t* buffer, uint16_t len) override;
+    uint16_t _onGetFeature(uint8_t report_id, uint8_t* buffer, uint16_t len) override;
+    void _onSetFeature(uint8_t report_id, const uint8_t* buffer, uint16_t len) override;
     #endif
 };
 
@@ -5,11 +5,19 @@
 
 #include "Digitizer.h"
 
-#if !SPACEMOUSE_ENABLE
+bool SQUIDTABLET::isConnected() {
+    return transport ? transport->isConnected() : false;
+}
+
+void SQUIDTABLET::onConnect() {
+    SQUID_LOG_DEBUG(DIGI_TAG, "Digitizer connected");
+}
+
+#if !DIGITIZER_TOUCHPAD
 
 SQUIDTABLET::SQUIDTABLET() 
     : transport(nullptr), _delay_ms(7), 
-      _screenWidth(1920), _screenHeight(1080) {
+      _screenWidth(1920), _screenHeight(1080), _stroking(false), _lastReport(0) {
     memset(&_digitizerReport, 0, sizeof(_digitizerReport));
 }
 
@@ -18,21 +26,17 @@ void SQUIDTABLET::begin(Transport* trans, uint32_t delay_ms) {
     _delay_ms = delay_ms;
     _screenWidth = 1920;
     _screenHeight = 1080;
+    _stroke.setRange(_screenWidth, _screenHeight);
+    _stroking = false;
     memset(&_digitizerReport, 0, sizeof(_digitizerReport));
     
     SQUID_LOG_DEBUG(DIGI_TAG, "Digitizer subsystem initialized with delay: %lu ms", delay_ms);
     SQUID_LOG_INFO(DIGI_TAG, "Digitizer service ready");
 }
 
-bool SQUIDTABLET::isConnected() {
-    return transport ? transport->isConnected() : false;
-}
-
-void SQUIDTABLET::onConnect() {
-    SQUID_LOG_DEBUG(DIGI_TAG, "Digitizer connected");
-}
-
 void SQUIDTABLET::onDisconnect() {
+    // A half-drawn stroke would carry on from wherever the pen is after reconnecting
+    _stroking = false;
     SQUID_LOG_DEBUG(DIGI_TAG, "Digitizer disconnected");
 }
 
@@ -42,7 +46,7 @@ void SQUIDTABLET::click(uint16_t x, uint16_t y, DigitizerKey b) {
     
     SQUID_LOG_DEBUG(DIGI_TAG, "Digitizer click at X:%u, Y:%u, buttons: 0x%02X", x, y, digitizerButtons);
     
-    moveTo(x, y, 127, b); // Press with pressure
+    moveTo(x, y, 0xFFFF, b); // Full pressure, whatever range it was set to
     delay(_delay_ms);
     moveTo(x, y, 0, DigitizerKey{0});   // Release
     
@@ -54,33 +58,46 @@ void SQUIDTABLET::setDigitizerRange(uint16_t maxX, uint16_t maxY) {
     
     _screenWidth = maxX;
     _screenHeight = maxY;
+    _stroke.setRange(maxX, maxY);  // Scale factors get worked out once here instead of divided out per sample
 
     SQUID_LOG_INFO(DIGI_TAG, "Digitizer range set to X:%u, Y:%u", _screenWidth, _screenHeight);
 }
 
-void SQUIDTABLET::moveTo(uint16_t x, uint16_t y, uint8_t pressure, DigitizerKey buttons) {
+void SQUIDTABLET::setPressureRange(uint16_t maxPressure) {
+    _stroke.setPressureRange(maxPressure);
+    SQUID_LOG_INFO(DIGI_TAG, "Digitizer pressure range set to 0-%u", maxPressure);
+}
+
+void SQUIDTABLET::fillReport(const StrokePoint& point, uint8_t buttons, bool touching) {
+    _digitizerReport.buttons = buttons & 0x07;  // Mask to 3 bits
+    _digitizerReport.x = point.x;
+    _digitizerReport.y = point.y;
+    _digitizerReport.pressure = touching ? point.pressure : 0;
+    
+    // Set flags: ALWAYS report In Range when active
+    _digitizerReport.flags = DIGITIZER_FLAG_IN_RANGE;
+    // Tip Switch = ON when pressure > 0 (touching), OFF when hovering
+    if (touching && point.pressure > 0) {
+        _digitizerReport.flags |= DIGITIZER_FLAG_TIP_SWITCH;
+    }
+}
+
+bool SQUIDTABLET::sendNow() {
+    return transport->sendReport(DIGITIZER_ID, (uint8_t*)&_digitizerReport, sizeof(_digitizerReport));
+}
+
+void SQUIDTABLET::moveTo(uint16_t x, uint16_t y, uint16_t pressure, DigitizerKey buttons) {
     if (isConnected() && transport) {
-        // Scale to HID descriptor's 0-32767 range
-        uint16_t scaledX = (x * 32767ULL) / _screenWidth;
-        uint16_t scaledY = (y * 32767ULL) / _screenHeight;
-        
+        StrokePoint point = _stroke.scale(x, y, pressure);
         uint8_t buttonValue = static_cast<uint8_t>(buttons);
-        _digitizerReport.buttons = buttonValue & 0x07;  // Mask to 3 bits
-        _digitizerReport.x = scaledX;
-        _digitizerReport.y = scaledY;
-        _digitizerReport.pressure = (pressure > 127) ? 127 : pressure;
-        
-        // Set flags: ALWAYS report In Range when active
-        _digitizerReport.flags = DIGITIZER_FLAG_IN_RANGE;
-        // Tip Switch = ON when pressure > 0 (touching), OFF when hovering
-        if (pressure > 0) {
-            _digitizerReport.flags |= DIGITIZER_FLAG_TIP_SWITCH;
-        }
+        fillReport(point, buttonValue, true);
         
-        SQUID_LOG_DEBUG(DIGI_TAG, "Digitizer move - X:%u->%u, Y:%u->%u, Pressure:%u, Buttons:0x%02X, Flags:0x%02X",
-                     x, scaledX, y, scaledY, pressure, buttonValue, _digitizerReport.flags);
+        SQUID_LOG_DEBUG(DIGI_TAG, "Digitizer move - X:%u->%u, Y:%u->%u, Pressure:%u->%u, Buttons:0x%02X, Flags:0x%02X",
+                     x, point.x, y, point.y, pressure, point.pressure, buttonValue, _digitizerReport.flags);
         
-        sendDigitizerReport();
+        if (!sendNow()) {
+            SQUID_LOG_ERROR(DIGI_TAG, "Failed to send digitizer report via transport");
+        }
     } else {
         SQUID_LOG_DEBUG(DIGI_TAG, "Digitizer movement ignored - %s%s", 
                      !isConnected() ? "not connected" : "",
@@ -90,17 +107,58 @@ void SQUIDTABLET::moveTo(uint16_t x, uint16_t y, uint8_t pressure, DigitizerKey
 
 void SQUIDTABLET::beginStroke(uint16_t x, uint16_t y, uint16_t initialPressure) {
     SQUID_LOG_DEBUG(DIGI_TAG, "Beginning stroke at X:%u, Y:%u, initial pressure:%u", x, y, initialPressure);
-    moveTo(x, y, initialPressure, DigitizerKey{0});
+    uint32_t nowUs = micros();
+    _stroke.begin(x, y, initialPressure, nowUs);
+    _stroking = true;
+    
+    // Pen down goes out straight away, the rest of the stroke follows at the report rate
+    if (isConnected() && transport) {
+        fillReport(_stroke.latest(), 0, true);
+        sendNow();
+        _lastReport = nowUs;
+    }
 }
 
 void SQUIDTABLET::updateStroke(uint16_t x, uint16_t y, uint16_t pressure) {
-    SQUID_LOG_DEBUG(DIGI_TAG, "Updating stroke at X:%u, Y:%u, pressure:%u", x, y, pressure);
-    moveTo(x, y, pressure, DigitizerKey{0});
+    if (!_stroking) {
+        beginStroke(x, y, pressure);
+        return;
+    }
+    _stroke.add(x, y, pressure, micros());
 }
 
 void SQUIDTABLET::endStroke(uint16_t x, uint16_t y) {
     SQUID_LOG_DEBUG(DIGI_TAG, "Ending stroke at X:%u, Y:%u", x, y);
-    moveTo(x, y, 0, DigitizerKey{0});
+    _stroking = false;
+    if (!isConnected() || !transport) return;
+    
+    // Finish the line at the end point before lifting, so nothing still waiting in the pipeline gets cut off
+    StrokePoint end = _stroke.scale(x, y, 0);
+    StrokePoint pen = _stroke.latest();
+    end.pressure = pen.pressure;
+    if (end.pressure && (end.x != _digitizerReport.x || end.y != _digitizerReport.y)) {
+        fillReport(end, 0, true);
+        sendNow();
+    }
+    fillReport(end, 0, false);
+    sendNow();
+    _lastReport = micros();
+}
+
+void SQUIDTABLET::update(uint32_t nowUs) {
+    if (!_stroking || !transport) return;
+    if (nowUs - _lastReport < transport->getReportInterval()) return;
+    
+    // Only goes out if the pen actually moved, a still pen doesn't need to keep the link busy
+    StrokePoint point;
+    if (!_stroke.render(nowUs, point)) return;
+    if (!isConnected()) return;
+    
+    fillReport(point, 0, true);
+    _lastReport = nowUs;
+    if (!sendNow()) {
+        SQUID_LOG_DEBUG(DIGI_TAG, "Digitizer report didn't go out, the next one carries on from there");
+    }
 }
 
 void SQUIDTABLET::sendDigitizerReport() {
@@ -109,8 +167,7 @@ void SQUIDTABLET::sendDigitizerReport() {
         return;
     }
     
-    bool result = transport->sendReport(DIGITIZER_ID, (uint8_t*)&_digitizerReport, sizeof(_digitizerReport));
-    if (!result) {
+    if (!sendNow()) {
         SQUID_LOG_ERROR(DIGI_TAG, "Failed to send digitizer report via transport");
     } else {
         SQUID_LOG_DEBUG(DIGI_TAG, "Digitizer report sent successfully");
@@ -119,4 +176,75 @@ void SQUIDTABLET::sendDigitizerReport() {
     delay(_delay_ms);
 }
 
+#else
+
+SQUIDTABLET::SQUIDTABLET() 
+    : transport(nullptr), _delay_ms(7), _touchButtons(0), _padType(TOUCHPAD_CLICKPAD) {
+}
+
+void SQUIDTABLET::begin(Transport* trans, uint32_t delay_ms) {
+    transport = trans;
+    _delay_ms = delay_ms;
+    _tracker.reset();
+    _touchButtons = 0;
+    publishFeatures();
+    
+    SQUID_LOG_DEBUG(DIGI_TAG, "Touchpad initialized - %u contacts, %u per report", TOUCH_MAX_CONTACTS, TOUCHPAD_REPORT_CONTACTS);
+    SQUID_LOG_INFO(DIGI_TAG, "Touchpad service ready");
+}
+
+void SQUIDTABLET::publishFeatures() {
+    if (!transport) return;
+    
+    uint8_t caps = (TOUCH_MAX_CONTACTS & 0x0F) | (_padType << 4);
+    uint8_t mode = 0x00;      // Mouse until the host says otherwise
+    uint8_t switches = 0x03;  // Surface and button both on
+    
+    if (!transport->setFeatureReport(TOUCHPAD_CAPS_ID, &caps, 1)) {
+        SQUID_LOG_WARN(DIGI_TAG, "Transport can't hold feature reports, hosts won't see this as a touchpad");
+        return;
+    }
+    transport->setFeatureReport(TOUCHPAD_MODE_ID, &mode, 1);
+    transport->setFeatureReport(TOUCHPAD_SWITCH_ID, &switches, 1);
+}
+
+void SQUIDTABLET::onDisconnect() {
+    // Fingers that were down when the link went are gone as far as the host's concerned
+    _tracker.reset();
+    _touchButtons = 0;
+    SQUID_LOG_DEBUG(DIGI_TAG, "Touchpad disconnected");
+}
+
+void SQUIDTABLET::setPadType(TouchpadType type) {
+    _padType = type;
+    publishFeatures();
+}
+
+bool SQUIDTABLET::setCertificationBlob(const uint8_t* blob, size_t length) {
+    if (!transport || !blob || length != TOUCHPAD_CERT_SIZE) {
+        SQUID_LOG_ERROR(DIGI_TAG, "Certification blob has to be %u bytes", TOUCHPAD_CERT_SIZE);
+        return false;
+    }
+    return transport->setFeatureReport(TOUCHPAD_CERT_ID, blob, length);
+}
+
+void SQUIDTABLET::touchFrame(const TouchPoint* points, uint8_t count, bool button) {
+    uint8_t buttons = button ? 0x01 : 0x00;
+    uint8_t n = _tracker.update(points, count, _contacts);
+    
+    // Nothing on the pad and nothing clicked - the lift-off frame already told the host, no need to keep saying it
+    if (!n && buttons == _touchButtons) return;
+    _touchButtons = buttons;
+    if (!isConnected()) return;
+    
+    uint16_t scanTime = (uint16_t)(micros() / 100);
+    uint8_t reports = packTouchpadReports(_contacts, n, scanTime, buttons, _reports);
+    for (uint8_t r = 0; r < reports; r++) {
+        if (!transport->sendReport(DIGITIZER_ID, (uint8_t*)&_reports[r], sizeof(TouchpadReport))) {
+            SQUID_LOG_DEBUG(DIGI_TAG, "Touchpad report didn't go out, the next frame carries on from there");
+            return;
+        }
+    }
+}
+
 #endif
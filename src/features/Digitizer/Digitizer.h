@@ -1,24 +1,25 @@
 /**
  * @file Digitizer.h
- * @brief Touch digitizer with pressure sensitivity, tip switch, and barrel
+ * @brief Touch digitizer with pressure sensitivity, tip switch, and barrel - or a multi-touch Precision Touchpad
  */
  
 #ifndef DIGITIZER_H
 #define DIGITIZER_H
 
-#if !SPACEMOUSE_ENABLE
-
 #include "drivers/Software/Transport/Transport.h"
 
-typedef struct {
+#if !DIGITIZER_TOUCHPAD
+#include "drivers/Software/Motion/StrokePipeline.h"
+
+typedef struct PACKED {
     uint8_t buttons;
     uint8_t flags;     // In range, tip switch, etc.
     uint16_t x;
     uint16_t y;
-    uint8_t pressure;  // 0-127 for Android compatibility
+    uint16_t pressure; // 0-32767, whatever range it came in at gets scaled up to this
 } DigitizerReport;
 
-static const uint8_t _digitizerReportDescriptor[] = {               
+static constexpr uint8_t _digitizerReportDescriptor[] = {               
   // ------------------------------------------------- Pointers - Absolute/Digitizer
   USAGE_PAGE(1),      0x0D,                      USAGE(1),           0x01,              
   COLLECTION(1),      0x01,                      REPORT_ID(1),       DIGITIZER_ID,      
@@ -47,12 +48,126 @@ static const uint8_t _digitizerReportDescriptor[] = {
   REPORT_COUNT(1),    0x02,                      HIDINPUT(1),        0x02,              
   // Pressure
   USAGE_PAGE(1),      0x0D,                      USAGE(1),           0x30,              
-  LOGICAL_MINIMUM(1), 0x00,                      LOGICAL_MAXIMUM(1), 0x7F,              
-  REPORT_SIZE(1),     0x08,                      REPORT_COUNT(1),    0x01,              
+  LOGICAL_MINIMUM(1), 0x00,                      LOGICAL_MAXIMUM(2), 0xFF, 0x7F,        
+  REPORT_SIZE(1),     0x10,                      REPORT_COUNT(1),    0x01,              
   HIDINPUT(1),        0x02,                      END_COLLECTION(0),                       
   END_COLLECTION(0),   
 };
 
+#else
+#include "drivers/Software/Touch/ContactTracker.h"
+#include "drivers/Software/Touch/TouchpadReport.h"
+
+// Logical range the sensor's coordinates get reported in
+#ifndef TOUCHPAD_MAX_X
+#define TOUCHPAD_MAX_X   4000
+#endif
+#ifndef TOUCHPAD_MAX_Y
+#define TOUCHPAD_MAX_Y   2600
+#endif
+// Physical size in 0.1mm - Windows works out the resolution from these and wants at least 300dpi
+#ifndef TOUCHPAD_WIDTH
+#define TOUCHPAD_WIDTH   1000
+#endif
+#ifndef TOUCHPAD_HEIGHT
+#define TOUCHPAD_HEIGHT  650
+#endif
+
+#define TOUCHPAD_LO(v) ((v) & 0xFF)
+#define TOUCHPAD_HI(v) (((v) >> 8) & 0xFF)
+
+// One finger, 51 bytes of descriptor - PUSH/POP keeps the X/Y units from leaking into the next one
+#define TOUCHPAD_FINGER \
+  USAGE(1),           0x22,                      COLLECTION(1),      0x02,              \
+  USAGE(1),           0x47,                      USAGE(1),           0x42,              \
+  HIDINPUT(1),        0x02,                      PUSH(0),                               \
+  REPORT_COUNT(1),    0x01,                      REPORT_SIZE(1),     0x06,              \
+  LOGICAL_MAXIMUM(1), 0x3F,                      USAGE(1),           0x51,              \
+  HIDINPUT(1),        0x02,                      USAGE_PAGE(1),      0x01,              \
+  REPORT_SIZE(1),     0x10,                      UNIT_EXPONENT(1),   0x0E,              \
+  UNIT(1),            0x11,                                                             \
+  LOGICAL_MAXIMUM(2), TOUCHPAD_LO(TOUCHPAD_MAX_X), TOUCHPAD_HI(TOUCHPAD_MAX_X),         \
+  PHYSICAL_MAXIMUM(2), TOUCHPAD_LO(TOUCHPAD_WIDTH), TOUCHPAD_HI(TOUCHPAD_WIDTH),        \
+  USAGE(1),           0x30,                      HIDINPUT(1),        0x02,              \
+  LOGICAL_MAXIMUM(2), TOUCHPAD_LO(TOUCHPAD_MAX_Y), TOUCHPAD_HI(TOUCHPAD_MAX_Y),         \
+  PHYSICAL_MAXIMUM(2), TOUCHPAD_LO(TOUCHPAD_HEIGHT), TOUCHPAD_HI(TOUCHPAD_HEIGHT),      \
+  USAGE(1),           0x31,                      HIDINPUT(1),        0x02,              \
+  POP(0),                                        END_COLLECTION(0)
+
+static constexpr uint8_t _digitizerReportDescriptor[] = {
+  // ------------------------------------------------- Pointers - Precision Touchpad
+  USAGE_PAGE(1),      0x0D,                      USAGE(1),           0x05,              
+  COLLECTION(1),      0x01,                      REPORT_ID(1),       DIGITIZER_ID,      
+  // Whatever came before might have left units set, and every finger starts from here
+  LOGICAL_MINIMUM(1), 0x00,                      LOGICAL_MAXIMUM(1), 0x01,              
+  PHYSICAL_MAXIMUM(1), 0x00,                     UNIT(1),            0x00,              
+  UNIT_EXPONENT(1),   0x00,                      REPORT_SIZE(1),     0x01,              
+  REPORT_COUNT(1),    0x02,              
+  TOUCHPAD_FINGER,
+#if TOUCHPAD_REPORT_CONTACTS >= 2
+  TOUCHPAD_FINGER,
+#endif
+#if TOUCHPAD_REPORT_CONTACTS >= 3
+  TOUCHPAD_FINGER,
+#endif
+#if TOUCHPAD_REPORT_CONTACTS >= 4
+  TOUCHPAD_FINGER,
+#endif
+#if TOUCHPAD_REPORT_CONTACTS >= 5
+  TOUCHPAD_FINGER,
+#endif
+  // Scan time, 100us units
+  UNIT_EXPONENT(1),   0x0C,                      UNIT(2),            0x01, 0x10,        
+  LOGICAL_MAXIMUM(4), 0xFF, 0xFF, 0x00, 0x00,    REPORT_SIZE(1),     0x10,              
+  REPORT_COUNT(1),    0x01,                      USAGE(1),           0x56,              
+  HIDINPUT(1),        0x02,              
+  // Contact count
+  UNIT_EXPONENT(1),   0x00,                      UNIT(1),            0x00,              
+  LOGICAL_MAXIMUM(1), 0x7F,                      REPORT_SIZE(1),     0x08,              
+  USAGE(1),           0x54,                      HIDINPUT(1),        0x02,              
+  // Button under the pad, then 7 bits of padding
+  USAGE_PAGE(1),      0x09,                      USAGE(1),           0x01,              
+  LOGICAL_MAXIMUM(1), 0x01,                      REPORT_SIZE(1),     0x01,              
+  HIDINPUT(1),        0x02,                      REPORT_SIZE(1),     0x07,              
+  HIDINPUT(1),        0x01,              
+  // Feature: max contacts and pad type, 4 bits each
+  REPORT_ID(1),       TOUCHPAD_CAPS_ID,          USAGE_PAGE(1),      0x0D,              
+  USAGE(1),           0x55,                      USAGE(1),           0x59,              
+  LOGICAL_MAXIMUM(1), 0x0F,                      REPORT_SIZE(1),     0x04,              
+  REPORT_COUNT(1),    0x02,                      FEATURE(1),         0x02,              
+  // Feature: 256 byte certification blob from Microsoft
+  REPORT_ID(1),       TOUCHPAD_CERT_ID,          USAGE_PAGE(2),      0x00, 0xFF,        
+  USAGE(1),           0xC5,                      LOGICAL_MAXIMUM(2), 0xFF, 0x00,        
+  REPORT_SIZE(1),     0x08,                      REPORT_COUNT(2),    0x00, 0x01,        
+  FEATURE(1),         0x02,                      END_COLLECTION(0),                     
+  // ------------------------------------------------- Touchpad configuration
+  USAGE_PAGE(1),      0x0D,                      USAGE(1),           0x0E,              
+  COLLECTION(1),      0x01,                      REPORT_ID(1),       TOUCHPAD_MODE_ID,  
+  USAGE(1),           0x22,                      COLLECTION(1),      0x02,              
+  // Input mode - 0 mouse, 3 touchpad
+  USAGE(1),           0x52,                      LOGICAL_MAXIMUM(1), 0x0A,              
+  REPORT_SIZE(1),     0x08,                      REPORT_COUNT(1),    0x01,              
+  FEATURE(1),         0x02,                      END_COLLECTION(0),                     
+  USAGE(1),           0x22,                      COLLECTION(1),      0x00,              
+  // Surface and button switches, then padding
+  REPORT_ID(1),       TOUCHPAD_SWITCH_ID,        USAGE(1),           0x57,              
+  USAGE(1),           0x58,                      LOGICAL_MAXIMUM(1), 0x01,              
+  REPORT_SIZE(1),     0x01,                      REPORT_COUNT(1),    0x02,              
+  FEATURE(1),         0x02,                      REPORT_COUNT(1),    0x06,              
+  FEATURE(1),         0x03,                      END_COLLECTION(0),                     
+  END_COLLECTION(0),   
+};
+
+// What the caps feature says sits under the surface
+enum TouchpadType : uint8_t {
+  TOUCHPAD_CLICKPAD  = 0,  // The whole pad clicks down, button 1 in the report
+  TOUCHPAD_PRESSURE  = 1,
+  TOUCHPAD_NO_BUTTON = 2
+};
+
+#define TOUCHPAD_CERT_SIZE 256
+#endif
+
 // Button bitmask constants
 enum class DigitizerKeys : uint8_t {
   DIGITIZER_BTN1 = 0x01, // Button 1 (tip button, if present)
@@ -74,20 +189,42 @@ MK(DigitizerAnalogue, DI_AX, DIGITIZER_X_AXIS);
 MK(DigitizerAnalogue, DI_AY, DIGITIZER_Y_AXIS);
 MK(DigitizerAnalogue, DI_AZ, DIGITIZER_Z_AXIS);
 
+#if !DIGITIZER_TOUCHPAD
 // Flag constants (internal, for 'flags' field)
 const uint8_t DIGITIZER_FLAG_IN_RANGE     = 0x01;  // Bit 0
 const uint8_t DIGITIZER_FLAG_TIP_SWITCH   = 0x02;  // Bit 1
 const uint8_t DIGITIZER_FLAG_INVERT       = 0x04;  // Bit 2 (eraser)
 const uint8_t DIGITIZER_FLAG_BARREL_SW    = 0x08;  // Bit 3
+#endif
 
 class SQUIDTABLET {
 private:
     Transport*            transport; 
-    DigitizerReport       _digitizerReport;
     uint32_t              _delay_ms;
+    
+    #if !DIGITIZER_TOUCHPAD
+    DigitizerReport       _digitizerReport;
     uint16_t              _screenWidth;
     uint16_t              _screenHeight;
     
+    // Strokes get scaled and smoothed here, update() sends them at the transport's report rate
+    StrokePipeline        _stroke;
+    bool                  _stroking;
+    uint32_t              _lastReport;
+    
+    void fillReport(const StrokePoint& point, uint8_t buttons, bool touching);
+    bool sendNow();
+    #else
+    // All fixed size, a frame never allocates
+    ContactTracker        _tracker;
+    TouchContact          _contacts[TOUCH_MAX_CONTACTS];
+    TouchpadReport        _reports[TOUCHPAD_MAX_REPORTS];
+    uint8_t               _touchButtons;
+    TouchpadType          _padType;
+    
+    void publishFeatures();
+    #endif
+    
 public:
     SQUIDTABLET();
     
@@ -96,14 +233,27 @@ public:
     void onConnect();
     void onDisconnect();
     
+    #if !DIGITIZER_TOUCHPAD
     // Digitizer methods
     void click(uint16_t x, uint16_t y, DigitizerKey b = DI_BTN1);  // 1 = MOUSE_LEFT equivalent
-    void moveTo(uint16_t x, uint16_t y, uint8_t pressure = 0, DigitizerKey buttons = DigitizerKey{0});
+    void moveTo(uint16_t x, uint16_t y, uint16_t pressure = 0, DigitizerKey buttons = DigitizerKey{0});
+    // Strokes don't send straight away - samples can come in at any rate, update() draws them out at the report rate
     void beginStroke(uint16_t x, uint16_t y, uint16_t initialPressure = 127);
     void updateStroke(uint16_t x, uint16_t y, uint16_t pressure);
     void endStroke(uint16_t x, uint16_t y);
     void setDigitizerRange(uint16_t maxX, uint16_t maxY);
+    void setPressureRange(uint16_t maxPressure);  // What full pressure is on the way in, 127 unless you change it
+    StrokePipeline& stroke() { return _stroke; }  // Smoothing and input rate
     void sendDigitizerReport();
+    void update(uint32_t nowUs);
+    #else
+    // Touchpad methods
+    // One sensor scan, points in 0..TOUCHPAD_MAX_X/Y in any order - IDs, lift-offs and hybrid reports are handled here
+    void touchFrame(const TouchPoint* points, uint8_t count, bool button = false);
+    void setPadType(TouchpadType type);
+    // Windows only treats it as a Precision Touchpad with a blob from Microsoft's certification, it's not something this library can ship
+    bool setCertificationBlob(const uint8_t* blob, size_t length = TOUCHPAD_CERT_SIZE);
+    ContactTracker& tracker() { return _tracker; }  // Match distance
+    #endif
 };
 #endif
-#endif
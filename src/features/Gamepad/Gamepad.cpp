@@ -5,12 +5,11 @@
 
 #include "Gamepad.h"
 
-#if !SPACEMOUSE_ENABLE
-
 SQUIDGAMEPAD::SQUIDGAMEPAD() 
-    : transport(nullptr), _delay_ms(7) {
+    : transport(nullptr), _delay_ms(7), _pollInterval(0), _lastReport(0) {
     memset(&_gamepadReport, 0, sizeof(_gamepadReport));
     _gamepadReport.hat = static_cast<int8_t>(HAT_CE);
+    _sentReport = _gamepadReport;
     
     SQUID_LOG_DEBUG(GAMEPAD_TAG, "Gamepad instance created");
 }
@@ -20,6 +19,8 @@ void SQUIDGAMEPAD::begin(Transport* trans, uint32_t delay_ms) {
     _delay_ms = delay_ms;
     memset(&_gamepadReport, 0, sizeof(_gamepadReport));
     _gamepadReport.hat = static_cast<int8_t>(HAT_CE);
+    _sentReport = _gamepadReport;
+    for (uint8_t i = 0; i < GAMEPAD_ANALOGUE_COUNT; i++) _axes[i].reset();
     
     SQUID_LOG_DEBUG(GAMEPAD_TAG, "Gamepad subsystem initialized with delay: %lu ms", delay_ms);
     SQUID_LOG_INFO(GAMEPAD_TAG, "Gamepad service ready");
@@ -31,6 +32,8 @@ bool SQUIDGAMEPAD::isConnected() {
 }
 
 void SQUIDGAMEPAD::onConnect() {
+    // New host, so it gets the whole state whether or not it matches what the last one had
+    memset(&_sentReport, 0xFF, sizeof(_sentReport));
     SQUID_LOG_DEBUG(GAMEPAD_TAG, "Gamepad connected");
 }
 
@@ -63,8 +66,7 @@ size_t SQUIDGAMEPAD::press(GamepadButton button) {
         return 0;
     }
     
-    sendGamepadReport();
-    SQUID_LOG_DEBUG(GAMEPAD_TAG, "Gamepad button press completed: %d", buttonValue);
+    flush(micros(), true);
     return 1;
 }
 
@@ -93,8 +95,7 @@ size_t SQUIDGAMEPAD::release(GamepadButton button) {
         return 0;
     }
     
-    sendGamepadReport();
-    SQUID_LOG_DEBUG(GAMEPAD_TAG, "Gamepad button release completed: %d", buttonValue);
+    flush(micros(), true);
     return 1;
 }
 
@@ -106,8 +107,7 @@ void SQUIDGAMEPAD::releaseAll() {
     _gamepadReport.buttons[1] = 0;
     _gamepadReport.hat = static_cast<int8_t>(HAT_CE);
     
-    sendGamepadReport();
-    SQUID_LOG_DEBUG(GAMEPAD_TAG, "All gamepad buttons released");
+    flush(micros(), true);
 }
 
 bool SQUIDGAMEPAD::gamepadIsPressed(GamepadButton button) {
@@ -153,15 +153,14 @@ bool SQUIDGAMEPAD::gamepadIsPressed(GamepadButton button) {
     return pressed;
 } 
 
+void SQUIDGAMEPAD::setAxisValue(uint8_t axis, int16_t value) {
+    _gamepadReport.analogues[axis] = _axes[axis].apply(value);
+}
+
 void SQUIDGAMEPAD::gamepadSetAxis(GamepadAnalogue axis, int16_t value) {
     int8_t axisIndex = static_cast<int8_t>(axis);
-    if (axisIndex < GAMEPAD_ANALOGUE_COUNT) {
-        int16_t previousValue = _gamepadReport.analogues[axisIndex];
-        _gamepadReport.analogues[axisIndex] = value;
-        
-        SQUID_LOG_DEBUG(GAMEPAD_TAG, "Axis set - Axis: %d, Value: %d -> %d", 
-                     axisIndex, previousValue, value);
-        sendGamepadReport();
+    if (axisIndex >= 0 && axisIndex < GAMEPAD_ANALOGUE_COUNT) {
+        setAxisValue(axisIndex, value);
     } else {
         SQUID_LOG_WARN(GAMEPAD_TAG, "Invalid axis set attempt - Axis: %d, Value: %d", axisIndex, value);
     }
@@ -181,41 +180,24 @@ int16_t SQUIDGAMEPAD::gamepadGetAxis(GamepadAnalogue axis) {
     return value;
 }
 
+// Axes only change the report here, update() sends it at the poll rate so a noisy stick can't flood the link
 void SQUIDGAMEPAD::gamepadSetAllAxes(int16_t values[GAMEPAD_ANALOGUE_COUNT]) {
-    SQUID_LOG_DEBUG(GAMEPAD_TAG, "Setting all analogue axes");
-    memcpy(_gamepadReport.analogues, values, sizeof(_gamepadReport.analogues));
-    sendGamepadReport();
-    SQUID_LOG_DEBUG(GAMEPAD_TAG, "All analogue axes set successfully");
+    for (uint8_t i = 0; i < GAMEPAD_ANALOGUE_COUNT; i++) setAxisValue(i, values[i]);
 }
 
 void SQUIDGAMEPAD::gamepadSetLeftStick(int16_t x, int16_t y) {
-    SQUID_LOG_DEBUG(GAMEPAD_TAG, "Setting left stick - X: %d -> %d, Y: %d -> %d", 
-                 _gamepadReport.analogues[static_cast<int8_t>(GA_LX)], x, 
-                 _gamepadReport.analogues[static_cast<int8_t>(GA_LY)], y);
-    
-    _gamepadReport.analogues[static_cast<int8_t>(GA_LX)] = x;
-    _gamepadReport.analogues[static_cast<int8_t>(GA_LY)] = y;
-    sendGamepadReport();
+    setAxisValue(static_cast<int8_t>(GA_LX), x);
+    setAxisValue(static_cast<int8_t>(GA_LY), y);
 }
 
 void SQUIDGAMEPAD::gamepadSetRightStick(int16_t x, int16_t y) {
-    SQUID_LOG_DEBUG(GAMEPAD_TAG, "Setting right stick - X: %d -> %d, Y: %d -> %d", 
-                 _gamepadReport.analogues[static_cast<int8_t>(GA_RX)], x, 
-                 _gamepadReport.analogues[static_cast<int8_t>(GA_RY)], y);
-    
-    _gamepadReport.analogues[static_cast<int8_t>(GA_RX)] = x;
-    _gamepadReport.analogues[static_cast<int8_t>(GA_RY)] = y;
-    sendGamepadReport();
+    setAxisValue(static_cast<int8_t>(GA_RX), x);
+    setAxisValue(static_cast<int8_t>(GA_RY), y);
 }
 
 void SQUIDGAMEPAD::gamepadSetTriggers(int16_t left, int16_t right) {
-    SQUID_LOG_DEBUG(GAMEPAD_TAG, "Setting triggers - Left: %d -> %d, Right: %d -> %d", 
-                 _gamepadReport.analogues[static_cast<int8_t>(GA_LT)], left, 
-                 _gamepadReport.analogues[static_cast<int8_t>(GA_RT)], right);
-    
-    _gamepadReport.analogues[static_cast<int8_t>(GA_LT)] = left;
-    _gamepadReport.analogues[static_cast<int8_t>(GA_RT)] = right;
-    sendGamepadReport();
+    setAxisValue(static_cast<int8_t>(GA_LT), left);
+    setAxisValue(static_cast<int8_t>(GA_RT), right);
 }
 
 void SQUIDGAMEPAD::gamepadGetLeftStick(int16_t &x, int16_t &y) {
@@ -232,6 +214,45 @@ void SQUIDGAMEPAD::gamepadGetRightStick(int16_t &x, int16_t &y) {
     SQUID_LOG_DEBUG(GAMEPAD_TAG, "Getting right stick - X: %d, Y: %d", x, y);
 }
 
+void SQUIDGAMEPAD::setPollRate(uint16_t hz) {
+    _pollInterval = hz ? 1000000UL / hz : 0;
+    SQUID_LOG_INFO(GAMEPAD_TAG, "Gamepad poll rate set to %u Hz", hz);
+}
+
+void SQUIDGAMEPAD::setAxisHysteresis(GamepadAnalogue axis, uint16_t counts) {
+    int8_t axisIndex = static_cast<int8_t>(axis);
+    if (axisIndex >= 0 && axisIndex < GAMEPAD_ANALOGUE_COUNT) _axes[axisIndex].setHysteresis(counts);
+}
+
+void SQUIDGAMEPAD::setAxisQuantisation(GamepadAnalogue axis, uint8_t bits) {
+    int8_t axisIndex = static_cast<int8_t>(axis);
+    if (axisIndex >= 0 && axisIndex < GAMEPAD_ANALOGUE_COUNT) _axes[axisIndex].setQuantisation(bits);
+}
+
+bool SQUIDGAMEPAD::flush(uint32_t nowUs, bool force) {
+    if (!transport || !isConnected()) return false;
+    if (!memcmp(&_gamepadReport, &_sentReport, sizeof(_gamepadReport))) return false;
+    
+    if (!force) {
+        uint32_t interval = transport->getReportInterval();
+        if (_pollInterval > interval) interval = _pollInterval;
+        if (nowUs - _lastReport < interval) return false;
+    }
+    
+    if (!transport->sendReport(GAMEPAD_ID, (uint8_t*)&_gamepadReport, sizeof(_gamepadReport))) {
+        // Left as it was, so the next update tries again
+        SQUID_LOG_DEBUG(GAMEPAD_TAG, "Gamepad report didn't go out");
+        return false;
+    }
+    _sentReport = _gamepadReport;
+    _lastReport = nowUs;
+    return true;
+}
+
+void SQUIDGAMEPAD::update(uint32_t nowUs) {
+    flush(nowUs, false);
+}
+
 void SQUIDGAMEPAD::sendGamepadReport() {
     if (!isConnected() || !transport) {
         SQUID_LOG_DEBUG(GAMEPAD_TAG, "Cannot send gamepad report - not connected or no transport");
@@ -242,10 +263,10 @@ void SQUIDGAMEPAD::sendGamepadReport() {
     if (!result) {
         SQUID_LOG_ERROR(GAMEPAD_TAG, "Failed to send gamepad report via transport");
     } else {
+        _sentReport = _gamepadReport;
+        _lastReport = micros();
         SQUID_LOG_DEBUG(GAMEPAD_TAG, "Gamepad report sent successfully");
     }
     
     delay(_delay_ms);
 }
-
-#endif
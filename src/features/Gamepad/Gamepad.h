@@ -6,9 +6,8 @@
 #ifndef GAMEPAD_H
 #define GAMEPAD_H
 
-#if !SPACEMOUSE_ENABLE
-
 #include "drivers/Software/Transport/Transport.h"
+#include "drivers/Software/Analog/AxisHysteresis.h"
 
 typedef struct {
   uint32_t buttons[2];
@@ -17,7 +16,7 @@ typedef struct {
   int16_t analogues[GAMEPAD_ANALOGUE_COUNT];
 } GamepadReport;
 
-static const uint8_t _gamepadReportDescriptor[] = {
+static constexpr uint8_t _gamepadReportDescriptor[] = {
   USAGE_PAGE(1),      0x01,                      USAGE(1),           0x05,             
   COLLECTION(1),      0x01,                      REPORT_ID(1),       GAMEPAD_ID,       
   // 64 buttons in bitfield
@@ -272,6 +271,15 @@ private:
     Transport*            transport; 
     GamepadReport         _gamepadReport;
     uint32_t              _delay_ms;
+    
+    // Only what the host would actually see change goes out - buttons straight away, axes at the poll rate
+    GamepadReport         _sentReport;
+    AxisHysteresis        _axes[GAMEPAD_ANALOGUE_COUNT];
+    uint32_t              _pollInterval;   // us, 0 follows the transport
+    uint32_t              _lastReport;
+    
+    void setAxisValue(uint8_t axis, int16_t value);
+    bool flush(uint32_t nowUs, bool force);
 
 public:
     SQUIDGAMEPAD();
@@ -296,6 +304,12 @@ public:
     void    gamepadSetAllAxes(int16_t values[GAMEPAD_ANALOGUE_COUNT]);
     void    sendGamepadReport();
     
+    // Report rate and noise handling
+    void    setPollRate(uint16_t hz);                               // 0 sends as fast as the transport takes them
+    void    setAxisHysteresis(GamepadAnalogue axis, uint16_t counts);
+    void    setAxisQuantisation(GamepadAnalogue axis, uint8_t bits);
+    void    update(uint32_t nowUs);
+    
     // Motion control methods
     void setAccelerometer(int16_t x, int16_t y, int16_t z);
     void setGyroscope(int16_t x, int16_t y, int16_t z);
@@ -304,4 +318,3 @@ public:
     void getGyroscope(int16_t &x, int16_t &y, int16_t &z);
 };
 #endif
-#endif
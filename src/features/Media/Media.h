@@ -12,7 +12,7 @@ typedef struct {
     uint16_t usage;
 } MediaReport;
 
-static const uint8_t _mediakeyReportDescriptor[] = {
+static constexpr uint8_t _mediakeyReportDescriptor[] = {
   // ------------------------------------------------- Media Keys
   USAGE_PAGE(1),      0x0C,                      USAGE(1),           0x01,             
   COLLECTION(1),      0x01,                      REPORT_ID(1),       MEDIA_KEYS_ID,    
@@ -5,10 +5,8 @@
 
 #include "Mouse.h"
 
-#if !SPACEMOUSE_ENABLE
-
 SQUIDMOUSE::SQUIDMOUSE() 
-    : transport(nullptr), _mouseKeys(MouseKey{0}), _delay_ms(7) {
+    : transport(nullptr), _mouseKeys(MouseKey{0}), _delay_ms(7), _lastReport(0), _accelKey(-1) {
     memset(&_mouseReport, 0, sizeof(_mouseReport));
 }
 
@@ -17,6 +15,7 @@ void SQUIDMOUSE::begin(Transport* trans, uint32_t delay_ms) {
     _delay_ms = delay_ms;
     _mouseKeys = MouseKey{0};
     memset(&_mouseReport, 0, sizeof(_mouseReport));
+    _motion.clear();
     
     SQUID_LOG_DEBUG(MOUSE_TAG, "Mouse subsystem initialized with delay: %lu ms", delay_ms);
     SQUID_LOG_INFO(MOUSE_TAG, "Mouse service ready");
@@ -31,6 +30,10 @@ void SQUIDMOUSE::onConnect() {
 }
 
 void SQUIDMOUSE::onDisconnect() {
+    // Motion from before the disconnect would just jump the pointer on reconnect
+    _motion.clear();
+    _keys.reset();
+    _accelKey = -1;
     SQUID_LOG_DEBUG(MOUSE_TAG, "Mouse disconnected");
 }
 
@@ -69,6 +72,10 @@ void SQUIDMOUSE::releaseAll() {
                  static_cast<uint8_t>(_mouseKeys));
     _mouseKeys = MouseKey{0};
     _mouseReport.buttons = 0;
+    // Held mouse keys too - once a profile switch turns the mouse off nothing will send their releases
+    _keys.reset();
+    _accelKey = -1;
+    _motion.clear();
     sendMouseReport();
     SQUID_LOG_DEBUG(MOUSE_TAG, "All mouse buttons released");
 }
@@ -81,7 +88,7 @@ void SQUIDMOUSE::click(MouseKey b) {
     SQUID_LOG_DEBUG(MOUSE_TAG, "Mouse click completed: 0x%02X", static_cast<uint8_t>(b));
 }
 
-void SQUIDMOUSE::move(int8_t x, int8_t y, int8_t wheel, int8_t hWheel) {
+void SQUIDMOUSE::move(MouseAxis x, MouseAxis y, int8_t wheel, int8_t hWheel) {
     if (isConnected() && transport) {
         _mouseReport.buttons = static_cast<uint8_t>(_mouseKeys);  // Convert to underlying type
         
@@ -116,8 +123,7 @@ void SQUIDMOUSE::sendMouseReport() {
         return;
     }
     
-    bool result = transport->sendReport(MOUSE_ID, (uint8_t*)&_mouseReport, sizeof(_mouseReport));
-    if (!result) {
+    if (!sendNow()) {
         SQUID_LOG_ERROR(MOUSE_TAG, "Failed to send mouse report via transport");
     } else {
         SQUID_LOG_DEBUG(MOUSE_TAG, "Mouse report sent successfully");
@@ -126,4 +132,94 @@ void SQUIDMOUSE::sendMouseReport() {
     delay(_delay_ms);
 }
 
-#endif
+bool SQUIDMOUSE::sendNow() {
+    bool result = transport->sendReport(MOUSE_ID, (uint8_t*)&_mouseReport, sizeof(_mouseReport));
+    
+    // Motion is relative, so it only goes out once - a button report straight after shouldn't move it again
+    _mouseReport.relX = 0;
+    _mouseReport.relY = 0;
+    _mouseReport.wheel = 0;
+    _mouseReport.hWheel = 0;
+    return result;
+}
+
+void SQUIDMOUSE::accumulate(int32_t x, int32_t y, int32_t wheel, int32_t hWheel) {
+    _motion.add(x, y, wheel, hWheel);
+}
+
+void SQUIDMOUSE::accumulateFixed(int32_t x, int32_t y, int32_t wheel, int32_t hWheel) {
+    _motion.addFixed(x, y, wheel, hWheel);
+}
+
+// Direction bit for each mouse key, 0 for the analogue axes and the ACL keys
+static uint8_t mouseKeyDirection(MouseAnalogue k) {
+    switch (static_cast<MouseAnalogues>(k.get())) {
+        case MouseAnalogues::MOUSE_UP:        return MOUSEKEY_UP;
+        case MouseAnalogues::MOUSE_DOWN:      return MOUSEKEY_DOWN;
+        case MouseAnalogues::MOUSE_LEFT_DIR:  return MOUSEKEY_LEFT;
+        case MouseAnalogues::MOUSE_RIGHT_DIR: return MOUSEKEY_RIGHT;
+        case MouseAnalogues::MOUSE_WHEEL_UP:  return MOUSEKEY_WHEEL_UP;
+        case MouseAnalogues::MOUSE_WHEEL_DN:  return MOUSEKEY_WHEEL_DOWN;
+        case MouseAnalogues::MOUSE_WHEEL_LT:  return MOUSEKEY_WHEEL_LEFT;
+        case MouseAnalogues::MOUSE_WHEEL_RT:  return MOUSEKEY_WHEEL_RIGHT;
+        default:                              return 0;
+    }
+}
+
+void SQUIDMOUSE::pressDirection(MouseAnalogue k) {
+    int32_t value = k.get();
+    if (value >= static_cast<int32_t>(MouseAnalogues::MOUSE_ACCEL_0) &&
+        value <= static_cast<int32_t>(MouseAnalogues::MOUSE_ACCEL_2)) {
+        _accelKey = value - static_cast<int32_t>(MouseAnalogues::MOUSE_ACCEL_0);
+        _keys.setSpeedOverride(_accelKey);
+        return;
+    }
+    _keys.press(mouseKeyDirection(k));
+}
+
+void SQUIDMOUSE::releaseDirection(MouseAnalogue k) {
+    int32_t value = k.get();
+    if (value >= static_cast<int32_t>(MouseAnalogues::MOUSE_ACCEL_0) &&
+        value <= static_cast<int32_t>(MouseAnalogues::MOUSE_ACCEL_2)) {
+        // Only the last one pressed counts, letting go of an older one changes nothing
+        if (_accelKey == value - static_cast<int32_t>(MouseAnalogues::MOUSE_ACCEL_0)) {
+            _accelKey = -1;
+            _keys.setSpeedOverride(-1);
+        }
+        return;
+    }
+    _keys.release(mouseKeyDirection(k));
+}
+
+void SQUIDMOUSE::update(uint32_t nowUs) {
+    // Mouse keys run off their own tick and go through the accumulator like any other motion
+    int32_t keyMotion[MOTION_AXES];
+    if (_keys.update(nowUs, keyMotion)) {
+        _motion.addFixed(keyMotion[MotionAccumulator::AXIS_X], keyMotion[MotionAccumulator::AXIS_Y],
+                         keyMotion[MotionAccumulator::AXIS_WHEEL], keyMotion[MotionAccumulator::AXIS_HWHEEL]);
+    }
+    
+    if (!transport || !_motion.pending()) return;
+    if (nowUs - _lastReport < transport->getReportInterval()) return;
+    if (!isConnected()) {
+        _motion.clear();
+        return;
+    }
+    
+    static const int32_t limits[MOTION_AXES] = { MOUSE_AXIS_MAX, MOUSE_AXIS_MAX, 127, 127 };
+    int32_t out[MOTION_AXES];
+    if (!_motion.take(limits, out)) return;
+    
+    _mouseReport.buttons = static_cast<uint8_t>(_mouseKeys);
+    _mouseReport.relX = out[MotionAccumulator::AXIS_X];
+    _mouseReport.relY = out[MotionAccumulator::AXIS_Y];
+    _mouseReport.wheel = out[MotionAccumulator::AXIS_WHEEL];
+    _mouseReport.hWheel = out[MotionAccumulator::AXIS_HWHEEL];
+    _lastReport = nowUs;
+    
+    // No delay here, the report interval already spaces them out
+    if (!sendNow()) {
+        _motion.restore(out);
+        SQUID_LOG_DEBUG(MOUSE_TAG, "Mouse report didn't go out, keeping its motion for the next one");
+    }
+}
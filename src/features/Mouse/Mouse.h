@@ -6,19 +6,28 @@
 #ifndef MOUSE_H
 #define MOUSE_H
 
-#if !SPACEMOUSE_ENABLE
-
 #include "drivers/Software/Transport/Transport.h"
+#include "drivers/Software/Motion/MotionAccumulator.h"
+#include "drivers/Software/Motion/MouseKeyEngine.h"
+
+// MOUSE_16BIT widens X/Y so fast sensors don't need several reports for one movement
+#if MOUSE_16BIT
+  typedef int16_t MouseAxis;
+  #define MOUSE_AXIS_MAX 32767
+#else
+  typedef int8_t  MouseAxis;
+  #define MOUSE_AXIS_MAX 127
+#endif
 
-typedef struct {
-  uint8_t buttons;
-  int8_t relX;
-  int8_t relY;
-  int8_t wheel;
-  int8_t hWheel;
+typedef struct PACKED {
+  uint8_t   buttons;
+  MouseAxis relX;
+  MouseAxis relY;
+  int8_t    wheel;
+  int8_t    hWheel;
 } MouseReport;
 
-static const uint8_t _mouseReportDescriptor[] = {
+static constexpr uint8_t _mouseReportDescriptor[] = {
   // ------------------------------------------------- Pointers - Relative/Mouse
   USAGE_PAGE(1),      0x01,                      USAGE(1),           0x02,             
   COLLECTION(1),      0x01,                      REPORT_ID(1),       MOUSE_ID,         
@@ -28,12 +37,24 @@ static const uint8_t _mouseReportDescriptor[] = {
   USAGE_MAXIMUM(1),   0x05,                      LOGICAL_MINIMUM(1), 0x00,             
   LOGICAL_MAXIMUM(1), 0x01,                      REPORT_SIZE(1),     0x01,             
   REPORT_COUNT(1),    0x08,                      HIDINPUT(1),        0x02,                        
+  #if MOUSE_16BIT
+  // Relative X, Y
+  USAGE_PAGE(1),      0x01,                      USAGE(1),           0x30,             
+  USAGE(1),           0x31,                      LOGICAL_MINIMUM(2), 0x01, 0x80,       
+  LOGICAL_MAXIMUM(2), 0xFF, 0x7F,                REPORT_SIZE(1),     0x10,             
+  REPORT_COUNT(1),    0x02,                      HIDINPUT(1),        0x06,             
+  // Wheel
+  USAGE(1),           0x38,                      LOGICAL_MINIMUM(1), 0x81,             
+  LOGICAL_MAXIMUM(1), 0x7F,                      REPORT_SIZE(1),     0x08,             
+  REPORT_COUNT(1),    0x01,                      HIDINPUT(1),        0x06,             
+  #else
   // Relative X, Y, Wheel
   USAGE_PAGE(1),      0x01,                      USAGE(1),           0x30,             
   USAGE(1),           0x31,                      USAGE(1),           0x38,             
   LOGICAL_MINIMUM(1), 0x81,                      LOGICAL_MAXIMUM(1), 0x7F,             
   REPORT_SIZE(1),     0x08,                      REPORT_COUNT(1),    0x03,             
   HIDINPUT(1),        0x06,             
+  #endif
   // Horizontal Wheel
   USAGE_PAGE(1),      0x0C,                      USAGE(2),           0x38, 0x02,            
   LOGICAL_MINIMUM(1), 0x81,                      LOGICAL_MAXIMUM(1), 0x7F,             
@@ -66,13 +87,36 @@ enum class MouseAnalogues : uint8_t {
   MOUSE_X_AXIS    = 1,
   MOUSE_Y_AXIS    = 2,
   MOUSE_H_SCROLL  = 3,
-  MOUSE_V_SCROLL  = 4
+  MOUSE_V_SCROLL  = 4,
+  // Mouse keys - held down, these move the pointer and wheel through the MouseKeyEngine
+  MOUSE_UP        = 5,
+  MOUSE_DOWN      = 6,
+  MOUSE_LEFT_DIR  = 7,
+  MOUSE_RIGHT_DIR = 8,
+  MOUSE_WHEEL_UP  = 9,
+  MOUSE_WHEEL_DN  = 10,
+  MOUSE_WHEEL_LT  = 11,
+  MOUSE_WHEEL_RT  = 12,
+  MOUSE_ACCEL_0   = 13,
+  MOUSE_ACCEL_1   = 14,
+  MOUSE_ACCEL_2   = 15
 };
 
 MK(MouseAnalogue, MO_AX, MOUSE_X_AXIS);
 MK(MouseAnalogue, MO_AY, MOUSE_Y_AXIS);
 MK(MouseAnalogue, MO_HS, MOUSE_H_SCROLL);
 MK(MouseAnalogue, MO_VS, MOUSE_V_SCROLL);
+MK(MouseAnalogue, MO_UP, MOUSE_UP);
+MK(MouseAnalogue, MO_DOWN, MOUSE_DOWN);
+MK(MouseAnalogue, MO_LEFT, MOUSE_LEFT_DIR);
+MK(MouseAnalogue, MO_RGHT, MOUSE_RIGHT_DIR);
+MK(MouseAnalogue, MO_WHLU, MOUSE_WHEEL_UP);
+MK(MouseAnalogue, MO_WHLD, MOUSE_WHEEL_DN);
+MK(MouseAnalogue, MO_WHLL, MOUSE_WHEEL_LT);
+MK(MouseAnalogue, MO_WHLR, MOUSE_WHEEL_RT);
+MK(MouseAnalogue, MO_ACL0, MOUSE_ACCEL_0);
+MK(MouseAnalogue, MO_ACL1, MOUSE_ACCEL_1);
+MK(MouseAnalogue, MO_ACL2, MOUSE_ACCEL_2);
 
 class SQUIDMOUSE {
 private:
@@ -81,6 +125,14 @@ private:
     MouseKey              _mouseKeys;
     uint32_t              _delay_ms;
     
+    // High resolution motion waiting for the next report slot
+    MotionAccumulator     _motion;
+    uint32_t              _lastReport;
+    MouseKeyEngine        _keys;
+    int8_t                _accelKey;   // Which MO_ACL key is held, -1 for none
+    
+    bool sendNow();
+    
 public:
     SQUIDMOUSE();
     
@@ -93,10 +145,20 @@ public:
     size_t press(MouseKey b = MO_BTN1);
     size_t release(MouseKey b = MO_BTN1);
     void click(MouseKey b = MO_BTN1);
-    void move(int8_t x, int8_t y, int8_t wheel = 0, int8_t hWheel = 0);
+    void move(MouseAxis x, MouseAxis y, int8_t wheel = 0, int8_t hWheel = 0);
     bool mouseIsPressed(MouseKey b = MO_BTN1);
     void sendMouseReport();
     void releaseAll();
+    
+    // Any size of motion from any source, update() sends it at the transport's report rate
+    void accumulate(int32_t x, int32_t y, int32_t wheel = 0, int32_t hWheel = 0);
+    void accumulateFixed(int32_t x, int32_t y, int32_t wheel = 0, int32_t hWheel = 0);  // 1/256ths of a count
+    bool hasPendingMotion() const { return _motion.pending(); }
+    void update(uint32_t nowUs);
+    
+    // Mouse keys - MO_UP..MO_WHLR and MO_ACL0-2 from the keymap, update() ticks the motion
+    void pressDirection(MouseAnalogue k);
+    void releaseDirection(MouseAnalogue k);
+    MouseKeyEngine& mouseKeys() { return _keys; }  // Mode, curves and friction
 };
 #endif
-#endif
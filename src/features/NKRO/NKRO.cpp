@@ -143,25 +143,53 @@ void SQUIDNKRO::releaseAll() {
 }
 
 size_t SQUIDNKRO::write(uint8_t c) {
-    bool shift;
-    // Convert to char for the character processing function
-    char charValue = static_cast<char>(c);
-    uint8_t key = SQUIDNKRO::charToKeyCode(charValue, &shift);
-    
-    if (key == 0) {
-        SQUID_LOG_DEBUG(NKRO_TAG, "Character not supported: 0x%02X ('%c')", 
-                     static_cast<uint8_t>(c), isprint(charValue) ? charValue : '.');
-        return 0; // character not supported
+    return write(&c, 1);
+}
+
+size_t SQUIDNKRO::write(const uint8_t* buffer, size_t size) {
+    if (!buffer || !isConnected()) {
+        SQUID_LOG_DEBUG(NKRO_TAG, "Cannot type text - not connected or no buffer");
+        return 0;
     }
 
-    SQUID_LOG_DEBUG(NKRO_TAG, "Writing character: 0x%02X ('%c') with%s shift", 
-                 key, charValue, shift ? "" : "out");
-    
-    if (shift) press(KC_LSFT);           // hold shift
-    press(NKROKey{key});                 // key-down
-    release(NKROKey{key});               // key-up
-    if (shift) release(KC_LSFT);         // release shift
-    return 1;
+    size_t written = 0;
+    TextReport steps[2];
+    _typer.reset();
+
+    // Held modifiers would turn the text into shortcuts, so they're left out until it's done. A held key the
+    // text needs would never go down fresh either - that one's let go for good, as if it had been typed.
+    uint8_t held = _nkroReport.modifiers;
+    bool clash = held != 0;
+    for (size_t i = 0; i < size; i++) {
+        uint8_t keycode = asciiToKey(buffer[i]).keycode;
+        uint8_t bit = 1 << (keycode % 8);
+        if (keycode && (_nkroReport.keys_bitmask[keycode / 8] & bit)) {
+            _nkroReport.keys_bitmask[keycode / 8] &= ~bit;
+            clash = true;
+        }
+    }
+    bool sent = !clash || sendText(TextReport{ 0, 0 });
+
+    for (size_t i = 0; i < size && sent; i++) {
+        uint8_t n = _typer.type(buffer[i], steps);
+        if (!n) {
+            SQUID_LOG_DEBUG(NKRO_TAG, "Character not supported: 0x%02X ('%c')", 
+                         buffer[i], isprint(buffer[i]) ? buffer[i] : '.');
+            continue;
+        }
+
+        for (uint8_t s = 0; s < n && sent; s++) sent = sendText(steps[s]);
+        if (sent) written++;
+    }
+
+    // Even after a failure, so nothing's left held down - the held modifiers go back on in the same report
+    if (_typer.finish(steps) || held) sendText(TextReport{ held, 0 });
+    SQUID_LOG_DEBUG(NKRO_TAG, "Typed %u of %u characters", (unsigned)written, (unsigned)size);
+    return written;
+}
+
+size_t SQUIDNKRO::print(const char* text) {
+    return text ? write(reinterpret_cast<const uint8_t*>(text), strlen(text)) : 0;
 }
 
 size_t SQUIDNKRO::write(ModKey modifier) {
@@ -239,64 +267,22 @@ uint8_t SQUIDNKRO::getModifiers() {
     return modifiers;
 }
 
-uint8_t SQUIDNKRO::charToKeyCode(char c, bool *needShift) {
-    *needShift = false;
-
-    if (c >= '0' && c <= '9')            return (c - '0') + 0x27;   // 0x27…0x30
-    if (c == ')')  { *needShift = true;  return 0x27; }            // shift-0
-    if (c == '!')  { *needShift = true;  return 0x1e; }            // shift-1
-    if (c == '@')  { *needShift = true;  return 0x1f; }            // shift-2
-    if (c == '#')  { *needShift = true;  return 0x20; }            // shift-3
-    if (c == '$')  { *needShift = true;  return 0x21; }            // shift-4
-    if (c == '%')  { *needShift = true;  return 0x22; }            // shift-5
-    if (c == '^')  { *needShift = true;  return 0x23; }            // shift-6
-    if (c == '&')  { *needShift = true;  return 0x24; }            // shift-7
-    if (c == '*')  { *needShift = true;  return 0x25; }            // shift-8
-    if (c == '(')  { *needShift = true;  return 0x26; }            // shift-9
-
-    if (c >= 'a' && c <= 'z') {           return (c - 'a') + 0x04; }  // 0x04…0x1D
-    if (c >= 'A' && c <= 'Z') { *needShift = true;  return (c - 'A') + 0x04; }
-
-    switch (c)
-    {
-    case '\n': case '\r':                return static_cast<uint8_t>(KC_ENT);          // 0xB0
-    case '\t':                           return static_cast<uint8_t>(KC_TAB);           // 0xB3
-    case ' ':                            return static_cast<uint8_t>(KC_SPC);           // 0x2C
-    case '-': case '_':
-        if (c == '_') *needShift = true;
-        return static_cast<uint8_t>(KC_MINS);                                          // 0x2D
-    case '=': case '+':
-        if (c == '+') *needShift = true;
-        return static_cast<uint8_t>(KC_EQL);                                           // 0x2E
-    case '[': case '{':
-        if (c == '{') *needShift = true;
-        return static_cast<uint8_t>(KC_LBRC);                                          // 0x2F
-    case ']': case '}':
-        if (c == '}') *needShift = true;
-        return static_cast<uint8_t>(KC_RBRC);                                          // 0x30
-    case '\\': case '|':
-        if (c == '|') *needShift = true;
-        return static_cast<uint8_t>(KC_BSLS);                                          // 0x31
-    case ';': case ':':
-        if (c == ':') *needShift = true;
-        return static_cast<uint8_t>(KC_SCLN);                                          // 0x33
-    case '\'': case '"':
-        if (c == '"') *needShift = true;
-        return static_cast<uint8_t>(KC_QUOT);                                          // 0x34
-    case '`': case '~':
-        if (c == '~') *needShift = true;
-        return static_cast<uint8_t>(KC_GRV);                                           // 0x35
-    case ',': case '<':
-        if (c == '<') *needShift = true;
-        return static_cast<uint8_t>(KC_COMM);                                          // 0x36
-    case '.': case '>':
-        if (c == '>') *needShift = true;
-        return static_cast<uint8_t>(KC_DOT);                                           // 0x37
-    case '/': case '?':
-        if (c == '?') *needShift = true;
-        return static_cast<uint8_t>(KC_SLSH);                                          // 0x38
-    default:                             return 0;                                     // non-printable
+bool SQUIDNKRO::sendText(const TextReport& text) {
+    // Keys held by hand stay down underneath the text, the modifiers are only the text's own
+    NKROReport report = _nkroReport;
+    report.modifiers = text.modifiers;
+    if (text.keycode) report.keys_bitmask[text.keycode / 8] |= 1 << (text.keycode % 8);
+
+    // Paced by how fast the host picks reports up rather than _delay_ms, anything sooner only queues up
+    uint32_t interval = transport->getReportInterval();
+    for (uint8_t tries = 0; tries < NKRO_TEXT_RETRIES; tries++) {
+        while (micros() - _lastTextReport < interval) yield();
+        _lastTextReport = micros();
+        if (transmit(report)) return true;
+        if (!isConnected()) break;
     }
+    SQUID_LOG_ERROR(NKRO_TAG, "Text report didn't go out");
+    return false;
 }
 
 void SQUIDNKRO::sendNKROReport() {
@@ -305,36 +291,40 @@ void SQUIDNKRO::sendNKROReport() {
         return;
     }
     
+    transmit(_nkroReport);
+    delay(_delay_ms);
+}
+
+bool SQUIDNKRO::transmit(const NKROReport& report) {
     if (_useNKRO) {
-        bool result = transport->sendReport(NKRO_ID, (uint8_t*)&_nkroReport, sizeof(NKROReport));
+        bool result = transport->sendReport(NKRO_ID, (const uint8_t*)&report, sizeof(NKROReport));
         if (!result) {
-          SQUID_LOG_ERROR(NKRO_TAG, "Failed to send NKRO report via transport");
+            SQUID_LOG_ERROR(NKRO_TAG, "Failed to send NKRO report via transport");
         } else {
-          SQUID_LOG_DEBUG(NKRO_TAG, "NKRO report sent successfully");
-      }
-    } else {
-        // 6KRO conversion
-        uint8_t bootReport[8];
-        bootReport[0] = _nkroReport.modifiers;
-        bootReport[1] = 0;
-        
-        int keyIndex = 2;
-        for (int i = 0; i < NKRO_KEY_COUNT && keyIndex < 8; i++) {
-            if ((_nkroReport.keys_bitmask[i/8] >> (i%8)) & 1) {
-                bootReport[keyIndex++] = i;
-            }
+            SQUID_LOG_DEBUG(NKRO_TAG, "NKRO report sent successfully");
         }
-        while (keyIndex < 8) {
-            bootReport[keyIndex++] = 0;
+        return result;
+    }
+
+    // 6KRO conversion
+    uint8_t bootReport[8] = { report.modifiers, 0 };
+    
+    int keyIndex = 2;
+    for (int i = 0; i < (int)sizeof(report.keys_bitmask) && keyIndex < 8; i++) {
+        uint8_t bits = report.keys_bitmask[i];
+        // Whole empty bytes skipped, text sends a lot of these
+        while (bits && keyIndex < 8) {
+            uint8_t bit = __builtin_ctz(bits);
+            bootReport[keyIndex++] = i * 8 + bit;
+            bits &= bits - 1;
         }
-        
-        bool result = transport->sendReport(NKRO_ID, bootReport, 8);
-        if (!result) {
-          SQUID_LOG_ERROR(NKRO_TAG, "Failed to send 6KRO report via transport");
-        } else {
-          SQUID_LOG_DEBUG(NKRO_TAG, "6KRO report sent successfully");
-      }
     }
     
-    delay(_delay_ms);
+    bool result = transport->sendReport(NKRO_ID, bootReport, 8);
+    if (!result) {
+        SQUID_LOG_ERROR(NKRO_TAG, "Failed to send 6KRO report via transport");
+    } else {
+        SQUID_LOG_DEBUG(NKRO_TAG, "6KRO report sent successfully");
+    }
+    return result;
 }
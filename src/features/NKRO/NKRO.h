@@ -7,6 +7,9 @@
 #define NKRO_H
 
 #include "drivers/Software/Transport/Transport.h"
+#include "drivers/Software/HID/TextTyper.h"
+
+#define NKRO_TEXT_RETRIES 3   // Goes at a report that didn't go out before the text gives up
 
 static const bool enabled = true;
 static const bool disabled = false;
@@ -17,7 +20,7 @@ typedef struct {
   uint8_t keys_bitmask[(NKRO_KEY_COUNT + 7) / 8];
 } NKROReport;
 
-static const uint8_t _nkroReportDescriptor[] = {
+static constexpr uint8_t _nkroReportDescriptor[] = {
   // NKRO Extended Report (6KRO is emulated)
   USAGE_PAGE(1),      0x01,                      USAGE(1),           0x06,                      
   COLLECTION(1),      0x01,                      REPORT_ID(1),       NKRO_ID,                  
@@ -452,11 +455,14 @@ private:
   NKROReport   _nkroReport;
   bool         _useNKRO = true; // Default to NKRO
   uint32_t     _delay_ms = 7;  
+  TextTyper    _typer;
+  uint32_t     _lastTextReport = 0;
     
   uint8_t      countPressedKeys();
-  uint8_t      charToKeyCode(char c, bool *needShift);
   void         splitShiftedKey(ShiftedKey shiftedKey, uint8_t* keycode, uint8_t* modifier);
   void         updateNKROBitmask(NKROKey k, bool pressed);
+  bool         transmit(const NKROReport& report);
+  bool         sendText(const TextReport& text);
 public:
   SQUIDNKRO();
     
@@ -475,6 +481,8 @@ public:
   size_t  write(uint8_t c);
   size_t  write(ModKey modifier);
   size_t  write(ShiftedKey shiftedKey);
+  size_t  write(const uint8_t* buffer, size_t size);
+  size_t  print(const char* text);
   void    useNKRO(bool state = enabled);
   void    use6KRO(bool state = enabled);
   bool    isNKROEnabled();
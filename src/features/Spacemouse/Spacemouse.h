@@ -25,7 +25,26 @@ typedef struct {
     uint32_t buttons[2];  // 64 bits for button bitmask
 } SpaceButtonReport;
 
-static const uint8_t _spacemouseReportDescriptor[] = {
+// SPACEMOUSE_COMBINED sends all six axes in one report instead of two
+typedef struct {
+    SpaceTranslationReport trans;
+    SpaceRotationReport    rot;
+} SpaceMotionReport;
+
+static constexpr uint8_t _spacemouseReportDescriptor[] = {
+  #if SPACEMOUSE_COMBINED
+  // Spacemouse Translation and Rotation axes in one report, like the newer 3DConnexion devices
+  USAGE_PAGE(1),       0x01,                      USAGE(1),            0x08,                      
+  COLLECTION(1),       0x01,                      COLLECTION(1),       0x00,                    
+  REPORT_ID(1),        SPACETRANS_ID,             LOGICAL_MINIMUM(2),  0x00, 0x80,            
+  LOGICAL_MAXIMUM(2),  0xFF, 0x7F,                PHYSICAL_MINIMUM(2), 0x00, 0x80,           
+  PHYSICAL_MAXIMUM(2), 0xFF, 0x7F,                USAGE(1),            0x30,                    
+  USAGE(1),            0x31,                      USAGE(1),            0x32,                    
+  USAGE(1),            0x33,                      USAGE(1),            0x34,                    
+  USAGE(1),            0x35,                      REPORT_SIZE(1),      0x10,                    
+  REPORT_COUNT(1),     0x06,                      HIDINPUT(1),         0x02,                    
+  END_COLLECTION(0),
+  #else
   // Spacemouse Translation axis
   USAGE_PAGE(1),       0x01,                      USAGE(1),            0x08,                      
   COLLECTION(1),       0x01,                      COLLECTION(1),       0x00,                    
@@ -43,6 +62,7 @@ static const uint8_t _spacemouseReportDescriptor[] = {
   USAGE(1),            0x35,                      REPORT_SIZE(1),      0x10,                    
   REPORT_COUNT(1),     0x03,                      HIDINPUT(1),         0x02,                    
   END_COLLECTION(0),
+  #endif
   // Spacemouse/3DConnexion Buttons (I added 32 of them)
   COLLECTION(1),       0x00,                      REPORT_ID(1),        SPACECLICK_ID,
   LOGICAL_MINIMUM(1),  0x00,                      LOGICAL_MAXIMUM(1),  0x01,                  
@@ -202,106 +222,6 @@ MK(SpacemouseKey, SM_62, SPACEMOUSE_62);
 MK(SpacemouseKey, SM_63, SPACEMOUSE_63);
 MK(SpacemouseKey, SM_64, SPACEMOUSE_64);
 
-#if MOUSE_ENABLE || DIGITIZER_ENABLE
-MK(SpacemouseKey, MO_BTN1, SPACEMOUSE_1);
-MK(SpacemouseKey, MO_BTN2, SPACEMOUSE_2);
-MK(SpacemouseKey, MO_BTN3, SPACEMOUSE_3);
-MK(SpacemouseKey, MO_BTN4, SPACEMOUSE_4);
-MK(SpacemouseKey, MO_BTN5, SPACEMOUSE_5);
-MK(SpacemouseKey, DI_BTN1, SPACEMOUSE_1);
-MK(SpacemouseKey, DI_BTN2, SPACEMOUSE_2);
-MK(SpacemouseKey, DI_BTN3, SPACEMOUSE_3);
-#endif
-
-#if GAMEPAD_ENABLE
-MK(SpacemouseAnalogue, GA_LX, SPACEMOUSE_TX);
-MK(SpacemouseAnalogue, GA_LY, SPACEMOUSE_TY);
-MK(SpacemouseAnalogue, GA_RX, SPACEMOUSE_TZ);
-MK(SpacemouseAnalogue, GA_RY, SPACEMOUSE_RX);
-MK(SpacemouseAnalogue, GA_LT, SPACEMOUSE_RY);
-MK(SpacemouseAnalogue, GA_RT, SPACEMOUSE_RZ);
-
-MK(SpacemouseKey, GB_00, SPACEMOUSE_1);
-MK(SpacemouseKey, GB_SO, SPACEMOUSE_1); // "South" like the bottom face button. So 'Cross' on a Playstation controller or 'A' on an Xbox controller.
-MK(SpacemouseKey, GB_01, SPACEMOUSE_2);
-MK(SpacemouseKey, GB_EA, SPACEMOUSE_2);  // "East" like the right face button. So 'Circle' on a Playstation controller or 'B' on an Xbox controller.
-MK(SpacemouseKey, GB_02, SPACEMOUSE_3);
-MK(SpacemouseKey, GB_03, SPACEMOUSE_4);
-MK(SpacemouseKey, GB_WE, SPACEMOUSE_4);  // "West" like the left face button. So 'Square' on a Playstation controller or 'X' on an Xbox controller.
-MK(SpacemouseKey, GB_04, SPACEMOUSE_5);
-MK(SpacemouseKey, GB_NO, SPACEMOUSE_5); // "North" like the top face button. So 'Triangle' on a Playstation controller or 'Y' on an Xbox controller.
-MK(SpacemouseKey, GB_05, SPACEMOUSE_6);
-MK(SpacemouseKey, GB_06, SPACEMOUSE_7);
-MK(SpacemouseKey, GB_L1, SPACEMOUSE_7);
-MK(SpacemouseKey, GB_07, SPACEMOUSE_8);
-MK(SpacemouseKey, GB_R1, SPACEMOUSE_8);
-MK(SpacemouseKey, GB_08, SPACEMOUSE_9);
-MK(SpacemouseKey, GB_09, SPACEMOUSE_10);
-MK(SpacemouseKey, GB_10, SPACEMOUSE_11);
-MK(SpacemouseKey, GB_BA, SPACEMOUSE_11);
-MK(SpacemouseKey, GB_11, SPACEMOUSE_12);
-MK(SpacemouseKey, GB_ST, SPACEMOUSE_12);
-MK(SpacemouseKey, GB_12, SPACEMOUSE_13);
-MK(SpacemouseKey, GB_GU, SPACEMOUSE_13);
-MK(SpacemouseKey, GB_13, SPACEMOUSE_14);
-MK(SpacemouseKey, GB_L3, SPACEMOUSE_14);
-MK(SpacemouseKey, GB_14, SPACEMOUSE_15);
-MK(SpacemouseKey, GB_R3, SPACEMOUSE_15);
-MK(SpacemouseKey, GB_15, SPACEMOUSE_16);
-MK(SpacemouseKey, GB_16, SPACEMOUSE_17);
-MK(SpacemouseKey, GB_17, SPACEMOUSE_18);
-MK(SpacemouseKey, GB_18, SPACEMOUSE_19);
-MK(SpacemouseKey, GB_19, SPACEMOUSE_20);
-MK(SpacemouseKey, GB_20, SPACEMOUSE_21);
-MK(SpacemouseKey, GB_21, SPACEMOUSE_22);
-MK(SpacemouseKey, GB_22, SPACEMOUSE_23);
-MK(SpacemouseKey, GB_23, SPACEMOUSE_24);
-MK(SpacemouseKey, GB_24, SPACEMOUSE_25);
-MK(SpacemouseKey, GB_25, SPACEMOUSE_26);
-MK(SpacemouseKey, GB_26, SPACEMOUSE_27);
-MK(SpacemouseKey, GB_27, SPACEMOUSE_28);
-MK(SpacemouseKey, GB_28, SPACEMOUSE_29);
-MK(SpacemouseKey, GB_29, SPACEMOUSE_30);
-MK(SpacemouseKey, GB_30, SPACEMOUSE_31);
-MK(SpacemouseKey, GB_31, SPACEMOUSE_32);
-MK(SpacemouseKey, GB_32, SPACEMOUSE_33);
-MK(SpacemouseKey, GB_33, SPACEMOUSE_34);
-MK(SpacemouseKey, GB_34, SPACEMOUSE_35);
-MK(SpacemouseKey, GB_35, SPACEMOUSE_36);
-MK(SpacemouseKey, GB_36, SPACEMOUSE_37);
-MK(SpacemouseKey, GB_37, SPACEMOUSE_38);
-MK(SpacemouseKey, GB_38, SPACEMOUSE_39);
-MK(SpacemouseKey, GB_39, SPACEMOUSE_40);
-MK(SpacemouseKey, GB_40, SPACEMOUSE_41);
-MK(SpacemouseKey, GB_41, SPACEMOUSE_42);
-MK(SpacemouseKey, GB_42, SPACEMOUSE_43);
-MK(SpacemouseKey, GB_43, SPACEMOUSE_44);
-MK(SpacemouseKey, GB_44, SPACEMOUSE_45);
-MK(SpacemouseKey, GB_45, SPACEMOUSE_46);
-MK(SpacemouseKey, GB_46, SPACEMOUSE_47);
-MK(SpacemouseKey, GB_47, SPACEMOUSE_48);
-MK(SpacemouseKey, GB_48, SPACEMOUSE_49);
-MK(SpacemouseKey, GB_49, SPACEMOUSE_50);
-MK(SpacemouseKey, GB_50, SPACEMOUSE_51);
-MK(SpacemouseKey, GB_51, SPACEMOUSE_52);
-MK(SpacemouseKey, GB_52, SPACEMOUSE_53);
-MK(SpacemouseKey, GB_53, SPACEMOUSE_54);
-MK(SpacemouseKey, GB_54, SPACEMOUSE_55);
-MK(SpacemouseKey, GB_55, SPACEMOUSE_56);
-MK(SpacemouseKey, GB_56, SPACEMOUSE_57);
-MK(SpacemouseKey, GB_57, SPACEMOUSE_58);
-MK(SpacemouseKey, GB_58, SPACEMOUSE_59);
-MK(SpacemouseKey, GB_59, SPACEMOUSE_60);
-MK(SpacemouseKey, GB_60, SPACEMOUSE_61);
-MK(SpacemouseKey, GB_61, SPACEMOUSE_62);
-MK(SpacemouseKey, GB_62, SPACEMOUSE_63);
-MK(SpacemouseKey, GB_63, SPACEMOUSE_64);
-MK(SpacemouseKey, GB_UP, SPACEMOUSE_61);
-MK(SpacemouseKey, GB_RI, SPACEMOUSE_62);
-MK(SpacemouseKey, GB_DO, SPACEMOUSE_63);
-MK(SpacemouseKey, GB_LE, SPACEMOUSE_64);
-#endif
-
 class SQUIDSPACEMOUSE {
 private:
     Transport*              transport;
@@ -310,18 +230,11 @@ private:
     SpaceButtonReport       _buttonReport;
     uint32_t                _delay_ms;
     
-    #if MOUSE_ENABLE || DIGITIZER_ENABLE
-      uint16_t              _relativeX;
-      uint16_t              _relativeY;
-      uint16_t              _screenWidth;
-      uint16_t              _screenHeight;
-      uint16_t              _currentAbsoluteX;
-      uint16_t              _currentAbsoluteY;
-    #endif
-    
-    #if GAMEPAD_ENABLE
-    
-    #endif
+    // What the host last got for each report, so unchanged ones aren't sent again
+    SpaceTranslationReport  _sentTrans;
+    SpaceRotationReport     _sentRot;
+    SpaceButtonReport       _sentButtons;
+    bool                    _resendAll;
     
 public:
     SQUIDSPACEMOUSE();
@@ -335,37 +248,13 @@ public:
     void   move(int16_t tx, int16_t ty, int16_t tz, int16_t rx, int16_t ry, int16_t rz);
     void   translate(int16_t tx, int16_t ty, int16_t tz);
     void   rotate(int16_t rx, int16_t ry, int16_t rz);
+    int16_t getAxis(uint8_t axis) const;  // In move() order, tx ty tz rx ry rz
     void   press(SpacemouseKey button);
     void   release(SpacemouseKey button);
     bool   isPressed(SpacemouseKey button);
     void   setAllButtons(uint32_t lowButtons, uint32_t highButtons = 0);
     void   sendReport();
     void   releaseAll();
-    
-    #if MOUSE_ENABLE || DIGITIZER_ENABLE
-    void   click(SpacemouseKey b = MO_BTN1);
-    void   move(int16_t x, int16_t y, int16_t wheel = 0, int16_t hWheel = 0);
-    void   moveRelative(int16_t relX, int16_t relY, bool sendImmediately = true);
-    void   sendMouseReport();
-    void   click(uint16_t x, uint16_t y, SpacemouseKey b = DI_BTN1); 
-    void   moveTo(uint16_t x, uint16_t y, uint8_t pressure = 0, SpacemouseKey buttons = SpacemouseKey{0});
-    void   beginStroke(uint16_t x, uint16_t y, uint16_t initialPressure = 1270);
-    void   updateStroke(uint16_t x, uint16_t y, uint16_t pressure);
-    void   endStroke(uint16_t x, uint16_t y);
-    void   setDigitizerRange(uint16_t maxX, uint16_t maxY);
-    void   sendDigitizerReport();
-    #endif
-    
-    #if GAMEPAD_ENABLE
-    void    gamepadSetLeftStick(int16_t x, int16_t y);
-    void    gamepadSetRightStick(int16_t x, int16_t y);
-    void    gamepadSetTriggers(int16_t left, int16_t right);
-    void    gamepadSetAxis(SpacemouseAnalogue axis, int16_t value);
-    int16_t gamepadGetAxis(SpacemouseAnalogue axis);
-    void    gamepadSetAllAxes(int16_t values[6]);
-    void    sendGamepadReport();
-    #endif
-    
 };
 
 #endif
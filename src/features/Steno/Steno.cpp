@@ -1,27 +1,60 @@
 /**
  * @file Steno.cpp
- * @brief Implementation of the PloverHID stenotype featureset
+ * @brief Implementation of the stenotype featureset
  */
 
 #include "Steno.h"
 
 SQUIDSTENO::SQUIDSTENO() 
-    : transport(nullptr) {
+    : transport(nullptr), _mode(STENO_PLOVER_HID), _serial(nullptr) {
     memset(&_stenoReport, 0, sizeof(_stenoReport));
+    memset(&_chord, 0, sizeof(_chord));
 }
 
 SQUIDSTENO::~SQUIDSTENO() {
     SQUID_LOG_DEBUG(STENO_TAG, "Stenotype instance destroyed");
 }
 
-void SQUIDSTENO::begin(Transport* trans, uint32_t delay_ms) {
+void SQUIDSTENO::begin(Transport* trans) {
     transport = trans;
-    _delay_ms = delay_ms;
     memset(&_stenoReport, 0, sizeof(_stenoReport));
+    memset(&_chord, 0, sizeof(_chord));
     
     SQUID_LOG_INFO(STENO_TAG, "Plover HID stenotype initialized with 64-key layout");
 }
 
+void SQUIDSTENO::setMode(StenoMode mode) {
+    _mode = mode;
+    memset(&_chord, 0, sizeof(_chord));
+    _translator.reset();
+    
+    #if UART_ENABLE
+    if ((mode == STENO_GEMINI || mode == STENO_TXBOLT) && !_serial) {
+        Serial1.begin(STENO_SERIAL_BAUD, SERIAL_8N1, RX_PIN, TX_PIN);
+        _serial = &Serial1;
+    }
+    #endif
+    
+    if ((mode == STENO_GEMINI || mode == STENO_TXBOLT) && !_serial) {
+        SQUID_LOG_WARN(STENO_TAG, "Serial steno mode with no serial port - call setSerial() or turn on UART_ENABLE");
+    }
+    SQUID_LOG_INFO(STENO_TAG, "Steno output mode: %u", mode);
+}
+
+void SQUIDSTENO::setSerial(Stream* serial) {
+    _serial = serial;
+}
+
+bool SQUIDSTENO::setDictionary(const StenoDictionary* dict) {
+    if (dict && !StenoDict::isSorted(*dict)) {
+        SQUID_LOG_ERROR(STENO_TAG, "Steno dictionary isn't sorted, lookups would miss - not using it");
+        return false;
+    }
+    _translator.setDictionary(dict);
+    SQUID_LOG_INFO(STENO_TAG, "Steno dictionary set - %lu entries", dict ? (unsigned long)dict->count : 0UL);
+    return true;
+}
+
 void SQUIDSTENO::updateStenoKey(StenoKey stenoKey, bool pressed) {
     uint8_t keyValue = static_cast<uint8_t>(stenoKey);
     
@@ -44,66 +77,101 @@ void SQUIDSTENO::updateStenoKey(StenoKey stenoKey, bool pressed) {
 }
 
 size_t SQUIDSTENO::press(StenoKey stenoKey) {
-    SQUID_LOG_DEBUG(STENO_TAG, "Stenotype key press: %d", static_cast<uint8_t>(stenoKey));
     updateStenoKey(stenoKey, true);
-    sendStenoReport();
+    uint8_t keyValue = static_cast<uint8_t>(stenoKey);
+    if (keyValue < 64) _chord.keys[keyValue / 8] |= 1 << (keyValue % 8);
+    
+    // Plover HID sends the live state and lets Plover find the chord, everything else waits for the chord to finish
+    if (_mode == STENO_PLOVER_HID) sendNow();
     return 1;
 }
 
 size_t SQUIDSTENO::release(StenoKey stenoKey) {
-    SQUID_LOG_DEBUG(STENO_TAG, "Stenotype key release: %d", static_cast<uint8_t>(stenoKey));
     updateStenoKey(stenoKey, false);
-    sendStenoReport();
+    
+    if (_mode == STENO_PLOVER_HID) {
+        sendNow();
+    } else if (!anyHeld()) {
+        // Last key up is the end of the chord
+        endChord(_chord.keys);
+    }
+    if (!anyHeld()) memset(&_chord, 0, sizeof(_chord));
     return 1;
 }
 
 void SQUIDSTENO::releaseAll() {
     SQUID_LOG_DEBUG(STENO_TAG, "Releasing all stenotype keys");
     
+    // A half-done chord just gets dropped, it never finished
     memset(_stenoReport.keys, 0, sizeof(_stenoReport.keys));
-    sendStenoReport();
-    
-    SQUID_LOG_DEBUG(STENO_TAG, "All stenotype keys released");
+    memset(&_chord, 0, sizeof(_chord));
+    if (_mode == STENO_PLOVER_HID) sendNow();
 }
 
 void SQUIDSTENO::stenoStroke(const StenoKey* keys, size_t count) {
     SQUID_LOG_DEBUG(STENO_TAG, "Executing steno stroke with %zu keys", count);
     
-    releaseAll();
+    StenoReport chord;
+    memset(&chord, 0, sizeof(chord));
     for (size_t i = 0; i < count; i++) {
-        updateStenoKey(keys[i], true);
+        uint8_t keyValue = static_cast<uint8_t>(keys[i]);
+        if (keyValue < 64) chord.keys[keyValue / 8] |= 1 << (keyValue % 8);
     }
-    sendStenoReport();
     
-    SQUID_LOG_DEBUG(STENO_TAG, "Steno stroke completed");
+    if (_mode == STENO_PLOVER_HID) {
+        // Down then up - Plover only counts the stroke once everything's let go
+        StenoReport held = _stenoReport;
+        _stenoReport = chord;
+        sendNow();
+        _stenoReport = held;
+        sendNow();
+    } else {
+        endChord(chord.keys);
+    }
 }
 
+bool SQUIDSTENO::anyHeld() {
+    for (uint8_t i = 0; i < sizeof(_stenoReport.keys); i++) {
+        if (_stenoReport.keys[i]) return true;
+    }
+    return false;
+}
+
+void SQUIDSTENO::endChord(const uint8_t keys[8]) {
+    switch (_mode) {
+        case STENO_GEMINI: {
+            uint8_t packet[GEMINI_PACKET_SIZE];
+            StenoChord::toGemini(keys, packet);
+            if (_serial) _serial->write(packet, sizeof(packet));
+            break;
+        }
+        case STENO_TXBOLT: {
+            uint8_t packet[TXBOLT_PACKET_MAX];
+            size_t n = StenoChord::toTxBolt(StenoChord::toStroke(keys), packet);
+            if (_serial && n) _serial->write(packet, n);
+            break;
+        }
+        case STENO_DICTIONARY: {
+            StenoEdit edit;
+            _translator.translate(StenoChord::toStroke(keys), edit);
+            if (_textOutput && (edit.backspaces || edit.length)) _textOutput(edit);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+bool SQUIDSTENO::sendNow() {
+    if (!transport || !transport->isConnected()) return false;
+    return transport->sendReport(STENO_ID, (uint8_t*)&_stenoReport, sizeof(StenoReport));
+}
+
+// Pushes the held keys out again, same as a press or release would - nothing waits after it
 void SQUIDSTENO::sendStenoReport() {
-    if (!transport || !transport->isConnected()) {
+    if (!sendNow()) {
         SQUID_LOG_DEBUG(STENO_TAG, "Cannot send steno report - not connected");
-        return;
     }
-    
-    // Log the report in a readable format
-    char reportStr[64];
-    snprintf(reportStr, sizeof(reportStr), 
-             "Report: %02X %02X %02X %02X %02X %02X %02X %02X",
-             _stenoReport.keys[0], _stenoReport.keys[1], 
-             _stenoReport.keys[2], _stenoReport.keys[3],
-             _stenoReport.keys[4], _stenoReport.keys[5],
-             _stenoReport.keys[6], _stenoReport.keys[7]);
-    
-    SQUID_LOG_DEBUG(STENO_TAG, "Sending Plover HID report: %s", reportStr);
-    
-    bool result = transport->sendReport(STENO_ID, (uint8_t*)&_stenoReport, sizeof(StenoReport));
-    
-    if (result) {
-        SQUID_LOG_DEBUG(STENO_TAG, "Plover HID report sent successfully");
-    } else {
-        SQUID_LOG_ERROR(STENO_TAG, "Failed to send Plover HID report");
-    }
-    
-    delay(_delay_ms);
 }
 
 void SQUIDSTENO::onConnect() {
@@ -1,18 +1,19 @@
 /**
  * @file Steno.h
- * @brief PloverHID stenotype feature
+ * @brief Stenotype feature - PloverHID, Gemini PR or TX Bolt over serial, or translated in firmware from a dictionary
  */
  
 #ifndef STENO_H
 #define STENO_H
 
 #include "drivers/Software/Transport/Transport.h"
+#include "drivers/Software/Steno/StenoTranslator.h"
 
 typedef struct {
     uint8_t keys[8];  // 64 bits for 64 keys
 } StenoReport;
 
-static const uint8_t _stenoReportDescriptor[] = {
+static constexpr uint8_t _stenoReportDescriptor[] = {
   USAGE_PAGE(2),      0x50, 0xFF,                 USAGE(2),           0x56, 0x4C,              
   COLLECTION(1),      0x02,                       REPORT_ID(1),       STENO_ID,          
   LOGICAL_MAXIMUM(1), 0x01,                       REPORT_SIZE(1),     0x01,                    
@@ -161,19 +162,37 @@ MK(StenoKey, SR_XD,    STN_X26);
 MK(StenoKey, SL_PWR,   STN_PWR);
 MK(StenoKey, SR_PWR,   STN_PWR);
 
+// Where a chord goes once it's done
+enum StenoMode : uint8_t {
+    STENO_PLOVER_HID,   // Live key state over HID, Plover works out the chords itself
+    STENO_GEMINI,       // Gemini PR packets over serial
+    STENO_TXBOLT,       // TX Bolt packets over serial
+    STENO_DICTIONARY    // Looked up here and typed out as text, no Plover needed on the host
+};
+
+#define STENO_SERIAL_BAUD 9600   // What Plover expects for both serial protocols
+
 class SQUIDSTENO {
 private:
     Transport*  transport;
-    StenoReport _stenoReport;
-    uint32_t    _delay_ms = 7;
+    StenoReport _stenoReport;   // Keys held right now
+    StenoReport _chord;         // Every key pressed since the chord started
+    StenoMode   _mode;
+    Stream*     _serial;
+    
+    StenoTranslator _translator;
+    std::function<void(const StenoEdit&)> _textOutput;
     
     void updateStenoKey(StenoKey stenoKey, bool pressed);
+    bool sendNow();
+    bool anyHeld();
+    void endChord(const uint8_t keys[8]);
     
 public:
     SQUIDSTENO();
     ~SQUIDSTENO();
     
-    void   begin(Transport* transport, uint32_t delay_ms = 7);
+    void   begin(Transport* transport);
     void   onConnect();
     void   onDisconnect();
     
@@ -183,6 +202,14 @@ public:
     void   releaseAll();
     void   stenoStroke(const StenoKey* keys, size_t count);
     void   sendStenoReport();
+    
+    // Output modes
+    void   setMode(StenoMode mode);
+    StenoMode getMode() const { return _mode; }
+    // Gemini PR and TX Bolt go here - Serial1 on RX_PIN/TX_PIN with UART_ENABLE, or anything else (USB CDC works with Plover too)
+    void   setSerial(Stream* serial);
+    bool   setDictionary(const StenoDictionary* dict);
+    void   onText(std::function<void(const StenoEdit&)> output) { _textOutput = output; }
 };
 
 #endif
@@ -0,0 +1,98 @@
+/**
+ * @file Arduino.h
+ * @brief Just enough of the Arduino core for the host tests
+ *
+ * Time is simulated - micros() reads simNow, and anything that waits (delay, yield) moves it
+ * forward instead of sleeping, so timing code runs instantly and the same way every time.
+ */
+
+#ifndef FAKE_ARDUINO_H
+#define FAKE_ARDUINO_H
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stddef.h>
+
+extern uint64_t simNow;         // us
+extern uint32_t simMicrosStep;  // Added on every micros() call, for code that times its own work
+
+inline unsigned long micros() { simNow += simMicrosStep; return (unsigned long)simNow; }
+inline unsigned long millis() { return (unsigned long)(simNow / 1000); }
+inline void yield() { simNow += 1; }
+inline void delay(uint32_t ms) { simNow += ms * 1000ULL; }
+inline void delayMicroseconds(uint32_t us) { simNow += us; }
+
+#define INPUT        0x01
+#define OUTPUT       0x03
+#define INPUT_PULLUP 0x05
+#define LOW          0
+#define HIGH         1
+
+// Whatever was last written to each pin, reads see the line pulled up unless a test hooks them
+// to stand in for whatever's on the other end of the wire
+extern uint8_t simPinLevel[64];
+extern int  (*simPinRead)(uint8_t pin);
+extern void (*simPinWrite)(uint8_t pin, uint8_t level);
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t level) {
+    if (pin < 64) simPinLevel[pin] = level;
+    if (simPinWrite) simPinWrite(pin, level);
+}
+inline int  digitalRead(uint8_t pin) { return simPinRead ? simPinRead(pin) : HIGH; }
+inline uint16_t analogRead(uint8_t) { return 0; }
+
+#define IRAM_ATTR
+#define FALLING 0x02
+#define RISING  0x01
+
+// Attached handlers per pin, a test raises one with simInterrupt()
+extern void (*simISR[64])(void*);
+extern void* simISRArg[64];
+
+inline int  digitalPinToInterrupt(uint8_t pin) { return pin; }
+inline void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int) {
+    if (pin < 64) { simISR[pin] = isr; simISRArg[pin] = arg; }
+}
+// Plain handlers ride along as the argument of one that calls them
+inline void simCallPlainISR(void* isr) { reinterpret_cast<void (*)()>(isr)(); }
+inline void attachInterrupt(uint8_t pin, void (*isr)(), int mode) {
+    attachInterruptArg(pin, simCallPlainISR, reinterpret_cast<void*>(isr), mode);
+}
+inline void detachInterrupt(uint8_t pin) { if (pin < 64) simISR[pin] = nullptr; }
+inline bool simInterrupt(uint8_t pin) {
+    if (pin >= 64 || !simISR[pin]) return false;
+    simISR[pin](simISRArg[pin]);
+    return true;
+}
+
+template <typename T, typename L, typename H>
+inline T constrain(T x, L low, H high) { return x < low ? (T)low : x > high ? (T)high : x; }
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buffer++);
+        return n;
+    }
+    size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+};
+
+#endif
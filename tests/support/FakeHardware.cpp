@@ -0,0 +1,21 @@
+/**
+ * @file FakeHardware.cpp
+ * @brief State behind the fake Arduino and ESP-IDF headers
+ */
+
+#include "Arduino.h"
+#include "driver/rmt_tx.h"
+#include "driver/spi_master.h"
+
+uint64_t simNow = 0;
+uint32_t simMicrosStep = 0;
+uint8_t  simPinLevel[64];
+int  (*simPinRead)(uint8_t pin);
+void (*simPinWrite)(uint8_t pin, uint8_t level);
+void (*simISR[64])(void*);
+void* simISRArg[64];
+
+std::vector<std::vector<rmt_data_t>> rmtFrames;
+bool rmtBusy = false;
+std::vector<std::vector<uint8_t>> spiTransfers;
+int spiPending = 0;
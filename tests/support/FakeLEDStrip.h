@@ -0,0 +1,70 @@
+/**
+ * @file FakeLEDStrip.h
+ * @brief What a WS2812 or APA102 chain would be showing after the frames the fake RMT/SPI sent it
+ *
+ * Both are shift chains - the first LED keeps the first pixel it's given and passes the rest on,
+ * so a short frame only touches the LEDs at the front.
+ */
+
+#ifndef FAKELEDSTRIP_H
+#define FAKELEDSTRIP_H
+
+#include <vector>
+#include "driver/rmt_tx.h"
+#include "driver/spi_master.h"
+
+// WS2812 - 8 RMT symbols a byte, MSB first, a 1 has the long high time
+struct FakeWS2812Strip {
+    std::vector<uint8_t> bytes;
+    bool badSymbol = false;
+
+    explicit FakeWS2812Strip(size_t numBytes) : bytes(numBytes, 0) {}
+
+    void receive(const std::vector<rmt_data_t>& frame) {
+        for (size_t i = 0; i + 8 <= frame.size() && i / 8 < bytes.size(); i += 8) {
+            uint8_t b = 0;
+            for (size_t bit = 0; bit < 8; bit++) {
+                uint32_t s = frame[i + bit].val;
+                uint32_t high = s & 0x7FFF, low = (s >> 16) & 0x7FFF;
+                bool level0 = (s >> 15) & 1, level1 = (s >> 31) & 1;
+                if (!level0 || level1 || high + low != 12) badSymbol = true;
+                b = (b << 1) | (high > low);
+            }
+            bytes[i / 8] = b;
+        }
+    }
+
+    void receiveAll(std::vector<std::vector<rmt_data_t>>& frames) {
+        for (auto& f : frames) receive(f);
+        frames.clear();
+    }
+};
+
+// APA102/SK9822 - 4 zero bytes, then a 111xxxxx header and B G R per LED
+struct FakeAPA102Strip {
+    std::vector<uint8_t> bytes;   // Same BGR byte order the driver stores them in
+    bool badFrame = false;
+
+    explicit FakeAPA102Strip(size_t numBytes) : bytes(numBytes, 0) {}
+
+    void receive(const std::vector<uint8_t>& frame) {
+        // The zero tail after each frame is only there for the clock, it doesn't start anything
+        bool allZero = true;
+        for (uint8_t b : frame) allZero &= b == 0;
+        if (allZero) return;
+
+        if (frame.size() < 4 || frame[0] || frame[1] || frame[2] || frame[3]) badFrame = true;
+        for (size_t led = 0; 4 + led * 4 + 3 < frame.size(); led++) {
+            const uint8_t* p = &frame[4 + led * 4];
+            if ((p[0] & 0xE0) != 0xE0) badFrame = true;
+            for (size_t c = 0; c < 3 && led * 3 + c < bytes.size(); c++) bytes[led * 3 + c] = p[1 + c];
+        }
+    }
+
+    void receiveAll(std::vector<std::vector<uint8_t>>& frames) {
+        for (auto& f : frames) receive(f);
+        frames.clear();
+    }
+};
+
+#endif
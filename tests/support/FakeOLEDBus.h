@@ -0,0 +1,126 @@
+/**
+ * @file FakeOLEDBus.h
+ * @brief An SSD1306/SH110x stand-in - keeps its own display RAM from the commands and data it's sent
+ *
+ * What the OLED driver thinks is on screen and what this says is on the glass should always match,
+ * however the flush got there.
+ */
+
+#ifndef FAKEOLEDBUS_H
+#define FAKEOLEDBUS_H
+
+#include <string.h>
+#include "drivers/Hardware/OLED/OLEDBus.h"
+
+class FakeOLEDBus : public OLEDBus {
+public:
+    // SSD1306 is 128 columns and does horizontal addressing, SH1106 is 132 and only does pages
+    explicit FakeOLEDBus(uint8_t ramWidth = 128, uint8_t ramPages = 8, size_t chunk = OLED_FLUSH_CHUNK, bool pageOnly = false)
+        : ramWidth(ramWidth), ramPages(ramPages), chunk(chunk), pageOnly(pageOnly) {
+        memset(ram, 0, sizeof(ram));
+        resetCounters();
+    }
+
+    bool begin() override { return true; }
+
+    bool command(const uint8_t* cmds, size_t length) override {
+        commandCalls++;
+        for (size_t i = 0; i < length; i++) commandByte(cmds[i]);
+        return true;
+    }
+
+    bool data(const uint8_t* bytes, size_t length) override {
+        dataCalls++;
+        dataBytes += length;
+        if (length > largestData) largestData = length;
+        for (size_t i = 0; i < length; i++) dataByte(bytes[i]);
+        return true;
+    }
+
+    size_t maxChunk() const override { return chunk; }
+
+    // What's lit at (x, y) on the glass, after the start line has moved things round
+    bool pixel(uint8_t x, uint8_t y, uint8_t columnOffset = 0) const {
+        uint8_t line = (y + startLine) % (ramPages * 8);
+        return (ram[line / 8][x + columnOffset] >> (line % 8)) & 1;
+    }
+
+    // Junk in every byte, so a full redraw that misses something shows up
+    void scramble() { memset(ram, 0xA5, sizeof(ram)); }
+    void resetCounters() { commandCalls = dataCalls = dataBytes = largestData = 0; }
+
+    size_t  commandCalls;
+    size_t  dataCalls;
+    size_t  dataBytes;
+    size_t  largestData;
+    uint8_t startLine = 0;
+
+private:
+    void commandByte(uint8_t c) {
+        if (argsLeft) {
+            args[argCount++] = c;
+            if (--argsLeft == 0) finishCommand();
+            return;
+        }
+
+        current = c;
+        argCount = 0;
+        if (pageOnly && c == 0x20) return;   // Not a thing on SH110x, the 0x00 after it just sets the column
+        switch (c) {
+            case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3: case 0xD5:
+            case 0xD9: case 0xDA: case 0xDB: case 0xDC:
+                argsLeft = 1; return;
+            case 0x21: case 0x22: case 0xA3:
+                argsLeft = 2; return;
+            case 0x29: case 0x2A:
+                argsLeft = 5; return;
+            case 0x26: case 0x27:
+                argsLeft = 6; return;
+        }
+
+        if (c <= 0x0F)                  column = (column & 0xF0) | c;
+        else if (c <= 0x1F)             column = (column & 0x0F) | ((c & 0x0F) << 4);
+        else if (c >= 0x40 && c <= 0x7F) startLine = c & 0x3F;
+        else if (c >= 0xB0 && c <= 0xBF && !horizontal) page = c & 0x0F;
+    }
+
+    void finishCommand() {
+        switch (current) {
+            case 0x20: horizontal = args[0] == 0x00; break;
+            case 0x21: colStart = args[0]; colEnd = args[1]; column = colStart; break;
+            case 0x22: pageStart = args[0]; pageEnd = args[1]; page = pageStart; break;
+            case 0xDC: startLine = args[0]; break;
+        }
+    }
+
+    void dataByte(uint8_t b) {
+        if (page < ramPages && column < ramWidth) ram[page][column] = b;
+        column++;
+        if (!horizontal) return;
+        if (column > colEnd) {
+            column = colStart;
+            if (++page > pageEnd) page = pageStart;
+        }
+    }
+
+    uint8_t ram[16][132];
+    const uint8_t ramWidth;
+    const uint8_t ramPages;
+    const size_t  chunk;
+    const bool    pageOnly;
+
+    bool    horizontal = false;
+    uint8_t column = 0;
+    uint8_t page = 0;
+    uint8_t colStart = 0;
+    uint8_t colEnd = 127;
+    uint8_t pageStart = 0;
+    uint8_t pageEnd = 7;
+
+    uint8_t current = 0;
+    uint8_t args[6];
+    uint8_t argCount = 0;
+    uint8_t argsLeft = 0;
+};
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ * @file MockTransport.h
+ * @brief A Transport that keeps every report it's given, stamped with the simulated time
+ */
+
+#ifndef MOCKTRANSPORT_H
+#define MOCKTRANSPORT_H
+
+#include <Arduino.h>
+#include <vector>
+#include "drivers/Software/Transport/Transport.h"
+
+class MockTransport : public Transport {
+public:
+    struct Report {
+        uint64_t             time;
+        uint8_t              id;
+        std::vector<uint8_t> data;
+    };
+
+    std::vector<Report> reports;
+    bool     connected = true;
+    bool     failSend = false;   // Every send refused, like a full BLE queue
+    uint32_t interval = 8000;
+
+    bool begin() override { return true; }
+    void end() override {}
+    void update() override {}
+
+    bool isConnected() override { return connected; }
+    bool connect() override { connected = true; return true; }
+    void disconnect() override { connected = false; }
+
+    bool sendData(const uint8_t*, size_t) override { return true; }
+    bool sendReport(uint8_t reportId, const uint8_t* data, size_t length) override {
+        if (failSend || !connected) return false;
+        reports.push_back(Report{ simNow, reportId, std::vector<uint8_t>(data, data + length) });
+        return true;
+    }
+
+    void setDeviceInfo(const char*, const char*, uint16_t, uint16_t, uint16_t) override {}
+    void setBatteryLevel(uint8_t) override {}
+    void setAppearance(uint16_t) override {}
+    void setCallbacks(TransportCallbacks*) override {}
+    void setReportMap(const uint8_t*, size_t) override {}
+    bool supportsHID() override { return true; }
+    uint32_t getReportInterval() override { return interval; }
+};
+
+#endif
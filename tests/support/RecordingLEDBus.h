@@ -0,0 +1,39 @@
+/**
+ * @file RecordingLEDBus.h
+ * @brief An LEDBus that keeps what NeoPixel asked of it - changed ranges, lengths and the output table
+ */
+
+#ifndef RECORDINGLEDBUS_H
+#define RECORDINGLEDBUS_H
+
+#include <string.h>
+#include <vector>
+#include "drivers/Hardware/LED/LEDBus.h"
+
+class RecordingLEDBus : public LEDBus {
+public:
+    bool begin(uint16_t numBytes) override {
+        begun = numBytes;
+        return true;
+    }
+
+    void encode(const uint8_t* pixels, const LEDRange& changed, const uint8_t* table) override {
+        encoded.push_back(changed);
+        memcpy(this->table, table, sizeof(this->table));
+    }
+
+    bool transmit(uint16_t length) override {
+        lengths.push_back(length);
+        return !failTransmit;
+    }
+
+    bool ready(void) override { return true; }
+
+    uint16_t begun = 0;
+    bool failTransmit = false;
+    std::vector<LEDRange> encoded;
+    std::vector<uint16_t> lengths;
+    uint8_t table[256];
+};
+
+#endif
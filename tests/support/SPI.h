@@ -0,0 +1,30 @@
+// Just enough of SPI for the OLED bus - every transaction is kept
+#ifndef SPI_H
+#define SPI_H
+
+#include "Arduino.h"
+#include <vector>
+
+#define MSBFIRST  1
+#define SPI_MODE0 0
+
+struct SPISettings {
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) {}
+};
+
+class SPIClass {
+public:
+    void begin(int8_t sck, int8_t miso, int8_t mosi, int8_t ss) {}
+    void beginTransaction(SPISettings settings) {}
+    void writeBytes(const uint8_t* bytes, uint32_t length) {
+        transactions.emplace_back(bytes, bytes + length);
+        wasData.push_back(dcPin >= 0 && simPinLevel[dcPin]);
+    }
+    void endTransaction() {}
+
+    int8_t dcPin = -1;   // Set it to have each transaction tagged as data or command
+    std::vector<std::vector<uint8_t>> transactions;
+    std::vector<bool> wasData;
+};
+
+#endif
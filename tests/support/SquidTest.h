@@ -0,0 +1,39 @@
+/**
+ * @file SquidTest.h
+ * @brief Bare-bones checks for the host tests - nothing to fetch, a failed check just gets counted
+ */
+
+#ifndef SQUIDTEST_H
+#define SQUIDTEST_H
+
+#include <stdio.h>
+
+inline int& squidTestFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        squidTestFailures()++; \
+    } \
+} while (0)
+
+#define CHECK_EQ(a, b) do { \
+    long long _a = (long long)(a), _b = (long long)(b); \
+    if (_a != _b) { \
+        fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed - %lld vs %lld\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+        squidTestFailures()++; \
+    } \
+} while (0)
+
+#define RUN_TEST(fn) do { \
+    int _before = squidTestFailures(); \
+    fn(); \
+    printf("%s %s\n", squidTestFailures() == _before ? "ok  " : "FAIL", #fn); \
+} while (0)
+
+#define TEST_RESULT() (squidTestFailures() ? 1 : 0)
+
+#endif
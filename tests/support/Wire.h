@@ -0,0 +1,25 @@
+// Just enough of Wire for the OLED bus - every transmission is kept, control byte and all
+#ifndef WIRE_H
+#define WIRE_H
+
+#include "Arduino.h"
+#include <vector>
+
+#define I2C_BUFFER_LENGTH 128
+
+class TwoWire {
+public:
+    bool begin(int sda, int scl, uint32_t frequency) { return true; }
+    void setTimeOut(uint16_t timeOutMillis) {}
+    void beginTransmission(uint8_t address) { transmissions.push_back({ address }); }
+    size_t write(uint8_t b) { transmissions.back().push_back(b); return 1; }
+    size_t write(const uint8_t* bytes, size_t length) {
+        transmissions.back().insert(transmissions.back().end(), bytes, bytes + length);
+        return length;
+    }
+    uint8_t endTransmission() { return transmissions.back().size() > I2C_BUFFER_LENGTH + 1 ? 1 : 0; }
+
+    std::vector<std::vector<uint8_t>> transmissions;   // Address first, then what was written
+};
+
+#endif
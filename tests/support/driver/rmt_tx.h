@@ -0,0 +1,25 @@
+#ifndef FAKE_RMT_TX_H
+#define FAKE_RMT_TX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Arduino-ESP32's RMT wrapper, every write lands in rmtFrames and is done as soon as rmtBusy is cleared
+typedef struct { uint32_t val; } rmt_data_t;
+
+#define RMT_TX_MODE          1
+#define RMT_MEM_NUM_BLOCKS_1 1
+
+extern std::vector<std::vector<rmt_data_t>> rmtFrames;
+extern bool rmtBusy;
+
+inline bool rmtInit(int, int, int, uint32_t) { return true; }
+inline bool rmtDeinit(int) { return true; }
+inline bool rmtTransmitCompleted(int) { return !rmtBusy; }
+inline bool rmtWriteAsync(int, rmt_data_t* data, size_t count) {
+    rmtFrames.emplace_back(data, data + count);
+    return true;
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef FAKE_SPI_MASTER_H
+#define FAKE_SPI_MASTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// The bits of the ESP-IDF SPI master LEDSPIBus uses. Queued transactions are copied into
+// spiTransfers and finish as soon as anybody asks.
+typedef int   spi_host_device_t;
+typedef void* spi_device_handle_t;
+typedef int   esp_err_t;
+
+#define ESP_OK          0
+#define ESP_FAIL        -1
+#define SPI2_HOST       1
+#define SPI_DMA_CH_AUTO 3
+#define portMAX_DELAY   0xFFFFFFFF
+
+struct spi_transaction_t {
+    size_t      length;   // Bits
+    const void* tx_buffer;
+};
+
+struct spi_bus_config_t {
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int max_transfer_sz;
+};
+
+struct spi_device_interface_config_t {
+    int clock_speed_hz;
+    int mode;
+    int spics_io_num;
+    int queue_size;
+};
+
+extern std::vector<std::vector<uint8_t>> spiTransfers;
+extern int spiPending;
+
+inline esp_err_t spi_bus_initialize(spi_host_device_t, const spi_bus_config_t*, int) { return ESP_OK; }
+inline esp_err_t spi_bus_free(spi_host_device_t) { return ESP_OK; }
+inline esp_err_t spi_bus_add_device(spi_host_device_t, const spi_device_interface_config_t*, spi_device_handle_t* handle) {
+    *handle = nullptr;
+    return ESP_OK;
+}
+inline esp_err_t spi_bus_remove_device(spi_device_handle_t) { return ESP_OK; }
+inline esp_err_t spi_device_queue_trans(spi_device_handle_t, spi_transaction_t* trans, uint32_t) {
+    const uint8_t* bytes = (const uint8_t*)trans->tx_buffer;
+    spiTransfers.emplace_back(bytes, bytes + trans->length / 8);
+    spiPending++;
+    return ESP_OK;
+}
+inline esp_err_t spi_device_get_trans_result(spi_device_handle_t, spi_transaction_t**, uint32_t) {
+    if (!spiPending) return ESP_FAIL;
+    spiPending--;
+    return ESP_OK;
+}
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef FAKE_ESP_HEAP_CAPS_H
+#define FAKE_ESP_HEAP_CAPS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_DMA 0
+
+inline void* heap_caps_calloc(size_t n, size_t size, uint32_t) { return calloc(n, size); }
+inline void  heap_caps_free(void* p) { free(p); }
+
+#endif
@@ -0,0 +1,164 @@
+// Analog conditioning - calibration maps the ends and the rest point where they should go, the
+// deadzones don't leave a jump, and the filters smooth noise without dragging behind real moves.
+// Also times a sample through each filter across a full set of channels.
+
+#include "drivers/Software/Analog/AnalogFilter.h"
+#include "SquidTest.h"
+#include <chrono>
+#include <random>
+
+// Same default as Analog.h, which needs the ESP32 ADC headers
+#ifndef ANALOG_MAX_CHANNELS
+#define ANALOG_MAX_CHANNELS 8
+#endif
+
+static void testCalibration() {
+    AnalogChannel c;
+    c.setCalibration(100, 2000, 4000);
+    CHECK_EQ(c.process(100), -ANALOG_AXIS_MAX);
+    CHECK_EQ(c.process(2000), 0);
+    CHECK_EQ(c.process(4000), ANALOG_AXIS_MAX);
+    CHECK_EQ(c.process(5000), ANALOG_AXIS_MAX);   // Past the end just clamps
+    CHECK_EQ(c.process(0), -ANALOG_AXIS_MAX);
+    CHECK_EQ(c.lastRaw(), 0);
+
+    // Lopsided ranges still hit full scale both ways, halfway is half
+    CHECK(abs(c.process(1050) + ANALOG_AXIS_MAX / 2) <= 2);
+    CHECK(abs(c.process(3000) - ANALOG_AXIS_MAX / 2) <= 2);
+
+    c.setCalibration(100, 2000, 4000, true);
+    CHECK_EQ(c.process(4000), -ANALOG_AXIS_MAX);
+
+    c.setCalibration(100, 2000, 4000);
+    c.setCenter(2100);
+    CHECK_EQ(c.process(2100), 0);
+}
+
+static void testTriggers() {
+    AnalogChannel bottom, top;
+    bottom.setCalibration(200, 200, 3800);
+    top.setCalibration(200, 3800, 3800);   // Rests high, pulls down
+    CHECK_EQ(bottom.process(100), 0);
+    CHECK_EQ(bottom.process(3800), ANALOG_AXIS_MAX);
+    CHECK(abs(bottom.process(2000) - ANALOG_AXIS_MAX / 2) <= 2);
+    CHECK_EQ(top.process(3900), 0);
+    CHECK_EQ(top.process(200), ANALOG_AXIS_MAX);
+}
+
+static void testDeadzonesAreContinuous() {
+    AnalogChannel c;
+    c.setCalibration(0, 2048, 4095);
+    c.setDeadzone(2000, 1000);
+
+    CHECK_EQ(c.process(2048 + 100), 0);   // Inside the inner zone
+    CHECK_EQ(c.process(2048 - 100), 0);
+    CHECK_EQ(c.process(4095 - 50), ANALOG_AXIS_MAX);   // Inside the outer zone
+
+    // Walking the whole range, the output never goes backwards and never jumps
+    int16_t prev = c.process(0);
+    bool monotonic = true;
+    int biggestStep = 0;
+    for (int raw = 1; raw <= 4095; raw++) {
+        int16_t v = c.process(raw);
+        if (v < prev) monotonic = false;
+        if (v - prev > biggestStep) biggestStep = v - prev;
+        prev = v;
+    }
+    CHECK(monotonic);
+    // What's left after the deadzones is stretched, so a raw step is a bit more than 16 units - but no cliff
+    CHECK(biggestStep < 40);
+}
+
+static void testIIR() {
+    AnalogChannel c;
+    c.filter().setIIR(3);
+    c.setCalibration(0, 2048, 4095);
+    c.process(2048);
+
+    // Each sample closes 1/8 of the gap, never overshoots, and gets there
+    int16_t prev = 0;
+    bool rising = true;
+    int16_t second = 0;
+    for (int i = 0; i < 200; i++) {
+        int16_t v = c.process(4095);
+        if (i == 0) CHECK(abs(v - ANALOG_AXIS_MAX / 8) <= 8);
+        if (i == 1) second = v;
+        rising &= v >= prev;
+        prev = v;
+    }
+    CHECK(second > ANALOG_AXIS_MAX / 8);
+    CHECK(rising);
+    CHECK(prev >= ANALOG_AXIS_MAX - 1);
+
+    c.filter().reset();
+    CHECK_EQ(c.process(2048), 0);   // Starts fresh from whatever comes next
+}
+
+static void testOneEuro() {
+    std::mt19937 rng(41);
+    AnalogChannel c;
+    c.filter().setSampleRate(1000);
+    c.filter().setOneEuro(1.0f, 0.0005f);
+    c.setCalibration(0, 2048, 4095);
+
+    // At rest with +-10 counts of noise (about +-160 output units)
+    double jitter = 0;
+    int16_t prev = c.process(2048);
+    for (int i = 0; i < 1000; i++) {
+        int16_t v = c.process(2048 + (int)(rng() % 21) - 10);
+        if (i > 200) jitter += abs(v - prev);
+        prev = v;
+    }
+    jitter /= 799;
+    CHECK(jitter < 5);
+
+    // A big fast move gets followed in a few tens of ms, not seconds
+    int settled = -1;
+    for (int i = 0; i < 1000 && settled < 0; i++) {
+        int16_t v = c.process(2048 + 1500 + (int)(rng() % 21) - 10);
+        if (v > 24000 * 9 / 10) settled = i;
+    }
+    CHECK(settled >= 0 && settled < 40);
+}
+
+// Not a pass/fail beyond the filters doing something - numbers to keep an eye on when a filter
+// changes. Every channel runs at once, like Analog::update() does.
+static void benchFilters() {
+    const int frames = 1000, reps = 100;
+    std::mt19937 rng(41);
+    static int32_t raws[frames][ANALOG_MAX_CHANNELS];
+    for (int f = 0; f < frames; f++)
+        for (int ch = 0; ch < ANALOG_MAX_CHANNELS; ch++)
+            raws[f][ch] = 2048 + (f * (ch + 1) * 3) % 1500 + (int)(rng() % 21) - 10;
+
+    const char* names[] = { "none", "IIR", "one-euro" };
+    for (int mode = 0; mode < 3; mode++) {
+        AnalogChannel channels[ANALOG_MAX_CHANNELS];
+        for (AnalogChannel& c : channels) {
+            c.setCalibration(0, 2048, 4095);
+            c.filter().setSampleRate(1000);
+            if (mode == 1) c.filter().setIIR(3);
+            if (mode == 2) c.filter().setOneEuro(1.0f, 0.0005f);
+        }
+
+        long sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int rep = 0; rep < reps; rep++)
+            for (int f = 0; f < frames; f++)
+                for (int ch = 0; ch < ANALOG_MAX_CHANNELS; ch++) sum += channels[ch].process(raws[f][ch]);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        printf("     %-8s %.1f ns/sample, %.1f ns for all %d channels\n", names[mode],
+               ns / ((double)reps * frames * ANALOG_MAX_CHANNELS), ns / ((double)reps * frames), ANALOG_MAX_CHANNELS);
+        CHECK(sum != 0);
+    }
+}
+
+int main() {
+    RUN_TEST(testCalibration);
+    RUN_TEST(testTriggers);
+    RUN_TEST(testDeadzonesAreContinuous);
+    RUN_TEST(testIIR);
+    RUN_TEST(testOneEuro);
+    RUN_TEST(benchFilters);
+    return TEST_RESULT();
+}
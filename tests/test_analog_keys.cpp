@@ -0,0 +1,162 @@
+// Analog keys - actuation with hysteresis, rapid trigger re-pressing and releasing anywhere past
+// the actuation point, either magnet direction, and the mux matrix reporting keys after the
+// digital ones however the two got set up. Also times a 100 key scan.
+
+#include "drivers/Software/Basic/Matrix/AnalogMatrix.h"
+#include "SquidTest.h"
+#include <chrono>
+
+// One key, rest at 2000 and bottomed out at 3000 raw, fed in travel units
+struct OneKey {
+    AnalogKeys keys;
+    int events = 0;
+
+    OneKey() {
+        keys.begin(1);
+        keys.setCalibration(0, 2000, 3000);
+    }
+    bool feed(int travel) {
+        uint16_t raw = 2000 + (travel * 1000 + 511) / ANALOG_KEY_TRAVEL;
+        keys.process(&raw, [this](size_t, bool) { events++; });
+        return keys.isPressed(0);
+    }
+};
+
+static void testActuationAndHysteresis() {
+    OneKey k;
+    k.keys.setActuation(0, 400, 30);
+    CHECK(!k.feed(0));
+    CHECK(!k.feed(390));
+    CHECK(k.feed(410));
+    CHECK(k.feed(380));    // Inside the hysteresis
+    CHECK(!k.feed(360));
+    CHECK_EQ(k.events, 2);
+    CHECK(abs(k.keys.getTravel(0) - 360) <= 2);
+}
+
+static void testRapidTrigger() {
+    OneKey k;
+    k.keys.setActuation(0, 400);
+    k.keys.setRapidTrigger(0, 50);
+    CHECK(!k.feed(300));
+    CHECK(k.feed(420));
+    CHECK(k.feed(800));
+    CHECK(k.feed(770));    // Up 30, not enough
+    CHECK(!k.feed(740));   // Up 60 from the deepest point, well past the actuation point
+    CHECK(!k.feed(770));   // Down 30
+    CHECK(k.feed(800));    // Down 60 from the highest point since releasing
+    CHECK(!k.feed(100));
+    CHECK_EQ(k.events, 4);
+
+    // Back above the actuation point it's a normal key again
+    CHECK(!k.feed(390));
+}
+
+static void testReversedMagnet() {
+    AnalogKeys keys;
+    keys.begin(1);
+    keys.setCalibration(0, 3000, 1000);   // Reads lower as it goes down
+    keys.setActuation(0, 400);
+    uint16_t raw = 1500;
+    int flips = keys.process(&raw, [](size_t, bool) {});
+    CHECK_EQ(flips, 1);
+    CHECK(keys.isPressed(0));
+    CHECK(abs(keys.getTravel(0) - 767) <= 2);
+    raw = 3100;   // Past rest clamps to 0
+    keys.process(&raw, [](size_t, bool) {});
+    CHECK_EQ(keys.getTravel(0), 0);
+}
+
+static void testCalibrateRestKeepsTravel() {
+    AnalogKeys keys;
+    keys.begin(2);
+    keys.setCalibration(0, 2000, 3000);
+    keys.setCalibration(1, 2000, 1000);
+    const uint16_t drifted[] = { 2100, 1900 };
+    keys.calibrateRest(drifted);
+
+    // Same distance from the new rest gives the same travel, both ways round
+    const uint16_t halfway[] = { 2600, 1400 };
+    keys.process(halfway, [](size_t, bool) {});
+    CHECK(abs(keys.getTravel(0) - ANALOG_KEY_TRAVEL / 2) <= 2);
+    CHECK(abs(keys.getTravel(1) - ANALOG_KEY_TRAVEL / 2) <= 2);
+}
+
+// Two 8 channel muxes behind 3 select lines, pressing keys by setting their voltage
+struct FakeMux {
+    uint16_t level[2][8];
+    uint8_t  select = 0;
+
+    FakeMux() {
+        for (auto& mux : level)
+            for (auto& v : mux) v = 2000;
+    }
+    void write(uint8_t pin, uint8_t value) {
+        uint8_t bit = pin - 10;   // Select lines on 10, 11, 12
+        select = (select & ~(1 << bit)) | ((value ? 1 : 0) << bit);
+    }
+    uint16_t read(uint8_t pin) { return level[pin - 20][select]; }   // Common pins on 20 and 21
+};
+
+static void testMatrixOffsetAndOrder() {
+    FakeMux mux;
+    SQUIDANALOGMATRIX matrix;
+    std::vector<std::pair<size_t, bool>> events;
+    CHECK(matrix.begin(AnalogMuxConfig({ 10, 11, 12 }, { 20, 21 }, 12),
+                       [&](size_t key, bool pressed) { events.push_back({ key, pressed }); }, 0,
+                       [](uint8_t, uint8_t) {},
+                       [&](uint8_t pin, uint8_t value) { mux.write(pin, value); },
+                       [&](uint8_t pin) { return mux.read(pin); }));
+    CHECK_EQ(matrix.getSwitchCount(), 12);   // Capped below the 16 channels there are
+    matrix.keys().setAll(400);
+    for (size_t i = 0; i < 12; i++) matrix.keys().setCalibration(i, 2000, 3000);
+
+    // The digital matrix in front of it only got its size afterwards
+    matrix.setIndexOffset(20);
+
+    mux.level[1][2] = 3000;   // Key 8 + 2
+    matrix.update();
+    CHECK_EQ(events.size(), 1);
+    CHECK_EQ(events[0].first, 30);
+    CHECK(events[0].second);
+    CHECK(matrix.isPressed(30));
+    CHECK(!matrix.isPressed(10));   // A digital key's index, not one of these
+    CHECK_EQ(matrix.getRaw(10), 3000);
+
+    mux.level[1][2] = 2000;
+    mux.level[0][0] = 2900;
+    matrix.update();
+    CHECK_EQ(events.size(), 3);
+    CHECK_EQ(events[1].first, 20);
+    CHECK_EQ(events[2].first, 30);
+    CHECK(!events[2].second);
+}
+
+// Not a pass/fail - a number to keep an eye on when the scan kernel changes
+static void benchScan() {
+    const int keys = 100, frames = 1000, reps = 200;
+    AnalogKeys bench;
+    bench.begin(keys);
+    bench.setAll(400, 30);
+    static uint16_t raws[frames][keys];
+    for (int f = 0; f < frames; f++)
+        for (int i = 0; i < keys; i++) raws[f][i] = 2048 + ((f * 7 + i * 13) % 700);
+
+    size_t changes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int rep = 0; rep < reps; rep++)
+        for (int f = 0; f < frames; f++) changes += bench.process(raws[f], [](size_t, bool) {});
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("     100 keys: %.1f ns/scan (%zu changes)\n", ns / (reps * frames), changes);
+    CHECK(changes > 0);
+}
+
+int main() {
+    RUN_TEST(testActuationAndHysteresis);
+    RUN_TEST(testRapidTrigger);
+    RUN_TEST(testReversedMagnet);
+    RUN_TEST(testCalibrateRestKeepsTravel);
+    RUN_TEST(testMatrixOffsetAndOrder);
+    RUN_TEST(benchScan);
+    return TEST_RESULT();
+}
@@ -0,0 +1,153 @@
+// BLE bond cache - hosts come back most recent first, the least recent one makes room for a new
+// host, and the flash blob round-trips while anything truncated, corrupt or from an older layout
+// gets turned away. Also the config hash that decides whether the GATT table needs setting up again.
+
+#include "drivers/Software/Transport/BLE/BondCache.h"
+#include "SquidTest.h"
+#include <string.h>
+
+static const uint8_t* host(uint8_t n) {
+    static uint8_t addresses[8][6];
+    for (int i = 0; i < 6; i++) addresses[n][i] = 0xC0 + n * 6 + i;
+    return addresses[n];
+}
+
+static bool candidateIs(const BondCache& cache, size_t rank, uint8_t n, uint8_t type = 0) {
+    BondCacheEntry e;
+    return cache.getCandidate(rank, e) && !memcmp(e.address, host(n), 6) && e.addressType == type;
+}
+
+static void testMostRecentFirst() {
+    BondCache cache;
+    BondCacheEntry e;
+    CHECK_EQ(cache.hostCount(), 0);
+    CHECK(!cache.getCandidate(0, e));
+
+    cache.recordHost(host(0), 0);
+    cache.recordHost(host(1), 0);
+    cache.recordHost(host(2), 0);
+    CHECK_EQ(cache.hostCount(), 3);
+    CHECK(candidateIs(cache, 0, 2));
+    CHECK(candidateIs(cache, 1, 1));
+    CHECK(candidateIs(cache, 2, 0));
+    CHECK(!cache.getCandidate(3, e));
+
+    // Coming back moves a host to the front without a second entry
+    cache.recordHost(host(0), 0);
+    CHECK_EQ(cache.hostCount(), 3);
+    CHECK(candidateIs(cache, 0, 0));
+    CHECK(candidateIs(cache, 2, 1));
+
+    // Same address, other type is another host
+    cache.recordHost(host(0), 1);
+    CHECK_EQ(cache.hostCount(), 4);
+    CHECK(candidateIs(cache, 0, 0, 1));
+
+    // The same host again straight away is nothing new to write
+    cache.save();
+    cache.recordHost(host(0), 1);
+    CHECK(!cache.isDirty());
+    cache.recordHost(host(1), 0);
+    CHECK(cache.isDirty());
+}
+
+static void testEvictionAndForget() {
+    BondCache cache;
+    for (uint8_t n = 0; n < BOND_CACHE_SIZE; n++) cache.recordHost(host(n), 0);
+    cache.recordHost(host(0), 0);                   // 1 is now the least recent
+    cache.recordHost(host(BOND_CACHE_SIZE), 0);
+    CHECK_EQ(cache.hostCount(), BOND_CACHE_SIZE);
+    CHECK(candidateIs(cache, 0, BOND_CACHE_SIZE));
+    CHECK(candidateIs(cache, 1, 0));
+    CHECK(!cache.forgetHost(host(1), 0));           // Already gone
+
+    cache.save();
+    CHECK(cache.forgetHost(host(0), 0));
+    CHECK(cache.isDirty());
+    CHECK_EQ(cache.hostCount(), BOND_CACHE_SIZE - 1);
+    CHECK(candidateIs(cache, 0, BOND_CACHE_SIZE));
+    CHECK(candidateIs(cache, 1, BOND_CACHE_SIZE - 1));
+
+    // The freed slot gets used before anyone else is kicked out
+    cache.recordHost(host(6), 0);
+    CHECK_EQ(cache.hostCount(), BOND_CACHE_SIZE);
+    CHECK(candidateIs(cache, BOND_CACHE_SIZE - 1, 2));
+}
+
+static void testBlobRoundTrip() {
+    BondCache cache;
+    cache.setConfigHash(0x12345678);
+    cache.recordHost(host(0), 0);
+    cache.recordHost(host(1), 1);
+    BondCache::Blob blob = cache.save();
+    CHECK(!cache.isDirty());
+
+    BondCache loaded;
+    CHECK(loaded.isDirty());                        // Nothing on flash yet is worth writing
+    CHECK(loaded.load(&blob, sizeof(blob)));
+    CHECK(!loaded.isDirty());
+    CHECK_EQ(loaded.hostCount(), 2);
+    CHECK(candidateIs(loaded, 0, 1, 1));
+    CHECK(candidateIs(loaded, 1, 0));
+    CHECK(loaded.configMatches(0x12345678));
+
+    // Sequence numbers carry on from where they were, so a new host still goes to the front
+    loaded.recordHost(host(2), 0);
+    CHECK(candidateIs(loaded, 0, 2));
+}
+
+static void testBadBlobs() {
+    BondCache cache;
+    cache.recordHost(host(0), 0);
+    BondCache::Blob good = cache.save();
+
+    BondCache target;
+    CHECK(!target.load(nullptr, sizeof(good)));
+    CHECK(!target.load(&good, sizeof(good) - 1));   // Blob from a build with a different layout
+
+    BondCache::Blob corrupt = good;
+    corrupt.entries[0].address[3] ^= 0x10;
+    CHECK(!target.load(&corrupt, sizeof(corrupt)));
+
+    // Checksums fine, but the version or the count says it's not ours to trust
+    BondCache::Blob old = good;
+    old.version = BOND_CACHE_VERSION + 1;
+    old.checksum = BondCache::hash(&old, offsetof(BondCache::Blob, checksum));
+    CHECK(!target.load(&old, sizeof(old)));
+    BondCache::Blob tooMany = good;
+    tooMany.count = BOND_CACHE_SIZE + 1;
+    tooMany.checksum = BondCache::hash(&tooMany, offsetof(BondCache::Blob, checksum));
+    CHECK(!target.load(&tooMany, sizeof(tooMany)));
+
+    // Nothing it turned away got in
+    CHECK_EQ(target.hostCount(), 0);
+    CHECK(target.load(&good, sizeof(good)));
+    CHECK_EQ(target.hostCount(), 1);
+}
+
+static void testConfigHash() {
+    // FNV-1a, and chaining is the same as hashing it all in one go
+    CHECK_EQ(BondCache::hash("", 0), 2166136261u);
+    CHECK_EQ(BondCache::hash("a", 1), 0xE40C292Cu);
+    CHECK_EQ(BondCache::hash("foobar", 6), BondCache::hash("bar", 3, BondCache::hash("foo", 3)));
+
+    BondCache cache;
+    cache.setConfigHash(1);
+    cache.save();
+    cache.setConfigHash(1);
+    CHECK(!cache.isDirty());
+    CHECK(cache.configMatches(1));
+    cache.setConfigHash(2);
+    CHECK(cache.isDirty());
+    CHECK(!cache.configMatches(1));
+    CHECK_EQ(cache.getConfigHash(), 2);
+}
+
+int main() {
+    RUN_TEST(testMostRecentFirst);
+    RUN_TEST(testEvictionAndForget);
+    RUN_TEST(testBlobRoundTrip);
+    RUN_TEST(testBadBlobs);
+    RUN_TEST(testConfigHash);
+    return TEST_RESULT();
+}
@@ -0,0 +1,106 @@
+// HID feature profiles - everything compiled in starts switched on and served straight from the
+// full descriptor, a profile builds one from just its features' parts in table order, the keyboard
+// never goes, the spacemouse and the mouse share one image, and asking for something that isn't
+// compiled in changes nothing.
+
+#include "drivers/Software/HID/FeatureRegistry.h"
+#include "SquidTest.h"
+#include <string.h>
+#include <vector>
+
+static const uint8_t nkro[]  = { 0x85, 0x01, 0xC0 };
+static const uint8_t media[] = { 0x85, 0x02 };
+static const uint8_t puck[]  = { 0x85, 0x03 };
+static const uint8_t mouse[] = { 0x85, 0x06, 0x09, 0x02 };
+static const uint8_t steno[] = { 0x85, 0x50 };
+static const uint8_t full[]  = { 0x85, 0x01, 0xC0, 0x85, 0x02, 0x85, 0x03, 0x85, 0x06, 0x09, 0x02, 0x85, 0x50 };
+
+static const HIDFeatureEntry table[] = {
+    { HID_FEATURE_NKRO,       nkro,  sizeof(nkro),  "NKRO"       },
+    { HID_FEATURE_MEDIA,      media, sizeof(media), "Media"      },
+    { HID_FEATURE_SPACEMOUSE, puck,  sizeof(puck),  "Spacemouse" },
+    { HID_FEATURE_MOUSE,      mouse, sizeof(mouse), "Mouse"      },
+    { HID_FEATURE_STENO,      steno, sizeof(steno), "Steno"      },
+};
+
+static bool describes(const HIDFeatureRegistry& r, std::vector<uint8_t> expect) {
+    return r.descriptorLength() == expect.size() && !memcmp(r.descriptor(), expect.data(), expect.size());
+}
+
+static HIDFeatureRegistry registry() {
+    HIDFeatureRegistry r;
+    r.begin(table, 5, full, sizeof(full));
+    return r;
+}
+
+static void testStartsWithEverything() {
+    HIDFeatureRegistry r = registry();
+    CHECK_EQ(r.available(), HID_FEATURE_NKRO | HID_FEATURE_MEDIA | HID_FEATURE_SPACEMOUSE | HID_FEATURE_MOUSE | HID_FEATURE_STENO);
+    CHECK_EQ(r.active(), r.available());
+    CHECK(r.descriptor() == full);                 // The one in flash, not a copy
+    CHECK_EQ(r.descriptorLength(), sizeof(full));
+    CHECK(!r.setProfile(HID_FEATURE_ALL));         // Already that
+}
+
+static void testProfiles() {
+    HIDFeatureRegistry r = registry();
+    CHECK(r.setProfile(HID_PROFILE_STENO));
+    CHECK_EQ(r.active(), HID_FEATURE_NKRO | HID_FEATURE_STENO);
+    CHECK(r.isActive(HID_FEATURE_STENO));
+    CHECK(!r.isActive(HID_FEATURE_MOUSE));
+    CHECK(describes(r, { 0x85, 0x01, 0xC0, 0x85, 0x50 }));
+    CHECK(!r.setProfile(HID_PROFILE_STENO));
+
+    // Table order whatever order the bits are in
+    CHECK(r.setProfile(HID_FEATURE_STENO | HID_FEATURE_MEDIA));
+    CHECK(describes(r, { 0x85, 0x01, 0xC0, 0x85, 0x02, 0x85, 0x50 }));
+
+    // Back to the lot goes back to flash
+    CHECK(r.setProfile(HID_FEATURE_ALL));
+    CHECK(r.descriptor() == full);
+}
+
+static void testKeyboardStays() {
+    HIDFeatureRegistry r = registry();
+    CHECK(r.setProfile(HID_FEATURE_MOUSE));
+    CHECK_EQ(r.active(), HID_FEATURE_NKRO | HID_FEATURE_MOUSE);
+    CHECK(describes(r, { 0x85, 0x01, 0xC0, 0x85, 0x06, 0x09, 0x02 }));
+    CHECK(r.setProfile(0));
+    CHECK(describes(r, { 0x85, 0x01, 0xC0 }));
+}
+
+// One image, the puck one minute and a macropad the next
+static void testSixDofAndMacropad() {
+    HIDFeatureRegistry r = registry();
+    CHECK(r.setProfile(HID_PROFILE_6DOF));
+    CHECK_EQ(r.active(), HID_FEATURE_NKRO | HID_FEATURE_SPACEMOUSE);
+    CHECK(describes(r, { 0x85, 0x01, 0xC0, 0x85, 0x03 }));
+    CHECK(r.setProfile(HID_PROFILE_MACROPAD));
+    CHECK_EQ(r.active(), HID_FEATURE_NKRO | HID_FEATURE_MEDIA | HID_FEATURE_MOUSE);
+    CHECK(describes(r, { 0x85, 0x01, 0xC0, 0x85, 0x02, 0x85, 0x06, 0x09, 0x02 }));
+    CHECK(r.setProfile(HID_FEATURE_SPACEMOUSE | HID_FEATURE_MOUSE));
+    CHECK(describes(r, { 0x85, 0x01, 0xC0, 0x85, 0x03, 0x85, 0x06, 0x09, 0x02 }));
+}
+
+static void testNotCompiledIn() {
+    HIDFeatureRegistry r = registry();
+    // No gamepad or digitizer in this build, asking for them gets what's there
+    CHECK(r.setProfile(HID_FEATURE_MOUSE | HID_FEATURE_GAMEPAD | HID_FEATURE_DIGITIZER));
+    CHECK_EQ(r.active(), HID_FEATURE_NKRO | HID_FEATURE_MOUSE);
+    CHECK(!r.setProfile(HID_FEATURE_MOUSE | HID_FEATURE_GAMEPAD));
+
+    // A fresh begin() forgets the profile
+    r.begin(table, 2, full, 5);
+    CHECK_EQ(r.active(), HID_FEATURE_NKRO | HID_FEATURE_MEDIA);
+    CHECK(r.descriptor() == full);
+    CHECK_EQ(r.descriptorLength(), 5);
+}
+
+int main() {
+    RUN_TEST(testStartsWithEverything);
+    RUN_TEST(testProfiles);
+    RUN_TEST(testKeyboardStays);
+    RUN_TEST(testSixDofAndMacropad);
+    RUN_TEST(testNotCompiledIn);
+    return TEST_RESULT();
+}
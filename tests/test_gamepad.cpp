@@ -0,0 +1,181 @@
+// Gamepad reports - axis hysteresis and quantisation hold a noisy stick still without losing the
+// centre or the end stops, buttons go out straight away, axes at the poll rate, and nothing goes out
+// that the host wouldn't see as a change. Also counts reports per second off a noisy stick.
+
+#include "features/Gamepad/Gamepad.h"
+#include "MockTransport.h"
+#include "SquidTest.h"
+#include <random>
+
+static void testHysteresis() {
+    AxisHysteresis a;
+    a.setHysteresis(100);
+    CHECK_EQ(a.apply(50), 0);       // Inside the band, held
+    CHECK_EQ(a.apply(-100), 0);
+    CHECK_EQ(a.apply(150), 150);    // Out of it, follows
+    CHECK_EQ(a.apply(200), 150);
+    CHECK_EQ(a.apply(251), 251);
+
+    // Centre and the rails always get through, however small the move
+    a.reset(30);
+    CHECK_EQ(a.apply(0), 0);
+    a.reset(32700);
+    CHECK_EQ(a.apply(32767), 32767);
+    a.reset(-32700);
+    CHECK_EQ(a.apply(-32767), -32767);
+
+    AxisHysteresis off;
+    CHECK_EQ(off.apply(1), 1);
+    CHECK_EQ(off.apply(2), 2);
+}
+
+static void testQuantisation() {
+    AxisHysteresis a;
+    a.setQuantisation(7);           // Steps of 128, rounded to the nearest
+    CHECK_EQ(a.apply(63), 0);
+    CHECK_EQ(a.apply(64), 128);
+    CHECK_EQ(a.apply(-64), 0);
+    CHECK_EQ(a.apply(-65), -128);
+    CHECK_EQ(a.apply(32767), 32767);    // Rounds up past the rail, gets clamped back
+    CHECK_EQ(a.apply(-32767), -32767);
+
+    // Noise inside a step doesn't make it flicker once it's there
+    a.setHysteresis(96);
+    a.reset();
+    std::mt19937 rng(48);
+    int changes = 0;
+    int16_t last = a.apply(1000);
+    for (int i = 0; i < 1000; i++) {
+        int16_t v = a.apply(1000 + (int)(rng() % 81) - 40);
+        changes += v != last;
+        last = v;
+    }
+    CHECK_EQ(changes, 0);
+}
+
+struct Pad {
+    MockTransport transport;
+    SQUIDGAMEPAD  pad;
+    Pad() {
+        simNow = 0;
+        pad.begin(&transport, 0);
+    }
+};
+
+static void testButtonsGoStraightOut() {
+    Pad p;
+    p.pad.press(GB_SO);
+    CHECK_EQ(p.transport.reports.size(), 1);
+    CHECK_EQ(p.transport.reports[0].id, GAMEPAD_ID);
+    CHECK_EQ(p.transport.reports[0].data.size(), sizeof(GamepadReport));
+    CHECK_EQ(p.transport.reports[0].data[0], 0x01);
+
+    p.pad.press(GB_SO);   // Already down, nothing new for the host
+    CHECK_EQ(p.transport.reports.size(), 1);
+    p.pad.release(GB_SO);
+    CHECK_EQ(p.transport.reports.size(), 2);
+    p.pad.releaseAll();
+    CHECK_EQ(p.transport.reports.size(), 2);
+
+    // Not connected, nothing sent and nothing lost - it goes once there's a host
+    p.transport.connected = false;
+    p.pad.press(GB_EA);
+    CHECK_EQ(p.transport.reports.size(), 2);
+    p.transport.connected = true;
+    p.pad.update(1000000);
+    CHECK_EQ(p.transport.reports.size(), 3);
+}
+
+static void testAxesWaitForThePollRate() {
+    Pad p;
+    p.pad.setPollRate(250);   // 4ms, under the transport's 8ms so that wins
+    p.pad.gamepadSetLeftStick(1000, -1000);
+    CHECK_EQ(p.transport.reports.size(), 0);   // Setting axes never sends
+    p.pad.update(10000);
+    CHECK_EQ(p.transport.reports.size(), 1);
+
+    p.pad.gamepadSetLeftStick(2000, -1000);
+    p.pad.update(17999);
+    CHECK_EQ(p.transport.reports.size(), 1);
+    p.pad.update(18000);
+    CHECK_EQ(p.transport.reports.size(), 2);
+    p.pad.update(30000);                       // Nothing changed
+    CHECK_EQ(p.transport.reports.size(), 2);
+
+    // A slower poll rate than the transport's
+    p.pad.setPollRate(50);
+    p.pad.gamepadSetAxis(GA_RT, 5000);
+    p.pad.update(30000);
+    CHECK_EQ(p.transport.reports.size(), 2);
+    p.pad.update(38000);
+    CHECK_EQ(p.transport.reports.size(), 3);
+
+    // A refused send is tried again on the next update
+    p.pad.gamepadSetAxis(GA_RT, 6000);
+    p.transport.failSend = true;
+    p.pad.update(100000);
+    p.transport.failSend = false;
+    CHECK_EQ(p.transport.reports.size(), 3);
+    p.pad.update(100001);
+    CHECK_EQ(p.transport.reports.size(), 4);
+
+    // A new host gets the whole state even though nothing changed
+    p.pad.onConnect();
+    p.pad.update(200000);
+    CHECK_EQ(p.transport.reports.size(), 5);
+}
+
+// A second of one stick read at 1kHz, both sticks and triggers noisy, the left X sweeping if moving.
+// sendEverySet is how it used to be, a report straight after every set with no update() in between.
+static long reportsPerSecond(uint16_t hysteresis, uint8_t bits, uint16_t pollHz, bool moving, bool sendEverySet = false) {
+    Pad p;
+    p.transport.interval = 1000;   // A USB host polling at 1kHz, so the transport doesn't throttle
+    p.pad.setPollRate(pollHz);
+    for (int a = 0; a < GAMEPAD_ANALOGUE_COUNT; a++) {
+        p.pad.setAxisHysteresis((GamepadAnalogue)a, hysteresis);
+        p.pad.setAxisQuantisation((GamepadAnalogue)a, bits);
+    }
+    std::mt19937 rng(480);
+    for (uint32_t t = 1000; t <= 1000000; t += 1000) {
+        int16_t axes[GAMEPAD_ANALOGUE_COUNT];
+        for (int a = 0; a < GAMEPAD_ANALOGUE_COUNT; a++) {
+            int base = moving && a == 0 ? (int)(t / 40) : 1000;
+            axes[a] = (int16_t)(base + (int)(rng() % 81) - 40);
+        }
+        simNow = t;
+        p.pad.gamepadSetAllAxes(axes);
+        if (sendEverySet) p.pad.sendGamepadReport();
+        else p.pad.update(t);
+    }
+    return (long)p.transport.reports.size();
+}
+
+static void testNoisyStickReportRate() {
+    long before = reportsPerSecond(0, 0, 0, false, true);
+    long raw = reportsPerSecond(0, 0, 0, false);
+    long still = reportsPerSecond(96, 0, 0, false);
+    long quantised = reportsPerSecond(0, 7, 0, false);
+    long moving = reportsPerSecond(96, 0, 0, true);
+    long polled = reportsPerSecond(64, 0, 125, true);
+    printf("     every set sent (before): %ld reports/s\n", before);
+    printf("     delta only:              %ld reports/s at rest\n", raw);
+    printf("     hysteresis 96:           %ld reports/s at rest, %ld moving\n", still, moving);
+    printf("     quantised to 7 bits:     %ld reports/s at rest\n", quantised);
+    printf("     hysteresis 64 at 125Hz:  %ld reports/s moving\n", polled);
+
+    CHECK_EQ(before, 1000);   // Every set, whether or not anything changed
+    CHECK(raw > 900);       // Noise on its own changes the report nearly every time
+    CHECK(still <= 1);      // Just the first
+    CHECK(quantised < 50);
+    CHECK(moving > 100 && moving < 300);   // Follows the sweep, not the noise
+    CHECK(polled <= 125);
+}
+
+int main() {
+    RUN_TEST(testHysteresis);
+    RUN_TEST(testQuantisation);
+    RUN_TEST(testButtonsGoStraightOut);
+    RUN_TEST(testAxesWaitForThePollRate);
+    RUN_TEST(testNoisyStickReportRate);
+    return TEST_RESULT();
+}
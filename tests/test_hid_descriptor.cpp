@@ -0,0 +1,96 @@
+// HID descriptor assembly - the short-item macros put the right size code in, the parts go in back
+// to back, the checks SQUIDHID.cpp runs on the full report map catch a truncated item, an unclosed
+// collection and a reused report ID, and every feature's descriptor passes them in whichever
+// report layout config.h picked.
+
+#include "features/NKRO/NKRO.h"
+#include "features/Media/Media.h"
+#include "features/Steno/Steno.h"
+#include "features/Spacemouse/Spacemouse.h"
+#include "features/Mouse/Mouse.h"
+#include "features/Digitizer/Digitizer.h"
+#include "features/Gamepad/Gamepad.h"
+#include "drivers/Software/HID/HIDDescriptor.h"
+#include "SquidTest.h"
+
+static constexpr uint8_t partA[] = { 0x05, 0x01, 0x09, 0x06 };
+static constexpr uint8_t partB[] = { 0xA1, 0x01, 0x85, 0x01, 0xC0 };
+static constexpr auto joined = concatDescriptors(partA, partB);
+
+// All of it happens at compile time
+static_assert(joined.size() == sizeof(partA) + sizeof(partB), "concatDescriptors lost a byte");
+static_assert(joined.data[4] == 0xA1 && joined.data[8] == 0xC0, "concatDescriptors put a part in the wrong place");
+static_assert(descriptorWellFormed(joined) && descriptorReportIdsUnique(joined), "A good descriptor failed its checks");
+
+// The short-item macros take the byte count, 4 going in as size code 3, and any expression as the count
+static_assert(LOGICAL_MAXIMUM(4) == 0x27 && LOGICAL_MAXIMUM(2) == 0x26 && END_COLLECTION(0) == 0xC0, "Short item size code is wrong");
+static_assert(USAGE_PAGE(MAX_DESCRIPTOR_SIZE > 0 ? 2 : 1) == 0x06, "Short item macro argument isn't parenthesised");
+
+template <size_t N>
+static bool wellFormed(const uint8_t (&bytes)[N]) {
+    return descriptorWellFormed(concatDescriptors(bytes));
+}
+
+template <size_t N>
+static bool idsUnique(const uint8_t (&bytes)[N]) {
+    return descriptorReportIdsUnique(concatDescriptors(bytes));
+}
+
+static void testConcat() {
+    const uint8_t expect[] = { 0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x85, 0x01, 0xC0 };
+    CHECK_EQ(joined.size(), sizeof(expect));
+    CHECK(!memcmp(joined.begin(), expect, sizeof(expect)));
+}
+
+static void testWellFormed() {
+    const uint8_t good[]       = { 0xA1, 0x01, 0xA1, 0x00, 0x27, 0xFF, 0xFF, 0x00, 0x00, 0xC0, 0xC0 };
+    const uint8_t truncated[]  = { 0xA1, 0x01, 0x26, 0xFF, 0xC0 };          // 2 byte item with 1 byte then End
+    const uint8_t cutShort[]   = { 0x05, 0x01, 0x26, 0xFF };
+    const uint8_t unclosed[]   = { 0xA1, 0x01, 0xA1, 0x00, 0xC0 };
+    const uint8_t overClosed[] = { 0xA1, 0x01, 0xC0, 0xC0, 0xA1, 0x01 };    // Balances out, but closes one too early
+    const uint8_t longItem[]   = { 0xA1, 0x01, 0xFE, 0x02, 0x10, 0xC0, 0xC0, 0xC0 };   // A long item's data isn't items
+    CHECK(wellFormed(good));
+    CHECK(!wellFormed(truncated));
+    CHECK(!wellFormed(cutShort));
+    CHECK(!wellFormed(unclosed));
+    CHECK(!wellFormed(overClosed));
+    CHECK(wellFormed(longItem));
+}
+
+static void testReportIds() {
+    const uint8_t twoIds[]  = { 0x85, 0x01, 0x85, 0x02 };
+    const uint8_t reused[]  = { 0x85, 0x01, 0x85, 0x02, 0x85, 0x01 };
+    const uint8_t zero[]    = { 0x85, 0x00 };
+    const uint8_t inData[]  = { 0x85, 0x01, 0x26, 0x85, 0x01 };   // 0x85 0x01 as Logical Maximum's data, not an ID
+    CHECK(idsUnique(twoIds));
+    CHECK(!idsUnique(reused));
+    CHECK(!idsUnique(zero));
+    CHECK(idsUnique(inData));
+}
+
+static void testFeatureDescriptors() {
+    CHECK(wellFormed(_nkroReportDescriptor));
+    CHECK(wellFormed(_mediakeyReportDescriptor));
+    CHECK(wellFormed(_stenoReportDescriptor));
+
+    CHECK(wellFormed(_spacemouseReportDescriptor));
+    CHECK(wellFormed(_mouseReportDescriptor));
+    CHECK(wellFormed(_digitizerReportDescriptor));
+    CHECK(wellFormed(_gamepadReportDescriptor));
+
+    // The biggest set SQUIDHID.cpp can put together, everything in one image for the profiles to pick from
+    auto full = concatDescriptors(_nkroReportDescriptor, _mediakeyReportDescriptor, _spacemouseReportDescriptor,
+                                  _mouseReportDescriptor, _digitizerReportDescriptor, _gamepadReportDescriptor,
+                                  _stenoReportDescriptor);
+    CHECK(descriptorWellFormed(full));
+    CHECK(descriptorReportIdsUnique(full));
+    printf("     everything on: %zu of %d bytes\n", full.size(), MAX_DESCRIPTOR_SIZE);
+}
+
+int main() {
+    RUN_TEST(testConcat);
+    RUN_TEST(testWellFormed);
+    RUN_TEST(testReportIds);
+    RUN_TEST(testFeatureDescriptors);
+    return TEST_RESULT();
+}
@@ -0,0 +1,83 @@
+// Host lock LEDs - the transport's task posts, update() takes, only real changes come out, any
+// task can read the newest state, and with a stack thread hammering it the taker always ends up
+// on the last state posted.
+
+#include "drivers/Software/HID/HostLEDs.h"
+#include "SquidTest.h"
+#include <thread>
+
+static void testOnlyChangesComeOut() {
+    HostLEDs leds;
+    CHECK_EQ(leds.take(), 0);   // Nothing posted
+
+    leds.post(0x02);            // Caps
+    CHECK_EQ(leds.latest(), 0x02);   // Readable before update() gets to it
+    CHECK_EQ(leds.get(), 0);
+    CHECK_EQ(leds.take(), 0x02);
+    CHECK_EQ(leds.get(), 0x02);
+    CHECK_EQ(leds.take(), 0);
+
+    leds.post(0x02);            // Same again, e.g. on reconnect
+    CHECK_EQ(leds.take(), 0);
+
+    leds.post(0x03);
+    leds.post(0x01);            // Only the newest counts
+    CHECK_EQ(leds.take(), 0x03);
+    CHECK_EQ(leds.get(), 0x01);
+
+    leds.post(0xE1);            // Padding bits never get through
+    CHECK_EQ(leds.take(), 0);
+    CHECK_EQ(leds.get(), 0x01);
+    CHECK_EQ(leds.latest(), 0x01);
+}
+
+static void testPS2Order() {
+    CHECK_EQ(HostLEDs::fromPS2(0x01), 0x04);   // Scroll
+    CHECK_EQ(HostLEDs::fromPS2(0x02), 0x01);   // Num
+    CHECK_EQ(HostLEDs::fromPS2(0x04), 0x02);   // Caps
+    CHECK_EQ(HostLEDs::fromPS2(0x07), 0x07);
+}
+
+// The changes taken have to add up to the state - XOR of every change is where it ended
+static void testThreadedHandoff() {
+    HostLEDs leds;
+    std::atomic<bool> go{false}, done{false};
+    uint8_t last = 0;
+    std::thread stack([&]() {
+        while (!go.load()) {}   // Don't let it finish before the taker's even running
+        uint32_t x = 12345;
+        for (int i = 0; i < 200000; i++) {
+            x = x * 1103515245 + 12345;
+            last = (x >> 16) & 0x1F;
+            leds.post(last);
+            if (i % 1000 == 0) std::this_thread::yield();   // On one core it'd otherwise finish in a single timeslice
+        }
+        done.store(true);
+    });
+
+    uint8_t seen = 0;
+    bool consistent = true;
+    long changes = 0;
+    go.store(true);
+    while (!done.load()) {
+        uint8_t changed = leds.take();
+        if (changed) changes++;
+        seen ^= changed;
+        consistent &= seen == leds.get();
+    }
+    stack.join();
+    CHECK_EQ(leds.latest(), last);   // What a sketch on another task reads, taken or not
+    seen ^= leds.take();
+
+    CHECK(consistent);
+    CHECK(changes > 0);
+    CHECK_EQ(seen, last);
+    CHECK_EQ(leds.get(), last);
+}
+
+int main() {
+    RUN_TEST(testOnlyChangesComeOut);
+    RUN_TEST(testPS2Order);
+    RUN_TEST(testThreadedHandoff);
+    return TEST_RESULT();
+}
@@ -0,0 +1,130 @@
+// Frame diffing - only bytes that actually changed count as changed, a frame only runs as far as
+// the last LED that changed, and the APA102 backend's partial frames leave the rest of the chain alone.
+
+#include "drivers/Hardware/LED/NeoPixel.h"
+#include "FakeLEDStrip.h"
+#include "RecordingLEDBus.h"
+#include "SquidTest.h"
+#include <random>
+
+static void testRange() {
+    LEDRange r;
+    CHECK(r.empty());
+    CHECK_EQ(r.length(), 0);
+    r.add(5, 5);   // Empty adds are ignored
+    CHECK(r.empty());
+    r.add(9, 12);
+    r.add(3, 6);
+    CHECK_EQ(r.first, 3);
+    CHECK_EQ(r.last, 12);
+    r.add(LEDRange());
+    CHECK_EQ(r.length(), 9);
+    r.clear();
+    CHECK(r.empty());
+}
+
+static void testOnlyRealChangesCount() {
+    RecordingLEDBus bus;
+    NeoPixel strip(20, &bus);
+    strip.begin();
+    strip.show();   // First frame covers the whole strip, nobody knows what it's showing
+    CHECK_EQ(bus.lengths.back(), 60);
+
+    strip.setPixelColor(4, 0);   // Already black
+    CHECK(!strip.isChanged());
+    strip.show();
+    CHECK_EQ(bus.lengths.size(), 1);
+
+    strip.setPixelColor(4, NeoPixel::Color(1, 0, 0));
+    strip.setPixelColor(2, NeoPixel::Color(0, 0, 1));
+    strip.show();
+    CHECK_EQ(bus.encoded.back().first, 6);
+    CHECK_EQ(bus.encoded.back().last, 15);
+    CHECK_EQ(bus.lengths.back(), 15);   // Stops after LED 4, the tail's untouched
+
+    // Clearing only covers the bytes that were lit - LED 2's blue (GRB, so byte 8) to LED 4's red
+    strip.clear();
+    strip.show();
+    CHECK_EQ(bus.encoded.back().first, 8);
+    CHECK_EQ(bus.encoded.back().last, 14);
+    strip.clear();
+    CHECK(!strip.isChanged());
+}
+
+static void testFailedTransmitIsRetried() {
+    RecordingLEDBus bus;
+    NeoPixel strip(10, &bus);
+    strip.begin();
+    strip.show();
+
+    bus.failTransmit = true;
+    strip.setPixelColor(7, NeoPixel::Color(9, 9, 9));
+    strip.show();
+    CHECK(strip.isChanged());   // Never went out, so it's still owed
+
+    bus.failTransmit = false;
+    strip.show();
+    CHECK_EQ(bus.lengths.back(), 24);
+    CHECK(!strip.isChanged());
+}
+
+static void testAPA102PartialFrames() {
+    spiTransfers.clear();
+    const uint16_t count = 40;
+    LEDSPIBus spi(13, 14);
+    NeoPixel strip(count, &spi, NEO_BGR);
+    CHECK(strip.begin());
+    FakeAPA102Strip leds(count * 3);
+
+    strip.fill(NeoPixel::Color(1, 2, 3));
+    strip.show();
+    strip.wait();
+    CHECK_EQ(spiTransfers.size(), 2);        // The frame and its tail
+    CHECK_EQ(spiTransfers[0].size(), 4 + count * 4);
+    leds.receiveAll(spiTransfers);
+    CHECK(!leds.badFrame);
+    CHECK_EQ(leds.bytes[0], 3);              // Blue first on the wire
+    CHECK_EQ(leds.bytes[2], 1);
+
+    strip.setPixelColor(5, NeoPixel::Color(7, 8, 9));
+    strip.show();
+    strip.wait();
+    CHECK_EQ(spiTransfers[0].size(), 4 + 6 * 4);   // LEDs 0-5 only
+    leds.receiveAll(spiTransfers);
+    CHECK(leds.bytes == std::vector<uint8_t>(strip.getPixels(), strip.getPixels() + count * 3));
+}
+
+// Random edits through both SPI buffers - the chain always ends up showing what's in the strip
+static void testAPA102RandomEdits() {
+    spiTransfers.clear();
+    std::mt19937 rng(37);
+    const uint16_t count = 50;
+    LEDSPIBus spi(13, 14);
+    NeoPixel strip(count, &spi, NEO_BGR);
+    strip.begin();
+    FakeAPA102Strip leds(count * 3);
+
+    bool matched = true;
+    for (int frame = 0; frame < 500; frame++) {
+        for (int edits = rng() % 4; edits > 0; edits--) strip.setPixelColor(rng() % count, rng() & 0xFFFFFF);
+        if (rng() % 20 == 0) strip.setBrightness(rng() & 0xFF);
+        strip.show();
+        strip.wait();
+        leds.receiveAll(spiTransfers);
+
+        // What's on the chain is the strip through the brightness table
+        unsigned scale = strip.getBrightness() + 1;
+        for (uint16_t i = 0; i < count * 3; i++) matched &= leds.bytes[i] == ((strip.getPixels()[i] * scale) >> 8);
+    }
+    CHECK(matched);
+    CHECK(!leds.badFrame);
+}
+
+int main() {
+    RUN_TEST(testRange);
+    RUN_TEST(testOnlyRealChangesCount);
+    RUN_TEST(testFailedTransmitIsRetried);
+    RUN_TEST(testAPA102PartialFrames);
+    RUN_TEST(testAPA102RandomEdits);
+    return TEST_RESULT();
+}
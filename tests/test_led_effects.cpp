@@ -0,0 +1,212 @@
+// Effects engine - frames come at the set rate whatever the tick rate, late ones get dropped
+// rather than caught up, a big strip spreads over ticks when the budget runs out, and key presses
+// light up around where they happened and then fade away, each splash in its own colour. Also
+// times whole frames of each effect on 100 and 300 LED strips.
+
+#include "drivers/Hardware/LED/LEDEffects.h"
+#include "SquidTest.h"
+#include <chrono>
+
+// Never touches hardware, the effects only write into the strip's pixels
+class NullLEDBus : public LEDBus {
+public:
+    bool begin(uint16_t) override { return true; }
+    void encode(const uint8_t*, const LEDRange&, const uint8_t*) override {}
+    bool transmit(uint16_t) override { return true; }
+    bool ready(void) override { return true; }
+};
+
+static bool lit(NeoPixel& strip, uint16_t n) { return strip.getPixelColor(n) != 0; }
+
+static void testFrameRate() {
+    NullLEDBus bus;
+    NeoPixel strip(30, &bus);
+    LEDEffects fx;
+    CHECK(fx.begin(&strip));
+    fx.setFrameRate(50);
+    fx.setEffect(LEDEffects::EFFECT_RAINBOW);
+
+    // Ticking every ms for a second gives 50 frames, not 1000
+    int frames = 0;
+    for (int ms = 0; ms < 1000; ms++) {
+        if (fx.tick(micros())) frames++;
+        simNow += 1000;
+    }
+    CHECK(frames >= 49 && frames <= 51);
+    CHECK_EQ(fx.getSkippedFrames(), 0);
+
+    // A 100ms stall drops the missed frames instead of rendering them back to back
+    simNow += 100000;
+    CHECK(fx.tick(micros()));
+    CHECK(!fx.tick(micros()));
+    CHECK(fx.getSkippedFrames() >= 4);
+}
+
+static void testBudgetSpreadsTheFrame() {
+    NullLEDBus bus;
+    NeoPixel strip(200, &bus);
+    LEDEffects fx;
+    fx.begin(&strip);
+    fx.setBudget(300);
+    fx.setColor(0, 255, 255);
+    fx.setEffect(LEDEffects::EFFECT_SOLID);
+
+    // Every budget check costs 100us, so a tick only gets through a few slices
+    simMicrosStep = 100;
+    int ticks = 1;
+    while (!fx.tick(micros())) ticks++;
+    simMicrosStep = 0;
+
+    CHECK(ticks > 1);
+    CHECK(ticks <= (200 + LED_EFFECT_SLICE - 1) / LED_EFFECT_SLICE);
+    bool all = true;
+    for (uint16_t i = 0; i < 200; i++) all &= strip.getPixelColor(i) == NeoPixel::Color(255, 0, 0);
+    CHECK(all);
+}
+
+static void testRippleSpreadsAndFades() {
+    NullLEDBus bus;
+    NeoPixel strip(64, &bus);
+    LEDEffects fx;
+    fx.begin(&strip);
+    fx.setEffect(LEDEffects::EFFECT_RIPPLE);
+
+    fx.onKey(32, true);
+    fx.onKey(32, false);   // Releases don't start anything
+    simNow += 20000;
+    while (!fx.tick(micros())) {}
+    CHECK(lit(strip, 32));
+    CHECK(!lit(strip, 50));
+
+    // Half a second later the ring has moved out past the key
+    simNow += 500000;
+    while (!fx.tick(micros())) {}
+    CHECK(!lit(strip, 32));
+    bool ring = false;
+    for (uint16_t i = 33; i < 64; i++) ring |= lit(strip, i);
+    CHECK(ring);
+
+    // ...and a few seconds on it's gone
+    simNow += 5000000;
+    while (!fx.tick(micros())) {}
+    bool any = false;
+    for (uint16_t i = 0; i < 64; i++) any |= lit(strip, i);
+    CHECK(!any);
+}
+
+static void testHeatmapCoolsOff() {
+    NullLEDBus bus;
+    NeoPixel strip(16, &bus);
+    LEDEffects fx;
+    fx.begin(&strip);
+    const uint16_t keyToLed[] = { 3, LED_EFFECT_NO_LED, 12 };
+    fx.setKeyMap(keyToLed, 3);
+    fx.setEffect(LEDEffects::EFFECT_HEATMAP);
+
+    for (int i = 0; i < 5; i++) {
+        fx.onKey(0, true);
+        fx.onKey(1, true);   // No LED, nothing happens
+    }
+    simNow += 20000;
+    while (!fx.tick(micros())) {}
+    CHECK(lit(strip, 3));
+    CHECK(lit(strip, 4));   // Neighbours warm up a bit too
+    CHECK(!lit(strip, 12));
+    CHECK(!lit(strip, 8));
+
+    simNow += 5000000;
+    while (!fx.tick(micros())) {}
+    CHECK(!lit(strip, 3));
+}
+
+static void testSplashBlobs() {
+    NullLEDBus bus;
+    NeoPixel strip(64, &bus);
+    LEDEffects fx;
+    fx.begin(&strip);
+    fx.setEffect(LEDEffects::EFFECT_SPLASH);
+
+    fx.onKey(10, true);
+    fx.onKey(40, true);
+    fx.onKey(40, false);
+    simNow += 100000;
+    while (!fx.tick(micros())) {}
+
+    // A filled blob around each key rather than a ring, and a different colour for each press
+    CHECK(lit(strip, 10));
+    CHECK(lit(strip, 12));
+    CHECK(lit(strip, 8));
+    CHECK(!lit(strip, 20));
+    CHECK(lit(strip, 40));
+    CHECK(strip.getPixelColor(10) != strip.getPixelColor(40));
+
+    // It dims as it grows
+    uint32_t before = strip.getPixelColor(40);
+    simNow += 300000;
+    while (!fx.tick(micros())) {}
+    CHECK(lit(strip, 40));
+    CHECK(lit(strip, 45));
+    uint32_t after = strip.getPixelColor(40);
+    CHECK(((after >> 16) & 0xFF) + ((after >> 8) & 0xFF) + (after & 0xFF) <
+          ((before >> 16) & 0xFF) + ((before >> 8) & 0xFF) + (before & 0xFF));
+
+    simNow += 2000000;
+    while (!fx.tick(micros())) {}
+    bool any = false;
+    for (uint16_t i = 0; i < 64; i++) any |= lit(strip, i);
+    CHECK(!any);
+}
+
+// Not a pass/fail beyond every frame rendering - numbers to keep an eye on when an effect changes.
+// The reactive ones have a full set of ripples on the go.
+static void benchFrames() {
+    const int frames = 2000;
+    const LEDEffects::Effect effects[] = { LEDEffects::EFFECT_RAINBOW, LEDEffects::EFFECT_RIPPLE,
+                                           LEDEffects::EFFECT_SPLASH, LEDEffects::EFFECT_HEATMAP };
+    const char* names[] = { "rainbow", "ripple", "splash", "heatmap" };
+
+    for (uint16_t leds : { 100, 300 }) {
+        NullLEDBus bus;
+        NeoPixel strip(leds, &bus);
+        LEDEffects fx;
+        fx.begin(&strip);
+        fx.setBudget(60000);   // Whole frame every tick
+
+        for (int e = 0; e < 4; e++) {
+            fx.setEffect(effects[e]);
+            for (int k = 0; k < LED_EFFECT_MAX_RIPPLES; k++) fx.onKey(k * leds / LED_EFFECT_MAX_RIPPLES, true);
+            simNow += 200000;
+
+            // The clock stands still so the ripples stay mid-spread, only the frame times move on
+            uint32_t at = micros();
+            int rendered = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int f = 0; f < frames; f++, at += 20000) rendered += fx.tick(at);
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            printf("     %3u LEDs %-8s %.2f us/frame\n", leds, names[e], us / frames);
+            CHECK_EQ(rendered, frames);
+        }
+    }
+}
+
+static void testNoneLeavesTheStripAlone() {
+    NullLEDBus bus;
+    NeoPixel strip(8, &bus);
+    LEDEffects fx;
+    fx.begin(&strip);
+    strip.setPixelColor(2, NeoPixel::Color(1, 2, 3));
+    simNow += 1000000;
+    CHECK(!fx.tick(micros()));
+    CHECK_EQ(strip.getPixelColor(2), NeoPixel::Color(1, 2, 3));
+}
+
+int main() {
+    RUN_TEST(testFrameRate);
+    RUN_TEST(testBudgetSpreadsTheFrame);
+    RUN_TEST(testRippleSpreadsAndFades);
+    RUN_TEST(testHeatmapCoolsOff);
+    RUN_TEST(testSplashBlobs);
+    RUN_TEST(testNoneLeavesTheStripAlone);
+    RUN_TEST(benchFrames);
+    return TEST_RESULT();
+}
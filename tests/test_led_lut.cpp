@@ -0,0 +1,71 @@
+// Output table - brightness and gamma folded into one lookup has to give the same byte as applying
+// them one after the other, for every value and every setting, and never touch the stored colours.
+
+#include "drivers/Hardware/LED/NeoPixel.h"
+#include "RecordingLEDBus.h"
+#include "SquidTest.h"
+
+static void testTableMatchesTwoSteps() {
+    RecordingLEDBus bus;
+    NeoPixel strip(4, &bus);
+    strip.begin();
+
+    bool matched = true;
+    for (int gamma = 0; gamma < 2; gamma++) {
+        strip.setGamma(gamma);
+        for (int b = 0; b < 256; b++) {
+            strip.setBrightness(b);
+            strip.show();
+            for (int x = 0; x < 256; x++) {
+                unsigned v = gamma ? NeoPixel::gamma8(x) : x;
+                matched &= bus.table[x] == ((v * (b + 1)) >> 8);
+            }
+        }
+    }
+    CHECK(matched);
+
+    // Full brightness without gamma is a straight copy
+    strip.setGamma(false);
+    strip.setBrightness(255);
+    strip.setPixelColor(0, 1);   // Something has to change for show() to encode
+    strip.show();
+    bool identity = true;
+    for (int x = 0; x < 256; x++) identity &= bus.table[x] == x;
+    CHECK(identity);
+}
+
+static void testColoursSurviveDimming() {
+    RecordingLEDBus bus;
+    NeoPixel strip(3, &bus);
+    strip.begin();
+    strip.setPixelColor(1, NeoPixel::Color(200, 7, 1));
+    strip.setBrightness(3);
+    strip.setGamma(true);
+    strip.setBrightness(255);
+    strip.setGamma(false);
+    CHECK_EQ(strip.getPixelColor(1), NeoPixel::Color(200, 7, 1));
+    CHECK_EQ(strip.getBrightness(), 255);
+}
+
+static void testSettingsResendOnlyWhenTheyChange() {
+    RecordingLEDBus bus;
+    NeoPixel strip(10, &bus);
+    strip.begin();
+    strip.show();
+
+    strip.setBrightness(100);
+    CHECK(strip.isChanged());
+    strip.show();
+    CHECK_EQ(bus.lengths.back(), 30);   // Every byte's output changed
+
+    strip.setBrightness(100);
+    strip.setGamma(false);
+    CHECK(!strip.isChanged());
+}
+
+int main() {
+    RUN_TEST(testTableMatchesTwoSteps);
+    RUN_TEST(testColoursSurviveDimming);
+    RUN_TEST(testSettingsResendOnlyWhenTheyChange);
+    return TEST_RESULT();
+}
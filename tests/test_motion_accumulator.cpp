@@ -0,0 +1,114 @@
+// Motion accumulator - nothing added ever goes missing. Fractions carry over until they make a
+// whole count, what doesn't fit in a report waits for the next one, and a failed send can be put back.
+
+#include "drivers/Software/Motion/MotionAccumulator.h"
+#include "SquidTest.h"
+#include <random>
+
+static const int32_t LIMIT[MOTION_AXES] = { 127, 127, 127, 127 };
+
+static void testFractionsCarry() {
+    MotionAccumulator m;
+    int32_t out[MOTION_AXES];
+    long total = 0;
+    for (int i = 0; i < 10; i++) {   // 0.3 of a count at a time
+        m.addFixed(77, -77);
+        if (m.take(LIMIT, out)) total += out[0];
+    }
+    CHECK_EQ(total, 3);
+    CHECK_EQ(m.getFixed(MotionAccumulator::AXIS_X), 770 - 3 * 256);
+
+    // Below a whole count is nothing to send, in either direction
+    m.clear();
+    m.addFixed(255, -255, 100, -100);
+    CHECK(!m.pending());
+    CHECK(!m.take(LIMIT, out));
+
+    // Negative fractions keep their sign rather than rounding towards the next report
+    m.clear();
+    m.addFixed(-300, 0);
+    CHECK(m.take(LIMIT, out));
+    CHECK_EQ(out[0], -1);
+    CHECK_EQ(m.getFixed(MotionAccumulator::AXIS_X), -44);
+}
+
+static void testBigMovesSpreadOverReports() {
+    MotionAccumulator m;
+    int32_t out[MOTION_AXES];
+    m.add(1000, -1000, 3);
+    long x = 0, y = 0, wheel = 0;
+    int reports = 0;
+    while (m.take(LIMIT, out)) {
+        CHECK(out[0] <= 127 && out[1] >= -127);
+        x += out[0];
+        y += out[1];
+        wheel += out[2];
+        reports++;
+    }
+    CHECK_EQ(x, 1000);
+    CHECK_EQ(y, -1000);
+    CHECK_EQ(wheel, 3);
+    CHECK_EQ(reports, 8);
+}
+
+static void testRestoreAndSaturation() {
+    MotionAccumulator m;
+    int32_t out[MOTION_AXES];
+    m.add(5, 0, 0, -2);
+    CHECK(m.take(LIMIT, out));
+    CHECK(!m.pending());
+    m.restore(out);
+    CHECK(m.pending());
+    CHECK_EQ(m.getFixed(MotionAccumulator::AXIS_X), 5 * 256);
+    CHECK_EQ(m.getFixed(MotionAccumulator::AXIS_HWHEEL), -2 * 256);
+
+    // Runaway input pins at the end rather than wrapping round to the other direction
+    m.clear();
+    m.add(2000000000, -2000000000);
+    m.add(2000000000, -2000000000);
+    CHECK(m.getFixed(MotionAccumulator::AXIS_X) > 0);
+    CHECK(m.getFixed(MotionAccumulator::AXIS_Y) < 0);
+}
+
+// Random fixed point motion, random report sizes, some reports lost and put back - every count
+// that went in comes out
+static void testRandomTrafficAddsUp() {
+    std::mt19937 rng(43);
+    MotionAccumulator m;
+    int32_t out[MOTION_AXES];
+    long long added[MOTION_AXES] = {}, sent[MOTION_AXES] = {};
+
+    for (int i = 0; i < 100000; i++) {
+        int32_t d[MOTION_AXES];
+        for (int a = 0; a < MOTION_AXES; a++) {
+            d[a] = (int32_t)(rng() % 2001) - 1000;
+            added[a] += d[a];
+        }
+        m.addFixed(d[0], d[1], d[2], d[3]);
+
+        if (rng() % 3 == 0) {
+            int32_t limit[MOTION_AXES];
+            for (int a = 0; a < MOTION_AXES; a++) limit[a] = 1 + rng() % 127;
+            if (m.take(limit, out)) {
+                bool fits = true;
+                for (int a = 0; a < MOTION_AXES; a++) fits &= out[a] >= -limit[a] && out[a] <= limit[a];
+                CHECK(fits);
+                if (rng() % 10 == 0) m.restore(out);
+                else for (int a = 0; a < MOTION_AXES; a++) sent[a] += out[a];
+            }
+        }
+    }
+
+    bool conserved = true;
+    for (int a = 0; a < MOTION_AXES; a++)
+        conserved &= sent[a] * 256 + m.getFixed((MotionAccumulator::Axis)a) == added[a];
+    CHECK(conserved);
+}
+
+int main() {
+    RUN_TEST(testFractionsCarry);
+    RUN_TEST(testBigMovesSpreadOverReports);
+    RUN_TEST(testRestoreAndSaturation);
+    RUN_TEST(testRandomTrafficAddsUp);
+    return TEST_RESULT();
+}
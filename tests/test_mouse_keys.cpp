@@ -0,0 +1,249 @@
+// Mouse keys - cursor trajectories from a simulated keyboard loop feeding the accumulator and a
+// 125Hz report. A tap is one count, the curve gets to the top speed it was given, diagonals aren't
+// faster, inertia coasts to a stop, and how often update() runs doesn't change where the cursor ends up.
+// A key still held when a profile switch turns the mouse off doesn't leave the pointer drifting.
+
+#include "drivers/Software/Motion/MouseKeyEngine.h"
+#include "features/Mouse/Mouse.h"
+#include "MockTransport.h"
+#include "SquidTest.h"
+#include <math.h>
+#include <stdlib.h>
+#include <initializer_list>
+
+static const int32_t LIMIT[MOTION_AXES] = { 127, 127, 127, 127 };
+
+// update() every stepUs, a report every 8ms
+struct Sim {
+    MouseKeyEngine    engine;
+    MotionAccumulator acc;
+    long     x = 0, y = 0, wheel = 0;
+    uint32_t now = 0;
+    uint32_t stepUs;
+    uint32_t nextReport = 0;
+    int      reports = 0;
+
+    Sim(uint32_t stepUs = 1000) : stepUs(stepUs) {}
+
+    // Reported plus what's still waiting for a report
+    double exactX() const { return x + acc.getFixed(MotionAccumulator::AXIS_X) / 256.0; }
+
+    void run(uint32_t ms) {
+        uint32_t end = now + ms * 1000;
+        while (now < end) {
+            now += stepUs;
+            int32_t out[MOTION_AXES];
+            if (engine.update(now, out)) acc.addFixed(out[0], out[1], out[2], out[3]);
+            if (now >= nextReport) {
+                nextReport += 8000;
+                int32_t report[MOTION_AXES];
+                if (acc.take(LIMIT, report)) {
+                    x += report[0];
+                    y += report[1];
+                    wheel += report[2];
+                    reports++;
+                }
+            }
+        }
+    }
+};
+
+static void testTapIsOneCount() {
+    Sim s;
+    s.engine.press(MOUSEKEY_RIGHT);
+    s.run(5);
+    s.engine.release(MOUSEKEY_RIGHT);
+    s.run(100);
+    CHECK_EQ(s.x, 1);
+    CHECK_EQ(s.y, 0);
+    CHECK(!s.engine.active());
+
+    s.engine.press(MOUSEKEY_UP);
+    s.run(5);
+    s.engine.release(MOUSEKEY_UP);
+    s.run(100);
+    CHECK_EQ(s.y, -1);
+}
+
+static void testAcceleratedCurve() {
+    Sim s;
+    s.engine.press(MOUSEKEY_RIGHT);
+    s.run(150);
+    CHECK_EQ(s.x, 1);   // Still inside the 200ms delay
+
+    // Speeds up along the curve, never slows down, and settles on the top speed of 2000/s
+    double last = s.exactX(), lastStep = 0;
+    bool speedingUp = true;
+    for (int i = 0; i < 13; i++) {
+        s.run(96);   // 12 ticks each
+        double step = s.exactX() - last;
+        if (i > 0 && step < lastStep) speedingUp = false;
+        lastStep = step;
+        last = s.exactX();
+    }
+    CHECK(speedingUp);
+    long before = s.x;
+    s.run(1000);
+    CHECK(s.x - before > 1950 && s.x - before <= 2050);
+    CHECK_EQ(s.y, 0);
+}
+
+static void testDiagonal() {
+    Sim straight, diagonal;
+    straight.engine.press(MOUSEKEY_RIGHT);
+    diagonal.engine.press(MOUSEKEY_RIGHT | MOUSEKEY_DOWN);
+    straight.run(3000);
+    diagonal.run(3000);
+    CHECK_EQ(diagonal.x, diagonal.y);
+    // Same distance either way, within a percent
+    double d = sqrt((double)diagonal.x * diagonal.x + (double)diagonal.y * diagonal.y);
+    CHECK(fabs(d - straight.x) < straight.x / 100.0);
+
+    // Opposite keys cancel
+    Sim both;
+    both.engine.press(MOUSEKEY_LEFT | MOUSEKEY_RIGHT);
+    both.run(500);
+    CHECK_EQ(both.x, 0);
+}
+
+static void testKinetic() {
+    Sim s;
+    s.engine.setMode(MOUSEKEY_KINETIC);
+    s.engine.press(MOUSEKEY_UP);
+    s.run(100);
+    CHECK(s.y < -1 && s.y > -30);   // Moving straight away, but slowly
+    s.run(2000);
+    long before = s.y;
+    s.run(1000);
+    CHECK(before - s.y > 1950 && before - s.y <= 2050);
+}
+
+static void testInertia() {
+    Sim s;
+    s.engine.setMode(MOUSEKEY_INERTIA);
+    s.engine.press(MOUSEKEY_LEFT);
+    s.run(1000);
+    long held = s.x;
+    CHECK(held < 0);
+    s.engine.release(MOUSEKEY_LEFT);
+    s.run(100);
+    CHECK(s.x < held);             // Still coasting
+    CHECK(s.engine.active());
+    s.run(2000);
+    CHECK(!s.engine.active());     // Friction got it in the end
+    long stopped = s.x;
+    s.run(500);
+    CHECK_EQ(s.x, stopped);
+
+    // Pushing the other way brakes before it reverses
+    Sim r;
+    r.engine.setMode(MOUSEKEY_INERTIA);
+    r.engine.press(MOUSEKEY_RIGHT);
+    r.run(500);
+    r.engine.release(MOUSEKEY_RIGHT);
+    r.engine.press(MOUSEKEY_LEFT);
+    long turn = r.x;
+    r.run(50);
+    CHECK(r.x > turn);
+    r.run(1000);
+    CHECK(r.x < turn);
+}
+
+static void testSpeedOverride() {
+    Sim slow, medium;
+    slow.engine.setSpeedOverride(0);
+    medium.engine.setSpeedOverride(1);
+    slow.engine.press(MOUSEKEY_RIGHT);
+    medium.engine.press(MOUSEKEY_RIGHT);
+    slow.run(1000);
+    medium.run(1000);
+    CHECK(slow.x > 450 && slow.x < 550);       // A quarter of the top speed, from the first tick
+    CHECK(medium.x > 950 && medium.x < 1050);  // Half
+}
+
+static void testWheel() {
+    Sim s;
+    s.engine.press(MOUSEKEY_WHEEL_UP);
+    s.run(5);
+    s.engine.release(MOUSEKEY_WHEEL_UP);
+    s.run(100);
+    CHECK_EQ(s.wheel, 1);   // One notch per tap, like the pointer
+
+    s.engine.press(MOUSEKEY_WHEEL_DOWN);
+    s.run(3000);
+    long before = s.wheel;
+    s.run(1000);
+    CHECK(before - s.wheel >= 38 && before - s.wheel <= 42);
+    CHECK_EQ(s.x, 0);
+}
+
+// The cursor has to end up in the same place whether the loop runs at 1kHz or a jittery 3ms
+static void testLoopRateDoesntMatter() {
+    Sim fast(1000), slow(3000);
+    for (Sim* s : { &fast, &slow }) {
+        s->engine.press(MOUSEKEY_RIGHT | MOUSEKEY_UP);
+        s->run(1500);
+        s->engine.release(MOUSEKEY_UP);
+        s->run(600);
+        s->engine.release(MOUSEKEY_RIGHT);
+        s->run(200);
+    }
+    CHECK(abs(fast.x - slow.x) <= fast.x / 50 + 2);
+    CHECK(abs(fast.y - slow.y) <= -fast.y / 50 + 2);
+}
+
+static void testStallDoesntThrowThePointer() {
+    MouseKeyEngine engine;
+    engine.setSpeedOverride(2);
+    engine.press(MOUSEKEY_RIGHT);
+    int32_t out[MOTION_AXES];
+    CHECK(engine.update(1000, out));
+    int32_t oneTick = out[0];
+    CHECK(engine.update(1000000, out));   // A second's stall only catches up a few ticks
+    CHECK_EQ(out[0], oneTick * MOUSEKEY_MAX_BEHIND);
+
+    engine.reset();
+    CHECK(!engine.active());
+    CHECK(!engine.update(1008000, out));
+    CHECK_EQ(out[0], 0);
+}
+
+// setFeatureProfile() calls releaseAll() and the keymap stops sending the mouse anything, so the
+// release for a key held through the switch never comes
+static void testHeldThroughProfileSwitch() {
+    MockTransport transport;
+    SQUIDMOUSE mouse;
+    simNow = 0;
+    mouse.begin(&transport, 0);
+    mouse.pressDirection(MO_RGHT);
+    mouse.pressDirection(MO_ACL2);
+    for (uint32_t t = 1000; t <= 100000; t += 1000) mouse.update(t);
+    CHECK(transport.reports.size() > 5);
+
+    mouse.releaseAll();
+    CHECK(!mouse.hasPendingMotion());
+    CHECK(!mouse.mouseKeys().active());
+    transport.reports.clear();
+    for (uint32_t t = 101000; t <= 300000; t += 1000) mouse.update(t);
+    CHECK(transport.reports.empty());
+
+    // Back on, the next press starts on the curve rather than at the old ACL2 speed
+    mouse.pressDirection(MO_RGHT);
+    int32_t out[MOTION_AXES];
+    CHECK(mouse.mouseKeys().update(300000, out));
+    CHECK_EQ(out[MotionAccumulator::AXIS_X], 256);
+}
+
+int main() {
+    RUN_TEST(testTapIsOneCount);
+    RUN_TEST(testAcceleratedCurve);
+    RUN_TEST(testDiagonal);
+    RUN_TEST(testKinetic);
+    RUN_TEST(testInertia);
+    RUN_TEST(testSpeedOverride);
+    RUN_TEST(testWheel);
+    RUN_TEST(testLoopRateDoesntMatter);
+    RUN_TEST(testStallDoesntThrowThePointer);
+    RUN_TEST(testHeldThroughProfileSwitch);
+    return TEST_RESULT();
+}
@@ -0,0 +1,147 @@
+// WS2812 over RMT - show() never waits on the strip, a frame shown while the last one is still
+// going out gets encoded into the other buffer and sent once the strip's latched, and whatever
+// order that happens in, the LEDs end up showing the last frame.
+
+#include "drivers/Hardware/LED/NeoPixel.h"
+#include "FakeLEDStrip.h"
+#include "SquidTest.h"
+#include <random>
+
+static void reset() {
+    rmtFrames.clear();
+    rmtBusy = false;
+    simNow += 1000;
+}
+
+static void testFrameDecodes() {
+    reset();
+    NeoPixel strip(8, 4);
+    CHECK(strip.begin());
+    strip.setPixelColor(0, NeoPixel::Color(255, 0, 0));
+    strip.setPixelColor(7, NeoPixel::Color(1, 2, 3));
+    strip.show();
+    CHECK_EQ(rmtFrames.size(), 1);
+
+    FakeWS2812Strip leds(8 * 3);
+    leds.receiveAll(rmtFrames);
+    CHECK(!leds.badSymbol);
+    CHECK(leds.bytes == std::vector<uint8_t>(strip.getPixels(), strip.getPixels() + 24));
+    CHECK_EQ(leds.bytes[1], 255);   // GRB on the wire
+    CHECK_EQ(leds.bytes[21], 2);
+}
+
+static void testShowNeverWaits() {
+    reset();
+    NeoPixel strip(4, 4);
+    strip.begin();
+    FakeWS2812Strip leds(4 * 3);
+
+    strip.fill(NeoPixel::Color(10, 20, 30));
+    strip.show();
+    CHECK_EQ(rmtFrames.size(), 1);
+    rmtBusy = true;   // Still on the wire
+
+    uint64_t before = simNow;
+    strip.setPixelColor(1, NeoPixel::Color(99, 0, 0));
+    strip.show();
+    strip.setPixelColor(2, NeoPixel::Color(0, 99, 0));
+    strip.show();   // Both land in the same queued frame
+    CHECK_EQ(simNow, before);
+    CHECK_EQ(rmtFrames.size(), 1);
+    CHECK(strip.poll());
+
+    rmtBusy = false;
+    CHECK(strip.poll());   // Done, but not latched yet
+    CHECK_EQ(rmtFrames.size(), 1);
+    simNow += NEO_RMT_LATCH_US;
+    strip.poll();
+    CHECK_EQ(rmtFrames.size(), 2);
+
+    leds.receiveAll(rmtFrames);
+    CHECK(leds.bytes == std::vector<uint8_t>(strip.getPixels(), strip.getPixels() + 12));
+}
+
+// Each frame that goes out has to be exactly what was shown last, even though the two buffers
+// only get the bytes they missed re-encoded
+static void testRandomFramesAlwaysMatchTheLastShow() {
+    reset();
+    std::mt19937 rng(35);
+    const uint16_t count = 60;
+    NeoPixel strip(count, 4);
+    strip.begin();
+    FakeWS2812Strip leds(count * 3);
+    std::vector<uint8_t> shown(count * 3, 0);
+    bool matched = true;
+    int frames = 0;
+
+    for (int step = 0; step < 3000; step++) {
+        switch (rng() % 6) {
+            case 0: case 1:
+                strip.setPixelColor(rng() % count, rng() & 0xFFFFFF);
+                break;
+            case 2:
+                if (rng() % 8 == 0) strip.clear();
+                else strip.fill(rng() & 0xFFFFFF, rng() % count, rng() % 5);
+                break;
+            case 3:
+                strip.show();
+                if (strip.isChanged()) matched = false;
+                shown.assign(strip.getPixels(), strip.getPixels() + count * 3);
+                break;
+            case 4:
+                rmtBusy = rng() & 1;
+                break;
+            case 5:
+                simNow += rng() % 400;
+                strip.poll();
+                break;
+        }
+
+        if (!rmtFrames.empty()) {
+            // A partial frame only covers the front of the strip, the rest is already right
+            frames += rmtFrames.size();
+            leds.receiveAll(rmtFrames);
+            matched &= leds.bytes == shown;
+        }
+    }
+    rmtBusy = false;
+    strip.show();
+    shown.assign(strip.getPixels(), strip.getPixels() + count * 3);
+    strip.wait();
+    leds.receiveAll(rmtFrames);
+
+    CHECK(matched);
+    CHECK(frames > 100);
+    CHECK(!leds.badSymbol);
+    CHECK(leds.bytes == shown);
+}
+
+static void testNothingChangedSendsNothing() {
+    reset();
+    NeoPixel strip(10, 4);
+    strip.begin();
+    strip.fill(NeoPixel::Color(5, 5, 5));
+    strip.show();
+    strip.wait();
+    rmtFrames.clear();
+
+    strip.fill(NeoPixel::Color(5, 5, 5));
+    strip.show();
+    strip.wait();
+    CHECK_EQ(rmtFrames.size(), 0);
+
+    // Only as far as the last LED that changed
+    simNow += NEO_RMT_LATCH_US;
+    strip.setPixelColor(3, NeoPixel::Color(6, 5, 5));
+    strip.show();
+    CHECK_EQ(rmtFrames.size(), 1);
+    CHECK_EQ(rmtFrames[0].size(), 4 * 3 * 8);
+}
+
+int main() {
+    RUN_TEST(testFrameDecodes);
+    RUN_TEST(testShowNeverWaits);
+    RUN_TEST(testRandomFramesAlwaysMatchTheLastShow);
+    RUN_TEST(testNothingChangedSendsNothing);
+    return TEST_RESULT();
+}
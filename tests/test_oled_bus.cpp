@@ -0,0 +1,81 @@
+// Bus backends - what the Wire and SPI backends put on the wire, replayed into a fake controller,
+// has to leave the same picture as driving the fake directly, in transactions the bus can take.
+
+#include "drivers/Hardware/OLED/OLED.h"
+#include <Wire.h>
+#include <SPI.h>
+#include "FakeOLEDBus.h"
+#include "SquidTest.h"
+
+static void drawSomething(OLED& oled) {
+    oled.draw_string(3, 5, "Squid HID", OLED::DOUBLE_SIZE);
+    oled.draw_circle(100, 40, 15, OLED::SOLID);
+    oled.draw_line(0, 63, 127, 30);
+}
+
+static bool sameGlass(FakeOLEDBus& a, FakeOLEDBus& b) {
+    for (uint8_t y = 0; y < 64; y++)
+        for (uint8_t x = 0; x < 128; x++)
+            if (a.pixel(x, y) != b.pixel(x, y)) return false;
+    return true;
+}
+
+static void testWireTransactions() {
+    TwoWire wire;
+    OLEDWireI2C bus(wire, 21, 22, 0x3D);
+    OLED oled(&bus, 128, 64);
+    oled.begin();
+    drawSomething(oled);
+    oled.display();
+
+    FakeOLEDBus reference, replayed;
+    OLED ref(&reference, 128, 64);
+    ref.begin();
+    drawSomething(ref);
+    ref.display();
+
+    bool addressed = true, fits = true, controlOk = true;
+    for (auto& t : wire.transmissions) {
+        addressed &= t[0] == 0x3D;
+        fits &= t.size() - 1 <= I2C_BUFFER_LENGTH;
+        if (t[1] == 0x00)      replayed.command(&t[2], t.size() - 2);
+        else if (t[1] == 0x40) replayed.data(&t[2], t.size() - 2);
+        else                   controlOk = false;
+    }
+    CHECK(addressed);
+    CHECK(fits);
+    CHECK(controlOk);
+    CHECK(replayed.largestData <= bus.maxChunk());
+    CHECK(sameGlass(reference, replayed));
+}
+
+static void testSPITransactions() {
+    SPIClass spi;
+    spi.dcPin = 16;
+    OLEDSPI bus(spi, 18, 23, 5, 16, 17);
+    OLED oled(&bus, 128, 64);
+    oled.begin();
+    drawSomething(oled);
+    oled.display();
+
+    FakeOLEDBus reference, replayed;
+    OLED ref(&reference, 128, 64);
+    ref.begin();
+    drawSomething(ref);
+    ref.display();
+
+    for (size_t i = 0; i < spi.transactions.size(); i++) {
+        auto& t = spi.transactions[i];
+        if (spi.wasData[i]) replayed.data(t.data(), t.size());
+        else                replayed.command(t.data(), t.size());
+    }
+    CHECK(sameGlass(reference, replayed));
+    CHECK_EQ(simPinLevel[5], HIGH);   // CS let go after the last one
+    CHECK_EQ(simPinLevel[17], HIGH);  // Out of reset
+}
+
+int main() {
+    RUN_TEST(testWireTransactions);
+    RUN_TEST(testSPITransactions);
+    return TEST_RESULT();
+}
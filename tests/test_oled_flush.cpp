@@ -0,0 +1,159 @@
+// Dirty-page flush - only the changed column window of each changed page goes out, a step at a
+// time when it's async, and whatever order it goes out in the glass ends up matching the framebuffer.
+
+#include "drivers/Hardware/OLED/OLED.h"
+#include "FakeOLEDBus.h"
+#include "SquidTest.h"
+#include <random>
+
+static void flushAll(OLED& oled) {
+    oled.display_async();
+    while (oled.flush_step()) {}
+}
+
+// Whatever's on the glass now has to survive a full redraw over a screen of junk unchanged
+static bool glassMatchesFullRedraw(OLED& oled, FakeOLEDBus& bus, uint8_t width, uint8_t height) {
+    static bool before[128][128];
+    for (uint8_t y = 0; y < height; y++)
+        for (uint8_t x = 0; x < width; x++) before[x][y] = bus.pixel(x, y);
+
+    bus.scramble();
+    oled.mark_all_dirty();
+    oled.display();
+
+    for (uint8_t y = 0; y < height; y++)
+        for (uint8_t x = 0; x < width; x++)
+            if (bus.pixel(x, y) != before[x][y]) return false;
+    return true;
+}
+
+static void testBeginSendsEverything() {
+    FakeOLEDBus bus;
+    OLED oled(&bus, 128, 64);
+    oled.begin();
+    CHECK_EQ(bus.dataBytes, 128 * 8);
+    CHECK(bus.largestData <= OLED_FLUSH_CHUNK);
+    CHECK(!oled.is_dirty());
+}
+
+static void testOnlyChangedColumnsGoOut() {
+    FakeOLEDBus bus;
+    OLED oled(&bus, 128, 64);
+    oled.begin();
+    bus.resetCounters();
+
+    oled.draw_pixel(10, 10);
+    oled.draw_pixel(20, 12);
+    oled.display();
+    CHECK_EQ(bus.dataBytes, 11);   // Page 1, columns 10 to 20
+    CHECK(bus.pixel(10, 10));
+    CHECK(bus.pixel(20, 12));
+    CHECK(!bus.pixel(15, 10));
+
+    bus.resetCounters();
+    oled.display();
+    CHECK_EQ(bus.dataBytes, 0);
+    CHECK_EQ(bus.commandCalls, 0);
+
+    // Two pages far apart are two windows, not everything in between
+    oled.draw_pixel(0, 0);
+    oled.draw_pixel(127, 63);
+    oled.display();
+    CHECK_EQ(bus.dataBytes, 2);
+    CHECK(bus.pixel(0, 0) && bus.pixel(127, 63));
+}
+
+static void testAsyncGoesOneTransactionAtATime() {
+    FakeOLEDBus bus;
+    OLED oled(&bus, 128, 64);
+    oled.begin();
+    oled.draw_rectangle(0, 0, 127, 15, OLED::SOLID);   // Pages 0 and 1, 128 columns each
+    bus.resetCounters();
+
+    CHECK(oled.display_async());
+    CHECK_EQ(bus.dataBytes, 0);   // Nothing goes out until it's stepped
+
+    size_t steps = 0;
+    while (oled.flush_step()) {
+        steps++;
+        CHECK(bus.largestData <= OLED_FLUSH_CHUNK);
+    }
+    // An address step and four 32 byte chunks per page
+    CHECK_EQ(steps, 2 * (1 + 4));
+    CHECK_EQ(bus.dataBytes, 256);
+    CHECK(!oled.is_flushing());
+    CHECK(!oled.display_async());   // Clean, so it doesn't even start
+}
+
+static void testDrawingDuringAFlushIsntLost() {
+    FakeOLEDBus bus;
+    OLED oled(&bus, 128, 64);
+    oled.begin();
+
+    oled.draw_pixel(5, 2);
+    oled.draw_pixel(5, 50);
+    oled.display_async();
+    oled.flush_step();   // Page 0 addressed
+    oled.flush_step();   // ...and sent
+    oled.draw_pixel(6, 3);   // Page 0 again, after it went out
+    oled.draw_pixel(7, 51);  // Page 6, before it goes out
+    while (oled.flush_step()) {}
+
+    CHECK(bus.pixel(7, 51));
+    CHECK(!bus.pixel(6, 3));
+    CHECK(oled.is_dirty());
+    flushAll(oled);
+    CHECK(bus.pixel(6, 3));
+    CHECK(!oled.is_dirty());
+}
+
+static void testSH1106PageAddressing() {
+    FakeOLEDBus bus(132, 8, OLED_FLUSH_CHUNK, true);
+    OLED oled(&bus, 128, 64, SH1106);
+    oled.useOffset(true);
+    oled.begin();
+    oled.draw_pixel(0, 0);
+    oled.draw_pixel(100, 40);
+    oled.display();
+    CHECK(bus.pixel(0, 0, 2));
+    CHECK(bus.pixel(100, 40, 2));
+    CHECK(!bus.pixel(0, 0, 0));
+}
+
+// Random drawing with flushes cut off part way - the glass has to end up as a full redraw would leave it
+static void testRandomDrawingMatchesFullRedraw() {
+    std::mt19937 rng(7);
+    for (uint8_t height : { 32, 64 }) {
+        FakeOLEDBus bus(128, height / 8, 16);
+        OLED oled(&bus, 128, height);
+        oled.begin();
+
+        for (int round = 0; round < 300; round++) {
+            uint8_t x0 = rng() % 128, y0 = rng() % height, x1 = rng() % 128, y1 = rng() % height;
+            OLED::tColor color = (rng() & 1) ? OLED::WHITE : OLED::BLACK;
+            switch (rng() % 5) {
+                case 0: oled.draw_pixel(x0, y0, color); break;
+                case 1: oled.draw_line(x0, y0, x1, y1, color); break;
+                case 2: oled.draw_rectangle(x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, x0 < x1 ? x1 : x0, y0 < y1 ? y1 : y0,
+                                            (rng() & 1) ? OLED::SOLID : OLED::HOLLOW, color); break;
+                case 3: oled.draw_string(x0, y0, "Squid", OLED::NORMAL_SIZE, color); break;
+                case 4: oled.draw_circle(x0, y0, rng() % 20, OLED::HOLLOW, color); break;
+            }
+            if (!oled.is_flushing()) oled.display_async();
+            for (int s = rng() % 6; s > 0; s--) oled.flush_step();
+        }
+        flushAll(oled);
+        flushAll(oled);
+        CHECK(glassMatchesFullRedraw(oled, bus, 128, height));
+    }
+}
+
+int main() {
+    RUN_TEST(testBeginSendsEverything);
+    RUN_TEST(testOnlyChangedColumnsGoOut);
+    RUN_TEST(testAsyncGoesOneTransactionAtATime);
+    RUN_TEST(testDrawingDuringAFlushIsntLost);
+    RUN_TEST(testSH1106PageAddressing);
+    RUN_TEST(testRandomDrawingMatchesFullRedraw);
+    return TEST_RESULT();
+}
@@ -0,0 +1,120 @@
+// Glyph blitting - whole columns OR'd into one or two pages at a time has to light exactly the
+// pixels that plotting the font bit by bit would, aligned or not, small or doubled, clipped or not.
+// Also times the two against each other.
+
+#include "drivers/Hardware/OLED/OLED.h"
+#include "FakeOLEDBus.h"
+#include "SquidTest.h"
+#include <chrono>
+#include <initializer_list>
+
+// The slow way - one draw_pixel per lit (or, inverted, unlit) font bit
+static void plotString(OLED& oled, int x, int y, const char* s, OLED::tFontScaling scaling, OLED::tColor color, bool inverted) {
+    int scale = scaling == OLED::DOUBLE_SIZE ? 2 : 1;
+    for (; *s; s++, x += 6 * scale) {
+        const uint8_t* glyph = &oled_font6x8[((unsigned char)*s - 32) * 6];
+        for (int col = 0; col < 6; col++) {
+            for (int bit = 0; bit < 8; bit++) {
+                if (((glyph[col] >> bit) & 1) == inverted) continue;
+                for (int dx = 0; dx < scale; dx++)
+                    for (int dy = 0; dy < scale; dy++) {
+                        int px = x + col * scale + dx, py = y + bit * scale + dy;
+                        if (px < 128 && py < 64) oled.draw_pixel(px, py, color);
+                    }
+            }
+        }
+    }
+}
+
+static bool blitMatchesPlot(int x, int y, OLED::tFontScaling scaling, OLED::tColor color, bool inverted) {
+    const char* text = "Sq~d!0";
+    FakeOLEDBus bus, refBus;
+    OLED oled(&bus, 128, 64), ref(&refBus, 128, 64);
+    oled.begin();
+    ref.begin();
+
+    // Black text only shows up on something lit
+    if (color == OLED::BLACK) {
+        oled.clear(OLED::WHITE);
+        ref.clear(OLED::WHITE);
+    }
+    if (inverted) oled.inverse();
+    oled.draw_string(x, y, text, scaling, color);
+    plotString(ref, x, y, text, scaling, color, inverted);
+    oled.display();
+    ref.display();
+
+    for (uint8_t py = 0; py < 64; py++)
+        for (uint8_t px = 0; px < 128; px++)
+            if (bus.pixel(px, py) != refBus.pixel(px, py)) return false;
+    return true;
+}
+
+static void testNormalSize() {
+    for (int y : { 0, 3, 8, 13, 59 })   // Aligned, straddling two pages, and hanging off the bottom
+        for (int x : { 0, 100 })        // ...and off the right edge
+            CHECK(blitMatchesPlot(x, y, OLED::NORMAL_SIZE, OLED::WHITE, false));
+}
+
+static void testDoubleSize() {
+    for (int y : { 0, 5, 16, 50 })
+        for (int x : { 0, 70 })
+            CHECK(blitMatchesPlot(x, y, OLED::DOUBLE_SIZE, OLED::WHITE, false));
+}
+
+static void testBlackAndInverted() {
+    CHECK(blitMatchesPlot(4, 6, OLED::NORMAL_SIZE, OLED::BLACK, false));
+    CHECK(blitMatchesPlot(4, 6, OLED::NORMAL_SIZE, OLED::WHITE, true));
+    CHECK(blitMatchesPlot(4, 21, OLED::DOUBLE_SIZE, OLED::WHITE, true));
+}
+
+// A glyph only marks the columns it covers, on the pages it covers
+static void testGlyphMarksItsOwnBox() {
+    FakeOLEDBus bus;
+    OLED oled(&bus, 128, 64);
+    oled.begin();
+    bus.resetCounters();
+
+    oled.draw_character(30, 8, 'A');
+    oled.display();
+    CHECK_EQ(bus.dataBytes, 6);
+
+    bus.resetCounters();
+    oled.draw_character(30, 20, 'A', OLED::DOUBLE_SIZE);   // 16 rows from 20 covers pages 2 to 4
+    oled.display();
+    CHECK_EQ(bus.dataBytes, 3 * 12);
+}
+
+// Not a pass/fail beyond the blit being quicker - a screen of text drawn over and over both ways
+static void benchDrawString() {
+    const char* lines[] = { "Layer 2  NKRO  BLE", "Battery 87%  7.5ms", "abcdefghijklmnopqrstu", "0123456789!?#$%&*()[]" };
+    const int reps = 2000;
+    FakeOLEDBus bus;
+    OLED oled(&bus, 128, 64);
+    oled.begin();
+
+    auto time = [&](bool blit) {
+        auto start = std::chrono::steady_clock::now();
+        for (int rep = 0; rep < reps; rep++)
+            for (int line = 0; line < 4; line++) {
+                // Half straddle two pages, which is the blit's slow case
+                int y = line * 16 + (rep & 1) * 3;
+                if (blit) oled.draw_string(0, y, lines[line]);
+                else      plotString(oled, 0, y, lines[line], OLED::NORMAL_SIZE, OLED::WHITE, false);
+            }
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / reps;
+    };
+    double plot = time(false);
+    double blit = time(true);
+    printf("     4 lines of text: plotString %.1f us, draw_string %.1f us (%.1fx)\n", plot, blit, plot / blit);
+    CHECK(blit < plot);
+}
+
+int main() {
+    RUN_TEST(testNormalSize);
+    RUN_TEST(testDoubleSize);
+    RUN_TEST(testBlackAndInverted);
+    RUN_TEST(testGlyphMarksItsOwnBox);
+    RUN_TEST(benchDrawString);
+    return TEST_RESULT();
+}
@@ -0,0 +1,112 @@
+// TTY scrolling - whole lines rotate the page ring and move the start line instead of shifting the
+// buffer, and what ends up on the glass is the same as drawing the last lines in place.
+
+#include "drivers/Hardware/OLED/OLED.h"
+#include "FakeOLEDBus.h"
+#include "SquidTest.h"
+
+static bool sameGlass(FakeOLEDBus& a, FakeOLEDBus& b, uint8_t width, uint8_t height) {
+    for (uint8_t y = 0; y < height; y++)
+        for (uint8_t x = 0; x < width; x++)
+            if (a.pixel(x, y) != b.pixel(x, y)) return false;
+    return true;
+}
+
+// Prints count numbered lines to a console, then draws the ones that should still be visible
+// straight onto a second display - the two have to look the same
+static bool consoleMatchesDrawn(OLED::tDisplayCtrl ctrl, uint8_t height, int count) {
+    bool pageOnly = ctrl != SSD1306;
+    FakeOLEDBus ttyBus(128, height / 8, OLED_FLUSH_CHUNK, pageOnly), refBus(128, height / 8, OLED_FLUSH_CHUNK, pageOnly);
+    OLED tty(&ttyBus, 128, height, ctrl), ref(&refBus, 128, height, ctrl);
+    tty.begin();
+    ref.begin();
+
+    tty.setTTYMode(true);
+    for (int i = 0; i < count; i++) {
+        tty.printf("line %d\n", i);
+        if (i % 3 == 0) tty.display();   // Some scrolls go out one at a time, some bunched up
+    }
+    tty.display();
+
+    // The trailing newline leaves the bottom row empty
+    int rows = height / 8;
+    int first = count - (rows - 1);
+    if (first < 0) first = 0;
+    char text[16];
+    for (int i = first; i < count; i++) {
+        snprintf(text, sizeof(text), "line %d", i);
+        ref.draw_string(0, (i - first) * 8, text);
+    }
+    ref.display();
+    return sameGlass(ttyBus, refBus, 128, height);
+}
+
+static void testConsoleMatchesDrawnText() {
+    CHECK(consoleMatchesDrawn(SSD1306, 64, 5));    // Not scrolled yet
+    CHECK(consoleMatchesDrawn(SSD1306, 64, 30));   // Start line has wrapped round a few times
+    CHECK(consoleMatchesDrawn(SSD1306, 32, 30));   // No hardware scroll, the ring is unrolled in the flush
+    CHECK(consoleMatchesDrawn(SH1106, 64, 30));
+    CHECK(consoleMatchesDrawn(SH1107, 128, 40));   // Start line goes through 0xDC
+}
+
+static void testScrollSendsOnePage() {
+    FakeOLEDBus bus;
+    OLED oled(&bus, 128, 64);
+    oled.begin();
+    oled.setTTYMode(true);
+    for (int i = 0; i < 20; i++) oled.printf("line %d\n", i);
+    oled.display();
+
+    bus.resetCounters();
+    oled.printf("one more\n");
+    CHECK_EQ(bus.dataBytes, 0);   // Printing only marks pages, nothing goes out until a flush
+    oled.display();
+    // The text's own window on the row above, the blanked page, and a start line
+    CHECK_EQ(bus.dataBytes, 8 * OLED_FONT_WIDTH + 128);
+    CHECK(bus.startLine != 0);
+}
+
+static void testScrollWithoutStartLineResendsEverything() {
+    FakeOLEDBus bus(128, 4);
+    OLED oled(&bus, 128, 32);
+    oled.begin();
+    oled.setTTYMode(true);
+    for (int i = 0; i < 10; i++) oled.printf("line %d\n", i);
+    oled.display();
+
+    bus.resetCounters();
+    oled.printf("one more\n");
+    oled.display();
+    CHECK_EQ(bus.dataBytes, 128 * 4);
+    CHECK_EQ(bus.startLine, 0);
+}
+
+// Anything that isn't whole pages still gets shifted bit by bit, and has to land in the same place
+static void testPartialScrollShiftsPixels() {
+    FakeOLEDBus bus, refBus;
+    OLED oled(&bus, 128, 64), ref(&refBus, 128, 64);
+    oled.begin();
+    ref.begin();
+
+    // Scroll a whole page first so the ring is rotated under the bit shift
+    oled.scroll_up(8);
+    for (uint8_t y = 0; y < 64; y++) {
+        for (uint8_t x = 0; x < 128; x += 7) {
+            if ((x * 31 + y * 17) % 5) continue;
+            oled.draw_pixel(x, y);
+            if (y >= 11) ref.draw_pixel(x, y - 11);
+        }
+    }
+    oled.scroll_up(11);
+    oled.display();
+    ref.display();
+    CHECK(sameGlass(bus, refBus, 128, 64));
+}
+
+int main() {
+    RUN_TEST(testConsoleMatchesDrawnText);
+    RUN_TEST(testScrollSendsOnePage);
+    RUN_TEST(testScrollWithoutStartLineResendsEverything);
+    RUN_TEST(testPartialScrollShiftsPixels);
+    return TEST_RESULT();
+}
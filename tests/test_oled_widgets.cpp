@@ -0,0 +1,135 @@
+// Retained widgets - setting what's already shown costs nothing on the bus, a change only sends
+// its own box, and hiding one wipes it.
+
+#include "drivers/Hardware/OLED/OLEDWidgets.h"
+#include "FakeOLEDBus.h"
+#include "SquidTest.h"
+
+static bool boxLit(FakeOLEDBus& bus, int x0, int y0, int x1, int y1) {
+    for (int y = y0; y <= y1; y++)
+        for (int x = x0; x <= x1; x++)
+            if (bus.pixel(x, y)) return true;
+    return false;
+}
+
+static void testSameValueIsFree() {
+    FakeOLEDBus bus;
+    OLED oled(&bus, 128, 64);
+    oled.begin();
+
+    OLEDLabel layer(0, 0, 128);
+    OLEDBar battery(0, 56, 64, 8);
+    OLEDCompositor screen;
+    screen.add(&layer);
+    screen.add(&battery);
+
+    CHECK(!screen.render(oled));   // Nothing's been given a value, so nothing draws
+    layer.set("Base");
+    battery.set(80);
+    CHECK(screen.render(oled));
+    oled.display();
+
+    bus.resetCounters();
+    layer.set("Base");
+    battery.set(80);
+    CHECK(!screen.isStale());
+    CHECK(!screen.render(oled));
+    CHECK(!oled.is_dirty());
+    oled.display();
+    CHECK_EQ(bus.dataBytes, 0);
+}
+
+static void testChangeOnlySendsItsBox() {
+    FakeOLEDBus bus;
+    OLED oled(&bus, 128, 64);
+    oled.begin();
+
+    OLEDLabel layer(0, 0, 60);
+    OLEDLabel wpm(64, 24, 64, OLED::NORMAL_SIZE, OLEDLabel::ALIGN_RIGHT);
+    OLEDCompositor screen;
+    screen.add(&layer);
+    screen.add(&wpm);
+    layer.set("Base");
+    wpm.set("0 wpm");
+    screen.render(oled);
+    oled.display();
+
+    bus.resetCounters();
+    wpm.setf("%d wpm", 85);
+    screen.render(oled);
+    oled.display();
+    CHECK_EQ(bus.dataBytes, 64);   // Page 3, the label's 64 columns and nothing else
+    CHECK(boxLit(bus, 0, 0, 59, 7));   // The other label's still there
+
+    // Right aligned, so the text ends at the box's edge
+    CHECK(boxLit(bus, 122, 24, 127, 31));
+    CHECK(!boxLit(bus, 64, 24, 127 - 6 * 6, 31));
+}
+
+static void testHideWipesTheBox() {
+    FakeOLEDBus bus;
+    OLED oled(&bus, 128, 64);
+    oled.begin();
+
+    OLEDBar bar(10, 40, 50, 10, 10);
+    bar.set(10);
+    bar.render(oled);
+    oled.display();
+    CHECK(boxLit(bus, 10, 40, 59, 49));
+
+    bar.hide();
+    CHECK(bar.isStale());
+    CHECK(bar.render(oled));
+    oled.display();
+    CHECK(!boxLit(bus, 10, 40, 59, 49));
+    CHECK(!bar.render(oled));
+
+    // Setting the same value after a hide still brings it back
+    bar.set(10);
+    CHECK(bar.render(oled));
+}
+
+static void testInvalidateRedrawsAfterAClear() {
+    FakeOLEDBus bus;
+    OLED oled(&bus, 128, 64);
+    oled.begin();
+
+    OLEDLabel label(0, 16, 128, OLED::DOUBLE_SIZE, OLEDLabel::ALIGN_CENTER);
+    OLEDCompositor screen;
+    screen.add(&label);
+    label.set("Squid");
+    screen.render(oled);
+    oled.clear();
+    oled.display();
+    CHECK(!boxLit(bus, 0, 16, 127, 31));
+
+    screen.invalidate();
+    CHECK(screen.render(oled));
+    oled.display();
+    // 5 doubled glyphs are 60px wide, centred in 128
+    CHECK(boxLit(bus, 34, 16, 93, 31));
+    CHECK(!boxLit(bus, 0, 16, 33, 31));
+    CHECK(!boxLit(bus, 94, 16, 127, 31));
+}
+
+static void testGraphKeepsTheNewestOnTheRight() {
+    FakeOLEDBus bus;
+    OLED oled(&bus, 128, 64);
+    oled.begin();
+
+    OLEDGraph graph(0, 32, 16, 32, 100);
+    for (int i = 0; i < 20; i++) graph.push(i == 19 ? 100 : 0);   // Wraps the ring, last one full height
+    graph.render(oled);
+    oled.display();
+    CHECK(boxLit(bus, 15, 32, 15, 63));
+    CHECK(!boxLit(bus, 0, 32, 14, 63));
+}
+
+int main() {
+    RUN_TEST(testSameValueIsFree);
+    RUN_TEST(testChangeOnlySendsItsBox);
+    RUN_TEST(testHideWipesTheBox);
+    RUN_TEST(testInvalidateRedrawsAfterAClear);
+    RUN_TEST(testGraphKeepsTheNewestOnTheRight);
+    return TEST_RESULT();
+}
@@ -0,0 +1,430 @@
+// Pointing sensors - a fake bus plays a PixArt sensor, keeping to its timings and handing out the
+// motion it's built up. Checks power-up, CPI registers, the one transaction motion burst (primed
+// once on the PMW3360), lift and no-motion bursts, and SQUIDPOINTER's polling, orientation and snap.
+// A burst on the wire has to fit between 8kHz polls, and snap asked for before begin() still sticks.
+
+#include "drivers/Hardware/Pointer/Pointer.h"
+#include "SquidTest.h"
+#include <vector>
+
+// Register reads and writes, plus a motion burst that hands over and clears whatever built up.
+// Counts the datasheet waits it was given, anything shorter is a timing violation. Given a clock,
+// the bytes take as long as they would on the wire.
+class FakePointerBus : public PointerBus {
+public:
+    uint8_t  regs[128] = {};
+    uint8_t  burstRegister;
+    bool     needsPrime;
+    int16_t  dx = 0, dy = 0;
+    uint8_t  motionBits = 0;   // Lift and friends, MOT gets set from dx/dy
+    uint8_t  squal = 60;
+
+    std::vector<std::pair<uint8_t, uint8_t>> writes;
+    std::vector<uint8_t> srom;
+    int  selects = 0;
+    int  bursts = 0;
+    int  badBursts = 0;       // Burst without the prime it needed
+    int  violations = 0;
+    bool begun = false;
+    uint32_t clockHz = 0;
+
+    FakePointerBus(uint8_t productId, uint8_t burstRegister, bool needsPrime) :
+        burstRegister(burstRegister), needsPrime(needsPrime) { regs[0x00] = productId; }
+
+    bool begin() override { begun = true; return true; }
+
+    void select(bool active) override {
+        if (active && !selected) selects++;
+        selected = active;
+        if (active) { state = ADDRESS; waited = 0; }
+    }
+
+    void transfer(const uint8_t* tx, uint8_t* rx, size_t length) override {
+        if (!selected) { violations++; return; }
+        if (clockHz) {
+            wireNs += length * 8 * 1000000000ULL / clockHz;
+            simNow += wireNs / 1000;
+            wireNs %= 1000;
+        }
+        for (size_t i = 0; i < length; i++) {
+            uint8_t in = tx ? tx[i] : 0;
+            uint8_t out = 0;
+            switch (state) {
+            case ADDRESS:
+                address = in;
+                waited = 0;
+                if (in & 0x80) state = (in & 0x7F) == 0x62 ? SROM : WRITE;
+                else if (in == burstRegister) { state = BURST; startBurst(); }
+                else { state = READ; primed = false; }
+                break;
+            case WRITE:
+                regs[address & 0x7F] = in;
+                writes.push_back({ (uint8_t)(address & 0x7F), in });
+                primed = (address & 0x7F) == burstRegister;
+                state = DONE;
+                break;
+            case READ:
+                if (waited < 160) violations++;   // tSRAD
+                out = regs[address];
+                state = DONE;
+                break;
+            case BURST:
+                if (i == 0 && waited < 35) violations++;   // tSRAD_MOTBR
+                out = burstIndex < POINTER_BURST_LENGTH ? burst[burstIndex++] : 0;
+                break;
+            case SROM:
+                srom.push_back(in);
+                break;
+            case DONE:
+                violations++;   // More bytes than the access has
+                break;
+            }
+            if (rx) rx[i] = out;
+        }
+    }
+
+    void wait(uint32_t us) override {
+        waited += us;
+        simNow += us;
+    }
+
+    // What got written to a register last, -1 if nothing did
+    int written(uint8_t reg) const {
+        for (auto it = writes.rbegin(); it != writes.rend(); ++it)
+            if (it->first == reg) return it->second;
+        return -1;
+    }
+
+private:
+    enum State { ADDRESS, WRITE, READ, BURST, SROM, DONE };
+
+    void startBurst() {
+        bursts++;
+        burstIndex = 0;
+        if (needsPrime && !primed) {
+            badBursts++;
+            memset(burst, 0xEE, sizeof(burst));
+            return;
+        }
+        memset(burst, 0, sizeof(burst));
+        burst[0] = motionBits | ((dx || dy) ? 0x80 : 0);
+        burst[2] = dx & 0xFF;
+        burst[3] = (uint16_t)dx >> 8;
+        burst[4] = dy & 0xFF;
+        burst[5] = (uint16_t)dy >> 8;
+        burst[6] = squal;
+        dx = dy = 0;
+    }
+
+    State    state = DONE;
+    bool     selected = false;
+    bool     primed = false;
+    uint8_t  address = 0;
+    uint32_t waited = 0;
+    uint64_t wireNs = 0;
+    uint8_t  burst[POINTER_BURST_LENGTH] = {};
+    size_t   burstIndex = 0;
+};
+
+static void testPMW3360Begin() {
+    FakePointerBus bus(0x42, 0x50, true);
+    PMW3360 sensor(&bus);
+    CHECK(sensor.begin());
+    CHECK(bus.begun);
+    CHECK_EQ(bus.written(0x3A), 0x5A);   // Power_Up_Reset
+    CHECK_EQ(sensor.getCPI(), 1600);
+    CHECK_EQ(bus.regs[0x0F], 15);
+    CHECK(bus.srom.empty());             // No firmware given, none uploaded
+    CHECK_EQ(bus.violations, 0);
+
+    // Something else on the bus isn't a PMW3360
+    FakePointerBus wrong(0x00, 0x50, true);
+    PMW3360 missing(&wrong);
+    CHECK(!missing.begin());
+}
+
+static void testPMW3360Firmware() {
+    FakePointerBus bus(0x42, 0x50, true);
+    bus.regs[0x2A] = 0x04;   // SROM_ID once it's running
+    const uint8_t srom[] = { 0x01, 0x02, 0x03, 0xFE };
+    PMW3360 sensor(&bus);
+    sensor.setFirmware(srom, sizeof(srom));
+    CHECK(sensor.begin());
+    CHECK_EQ(bus.srom.size(), sizeof(srom));
+    CHECK(bus.srom == std::vector<uint8_t>(srom, srom + sizeof(srom)));
+    CHECK_EQ(bus.written(0x13), 0x18);
+    CHECK_EQ(bus.violations, 0);
+
+    // SROM_ID of 0 means it didn't take
+    FakePointerBus dead(0x42, 0x50, true);
+    PMW3360 failed(&dead);
+    failed.setFirmware(srom, sizeof(srom));
+    CHECK(!failed.begin());
+}
+
+static void testPMW3360CPI() {
+    FakePointerBus bus(0x42, 0x50, true);
+    PMW3360 sensor(&bus);
+    CHECK(sensor.begin());
+    CHECK(sensor.setCPI(12345));
+    CHECK_EQ(sensor.getCPI(), 12000);
+    CHECK_EQ(bus.regs[0x0F], 119);
+    CHECK(sensor.setCPI(10));
+    CHECK_EQ(sensor.getCPI(), 100);
+    CHECK_EQ(bus.regs[0x0F], 0);
+    CHECK(sensor.setCPI(850));   // Steps of 100, rounded down
+    CHECK_EQ(sensor.getCPI(), 800);
+    CHECK_EQ(bus.regs[0x0F], 7);
+
+    CHECK(sensor.setAngleSnap(true));
+    CHECK_EQ(bus.regs[0x42], 0x80);
+    sensor.setAngleSnap(false);
+    CHECK_EQ(bus.regs[0x42], 0x00);
+}
+
+static void testPMW3360Burst() {
+    FakePointerBus bus(0x42, 0x50, true);
+    PMW3360 sensor(&bus);
+    CHECK(sensor.begin());
+    PointerMotion motion;
+
+    // First burst after other traffic needs the prime, after that it's one transaction each
+    bus.dx = 16; bus.dy = -2; bus.squal = 77;
+    int selects = bus.selects;
+    CHECK(sensor.readMotion(motion));
+    CHECK_EQ(bus.selects - selects, 2);
+    CHECK(motion.moved);
+    CHECK(!motion.lifted);
+    CHECK_EQ(motion.dx, 16);
+    CHECK_EQ(motion.dy, -2);
+    CHECK_EQ(motion.squal, 77);
+
+    bus.dx = -300; bus.dy = 1000;
+    selects = bus.selects;
+    CHECK(sensor.readMotion(motion));
+    CHECK_EQ(bus.selects - selects, 1);
+    CHECK_EQ(motion.dx, -300);
+    CHECK_EQ(motion.dy, 1000);
+
+    // Nothing built up
+    CHECK(sensor.readMotion(motion));
+    CHECK(!motion.moved);
+
+    // Changing CPI knocks it out of burst mode, the next burst primes again
+    sensor.setCPI(3200);
+    bus.dx = 1;
+    selects = bus.selects;
+    CHECK(sensor.readMotion(motion));
+    CHECK_EQ(bus.selects - selects, 2);
+    CHECK_EQ(motion.dx, 1);
+
+    CHECK_EQ(bus.badBursts, 0);
+    CHECK_EQ(bus.violations, 0);
+}
+
+static void testPAW3395() {
+    FakePointerBus bus(0x51, 0x16, false);
+    const PointerRegWrite init[] = { { 0x7F, 0x07 }, { 0x40, 0x41 }, { 0x7F, 0x00 } };
+    PAW3395 sensor(&bus);
+    sensor.setInitSequence(init, 3);
+    CHECK(sensor.begin());
+
+    // The init sequence goes out in order, after the reset
+    size_t reset = 0;
+    while (reset < bus.writes.size() && bus.writes[reset].first != 0x3A) reset++;
+    CHECK(reset + 3 < bus.writes.size());
+    CHECK(bus.writes[reset + 1] == std::make_pair((uint8_t)0x7F, (uint8_t)0x07));
+    CHECK(bus.writes[reset + 2] == std::make_pair((uint8_t)0x40, (uint8_t)0x41));
+    CHECK(bus.writes[reset + 3] == std::make_pair((uint8_t)0x7F, (uint8_t)0x00));
+
+    // 50 CPI steps, 16 bits per axis, then latched
+    CHECK(sensor.setCPI(26000));
+    CHECK_EQ(sensor.getCPI(), 26000);
+    CHECK_EQ(bus.regs[0x48] | (bus.regs[0x49] << 8), 520);
+    CHECK_EQ(bus.regs[0x4A] | (bus.regs[0x4B] << 8), 520);
+    CHECK_EQ(bus.writes.back().first, 0x47);
+    CHECK_EQ(bus.writes.back().second, 0x01);
+    CHECK(sensor.setCPI(30000));
+    CHECK_EQ(sensor.getCPI(), 26000);
+    CHECK(sensor.setCPI(1));
+    CHECK_EQ(sensor.getCPI(), 50);
+
+    // No prime, straight to the burst every time
+    PointerMotion motion;
+    bus.dx = -5; bus.dy = 7;
+    int selects = bus.selects;
+    CHECK(sensor.readMotion(motion));
+    CHECK_EQ(bus.selects - selects, 1);
+    CHECK_EQ(motion.dx, -5);
+    CHECK_EQ(motion.dy, 7);
+
+    CHECK(!sensor.setAngleSnap(true));   // SQUIDPOINTER does it then
+    CHECK_EQ(bus.violations, 0);
+}
+
+struct Moves {
+    std::vector<std::pair<int, int>> list;
+    SQUIDPOINTER::MotionCallback callback() {
+        return [this](int16_t dx, int16_t dy) { list.push_back({ dx, dy }); };
+    }
+};
+
+static void testPollingAndOrientation() {
+    simNow = 0;
+    auto* bus = new FakePointerBus(0x42, 0x50, true);
+    SQUIDPOINTER pointer;
+    Moves moves;
+    pointer.onMotion(moves.callback());
+    CHECK(pointer.begin(new PMW3360(bus, true)));
+    CHECK_EQ(pointer.getCPI(), 1600);
+
+    bus->dx = 16; bus->dy = -2; bus->squal = 77;
+    CHECK(pointer.update(1000));
+    CHECK_EQ(moves.list.size(), 1);
+    CHECK(moves.list[0] == std::make_pair(16, -2));
+    CHECK_EQ(pointer.getSqual(), 77);
+    CHECK(pointer.getReadTime() > 0);
+
+    // Inside the poll interval the sensor isn't touched
+    bus->dx = 4;
+    int bursts = bus->bursts;
+    CHECK(!pointer.update(1000 + POINTER_POLL_US - 1));
+    CHECK_EQ(bus->bursts, bursts);
+    CHECK(pointer.update(1000 + POINTER_POLL_US));
+    CHECK_EQ(moves.list.size(), 2);
+
+    // Swap, then invert X
+    pointer.setOrientation(true, true, false);
+    bus->dx = 16; bus->dy = -2;
+    CHECK(pointer.update(2000));
+    CHECK(moves.list.back() == std::make_pair(2, 16));
+
+    // Lifted or still, nothing goes out
+    pointer.setOrientation(false, false, false);
+    bus->dx = 50; bus->motionBits = 0x08;
+    CHECK(!pointer.update(3000));
+    bus->motionBits = 0;
+    CHECK(!pointer.update(4000));
+    CHECK_EQ(moves.list.size(), 3);
+
+    // The sensor does the snapping itself on a PMW3360
+    pointer.setAngleSnap(true);
+    CHECK_EQ(bus->regs[0x42], 0x80);
+    bus->dx = 80; bus->dy = 3;
+    CHECK(pointer.update(5000));
+    CHECK(moves.list.back() == std::make_pair(80, 3));
+    CHECK_EQ(bus->badBursts, 0);
+}
+
+static void testSoftwareSnap() {
+    auto* bus = new FakePointerBus(0x51, 0x16, false);
+    SQUIDPOINTER pointer;
+    Moves moves;
+    pointer.onMotion(moves.callback());
+    CHECK(pointer.begin(new PAW3395(bus, true)));
+    pointer.setAngleSnap(true);
+
+    bus->dx = 80; bus->dy = 3;   // Mostly X, the wobble goes
+    CHECK(pointer.update(1000));
+    CHECK(moves.list.back() == std::make_pair(80, 0));
+    bus->dx = -2; bus->dy = -40;
+    CHECK(pointer.update(2000));
+    CHECK(moves.list.back() == std::make_pair(0, -40));
+    bus->dx = 30; bus->dy = 20;   // A real diagonal stays one
+    CHECK(pointer.update(3000));
+    CHECK(moves.list.back() == std::make_pair(30, 20));
+
+    pointer.setAngleSnap(false);
+    bus->dx = 80; bus->dy = 3;
+    CHECK(pointer.update(4000));
+    CHECK(moves.list.back() == std::make_pair(80, 3));
+}
+
+// The whole burst, waits and clocking included, has to be done before the next 8kHz poll is due.
+// The PMW3360's first one after a register access carries the prime write, that's a one-off.
+static void testBurstFitsThePollInterval() {
+    struct Sensor { uint8_t id, burstRegister; bool prime; };
+    for (Sensor kind : { Sensor{ 0x42, 0x50, true }, Sensor{ 0x51, 0x16, false } }) {
+        simNow = 0;
+        auto* bus = new FakePointerBus(kind.id, kind.burstRegister, kind.prime);
+        bus->clockHz = POINTER_SPI_CLOCK;
+        SQUIDPOINTER pointer;
+        Moves moves;
+        pointer.onMotion(moves.callback());
+        if (kind.prime) CHECK(pointer.begin(new PMW3360(bus, true)));
+        else            CHECK(pointer.begin(new PAW3395(bus, true)));
+
+        uint32_t first = 0, slowest = 0;
+        for (int i = 0; i < 100; i++) {
+            bus->dx = 10 + i;
+            CHECK(pointer.update(micros()));
+            if (i == 0) first = pointer.getReadTime();
+            else if (pointer.getReadTime() > slowest) slowest = pointer.getReadTime();
+            simNow += POINTER_POLL_US;
+        }
+        printf("     %s: burst takes %u of %d us (%u for the first)\n", pointer.getSensor()->name(), slowest, POINTER_POLL_US, first);
+        CHECK(slowest > 0);
+        CHECK(slowest < POINTER_POLL_US);
+        CHECK_EQ(moves.list.size(), 100);
+        CHECK_EQ(bus->violations, 0);
+        CHECK_EQ(bus->badBursts, 0);
+    }
+}
+
+// Asked for before there's a sensor, it's applied once there is one
+static void testAngleSnapBeforeBegin() {
+    auto* bus = new FakePointerBus(0x42, 0x50, true);
+    SQUIDPOINTER pointer;
+    pointer.setAngleSnap(true);
+    CHECK(pointer.begin(new PMW3360(bus, true)));
+    CHECK_EQ(bus->regs[0x42], 0x80);
+
+    auto* plain = new FakePointerBus(0x51, 0x16, false);
+    Moves moves;
+    pointer.onMotion(moves.callback());
+    CHECK(pointer.begin(new PAW3395(plain, true)));   // Nothing to do it in hardware, so software does
+    plain->dx = 80; plain->dy = 3;
+    CHECK(pointer.update(1000));
+    CHECK(moves.list.back() == std::make_pair(80, 0));
+}
+
+static void testMotionPin() {
+    auto* bus = new FakePointerBus(0x42, 0x50, true);
+    SQUIDPOINTER pointer;
+    Moves moves;
+    pointer.onMotion(moves.callback());
+    CHECK(pointer.begin(new PMW3360(bus, true), 7));
+
+    // Whatever built up before the interrupt was attached gets one read
+    bus->dx = 3;
+    CHECK(pointer.update(1000));
+    CHECK_EQ(moves.list.size(), 1);
+
+    // Line high and no edge, no burst
+    bus->dx = 5;
+    int bursts = bus->bursts;
+    CHECK(!pointer.update(2000));
+    CHECK_EQ(bus->bursts, bursts);
+
+    CHECK(simInterrupt(7));
+    CHECK(pointer.update(3000));
+    CHECK(moves.list.back() == std::make_pair(5, 0));
+
+    pointer.end();
+    CHECK(!simInterrupt(7));   // Detached
+    CHECK(!pointer.update(4000));
+}
+
+int main() {
+    RUN_TEST(testPMW3360Begin);
+    RUN_TEST(testPMW3360Firmware);
+    RUN_TEST(testPMW3360CPI);
+    RUN_TEST(testPMW3360Burst);
+    RUN_TEST(testPAW3395);
+    RUN_TEST(testPollingAndOrientation);
+    RUN_TEST(testSoftwareSnap);
+    RUN_TEST(testBurstFitsThePollInterval);
+    RUN_TEST(testAngleSnapBeforeBegin);
+    RUN_TEST(testMotionPin);
+    return TEST_RESULT();
+}
@@ -0,0 +1,275 @@
+// PS/2 transport - bytes clocked in through the ISR land in the RX ring in order, with bad parity
+// and a full ring counted rather than let through, and host commands get answered whether their
+// argument byte turns up in the same update or a later one. A command where an argument should be
+// starts over, and 0xF3 on a combo device sets both the typematic and the mouse sample rate. The
+// ring on its own gets a producer and a consumer thread hammering it.
+
+#include "drivers/Software/Transport/PS2/PS2Transport.h"
+#include "drivers/Software/Transport/PS2/PS2RxRing.h"
+#include "drivers/Software/HID/HostLEDs.h"
+#include "SquidTest.h"
+#include <initializer_list>
+#include <thread>
+#include <vector>
+
+#define CLK_PIN   3
+#define DATA_PIN  4
+
+// The host end of the wire. It clocks the transport's writes and reads them off the data line, and
+// clocks its own bytes in through the ISR.
+namespace FakeHost {
+    std::vector<uint8_t> received;
+    int      badFrames = 0;
+    int      bit = -1;            // -1 between frames
+    uint16_t frame = 0;
+    bool     clock = LOW;
+
+    int read(uint8_t pin) {
+        if (pin == DATA_PIN) return simPinLevel[DATA_PIN];
+        clock = !clock;           // Every wait for an edge sees one straight away
+        return clock;
+    }
+
+    void write(uint8_t pin, uint8_t level) {
+        if (pin == CLK_PIN && level == LOW) {
+            bit = 0;              // Clock held low, a frame's on its way
+            frame = 0;
+        } else if (pin == DATA_PIN && bit >= 0) {
+            frame |= (level ? 1 : 0) << bit++;
+            if (bit < 10) return;
+            // 8 data bits, odd parity, stop bit high
+            uint8_t data = frame & 0xFF;
+            bool ok = (__builtin_popcount(frame & 0x1FF) & 1) && (frame >> 9 & 1);
+            if (ok) received.push_back(data);
+            else badFrames++;
+            bit = -1;
+        }
+    }
+
+    void send(uint8_t data, bool goodParity = true) {
+        bool parity = !(__builtin_popcount(data) & 1) == goodParity;
+        uint16_t bits = (data << 1) | (parity << 9) | (1 << 10);
+        for (int i = 0; i < 11; i++) {
+            simPinLevel[DATA_PIN] = bits >> i & 1;
+            simNow += 60;
+            simInterrupt(CLK_PIN);
+        }
+    }
+
+    void attach() {
+        simPinRead = read;
+        simPinWrite = write;
+        received.clear();
+        badFrames = 0;
+        bit = -1;
+    }
+}
+
+struct Callbacks : public TransportCallbacks {
+    std::vector<uint8_t> leds;
+    void onConnect() override {}
+    void onDisconnect() override {}
+    void onDataReceived(const uint8_t*, size_t) override {}
+    void onOutputReport(uint8_t, const uint8_t* data, size_t length) override {
+        if (length) leds.push_back(data[0]);
+    }
+};
+
+struct Device {
+    Callbacks    callbacks;
+    PS2Transport transport;
+
+    Device(PS2Transport::DeviceType type = PS2Transport::DeviceType::PS2_KEYBOARD) : transport(type, CLK_PIN, DATA_PIN) {
+        FakeHost::attach();
+        transport.setCallbacks(&callbacks);
+        transport.begin();
+        FakeHost::received.clear();
+    }
+
+    // Bytes from the host, then one update
+    std::vector<uint8_t> command(std::initializer_list<uint8_t> bytes) {
+        FakeHost::received.clear();
+        for (uint8_t b : bytes) FakeHost::send(b);
+        transport.update();
+        return FakeHost::received;
+    }
+};
+
+typedef std::vector<uint8_t> Bytes;
+
+static void testBegin() {
+    FakeHost::attach();
+    PS2Transport transport(PS2Transport::DeviceType::PS2_COMBO, CLK_PIN, DATA_PIN);
+    uint64_t start = simNow;
+    CHECK(transport.begin());
+    CHECK(transport.isConnected());
+    CHECK_EQ(FakeHost::badFrames, 0);
+    CHECK(simNow - start < 2000000);   // Nobody answering doesn't hold it up for long
+    transport.end();
+    CHECK(!transport.isConnected());
+    CHECK(!simInterrupt(CLK_PIN));     // ISR let go of the pin
+}
+
+static void testRxFraming() {
+    Device d;
+    CHECK(d.command({ 0xEE }) == Bytes({ 0xEE }));     // Echo
+    CHECK(d.command({ 0xEE, 0xEE, 0xEE }) == Bytes({ 0xEE, 0xEE, 0xEE }));
+
+    // A byte with bad parity never reaches the parser
+    FakeHost::received.clear();
+    FakeHost::send(0xEE, false);
+    d.transport.update();
+    CHECK(FakeHost::received.empty());
+    CHECK_EQ(d.transport.getRxParityErrorCount(), 1);
+    CHECK(d.command({ 0xEE }) == Bytes({ 0xEE }));     // And the next one's fine
+
+    d.transport.resetRxCounters();
+    CHECK_EQ(d.transport.getRxParityErrorCount(), 0);
+}
+
+static void testRxOverflow() {
+    Device d;
+    // The ring holds 31, the rest are dropped and counted - the ones already in it are kept
+    FakeHost::received.clear();
+    for (int i = 0; i < 40; i++) FakeHost::send(0xEE);
+    CHECK_EQ(d.transport.getRxOverflowCount(), 9);
+    d.transport.update();
+    CHECK_EQ(FakeHost::received.size(), 31);
+    CHECK(d.command({ 0xEE }) == Bytes({ 0xEE }));
+    d.transport.resetRxCounters();
+    CHECK_EQ(d.transport.getRxOverflowCount(), 0);
+}
+
+static void testKeyboardCommands() {
+    Device d;
+    // Set LEDs, the argument in a later update
+    CHECK(d.command({ 0xED }) == Bytes({ 0xFA }));
+    CHECK(d.callbacks.leds.empty());
+    CHECK(d.command({ 0x04 }) == Bytes({ 0xFA }));     // Caps lock
+    CHECK(d.callbacks.leds == Bytes({ HostLEDs::fromPS2(0x04) }));
+
+    // Scancode set - 0 asks which one's in use
+    CHECK(d.command({ 0xF0, 0x00 }) == Bytes({ 0xFA, 0xFA, 0x02 }));
+    CHECK(d.command({ 0xF0, 0x03 }) == Bytes({ 0xFA, 0xFA }));
+    CHECK(d.command({ 0xF0, 0x00 }) == Bytes({ 0xFA, 0xFA, 0x03 }));
+    CHECK(d.command({ 0xFE }) == Bytes({ 0x03 }));     // Resend the last byte
+
+    CHECK(d.command({ 0xFF }) == Bytes({ 0xFA, 0xAA }));
+    CHECK(d.command({ 0xF5, 0xF4 }) == Bytes({ 0xFA, 0xFA }));
+}
+
+static void testCommandInArgumentSlot() {
+    Device d;
+    // The host gave up on the LED byte and sent enable instead, that's a command of its own
+    CHECK(d.command({ 0xED, 0xF4 }) == Bytes({ 0xFA, 0xFA }));
+    CHECK(d.command({ 0x04 }) == Bytes({ 0xFA }));     // Not taken as the LED byte any more
+    CHECK(d.callbacks.leds.empty());
+
+    CHECK(d.command({ 0xED }) == Bytes({ 0xFA }));
+    CHECK(d.command({ 0xED, 0x02 }) == Bytes({ 0xFA, 0xFA }));
+    CHECK(d.callbacks.leds == Bytes({ HostLEDs::fromPS2(0x02) }));
+
+    // A mouse knows commands down to 0xE6, so set resolution replaces a sample rate that never came
+    Device mouse(PS2Transport::DeviceType::PS2_MOUSE);
+    CHECK(mouse.command({ 0xF3, 0xE8, 0x02 }) == Bytes({ 0xFA, 0xFA, 0xFA }));
+    CHECK_EQ(mouse.transport.getReportInterval(), 10000);
+}
+
+static void testSampleRate() {
+    Device mouse(PS2Transport::DeviceType::PS2_MOUSE);
+    CHECK(mouse.command({ 0xF3, 200 }) == Bytes({ 0xFA, 0xFA }));
+    CHECK_EQ(mouse.transport.getReportInterval(), 5000);
+    CHECK(mouse.command({ 0xFF }) == Bytes({ 0xFA, 0xAA, 0x00 }));   // Mice send their ID after the self-test
+
+    // A keyboard takes 0xF3 as typematic, the mouse rate stays put
+    Device keyboard;
+    CHECK(keyboard.command({ 0xF3, 40 }) == Bytes({ 0xFA, 0xFA }));
+    CHECK_EQ(keyboard.transport.getReportInterval(), 10000);
+
+    // A combo can't tell which one the host meant, so both take it
+    Device combo(PS2Transport::DeviceType::PS2_COMBO);
+    CHECK(combo.command({ 0xF3, 40 }) == Bytes({ 0xFA, 0xFA }));
+    CHECK_EQ(combo.transport.getReportInterval(), 25000);
+}
+
+static void testRingSingleThread() {
+    PS2RxRing ring;
+    uint8_t data;
+    CHECK(ring.empty());
+    CHECK(!ring.pop(data));
+    for (int i = 0; i < PS2_RX_RING_SIZE + 3; i++) ring.push(i);
+    CHECK_EQ(ring.overflows(), 4);      // One slot always stays empty
+    for (int i = 0; i < PS2_RX_RING_SIZE - 1; i++) {
+        CHECK(ring.pop(data));
+        CHECK_EQ(data, i);
+    }
+    CHECK(!ring.pop(data));
+    ring.push(7);
+    ring.clear();
+    CHECK(ring.empty());
+    ring.resetCounters();
+    CHECK_EQ(ring.overflows(), 0);
+}
+
+// The ISR never waits, so the producer thread just pushes - it can tell its own drops from the
+// overflow count, since nothing else adds to it
+static std::vector<uint8_t> hammer(PS2RxRing& ring, int count, bool keepBelowCapacity, std::vector<uint8_t>& kept) {
+    std::atomic<bool> go{false}, done{false};
+    std::atomic<int> taken{0};
+    std::thread isr([&]() {
+        while (!go.load()) {}
+        for (int i = 0; i < count; i++) {
+            // Paced like a host that never outruns update(), no byte should ever be dropped
+            while (keepBelowCapacity && (int)kept.size() - taken.load() >= PS2_RX_RING_SIZE - 1) std::this_thread::yield();
+            uint32_t before = ring.overflows();
+            ring.push(i * 7);
+            if (ring.overflows() == before) kept.push_back(i * 7);
+            if (i % 1000 == 0) std::this_thread::yield();   // On one core it'd otherwise finish in a single timeslice
+        }
+        done.store(true);
+    });
+
+    std::vector<uint8_t> got;
+    uint8_t data;
+    go.store(true);
+    while (!done.load()) {
+        while (ring.pop(data)) {
+            got.push_back(data);
+            taken.store(got.size());
+        }
+        if (keepBelowCapacity) std::this_thread::yield();   // Let the paced producer get straight back in
+    }
+    isr.join();
+    while (ring.pop(data)) got.push_back(data);
+    return got;
+}
+
+static void testRingThreaded() {
+    // Never more than it holds - everything arrives, in order
+    PS2RxRing paced;
+    std::vector<uint8_t> sent;
+    std::vector<uint8_t> got = hammer(paced, 200000, true, sent);
+    CHECK_EQ(sent.size(), 200000);
+    CHECK(got == sent);
+    CHECK_EQ(paced.overflows(), 0);
+
+    // Flat out - whatever got in comes out in order, and every byte that didn't is counted
+    PS2RxRing flatOut;
+    sent.clear();
+    got = hammer(flatOut, 200000, false, sent);
+    CHECK(got == sent);
+    CHECK_EQ(got.size() + flatOut.overflows(), 200000);
+    printf("     flat out: %zu of 200000 through, %u dropped\n", got.size(), (unsigned)flatOut.overflows());
+}
+
+int main() {
+    RUN_TEST(testRingSingleThread);
+    RUN_TEST(testRingThreaded);
+    RUN_TEST(testBegin);
+    RUN_TEST(testRxFraming);
+    RUN_TEST(testRxOverflow);
+    RUN_TEST(testKeyboardCommands);
+    RUN_TEST(testCommandInArgumentSlot);
+    RUN_TEST(testSampleRate);
+    return TEST_RESULT();
+}
@@ -0,0 +1,130 @@
+// Spacemouse reports - only the parts that changed go to the host, a new host gets all of it once,
+// and a report that didn't go out goes again. Built once with separate translation and rotation
+// reports and once with SPACEMOUSE_COMBINED. Also counts reports off a twisting-only stream.
+
+#include "features/Spacemouse/Spacemouse.h"
+#include "MockTransport.h"
+#include "SquidTest.h"
+#include <vector>
+
+struct Puck {
+    MockTransport   transport;
+    SQUIDSPACEMOUSE puck;
+    Puck() {
+        simNow = 0;
+        puck.begin(&transport, 0);
+    }
+
+    // Report IDs since the last call
+    std::vector<uint8_t> sent() {
+        std::vector<uint8_t> ids;
+        for (auto& r : transport.reports) ids.push_back(r.id);
+        transport.reports.clear();
+        return ids;
+    }
+};
+
+typedef std::vector<uint8_t> Ids;
+
+#if SPACEMOUSE_COMBINED
+static const Ids ALL       = { SPACETRANS_ID, SPACECLICK_ID };
+static const Ids TRANSLATE = { SPACETRANS_ID };
+static const Ids ROTATE    = { SPACETRANS_ID };
+#else
+static const Ids ALL       = { SPACETRANS_ID, SPACEROTAT_ID, SPACECLICK_ID };
+static const Ids TRANSLATE = { SPACETRANS_ID };
+static const Ids ROTATE    = { SPACEROTAT_ID };
+#endif
+static const Ids BUTTONS   = { SPACECLICK_ID };
+static const Ids NOTHING   = {};
+
+static void testOnlyWhatChanged() {
+    Puck p;
+    p.puck.move(0, 0, 0, 0, 0, 0);
+    CHECK(p.sent() == ALL);                 // First one's everything, even at rest
+
+    p.puck.translate(10, -20, 30);
+    CHECK(p.sent() == TRANSLATE);
+    p.puck.translate(10, -20, 30);
+    CHECK(p.sent() == NOTHING);
+    p.puck.rotate(1, 2, 3);
+    CHECK(p.sent() == ROTATE);
+    p.puck.move(10, -20, 30, 1, 2, 3);
+    CHECK(p.sent() == NOTHING);
+
+    p.puck.press(SM_01);
+    CHECK(p.sent() == BUTTONS);
+    p.puck.press(SM_01);
+    CHECK(p.sent() == NOTHING);
+    p.puck.setAllButtons(1);
+    CHECK(p.sent() == NOTHING);
+    p.puck.releaseAll();
+    CHECK(p.sent() == BUTTONS);
+
+    CHECK_EQ(p.puck.getAxis(1), -20);
+    CHECK_EQ(p.puck.getAxis(5), 3);
+}
+
+static void testReportContents() {
+    Puck p;
+    p.puck.move(1, 2, 3, 4, 5, 6);
+    p.puck.press(SM_33);
+#if SPACEMOUSE_COMBINED
+    const std::vector<uint8_t>& motion = p.transport.reports[0].data;
+    CHECK_EQ(motion.size(), sizeof(SpaceMotionReport));
+    SpaceMotionReport m;
+    memcpy(&m, motion.data(), sizeof(m));
+    CHECK(m.trans.tx == 1 && m.trans.tz == 3 && m.rot.rx == 4 && m.rot.rz == 6);
+#else
+    CHECK_EQ(p.transport.reports[0].data.size(), sizeof(SpaceTranslationReport));
+    CHECK_EQ(p.transport.reports[1].data.size(), sizeof(SpaceRotationReport));
+    SpaceRotationReport r;
+    memcpy(&r, p.transport.reports[1].data.data(), sizeof(r));
+    CHECK(r.rx == 4 && r.ry == 5 && r.rz == 6);
+#endif
+    SpaceButtonReport b;
+    memcpy(&b, p.transport.reports.back().data.data(), sizeof(b));
+    CHECK(b.buttons[0] == 0 && b.buttons[1] == 1);
+}
+
+static void testResends() {
+    Puck p;
+    p.puck.move(0, 0, 0, 0, 0, 0);
+    p.sent();
+
+    // Refused, so it goes again next time even with nothing new
+    p.transport.failSend = true;
+    p.puck.rotate(5, 5, 5);
+    p.transport.failSend = false;
+    CHECK(p.sent() == NOTHING);
+    p.puck.rotate(5, 5, 5);
+    CHECK(!p.sent().empty());
+    p.puck.rotate(5, 5, 5);
+    CHECK(p.sent() == NOTHING);
+
+    // Nothing goes while there's no host, and a new one gets the whole state
+    p.transport.connected = false;
+    p.puck.press(SM_02);
+    p.transport.connected = true;
+    p.puck.onConnect();
+    p.puck.sendReport();
+    CHECK(p.sent() == ALL);
+}
+
+// Not a pass/fail beyond sending less than before - a second of the cap being twisted, read at 1kHz,
+// where every update used to send all three reports
+static void benchTwisting() {
+    Puck p;
+    for (int i = 0; i < 1000; i++) p.puck.move(0, 0, 0, 0, 0, (int16_t)(i / 4));
+    size_t now = p.transport.reports.size();
+    printf("     before: 3000 reports/s, now: %zu reports/s\n", now);
+    CHECK(now < ALL.size() + 250);   // The first full set, then one per step of the twist
+}
+
+int main() {
+    RUN_TEST(testOnlyWhatChanged);
+    RUN_TEST(testReportContents);
+    RUN_TEST(testResends);
+    RUN_TEST(benchTwisting);
+    return TEST_RESULT();
+}
@@ -0,0 +1,283 @@
+// Steno - chords from the Plover HID bitmap out as Gemini PR and TX Bolt, strokes written and read
+// back the dictionary way, the flash dictionary's order check and lookup, and the translator's
+// longest-match merging, metas and undo. Also times lookups in a 150k entry dictionary.
+
+#include "drivers/Software/Steno/StenoTranslator.h"
+#include "SquidTest.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace StenoChord;
+
+// Builds the flash layout from outline/text pairs, sorted the way lookup() wants
+struct TestDictionary {
+    std::vector<StenoStroke>    strokes;
+    std::vector<StenoDictEntry> entries;
+    std::string                 text;
+    StenoDictionary             dict;
+
+    TestDictionary(std::vector<std::pair<std::vector<StenoStroke>, std::string>> words, bool sort = true) {
+        if (sort) std::sort(words.begin(), words.end());
+        for (auto& w : words) {
+            entries.push_back(StenoDictEntry{ (uint32_t)strokes.size(), (uint32_t)text.size() });
+            for (size_t k = 0; k < w.first.size(); k++)
+                strokes.push_back(w.first[k] | (k + 1 == w.first.size() ? STENO_OUTLINE_END : 0));
+            text += w.second;
+            text.push_back('\0');
+        }
+        dict = StenoDictionary{ strokes.data(), entries.data(), text.data(), (uint32_t)entries.size() };
+    }
+};
+
+static StenoStroke S(const char* text) {
+    StenoStroke s = parseStroke(text);
+    CHECK(s != 0);
+    return s;
+}
+
+static void testFormatAndParse() {
+    const char* samples[] = { "STKPW", "-FRPB", "KA*T", "TPHOT", "#-D", "HR-FS", "WUPB", "*", "#STKPWHRAO*EUFRPBLGTSDZ" };
+    char buf[STENO_STROKE_TEXT];
+    for (const char* s : samples) {
+        formatStroke(S(s), buf);
+        CHECK(!strcmp(buf, s));
+    }
+    CHECK_EQ(parseStroke("-"), 0);
+    CHECK_EQ(parseStroke("KAX"), 0);
+    CHECK_EQ(parseStroke("TS"), S("TS"));
+    CHECK(S("-TS") != S("TS"));   // Right hand T S, not left hand
+}
+
+static void testWireFormats() {
+    // S1 K- A -T in the Plover HID bitmap
+    uint8_t keys[8] = {};
+    for (int k : { 0, 11, 20, 8 }) keys[k >> 3] |= 1 << (k & 7);
+    CHECK_EQ(toStroke(keys), S("SKAT"));
+
+    uint8_t gemini[GEMINI_PACKET_SIZE];
+    toGemini(keys, gemini);
+    CHECK_EQ(gemini[0], 0x80);                       // Only the first byte has the top bit
+    CHECK_EQ(gemini[1], (1 << 6) | (1 << 3));        // S1- K-
+    CHECK_EQ(gemini[2], 1 << 5);                     // A-
+    CHECK_EQ(gemini[3], 0);
+    CHECK_EQ(gemini[4], 1 << 2);                     // -T
+    CHECK_EQ(gemini[5], 0);
+
+    uint8_t bolt[TXBOLT_PACKET_MAX];
+    size_t n = toTxBolt(S("SKAT"), bolt);
+    CHECK_EQ(n, 4);
+    CHECK_EQ(bolt[0], 0x05);          // Group 0 - S K
+    CHECK_EQ(bolt[1], 0x40 | 0x02);   // Group 1 - A
+    CHECK_EQ(bolt[2], 0xC0 | 0x01);   // Group 3 - T
+    CHECK_EQ(bolt[3], 0);
+    n = toTxBolt(S("#-Z"), bolt);
+    CHECK_EQ(n, 2);
+    CHECK_EQ(bolt[0], 0xC0 | 0x18);
+    CHECK_EQ(bolt[1], 0);
+}
+
+static void testDictionary() {
+    TestDictionary d({
+        { { S("KAT") }, "cat" },
+        { { S("KAT"), S("-LG") }, "catalog" },
+        { { S("TKOG") }, "dog" },
+        { { S("A"), S("TKPWAEUPB") }, "again" },
+        { { S("A") }, "a" },
+    });
+    CHECK(StenoDict::isSorted(d.dict));
+
+    StenoStroke catalog[] = { S("KAT"), S("-LG") };
+    CHECK(!strcmp(StenoDict::lookup(d.dict, catalog, 2), "catalog"));
+    CHECK(!strcmp(StenoDict::lookup(d.dict, catalog, 1), "cat"));   // A prefix that's a word of its own
+    StenoStroke half[] = { S("TKPWAEUPB") };
+    CHECK(StenoDict::lookup(d.dict, half, 1) == nullptr);           // Only the end of an outline
+    StenoStroke longer[] = { S("KAT"), S("-LG"), S("-S") };
+    CHECK(StenoDict::lookup(d.dict, longer, 3) == nullptr);
+    CHECK(StenoDict::lookup(d.dict, longer, 0) == nullptr);
+
+    // One out of place or a duplicate and the order check says so
+    StenoStroke big = S("KAT"), small = S("TKOG");
+    if (big < small) std::swap(big, small);
+    TestDictionary unsorted({ { { big }, "big" }, { { small }, "small" } }, false);
+    CHECK(!StenoDict::isSorted(unsorted.dict));
+    TestDictionary twice({ { { S("KAT") }, "cat" }, { { S("KAT") }, "kat" } }, false);
+    CHECK(!StenoDict::isSorted(twice.dict));
+    TestDictionary longFirst({ { { S("KAT"), S("-LG") }, "catalog" }, { { S("KAT") }, "cat" } }, false);
+    CHECK(!StenoDict::isSorted(longFirst.dict));
+}
+
+// What the host's text box ends up with
+struct Screen {
+    StenoTranslator translator;
+    std::string     text;
+
+    void stroke(const char* steno) {
+        StenoEdit edit;
+        translator.translate(S(steno), edit);
+        CHECK(edit.backspaces <= text.size());
+        text.resize(text.size() - std::min<size_t>(edit.backspaces, text.size()));
+        CHECK_EQ(edit.length, strlen(edit.text));
+        text += edit.text;
+    }
+};
+
+static void testMergeAndUndo() {
+    TestDictionary d({
+        { { S("KAT") }, "cat" },
+        { { S("KAT"), S("-LG") }, "catalog" },
+        { { S("A") }, "a" },
+        { { S("A"), S("TKPWAEUPB") }, "again" },
+    });
+    Screen s;
+    s.translator.setDictionary(&d.dict);
+
+    s.stroke("KAT");
+    CHECK(s.text == " cat");
+    s.stroke("A");
+    CHECK(s.text == " cat a");
+    s.stroke("TKPWAEUPB");
+    CHECK(s.text == " cat again");   // "a" rubbed out, the two strokes together win
+
+    // Each * takes back one translation, putting back whatever it had replaced
+    s.stroke("*");
+    CHECK(s.text == " cat a");
+    s.stroke("*");
+    CHECK(s.text == " cat");
+    s.stroke("*");
+    CHECK(s.text == "");
+    s.stroke("*");                    // Nothing left to undo
+    CHECK(s.text == "");
+
+    s.stroke("KAT");
+    s.stroke("-LG");
+    CHECK(s.text == " catalog");
+    s.stroke("-LG");                  // Not a word after catalog, goes out as steno
+    CHECK(s.text == " catalog -LG");
+}
+
+static void testMetas() {
+    TestDictionary d({
+        { { S("TKOG") }, "dog" },
+        { { S("-G") }, "{^ing}" },
+        { { S("TP-PL") }, "{.}" },
+        { { S("KW-BG") }, "{,}" },
+        { { S("RE") }, "{re^}" },
+        { { S("TKUS") }, "{^}" },
+        { { S("WAL") }, "{wall}" },   // Not a meta, typed as written
+    });
+    Screen s;
+    s.translator.setDictionary(&d.dict);
+    s.stroke("TKOG");
+    s.stroke("-G");
+    CHECK(s.text == " doging");
+    s.stroke("KW-BG");
+    s.stroke("RE");
+    s.stroke("TKOG");
+    CHECK(s.text == " doging, redog");
+    s.stroke("TKUS");
+    s.stroke("TKOG");
+    s.stroke("TP-PL");
+    CHECK(s.text == " doging, redogdog.");
+    s.stroke("WAL");
+    CHECK(s.text == " doging, redogdog. wall");
+
+    s.stroke("*");
+    s.stroke("*");
+    s.stroke("*");
+    s.stroke("*");
+    CHECK(s.text == " doging, redog");
+
+    // Undoing an attach-next puts the space back for the next word
+    s.stroke("*");
+    s.stroke("*");
+    CHECK(s.text == " doging,");
+    s.stroke("TKOG");
+    CHECK(s.text == " doging, dog");
+}
+
+static void testLimits() {
+    std::string huge(200, 'x');
+    TestDictionary d({ { { S("KAT") }, "cat" }, { { S("HUPBLG") }, huge } });
+    Screen s;
+    s.translator.setDictionary(&d.dict);
+
+    // Only STENO_MAX_TEXT - 1 characters go out, and undo only rubs out those
+    s.stroke("KAT");
+    s.stroke("HUPBLG");
+    CHECK_EQ(s.text.size(), 4 + STENO_MAX_TEXT - 1);
+    s.stroke("*");
+    CHECK(s.text == " cat");
+
+    // Undo only reaches back STENO_UNDO_HISTORY translations
+    Screen many;
+    many.translator.setDictionary(&d.dict);
+    for (int i = 0; i < STENO_UNDO_HISTORY + 4; i++) many.stroke("KAT");
+    for (int i = 0; i < STENO_UNDO_HISTORY + 4; i++) many.stroke("*");
+    CHECK_EQ(many.text.size(), 4 * 4);
+
+    // No dictionary at all, everything's an untranslate
+    Screen none;
+    none.stroke("KAT");
+    CHECK(none.text == " KAT");
+}
+
+// Not a pass/fail beyond every entry being found - numbers to keep an eye on when the layout changes
+static void benchLookup() {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> anyStroke(1, STENO_STROKE_MASK);
+    std::vector<std::pair<std::vector<StenoStroke>, std::string>> words;
+    while (words.size() < 150000) {
+        std::vector<StenoStroke> outline(1 + rng() % 3);
+        for (auto& s : outline) s = anyStroke(rng);
+        words.push_back({ outline, "w" + std::to_string(words.size()) });
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end(),
+                            [](const auto& a, const auto& b) { return a.first == b.first; }), words.end());
+    TestDictionary d(words, false);
+    CHECK(StenoDict::isSorted(d.dict));
+
+    bool allFound = true;
+    for (auto& w : words) {
+        const char* text = StenoDict::lookup(d.dict, w.first.data(), w.first.size());
+        allFound &= text && w.second == text;
+    }
+    CHECK(allFound);
+
+    const int queries = 1000000;
+    std::vector<uint32_t> order(queries);
+    for (auto& i : order) i = rng() % words.size();
+    size_t hits = 0, misses = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i : order) hits += StenoDict::lookup(d.dict, words[i].first.data(), words[i].first.size()) != nullptr;
+    auto middle = std::chrono::steady_clock::now();
+    StenoStroke miss[2];
+    for (int i = 0; i < queries; i++) {
+        miss[0] = anyStroke(rng);
+        miss[1] = anyStroke(rng);
+        misses += StenoDict::lookup(d.dict, miss, 2) == nullptr;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    size_t bytes = d.strokes.size() * sizeof(StenoStroke) + d.entries.size() * sizeof(StenoDictEntry) + d.text.size();
+    printf("     %u entries, %zu KB: hit %.0f ns, miss %.0f ns per lookup\n", d.dict.count, bytes / 1024,
+           std::chrono::duration<double, std::nano>(middle - start).count() / queries,
+           std::chrono::duration<double, std::nano>(end - middle).count() / queries);
+    CHECK_EQ(hits, queries);
+    CHECK(misses > queries * 99 / 100);
+}
+
+int main() {
+    RUN_TEST(testFormatAndParse);
+    RUN_TEST(testWireFormats);
+    RUN_TEST(testDictionary);
+    RUN_TEST(testMergeAndUndo);
+    RUN_TEST(testMetas);
+    RUN_TEST(testLimits);
+    RUN_TEST(benchLookup);
+    return TEST_RESULT();
+}
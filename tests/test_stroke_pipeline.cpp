@@ -0,0 +1,218 @@
+// Pen strokes - fixed point scaling lands on the exact ends of the range, Catmull-Rom resampling
+// turns 240Hz samples into a steady 1kHz stream that stays on the stroke, the 1-euro filter steadies
+// a shaky pen, and a new stroke doesn't get bent towards the end of the last one.
+
+#include "drivers/Software/Motion/StrokePipeline.h"
+#include "SquidTest.h"
+#include <math.h>
+#include <stdlib.h>
+#include <random>
+
+static void testScaling() {
+    StrokePipeline s;
+    s.setRange(1920, 1080);
+    StrokePoint p = s.scale(1920, 1080, 127);
+    CHECK_EQ(p.x, STROKE_LOGICAL_MAX);
+    CHECK_EQ(p.y, STROKE_LOGICAL_MAX);
+    CHECK_EQ(p.pressure, STROKE_LOGICAL_MAX);
+    p = s.scale(5000, 5000, 500);   // Past the range clamps
+    CHECK_EQ(p.x, STROKE_LOGICAL_MAX);
+    CHECK_EQ(p.pressure, STROKE_LOGICAL_MAX);
+
+    // Whatever the range, every input is within one unit of the exact division
+    bool close = true, ends = true;
+    for (uint32_t max = 1; max < 65535; max += 37) {
+        StrokePipeline q;
+        q.setRange(max, max);
+        for (uint32_t x = 0; x <= max; x += max / 50 + 1) {
+            long exact = (long)x * STROKE_LOGICAL_MAX / max;
+            close &= labs((long)q.scale(x, x, 0).x - exact) <= 1;
+        }
+        ends &= q.scale(max, max, 0).x == STROKE_LOGICAL_MAX;
+    }
+    CHECK(close);
+    CHECK(ends);
+
+    // Pressure isn't stuck at 127 levels
+    s.setPressureRange(1270);
+    CHECK_EQ(s.scale(0, 0, 1270).pressure, STROKE_LOGICAL_MAX);
+    CHECK(s.scale(0, 0, 1).pressure != s.scale(0, 0, 2).pressure);
+}
+
+static void testNoSmoothingOnlySendsNewSamples() {
+    StrokePipeline s;
+    s.setRange(STROKE_LOGICAL_MAX, STROKE_LOGICAL_MAX);
+    s.setPressureRange(STROKE_LOGICAL_MAX);
+    StrokePoint out;
+    s.begin(100, 200, 300, 0);
+    CHECK(!s.render(1000, out));   // Nothing's moved since begin()
+
+    s.add(110, 200, 300, 4167);
+    CHECK(s.render(5000, out));
+    CHECK_EQ(out.x, 110);
+    CHECK(!s.render(6000, out));   // Same sample, nothing to send
+
+    s.add(110, 200, 300, 8333);    // A new sample in the same place isn't worth a report either
+    CHECK(!s.render(9000, out));
+}
+
+// Pen going round a 8000 unit circle once a second, sampled at 240Hz, rendered every reportUs
+struct Circle {
+    int    reports = 0;
+    double maxRadiusError = 0;
+    double maxStep = 0;
+    double meanStep = 0;
+
+    Circle(StrokePipeline::Smoothing smoothing, uint32_t reportUs) {
+        StrokePipeline s;
+        s.setRange(STROKE_LOGICAL_MAX, STROKE_LOGICAL_MAX);
+        s.setSmoothing(smoothing);
+        s.setInputRate(240);
+        auto at = [](uint32_t t, double& x, double& y) {
+            double a = t / 1e6 * 2 * M_PI;
+            x = 16000 + 8000 * cos(a);
+            y = 16000 + 8000 * sin(a);
+        };
+
+        double x, y;
+        at(0, x, y);
+        s.begin((uint16_t)x, (uint16_t)y, 100, 0);
+        int lastX = -1, lastY = -1;
+        double total = 0;
+        for (uint32_t t = 1; t < 1000000; t++) {
+            if (t % 4167 == 0) {
+                at(t, x, y);
+                s.add((uint16_t)lround(x), (uint16_t)lround(y), 100, t);
+            }
+            StrokePoint o;
+            if (t % reportUs == 0 && s.render(t, o)) {
+                reports++;
+                double r = hypot(o.x - 16000.0, o.y - 16000.0);
+                if (t > 20000) maxRadiusError = fmax(maxRadiusError, fabs(r - 8000));
+                if (lastX >= 0) {
+                    double step = hypot(o.x - lastX, o.y - lastY);
+                    maxStep = fmax(maxStep, step);
+                    total += step;
+                }
+                lastX = o.x;
+                lastY = o.y;
+            }
+        }
+        meanStep = total / (reports - 1);
+    }
+};
+
+static void testCatmullRomResamples() {
+    Circle raw(StrokePipeline::STROKE_SMOOTH_NONE, 1000);
+    Circle smooth(StrokePipeline::STROKE_SMOOTH_CATMULL_ROM, 1000);
+
+    // Raw only has a report when a sample comes in, Catmull-Rom fills in every ms
+    CHECK(raw.reports < 250);
+    CHECK(smooth.reports > 950);
+    // Steady steps, each a quarter of the raw jumps
+    CHECK(smooth.maxStep < 80);
+    CHECK(smooth.maxStep < smooth.meanStep * 1.5);
+    CHECK(raw.maxStep > 200);
+    // And the in-between points are still on the circle, not cutting the corners
+    CHECK(smooth.maxRadiusError < 30);
+
+    // At a slow report rate it just keeps up, no worse than the raw samples
+    Circle slow(StrokePipeline::STROKE_SMOOTH_CATMULL_ROM, 7500);
+    CHECK(slow.maxRadiusError < 30);
+    CHECK(slow.reports > 120);
+}
+
+static void testCatmullRomHitsTheSamples() {
+    StrokePipeline s;
+    s.setRange(STROKE_LOGICAL_MAX, STROKE_LOGICAL_MAX);
+    s.setPressureRange(STROKE_LOGICAL_MAX);
+    s.setSmoothing(StrokePipeline::STROKE_SMOOTH_CATMULL_ROM);
+    s.setInputRate(250);   // 4ms apart, rendered 8ms behind
+
+    // A straight line at constant speed with pressure ramping up, rendered every ms as it comes in
+    s.begin(1000, 1000, 0, 0);
+    StrokePoint out;
+    bool onSamples = true, onLine = true, even = true;
+    int prevX = -1;
+    for (uint32_t t = 1000; t <= 40000; t += 1000) {
+        uint32_t i = t / 4000;
+        if (t % 4000 == 0) s.add(1000 + i * 400, 1000 + i * 200, i * 1000, t);
+        bool moved = s.render(t, out);
+        if (t < 16000) continue;   // Until there's a sample before the segment the ends are bent
+        CHECK(moved);
+
+        // 8ms behind - right on a sample every 4ms, and on the line in between, 100 units a ms
+        uint32_t behind = t - 8000;
+        if (behind % 4000 == 0) {
+            onSamples &= out.x == 1000 + behind / 10 && out.y == 1000 + behind / 20 && out.pressure == behind / 4;
+        }
+        onLine &= abs((out.x - 1000) - 2 * (out.y - 1000)) <= 2;
+        if (prevX >= 0) even &= abs(out.x - prevX - 100) <= 1;
+        prevX = out.x;
+    }
+    CHECK(onSamples);
+    CHECK(onLine);
+    CHECK(even);
+
+    // Past the newest sample it holds there rather than guessing
+    CHECK(s.render(100000, out));
+    CHECK_EQ(out.x, 1000 + 10 * 400);
+    CHECK(!s.render(101000, out));
+}
+
+static void testOneEuroSteadiesAShakyPen() {
+    std::mt19937 rng(46);
+    StrokePipeline s;
+    s.setRange(STROKE_LOGICAL_MAX, STROKE_LOGICAL_MAX);
+    s.setSmoothing(StrokePipeline::STROKE_SMOOTH_ONE_EURO);
+    s.begin(16000, 16000, 100, 0);
+
+    // Held still with +-20 units of hand shake
+    double jitter = 0;
+    int prev = 16000;
+    for (int i = 1; i < 500; i++) {
+        s.add(16000 + (int)(rng() % 41) - 20, 16000, 100, i * 4167);
+        int x = s.latest().x;
+        if (i > 100) jitter += abs(x - prev);
+        prev = x;
+    }
+    jitter /= 399;
+    CHECK(jitter < 3);   // Raw would be about 13
+
+    // Then a fast stroke gets followed without much lag
+    for (int i = 500; i < 540; i++) s.add(16000 + (i - 500) * 200, 16000, 100, i * 4167);
+    CHECK(abs(s.latest().x - (16000 + 39 * 200)) < 400);
+}
+
+static void testNewStrokeStartsClean() {
+    StrokePipeline s;
+    s.setRange(STROKE_LOGICAL_MAX, STROKE_LOGICAL_MAX);
+    s.setSmoothing(StrokePipeline::STROKE_SMOOTH_CATMULL_ROM);
+    s.setInputRate(250);
+
+    s.begin(30000, 30000, 100, 0);
+    for (uint32_t i = 1; i <= 4; i++) s.add(30000, 30000 - i * 100, 100, i * 4000);
+
+    // Lifted and put down on the other side of the tablet
+    s.begin(1000, 1000, 100, 100000);
+    s.add(1100, 1000, 100, 104000);
+    s.add(1200, 1000, 100, 108000);
+
+    StrokePoint out;
+    bool stayed = true;
+    for (uint32_t t = 100000; t <= 120000; t += 1000) {
+        if (s.render(t, out)) stayed &= out.x >= 1000 && out.x <= 1200 && out.y == 1000;
+    }
+    CHECK(stayed);
+    CHECK_EQ(s.latest().x, 1200);
+}
+
+int main() {
+    RUN_TEST(testScaling);
+    RUN_TEST(testNoSmoothingOnlySendsNewSamples);
+    RUN_TEST(testCatmullRomResamples);
+    RUN_TEST(testCatmullRomHitsTheSamples);
+    RUN_TEST(testOneEuroSteadiesAShakyPen);
+    RUN_TEST(testNewStrokeStartsClean);
+    return TEST_RESULT();
+}
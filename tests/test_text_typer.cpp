@@ -0,0 +1,218 @@
+// Typing text - the keyboard's reports read back the way a host would, in NKRO and boot 6KRO, come
+// out as the text that went in with no key going down on the same report as a shift change and
+// nothing left held. Held modifiers and keys survive the text. Also counts chars/s at two report rates.
+
+#include "features/NKRO/NKRO.h"
+#include "MockTransport.h"
+#include "SquidTest.h"
+#include <string>
+
+// Host side - a key counts when its bit goes 0 to 1, shifted by the modifiers the host had already seen
+struct Host {
+    std::string text;
+    int         races = 0;      // A key down in the same report as a modifier change
+    uint8_t     mods = 0;
+    uint8_t     keys[32] = {};
+
+    void read(const MockTransport& transport, bool boot) {
+        for (auto& r : transport.reports) {
+            uint8_t now[32] = {};
+            if (boot) {
+                CHECK_EQ(r.data.size(), 8);
+                for (int i = 2; i < 8; i++) if (r.data[i]) now[r.data[i] / 8] |= 1 << (r.data[i] % 8);
+            } else {
+                CHECK_EQ(r.data.size(), sizeof(NKROReport));
+                memcpy(now, r.data.data() + 2, sizeof(now));
+            }
+            for (int k = 0; k < 256; k++) {
+                bool was = keys[k / 8] >> (k % 8) & 1, down = now[k / 8] >> (k % 8) & 1;
+                if (was || !down) continue;
+                races += r.data[0] != mods;
+                text += character(k, mods & 0x22);
+            }
+            memcpy(keys, now, sizeof(keys));
+            mods = r.data[0];
+        }
+    }
+
+    bool keysUp() const {
+        for (uint8_t b : keys) if (b) return false;
+        return true;
+    }
+
+    static char character(uint8_t keycode, bool shift) {
+        for (int c = 1; c < 128; c++) {
+            AsciiKey key = asciiToKey(c);
+            if (key.keycode == keycode && (key.modifiers != 0) == shift) return (char)c;
+        }
+        return '?';
+    }
+};
+
+struct Keyboard {
+    MockTransport transport;
+    SQUIDNKRO     keyboard;
+    Keyboard(uint32_t interval = 8000, bool boot = false) {
+        simNow = 0;
+        transport.interval = interval;
+        keyboard.begin(&transport, 7);
+        if (boot) keyboard.use6KRO();
+    }
+};
+
+static void testTable() {
+    // Real HID usages, 1-9 then 0, and Enter rather than the KC_ offset one
+    CHECK_EQ(asciiToKey('1').keycode, 0x1E);
+    CHECK_EQ(asciiToKey('9').keycode, 0x26);
+    CHECK_EQ(asciiToKey('0').keycode, 0x27);
+    CHECK_EQ(asciiToKey('\n').keycode, 0x28);
+    CHECK_EQ(asciiToKey('!').keycode, 0x1E);
+    CHECK_EQ(asciiToKey('!').modifiers, TEXT_MOD_SHIFT);
+    CHECK_EQ(asciiToKey('\r').keycode, 0);
+    CHECK_EQ(asciiToKey(0x80).keycode, 0);
+
+    // Every character with a key has its own key and shift pair
+    for (int c = 1; c < 128; c++) {
+        AsciiKey key = asciiToKey(c);
+        if (key.keycode) CHECK_EQ(Host::character(key.keycode, key.modifiers), c);
+    }
+}
+
+static void testPlanner() {
+    TextTyper typer;
+    TextReport out[2];
+    CHECK_EQ(typer.type('a', out), 1);
+    CHECK_EQ(out[0].keycode, 0x04);
+    CHECK_EQ(typer.type('b', out), 1);            // Letting go of a rides along with b going down
+    CHECK_EQ(typer.type('b', out), 2);            // Same key twice needs a gap
+    CHECK_EQ(out[0].keycode, 0);
+    CHECK_EQ(typer.type('C', out), 2);            // Shift on by itself first
+    CHECK_EQ(out[0].modifiers, TEXT_MOD_SHIFT);
+    CHECK_EQ(out[0].keycode, 0);
+    CHECK_EQ(typer.type('D', out), 1);
+    CHECK_EQ(typer.type('\r', out), 0);
+    CHECK_EQ(typer.finish(out), 1);
+    CHECK_EQ(typer.finish(out), 0);               // Nothing down any more
+}
+
+static std::string sampleText() {
+    std::string text;
+    for (int c = 32; c < 127; c++) text += (char)c;
+    text += "aa AA aA Aa \b\b\t\r\nHello, World! The quick brown fox jumps over the lazy dog. ";
+    std::string para = "It was the best of times, it was the worst of times (1859) -- Dickens said \"so\"; ok?\n";
+    while (text.size() < 1024) text += para;
+    text.resize(1024);
+    return text;
+}
+
+static void testRoundTrip() {
+    std::string text = sampleText();
+    std::string expect;
+    for (char c : text) if (c != '\r') expect += c;
+
+    for (bool boot : { false, true }) {
+        Keyboard k(1000, boot);
+        size_t n = k.keyboard.write((const uint8_t*)text.data(), text.size());
+        CHECK_EQ(n, expect.size());
+        Host host;
+        host.read(k.transport, boot);
+        CHECK(host.text == expect);
+        CHECK_EQ(host.races, 0);
+        CHECK(host.keysUp());
+        CHECK_EQ(host.mods, 0);
+
+        // Never faster than the host picks them up
+        bool paced = true;
+        for (size_t i = 1; i < k.transport.reports.size(); i++)
+            paced &= k.transport.reports[i].time - k.transport.reports[i - 1].time >= 1000;
+        CHECK(paced);
+    }
+}
+
+static void testSingleCharacter() {
+    Keyboard k;
+    CHECK_EQ(k.keyboard.write('Q'), 1);
+    Host host;
+    host.read(k.transport, false);
+    CHECK(host.text == "Q");
+    CHECK_EQ(host.races, 0);
+    CHECK(host.keysUp());
+    CHECK_EQ(host.mods, 0);
+    CHECK_EQ(k.transport.reports.size(), 3);      // Shift, shift and Q, everything up
+}
+
+static void testFailingTransport() {
+    Keyboard k;
+    k.transport.failSend = true;
+    CHECK_EQ(k.keyboard.print("abc"), 0);
+    k.transport.connected = false;
+    CHECK_EQ(k.keyboard.print("abc"), 0);
+    CHECK_EQ(k.transport.reports.size(), 0);
+}
+
+static void testHeldKeys() {
+    // Held ctrl is out of the way while typing, else it's ctrl+a, and goes back on after
+    Keyboard k;
+    k.keyboard.press(KC_LCTL);
+    k.transport.reports.clear();
+    CHECK_EQ(k.keyboard.print("aB"), 2);
+    Host host;
+    host.mods = 0x01;
+    host.read(k.transport, false);
+    CHECK(host.text == "aB");
+    CHECK_EQ(host.races, 0);
+    CHECK(k.transport.reports.front().data[0] == 0);
+    CHECK(k.transport.reports.back().data[0] == 0x01);
+    CHECK_EQ(k.keyboard.getModifiers(), 0x01);
+
+    // A held key stays down under the text, unless the text needs it - then it's let go and typed
+    Keyboard held;
+    held.keyboard.press(KC_X);
+    held.transport.reports.clear();
+    Host typed;
+    typed.keys[0x1B / 8] |= 1 << (0x1B % 8);
+    CHECK_EQ(held.keyboard.print("ab"), 2);
+    typed.read(held.transport, false);
+    CHECK(typed.text == "ab");
+    CHECK(!typed.keysUp());                       // x is still down
+    held.transport.reports.clear();
+    CHECK_EQ(held.keyboard.print("x"), 1);
+    typed.read(held.transport, false);
+    CHECK(typed.text == "abx");
+    CHECK(typed.keysUp());
+}
+
+// Not a pass/fail beyond being quicker than before - the old write() sent a press and a release,
+// shift on and off around them, with a 7ms delay after every report
+static void benchCharsPerSecond() {
+    std::string text = sampleText();
+    size_t before = 0;
+    for (char c : text) {
+        AsciiKey key = asciiToKey(c);
+        if (key.keycode) before += key.modifiers ? 4 : 2;
+    }
+    double beforeRate = text.size() / (before * 0.007);
+    printf("     before:             %.2f reports/char, %.0f chars/s\n", (double)before / text.size(), beforeRate);
+
+    for (bool boot : { false, true }) {
+        for (uint32_t interval : { 1000u, 7500u }) {
+            Keyboard k(interval, boot);
+            size_t n = k.keyboard.write((const uint8_t*)text.data(), text.size());
+            double rate = n / (simNow / 1e6);
+            printf("     %s every %4uus:  %.2f reports/char, %.0f chars/s\n", boot ? "6KRO" : "NKRO",
+                   (unsigned)interval, (double)k.transport.reports.size() / n, rate);
+            CHECK(rate > beforeRate);
+        }
+    }
+}
+
+int main() {
+    RUN_TEST(testTable);
+    RUN_TEST(testPlanner);
+    RUN_TEST(testRoundTrip);
+    RUN_TEST(testSingleCharacter);
+    RUN_TEST(testFailingTransport);
+    RUN_TEST(testHeldKeys);
+    RUN_TEST(benchCharsPerSecond);
+    return TEST_RESULT();
+}
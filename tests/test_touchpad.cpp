@@ -0,0 +1,241 @@
+// Precision Touchpad - contacts keep their IDs from frame to frame whatever order the sensor lists
+// them in, a lift goes out once with the tip off, and the packed reports line up bit for bit with
+// the real descriptor, which gets walked here like a host would. Built twice, once in hybrid mode.
+
+#include "features/Digitizer/Digitizer.h"
+#include "SquidTest.h"
+#include <stddef.h>
+#include <vector>
+
+static const TouchContact* find(const TouchContact* out, uint8_t n, uint8_t id) {
+    for (uint8_t i = 0; i < n; i++)
+        if (out[i].id == id) return &out[i];
+    return nullptr;
+}
+
+static void testIdsFollowFingers() {
+    ContactTracker t;
+    TouchContact out[TOUCH_MAX_CONTACTS];
+    TouchPoint first[] = { { 100, 100, true }, { 1000, 1000, true } };
+    CHECK_EQ(t.update(first, 2, out), 2);
+    CHECK_EQ(out[0].id, 0);
+    CHECK_EQ(out[1].id, 1);
+    CHECK(out[0].tip && out[1].tip);
+
+    // The sensor lists them the other way round this time
+    TouchPoint swapped[] = { { 1010, 1005, true }, { 105, 110, true } };
+    CHECK_EQ(t.update(swapped, 2, out), 2);
+    CHECK(find(out, 2, 0) && find(out, 2, 0)->x == 105);
+    CHECK(find(out, 2, 1) && find(out, 2, 1)->x == 1010);
+
+    // Two fingers crossing close together still pair up by distance
+    TouchPoint crossing[] = { { 1000, 1000, true }, { 300, 300, true } };
+    CHECK_EQ(t.update(crossing, 2, out), 2);
+    CHECK(find(out, 2, 0)->x == 300);
+    CHECK(find(out, 2, 1)->x == 1000);
+    CHECK_EQ(t.activeCount(), 2);
+}
+
+static void testLiftsAndNewFingers() {
+    ContactTracker t;
+    TouchContact out[TOUCH_MAX_CONTACTS];
+    TouchPoint two[] = { { 100, 100, true }, { 1000, 1000, true } };
+    t.update(two, 2, out);
+
+    // Finger 0 lifts as a new one lands somewhere else
+    TouchPoint next[] = { { 1020, 1010, true }, { 3000, 2000, true } };
+    uint8_t n = t.update(next, 2, out);
+    CHECK_EQ(n, 3);
+    CHECK_EQ(out[0].id, 0);
+    CHECK(!out[0].tip);
+    CHECK_EQ(out[0].x, 100);         // Where it was last seen
+    CHECK_EQ(out[1].id, 1);
+    CHECK_EQ(out[2].id, 2);          // Not 0, that one's still going out this frame
+    CHECK(out[2].tip);
+
+    // Both lift - one frame with the tips off, then nothing
+    n = t.update(nullptr, 0, out);
+    CHECK_EQ(n, 2);
+    CHECK(!out[0].tip && !out[1].tip);
+    CHECK_EQ(t.update(nullptr, 0, out), 0);
+    CHECK_EQ(t.activeCount(), 0);
+
+    // IDs rotate rather than coming straight back
+    TouchPoint one[] = { { 500, 500, true } };
+    t.update(one, 1, out);
+    CHECK_EQ(out[0].id, 3);
+}
+
+static void testFullPadTurnover() {
+    ContactTracker t;
+    TouchContact out[TOUCH_MAX_CONTACTS];
+    TouchPoint five[TOUCH_MAX_CONTACTS], moved[TOUCH_MAX_CONTACTS];
+    for (uint8_t i = 0; i < TOUCH_MAX_CONTACTS; i++) {
+        five[i] = { (uint16_t)(i * 800), (uint16_t)(i * 500), true };
+        moved[i] = { (uint16_t)(i * 800), (uint16_t)(i * 500 + 450), false };   // Past the match distance
+    }
+    CHECK_EQ(t.update(five, TOUCH_MAX_CONTACTS, out), TOUCH_MAX_CONTACTS);
+
+    // All five lift and five new ones land - the lifts take every slot, the new ones wait a frame
+    CHECK_EQ(t.update(moved, TOUCH_MAX_CONTACTS, out), TOUCH_MAX_CONTACTS);
+    bool allLifted = true;
+    for (uint8_t i = 0; i < TOUCH_MAX_CONTACTS; i++) allLifted &= !out[i].tip;
+    CHECK(allLifted);
+
+    CHECK_EQ(t.update(moved, TOUCH_MAX_CONTACTS, out), TOUCH_MAX_CONTACTS);
+    bool allNew = true;
+    for (uint8_t i = 0; i < TOUCH_MAX_CONTACTS; i++) allNew &= out[i].tip && !out[i].confident && out[i].id >= TOUCH_MAX_CONTACTS;
+    CHECK(allNew);
+
+    // More points than contacts just get cut off
+    TouchPoint six[6] = {};
+    for (uint8_t i = 0; i < 6; i++) six[i] = { (uint16_t)(i * 800), (uint16_t)(i * 500 + 450), true };
+    CHECK(t.update(six, 6, out) <= TOUCH_MAX_CONTACTS);
+}
+
+// One field of an input or feature report, as the host would lay it out from the descriptor
+struct Field {
+    uint8_t  reportId;
+    bool     input;
+    uint16_t page;
+    uint16_t usage;
+    uint16_t bit;
+    uint8_t  size;
+};
+
+static uint32_t itemValue(const uint8_t* d, uint8_t size) {
+    uint32_t v = 0;
+    for (uint8_t i = 0; i < size; i++) v |= (uint32_t)d[i] << (8 * i);
+    return v;
+}
+
+// Just the short items the library's descriptors use. reportBits gets each input report's length.
+static std::vector<Field> walkDescriptor(const uint8_t* d, size_t length, uint16_t reportBits[256]) {
+    struct Globals { uint16_t page = 0; uint8_t size = 0; uint16_t count = 0; uint8_t id = 0; };
+    Globals g, stack[4];
+    uint8_t depth = 0;
+    std::vector<uint16_t> usages;
+    std::vector<Field> fields;
+    uint16_t featureBits[256] = {};
+    for (int i = 0; i < 256; i++) reportBits[i] = 0;
+
+    for (size_t pos = 0; pos < length;) {
+        uint8_t prefix = d[pos];
+        uint8_t size = (prefix & 3) == 3 ? 4 : (prefix & 3);
+        uint32_t value = itemValue(d + pos + 1, size);
+        pos += 1 + size;
+
+        switch (prefix & 0xFC) {
+        case 0x04: g.page = value; break;
+        case 0x74: g.size = value; break;
+        case 0x84: g.id = value; break;
+        case 0x94: g.count = value; break;
+        case 0xA4: if (depth < 4) stack[depth++] = g; break;
+        case 0xB4: if (depth) g = stack[--depth]; break;
+        case 0x08: usages.push_back(value); break;
+        case 0x80:
+        case 0xB0: {
+            bool input = (prefix & 0xFC) == 0x80;
+            uint16_t& bits = input ? reportBits[g.id] : featureBits[g.id];
+            for (uint16_t f = 0; f < g.count; f++) {
+                if (!(value & 0x01) && !usages.empty()) {   // Constant is padding
+                    uint16_t usage = usages[f < usages.size() ? f : usages.size() - 1];
+                    fields.push_back(Field{ g.id, input, g.page, usage, bits, g.size });
+                }
+                bits += g.size;
+            }
+            usages.clear();
+            break;
+        }
+        case 0xA0:
+        case 0xC0:
+        case 0x90: usages.clear(); break;
+        }
+    }
+    return fields;
+}
+
+static const Field* field(const std::vector<Field>& fields, uint8_t id, bool input, uint16_t page, uint16_t usage, int nth = 0) {
+    for (const Field& f : fields)
+        if (f.reportId == id && f.input == input && f.page == page && f.usage == usage && nth-- == 0) return &f;
+    return nullptr;
+}
+
+static bool at(const Field* f, size_t byteOffset, uint8_t bit, uint8_t size) {
+    return f && f->bit == byteOffset * 8 + bit && f->size == size;
+}
+
+static void testReportMatchesDescriptor() {
+    static_assert(descriptorWellFormed(concatDescriptors(_digitizerReportDescriptor)), "touchpad descriptor");
+    uint16_t bits[256];
+    std::vector<Field> fields = walkDescriptor(_digitizerReportDescriptor, sizeof(_digitizerReportDescriptor), bits);
+
+    CHECK_EQ(bits[DIGITIZER_ID], sizeof(TouchpadReport) * 8);
+    for (int f = 0; f < TOUCHPAD_REPORT_CONTACTS; f++) {
+        size_t base = offsetof(TouchpadReport, fingers) + f * sizeof(TouchpadFinger);
+        CHECK(at(field(fields, DIGITIZER_ID, true, 0x0D, 0x47, f), base, 0, 1));                  // Confidence
+        CHECK(at(field(fields, DIGITIZER_ID, true, 0x0D, 0x42, f), base, 1, 1));                  // Tip
+        CHECK(at(field(fields, DIGITIZER_ID, true, 0x0D, 0x51, f), base, TOUCHPAD_ID_SHIFT, 6));  // Contact ID
+        CHECK(at(field(fields, DIGITIZER_ID, true, 0x01, 0x30, f), base + offsetof(TouchpadFinger, x), 0, 16));
+        CHECK(at(field(fields, DIGITIZER_ID, true, 0x01, 0x31, f), base + offsetof(TouchpadFinger, y), 0, 16));
+    }
+    CHECK(!field(fields, DIGITIZER_ID, true, 0x0D, 0x42, TOUCHPAD_REPORT_CONTACTS));   // No extra fingers
+    CHECK(at(field(fields, DIGITIZER_ID, true, 0x0D, 0x56), offsetof(TouchpadReport, scanTime), 0, 16));
+    CHECK(at(field(fields, DIGITIZER_ID, true, 0x0D, 0x54), offsetof(TouchpadReport, contactCount), 0, 8));
+    CHECK(at(field(fields, DIGITIZER_ID, true, 0x09, 0x01), offsetof(TouchpadReport, buttons), 0, 1));
+    CHECK_EQ(TOUCHPAD_CONFIDENCE, 0x01);
+    CHECK_EQ(TOUCHPAD_TIP, 0x02);
+
+    // Max contacts in the low nibble of the caps feature, pad type in the high one
+    CHECK(at(field(fields, TOUCHPAD_CAPS_ID, false, 0x0D, 0x55), 0, 0, 4));
+    CHECK(at(field(fields, TOUCHPAD_CAPS_ID, false, 0x0D, 0x59), 0, 4, 4));
+}
+
+static void testPacking() {
+    TouchContact contacts[TOUCH_MAX_CONTACTS];
+    for (uint8_t i = 0; i < TOUCH_MAX_CONTACTS; i++)
+        contacts[i] = TouchContact{ (uint16_t)(1000 + i), (uint16_t)(2000 + i), (uint8_t)(60 + i), i != 1, i != 2 };
+
+    TouchpadReport reports[TOUCHPAD_MAX_REPORTS];
+    uint8_t n = packTouchpadReports(contacts, TOUCH_MAX_CONTACTS, 0x1234, 1, reports);
+    CHECK_EQ(n, TOUCHPAD_MAX_REPORTS);
+
+    // Every contact lands once, in order, with the flag bits where the descriptor wants them
+    bool packed = true;
+    for (uint8_t i = 0; i < TOUCH_MAX_CONTACTS; i++) {
+        const uint8_t* b = (const uint8_t*)&reports[i / TOUCHPAD_REPORT_CONTACTS].fingers[i % TOUCHPAD_REPORT_CONTACTS];
+        uint8_t flags = (i != 2 ? 0x01 : 0) | (i != 1 ? 0x02 : 0) | (((60 + i) % 64) << 2);
+        packed &= b[0] == flags && (b[1] | (b[2] << 8)) == 1000 + i && (b[3] | (b[4] << 8)) == 2000 + i;
+    }
+    CHECK(packed);
+
+    // Hybrid mode - same scan time on every report, the count only on the first
+    bool sameScan = true, countOnFirst = reports[0].contactCount == TOUCH_MAX_CONTACTS;
+    for (uint8_t r = 0; r < n && r < TOUCHPAD_MAX_REPORTS; r++) {
+        sameScan &= reports[r].scanTime == 0x1234 && reports[r].buttons == 1;
+        if (r) countOnFirst &= reports[r].contactCount == 0;
+    }
+    CHECK(sameScan);
+    CHECK(countOnFirst);
+
+    // Empty slots are zero, and a frame with no contacts still carries the button
+    n = packTouchpadReports(contacts, 1, 7, 0, reports);
+    CHECK_EQ(n, 1);
+    bool empty = true;
+    for (uint8_t f = 1; f < TOUCHPAD_REPORT_CONTACTS; f++) empty &= reports[0].fingers[f].flags == 0 && reports[0].fingers[f].x == 0;
+    CHECK(empty);
+    n = packTouchpadReports(contacts, 0, 8, 1, reports);
+    CHECK_EQ(n, 1);
+    CHECK_EQ(reports[0].contactCount, 0);
+    CHECK_EQ(reports[0].buttons, 1);
+}
+
+int main() {
+    printf("     %d contacts per report\n", TOUCHPAD_REPORT_CONTACTS);
+    RUN_TEST(testIdsFollowFingers);
+    RUN_TEST(testLiftsAndNewFingers);
+    RUN_TEST(testFullPadTurnover);
+    RUN_TEST(testReportMatchesDescriptor);
+    RUN_TEST(testPacking);
+    return TEST_RESULT();
+}